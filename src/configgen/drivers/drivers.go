@@ -286,6 +286,11 @@ var Drivers=map[string]EthercatDriver{
     ProductID: "0x04e43052",
     Type: "EL1252",
   },
+  "EL1262": EthercatDriver{
+    VendorID: "0x00000002",
+    ProductID: "0x04ee3052",
+    Type: "EL1262",
+  },
   "EL1804": EthercatDriver{
     VendorID: "0x00000002",
     ProductID: "0x070c3052",
@@ -386,6 +391,11 @@ var Drivers=map[string]EthercatDriver{
     ProductID: "0x089a3052",
     Type: "EL2202",
   },
+  "EL2262": EthercatDriver{
+    VendorID: "0x00000002",
+    ProductID: "0x08d63052",
+    Type: "EL2262",
+  },
   "EL2521": EthercatDriver{
     VendorID: "0x00000002",
     ProductID: "0x09d93052",
@@ -676,6 +686,16 @@ var Drivers=map[string]EthercatDriver{
     ProductID: "0x0d4b3052",
     Type: "EL3403",
   },
+  "EL3702": EthercatDriver{
+    VendorID: "0x00000002",
+    ProductID: "0x0e763052",
+    Type: "EL3702",
+  },
+  "EL3742": EthercatDriver{
+    VendorID: "0x00000002",
+    ProductID: "0x0e9e3052",
+    Type: "EL3742",
+  },
   "EL4001": EthercatDriver{
     VendorID: "0x00000002",
     ProductID: "0x0fa13052",
@@ -796,6 +816,11 @@ var Drivers=map[string]EthercatDriver{
     ProductID: "0x10263052",
     Type: "EL4134",
   },
+  "EL4732": EthercatDriver{
+    VendorID: "0x00000002",
+    ProductID: "0x127c3052",
+    Type: "EL4732",
+  },
   "EL5002": EthercatDriver{
     VendorID: "0x00000002",
     ProductID: "0x138a3052",
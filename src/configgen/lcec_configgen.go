@@ -143,13 +143,17 @@ var (
 		EnableSDO{name: "enableProfileEndVelocity", offset: 0x82, subindex: 0},
 		EnableSDO{name: "enableProfileMaxVelocity", offset: 0x7f, subindex: 0},
 		EnableSDO{name: "enableProfileVelocity", offset: 0x81, subindex: 0},
+		EnableSDO{name: "enableSecondaryPosition", offset: 0xe4, subindex: 1},
 		EnableSDO{name: "enableTargetTorque", offset: 0x71, subindex: 0},
 		EnableSDO{name: "enableTorqueDemand", offset: 0x74, subindex: 0},
+		EnableSDO{name: "enableTorqueOffset", offset: 0xb2, subindex: 0},
+		EnableSDO{name: "enableTouchProbe", offset: 0xb8, subindex: 0},
 		EnableSDO{name: "enableTorqueProfileType", offset: 0x88, subindex: 0},
 		EnableSDO{name: "enableTorqueSlope", offset: 0x87, subindex: 0},
 		EnableSDO{name: "enableVelocityDemand", offset: 0x6b, subindex: 0},
 		EnableSDO{name: "enableVelocityErrorTime", offset: 0x6e, subindex: 0},
 		EnableSDO{name: "enableVelocityErrorWindow", offset: 0x6d, subindex: 0},
+		EnableSDO{name: "enableVelocityOffset", offset: 0xb1, subindex: 0},
 		EnableSDO{name: "enableVelocitySensorSelector", offset: 0x61, subindex: 0},
 		EnableSDO{name: "enableVelocityThresholdTime", offset: 0x70, subindex: 0},
 		EnableSDO{name: "enableVelocityThresholdWindow", offset: 0x6f, subindex: 0},
@@ -445,9 +449,9 @@ func (s *EthercatSlave) BuildPDOs(c *ConfigSlave) error {
 					entry.HalType = "s32"
 				case "bool":
 					entry.HalType = "bit"
-				case "uint64": // Some support in LinuxCNC, but not in LCEC today, so it'll throw an error.
+				case "uint64":
 					entry.HalType = "u64"
-				case "int64": // Some support in LinuxCNC, but not in LCEC today, so it'll throw an error.
+				case "int64":
 					entry.HalType = "s64"
 				case "float", "double":
 					if bits == 32 {
@@ -25,7 +25,8 @@
 static int lcec_ax5100_init(int comp_id, struct lcec_slave *slave);
 
 static lcec_modparam_desc_t lcec_ax5100_modparams[] = {
-  {"enableFB2", LCEC_AX5_PARAM_ENABLE_FB2, MODPARAM_TYPE_BIT}, {"enableDiag", LCEC_AX5_PARAM_ENABLE_DIAG, MODPARAM_TYPE_BIT}, {NULL},};
+  {"enableFB2", LCEC_AX5_PARAM_ENABLE_FB2, MODPARAM_TYPE_BIT}, {"enableDiag", LCEC_AX5_PARAM_ENABLE_DIAG, MODPARAM_TYPE_BIT},
+  {"soeSampleInterval", LCEC_AX5_PARAM_SOE_SAMPLE_INTERVAL, MODPARAM_TYPE_U32}, {NULL},};
 
 static lcec_typelist_t types[] = {
     // AX5000 servo drives
@@ -41,6 +42,7 @@ ADD_TYPES(types);
 typedef struct {
   lcec_syncs_t syncs;
   lcec_class_ax5_chan_t chan;
+  lcec_class_ax5_soe_t soe;
 } lcec_ax5100_data_t;
 
 static const LCEC_CONF_FSOE_T fsoe_conf = {
@@ -61,7 +63,7 @@ static void lcec_ax5100_write(struct lcec_slave *slave, long period);
   // set FSOE conf (this will be used by the corresponding AX5805
   slave->fsoeConf = &fsoe_conf;
 
-  return 0;
+  return lcec_class_ax5_preinit(slave, 0);
 }
 
 static int lcec_ax5100_init(int comp_id, struct lcec_slave *slave) {
@@ -85,6 +87,9 @@ static int lcec_ax5100_init(int comp_id, struct lcec_slave *slave) {
   if ((err = lcec_class_ax5_init(slave, &hal_data->chan, 0, "")) != 0) {
     return err;
   }
+  if ((err = lcec_class_ax5_soe_init(slave, &hal_data->soe, &hal_data->chan, 1)) != 0) {
+    return err;
+  }
 
   // initialize sync info
   lcec_syncs_init(&hal_data->syncs);
@@ -118,6 +123,9 @@ static void lcec_ax5100_read(struct lcec_slave *slave, long period) {
 
   // check inputs
   lcec_class_ax5_read(slave, &hal_data->chan);
+
+  // handle SoE parameter requests
+  lcec_class_ax5_soe_read(slave, &hal_data->soe, period);
 }
 
 static void lcec_ax5100_write(struct lcec_slave *slave, long period) {
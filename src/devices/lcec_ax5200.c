@@ -28,6 +28,7 @@ static int lcec_ax5200_init(int comp_id, struct lcec_slave *slave);
 static lcec_modparam_desc_t lcec_ax5200_modparams[] = {
     {"enableFB2", LCEC_AX5_PARAM_ENABLE_FB2, MODPARAM_TYPE_BIT},
     {"enableDiag", LCEC_AX5_PARAM_ENABLE_DIAG, MODPARAM_TYPE_BIT},
+    {"soeSampleInterval", LCEC_AX5_PARAM_SOE_SAMPLE_INTERVAL, MODPARAM_TYPE_U32},
     {NULL},
 };
 
@@ -41,6 +42,7 @@ ADD_TYPES(types);
 typedef struct {
   lcec_syncs_t syncs;
   lcec_class_ax5_chan_t chans[LCEC_AX5200_CHANS];
+  lcec_class_ax5_soe_t soe;
 } lcec_ax5200_data_t;
 
 static const LCEC_CONF_FSOE_T fsoe_conf = {
@@ -53,6 +55,8 @@ static void lcec_ax5200_read(struct lcec_slave *slave, long period);
 static void lcec_ax5200_write(struct lcec_slave *slave, long period);
 
 /*static*/ int lcec_ax5200_preinit(struct lcec_slave *slave) {
+  int i, err;
+
   // check if already initialized
   if (slave->fsoeConf != NULL) {
     return 0;
@@ -61,6 +65,12 @@ static void lcec_ax5200_write(struct lcec_slave *slave, long period);
   // set FSOE conf (this will be used by the corresponding AX5805
   slave->fsoeConf = &fsoe_conf;
 
+  for (i = 0; i < LCEC_AX5200_CHANS; i++) {
+    if ((err = lcec_class_ax5_preinit(slave, i)) != 0) {
+      return err;
+    }
+  }
+
   return 0;
 }
 
@@ -94,6 +104,9 @@ static int lcec_ax5200_init(int comp_id, struct lcec_slave *slave) {
       return err;
     }
   }
+  if ((err = lcec_class_ax5_soe_init(slave, &hal_data->soe, hal_data->chans, LCEC_AX5200_CHANS)) != 0) {
+    return err;
+  }
 
   // initialize sync info
   lcec_syncs_init(&hal_data->syncs);
@@ -148,6 +161,9 @@ static void lcec_ax5200_read(struct lcec_slave *slave, long period) {
     chan = &hal_data->chans[i];
     lcec_class_ax5_read(slave, chan);
   }
+
+  // handle SoE parameter requests
+  lcec_class_ax5_soe_read(slave, &hal_data->soe, period);
 }
 
 static void lcec_ax5200_write(struct lcec_slave *slave, long period) {
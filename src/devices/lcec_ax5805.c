@@ -161,6 +161,10 @@ static int lcec_ax5805_init(int comp_id, struct lcec_slave *slave) {
     slave_pins = slave_pins_1ch;
   }
 
+  // let the logic device's FSoE routes find this slave's frames
+  slave->fsoe_local_slave_offset = &hal_data->fsoe_slave_cmd_os;
+  slave->fsoe_local_master_offset = &hal_data->fsoe_master_cmd_os;
+
   // export pins
   if ((err = lcec_pin_newf_list(hal_data, slave_pins, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
     return err;
@@ -174,8 +178,6 @@ static void lcec_ax5805_read(struct lcec_slave *slave, long period) {
   lcec_ax5805_data_t *hal_data = (lcec_ax5805_data_t *)slave->hal_data;
   uint8_t *pd = master->process_data;
 
-  copy_fsoe_data(slave, hal_data->fsoe_slave_cmd_os, hal_data->fsoe_master_cmd_os);
-
   *(hal_data->fsoe_master_cmd) = EC_READ_U8(&pd[hal_data->fsoe_master_cmd_os]);
   *(hal_data->fsoe_master_connid) = EC_READ_U16(&pd[hal_data->fsoe_master_connid_os]);
   *(hal_data->fsoe_slave_cmd) = EC_READ_U8(&pd[hal_data->fsoe_slave_cmd_os]);
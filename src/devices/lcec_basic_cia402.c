@@ -44,6 +44,7 @@ static const lcec_modparam_desc_t modparams_lcec_basic_cia402[] = {
     {NULL},
 };
 
+static int lcec_basic_cia402_preinit(struct lcec_slave *slave);
 static int lcec_basic_cia402_init(int comp_id, struct lcec_slave *slave);
 
 // When extending this, you will need to modify the number of PDOs
@@ -60,7 +61,7 @@ static int lcec_basic_cia402_init(int comp_id, struct lcec_slave *slave);
 // PID.  Feel free to add multiple devices here if they can share the
 // same driver.
 static lcec_typelist_t types[] = {
-    {"basic_cia402", /* fake vid */ -1, /* fake pid */ -1, 0, NULL, lcec_basic_cia402_init, /* modparams implicitly added below */},
+    {"basic_cia402", /* fake vid */ -1, /* fake pid */ -1, 0, lcec_basic_cia402_preinit, lcec_basic_cia402_init, /* modparams implicitly added below */},
     {NULL},
 };
 ADD_TYPES_WITH_CIA402_MODPARAMS(types, modparams_lcec_basic_cia402)
@@ -83,8 +84,10 @@ static const lcec_pindesc_t slave_pins[] = {
 static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_t *options) {
   lcec_master_t *master = slave->master;
   lcec_slave_modparam_t *p;
+  lcec_cia402_modparam_ctx_t ctx;
   int v;
 
+  memset(&ctx, 0, sizeof(ctx));
   for (p = slave->modparams; p != NULL && p->id >= 0; p++) {
     switch (p->id) {
       // XXXX: add device-specific modparam handlers here.  Here's an example from lcec_rtec.c:
@@ -94,7 +97,7 @@ static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_
       //        break;
       default:
         // Handle cia402 generic modparams
-        v = lcec_cia402_handle_modparam(slave, p, options);
+        v = lcec_cia402_handle_modparam(slave, p, options, &ctx);
 
         // If an error occured, then return the error.
         if (v < 0) {
@@ -110,7 +113,17 @@ static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_
     }
   }
 
-  return 0;
+  // Report skipped writes and save parameters, if requested.
+  return lcec_cia402_finish_modparams(slave, options, &ctx);
+}
+
+static int lcec_basic_cia402_preinit(struct lcec_slave *slave) {
+  // XXXX: queue reads of any SDOs that device-specific modparam
+  // handlers read back here, with `lcec_prefetch_sdo()`.
+
+  // Read the current values of SDOs set by CiA 402 modparams, so
+  // unchanged ones aren't written again.
+  return lcec_cia402_prefetch_modparams(slave);
 }
 
 static int lcec_basic_cia402_init(int comp_id, struct lcec_slave *slave) {
@@ -23,6 +23,9 @@
 
 #include "../lcec.h"
 
+/// @brief Channels of all slaves using this class, allocated one after the other.
+static lcec_block_t channel_block;
+
 /// @brief Basic pins common to all analog in devices.
 static const lcec_pindesc_t slave_pins_basic[] = {
     {HAL_S32, HAL_OUT, offsetof(lcec_class_ain_channel_t, raw_val), "%s.%s.%s.%s-%d-raw"},
@@ -62,6 +65,54 @@ static const lcec_pindesc_t slave_pins_status[] = {
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
 };
 
+/// @brief Per-channel filter modParams, added to each device's own modParams by `ADD_TYPES_WITH_AIN_MODPARAMS()`.
+static const lcec_modparam_desc_t filter_modparams[] = {
+    {"ch0Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 0, MODPARAM_TYPE_FLOAT},
+    {"ch1Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 1, MODPARAM_TYPE_FLOAT},
+    {"ch2Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 2, MODPARAM_TYPE_FLOAT},
+    {"ch3Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 3, MODPARAM_TYPE_FLOAT},
+    {"ch4Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 4, MODPARAM_TYPE_FLOAT},
+    {"ch5Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 5, MODPARAM_TYPE_FLOAT},
+    {"ch6Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 6, MODPARAM_TYPE_FLOAT},
+    {"ch7Lowpass", LCEC_AIN_MODPARAM_LOWPASS + 7, MODPARAM_TYPE_FLOAT},
+    {"ch0Average", LCEC_AIN_MODPARAM_AVERAGE + 0, MODPARAM_TYPE_U32},
+    {"ch1Average", LCEC_AIN_MODPARAM_AVERAGE + 1, MODPARAM_TYPE_U32},
+    {"ch2Average", LCEC_AIN_MODPARAM_AVERAGE + 2, MODPARAM_TYPE_U32},
+    {"ch3Average", LCEC_AIN_MODPARAM_AVERAGE + 3, MODPARAM_TYPE_U32},
+    {"ch4Average", LCEC_AIN_MODPARAM_AVERAGE + 4, MODPARAM_TYPE_U32},
+    {"ch5Average", LCEC_AIN_MODPARAM_AVERAGE + 5, MODPARAM_TYPE_U32},
+    {"ch6Average", LCEC_AIN_MODPARAM_AVERAGE + 6, MODPARAM_TYPE_U32},
+    {"ch7Average", LCEC_AIN_MODPARAM_AVERAGE + 7, MODPARAM_TYPE_U32},
+    {"ch0Decimate", LCEC_AIN_MODPARAM_DECIMATE + 0, MODPARAM_TYPE_U32},
+    {"ch1Decimate", LCEC_AIN_MODPARAM_DECIMATE + 1, MODPARAM_TYPE_U32},
+    {"ch2Decimate", LCEC_AIN_MODPARAM_DECIMATE + 2, MODPARAM_TYPE_U32},
+    {"ch3Decimate", LCEC_AIN_MODPARAM_DECIMATE + 3, MODPARAM_TYPE_U32},
+    {"ch4Decimate", LCEC_AIN_MODPARAM_DECIMATE + 4, MODPARAM_TYPE_U32},
+    {"ch5Decimate", LCEC_AIN_MODPARAM_DECIMATE + 5, MODPARAM_TYPE_U32},
+    {"ch6Decimate", LCEC_AIN_MODPARAM_DECIMATE + 6, MODPARAM_TYPE_U32},
+    {"ch7Decimate", LCEC_AIN_MODPARAM_DECIMATE + 7, MODPARAM_TYPE_U32},
+    {NULL},
+};
+
+/// @brief Merge per-device modParams with the per-channel filter modParams.
+///
+/// @param device_mps The device's own `<modParam>` settings, or `NULL`.
+/// @return The merged list, or `NULL` on allocation failure.
+const lcec_modparam_desc_t *lcec_ain_modparams(lcec_modparam_desc_t const *device_mps) {
+  static const lcec_modparam_desc_t *last_device_mps, *last_mps;
+
+  if (device_mps == NULL) {
+    return filter_modparams;
+  }
+
+  // Most drivers share one list between all of their types, so only merge it once.
+  if (device_mps != last_device_mps) {
+    last_mps = lcec_modparam_desc_concat(device_mps, filter_modparams);
+    last_device_mps = device_mps;
+  }
+  return last_mps;
+}
+
 /// @brief Allocate a block of memory for holding the results from
 /// `count` calls to `lcec_ain_register_device() and friends.
 ///
@@ -72,13 +123,21 @@ static const lcec_pindesc_t slave_pins_status[] = {
 /// from `lcec_ain_register_channel()`.
 lcec_class_ain_channels_t *lcec_ain_allocate_channels(int count) {
   lcec_class_ain_channels_t *channels;
+  size_t size;
+
+  // room for the channels, their options, and the pointers to them
+  size = LCEC_BLOCK_ALIGN(sizeof(lcec_class_ain_channels_t)) + LCEC_BLOCK_ALIGN(sizeof(lcec_class_ain_channel_t *) * count);
+  size += count * (LCEC_BLOCK_ALIGN(sizeof(lcec_class_ain_channel_t)) + LCEC_BLOCK_ALIGN(sizeof(lcec_class_ain_options_t)));
+  if (lcec_block_reserve(&channel_block, size) < 0) {
+    return NULL;
+  }
 
-  channels = hal_malloc(sizeof(lcec_class_ain_channels_t));
+  channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_ain_channels_t));
   if (channels == NULL) {
     return NULL;
   }
   channels->count = count;
-  channels->channels = hal_malloc(sizeof(lcec_class_ain_channel_t *) * count);
+  channels->channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_ain_channel_t *) * count);
   if (channels->channels == NULL) {
     return NULL;
   }
@@ -91,7 +150,7 @@ lcec_class_ain_channels_t *lcec_ain_allocate_channels(int count) {
 /// `lcec_ain_register_channel`, so we can safely just memset
 /// everything to 0 here.
 lcec_class_ain_options_t *lcec_ain_options(void) {
-  lcec_class_ain_options_t *opts = hal_malloc(sizeof(lcec_class_ain_options_t));
+  lcec_class_ain_options_t *opts = lcec_block_alloc(&channel_block, sizeof(lcec_class_ain_options_t));
   if (opts == NULL) {
     return NULL;
   }
@@ -100,6 +159,50 @@ lcec_class_ain_options_t *lcec_ain_options(void) {
   return opts;
 }
 
+// Reads the `chXLowpass`, `chXAverage`, and `chXDecimate` modParams for channel `id`.
+static int setup_filter(struct lcec_slave *slave, lcec_class_ain_channel_t *data, int id) {
+  LCEC_CONF_MODPARAM_VAL_T *pval;
+
+  // <modParam name="chXLowpass" value="0.1"/>
+  pval = lcec_modparam_get(slave, LCEC_AIN_MODPARAM_LOWPASS + id);
+  if (pval != NULL) {
+    if (pval->flt <= 0.0 || pval->flt > 1.0) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "slave %s.%s: ch%dLowpass must be greater than 0 and at most 1, not %f\n",
+          slave->master->name, slave->name, id, pval->flt);
+      return -EINVAL;
+    }
+    if (pval->flt < 1.0) data->lowpass_gain = pval->flt;
+  }
+
+  // <modParam name="chXAverage" value="16"/>
+  pval = lcec_modparam_get(slave, LCEC_AIN_MODPARAM_AVERAGE + id);
+  if (pval != NULL) {
+    if (pval->u32 < 1 || pval->u32 > LCEC_AIN_MAX_AVERAGE) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "slave %s.%s: ch%dAverage must be between 1 and %d, not %u\n", slave->master->name,
+          slave->name, id, LCEC_AIN_MAX_AVERAGE, pval->u32);
+      return -EINVAL;
+    }
+    if (pval->u32 > 1) {
+      data->average_buf = lcec_block_alloc(&channel_block, sizeof(int32_t) * pval->u32);
+      if (data->average_buf == NULL) {
+        rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %d failed\n",
+            slave->master->name, slave->name, id);
+        return -ENOMEM;
+      }
+      data->average_len = pval->u32;
+      data->average_recip = 1.0 / (double)pval->u32;
+    }
+  }
+
+  // <modParam name="chXDecimate" value="10"/>
+  pval = lcec_modparam_get(slave, LCEC_AIN_MODPARAM_DECIMATE + id);
+  if (pval != NULL) {
+    data->decimate = pval->u32;
+  }
+
+  return 0;
+}
+
 /// @brief registers a single analog-input channel and publishes it as a LinuxCNC HAL pin.
 ///
 /// @param slave The slave, from `_init`.
@@ -155,18 +258,19 @@ lcec_class_ain_channel_t *lcec_ain_register_channel(struct lcec_slave *slave, in
   if (!opt) {
     opt = lcec_ain_options();
     if (opt == NULL) {
-      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %d failed\n", slave->master->name, slave->name, id);
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %d failed\n",
+          slave->master->name, slave->name, id);
       return NULL;
     }
   }
 
   // Allocate memory for per-channel data.
-  data = hal_malloc(sizeof(lcec_class_ain_channel_t));
+  data = lcec_block_alloc(&channel_block, sizeof(lcec_class_ain_channel_t));
   if (data == NULL) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %d failed\n", slave->master->name, slave->name, id);
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %d failed\n",
+        slave->master->name, slave->name, id);
     return NULL;
   }
-  memset(data, 0, sizeof(lcec_class_ain_channel_t));
 
   // Save important options for later use.  None of the _idx/_sidx will be needed outside of this function.
   data->options = opt;
@@ -234,6 +338,12 @@ lcec_class_ain_channel_t *lcec_ain_register_channel(struct lcec_slave *slave, in
     }
   }
 
+  // Per-channel filters, if configured.
+  data->recip_max = 1.0 / (double)max_value;
+  if (id < LCEC_AIN_MAX_CHANNELS && setup_filter(slave, data, id) != 0) {
+    return NULL;
+  }
+
   // Set default values for scale and bias.
   *(data->scale) = 1.0;
   if (is_temperature) *(data->scale) = 0.1;
@@ -243,6 +353,48 @@ lcec_class_ain_channel_t *lcec_ain_register_channel(struct lcec_slave *slave, in
   return data;
 }
 
+/// @brief Runs one raw sample through the channel's filters.
+///
+/// The moving average, if enabled, runs first and the first-order
+/// IIR filter is applied to its output.  Both are seeded with the
+/// first sample, so they don't ramp up from 0 after startup.
+///
+/// @param data The channel, as returned by `lcec_ain_register_channel()`.
+/// @param value The raw value read from the device.
+/// @return The filtered value, still in raw units.
+double lcec_ain_filter(lcec_class_ain_channel_t *data, int value) {
+  double out = (double)value;
+  int i;
+
+  if (data->average_buf == NULL && data->lowpass_gain == 0.0) {
+    return out;
+  }
+
+  if (!data->filter_primed) {
+    for (i = 0; i < data->average_len; i++) {
+      data->average_buf[i] = value;
+    }
+    data->average_sum = (int64_t)value * data->average_len;
+    data->lowpass = out;
+    data->filter_primed = 1;
+  }
+
+  if (data->average_buf != NULL) {
+    // Keep a running sum, so each cycle costs one add, one subtract, and one multiply.
+    data->average_sum += value - data->average_buf[data->average_pos];
+    data->average_buf[data->average_pos] = value;
+    if (++data->average_pos >= data->average_len) data->average_pos = 0;
+    out = (double)data->average_sum * data->average_recip;
+  }
+
+  if (data->lowpass_gain != 0.0) {
+    data->lowpass += data->lowpass_gain * (out - data->lowpass);
+    out = data->lowpass;
+  }
+
+  return out;
+}
+
 /// @brief Reads data from a single analog in port.
 ///
 /// @param slave The `slave`, passed from the per-device `_read`.
@@ -253,7 +405,7 @@ lcec_class_ain_channel_t *lcec_ain_register_channel(struct lcec_slave *slave, in
 void lcec_ain_read(struct lcec_slave *slave, lcec_class_ain_channel_t *data) {
   uint8_t *pd = slave->master->process_data;
   int value;  // Needs to be large enough to hold either a uint16_t or an sint16_t without loss.
-  int max_value = data->options->max_value;
+  double filtered;
 
   // Update status bits, if enabled
   if (!data->options->valueonly) {
@@ -274,16 +426,27 @@ void lcec_ain_read(struct lcec_slave *slave, lcec_class_ain_channel_t *data) {
     value = EC_READ_S16(&pd[data->val_pdo_os]);
   }
   *(data->raw_val) = value;
+
+  // The filters run every cycle, even when `val` is decimated.
+  filtered = lcec_ain_filter(data, value);
+  if (data->decimate > 1) {
+    if (data->decimate_count > 0) {
+      data->decimate_count--;
+      return;
+    }
+    data->decimate_count = data->decimate - 1;
+  }
+
   if (data->options->is_temperature) {
     // Temperature uses different value calculations than regular analog sensors.
-    *(data->val) = *(data->scale) * (double)value;
+    *(data->val) = *(data->scale) * filtered;
   } else {
     // Normal analog sensors return a value between -1.0 and 1.0 (or 0
     // and 1.0, depending on the sensor type), where 1.0 is the
     // largest possible input value.
     //
     // Then, the result is multipled by `scale` (default: 1.0) and `bias` is added (default 0).
-    *(data->val) = *(data->bias) + *(data->scale) * (double)value * ((double)1 / (double)max_value);
+    *(data->val) = *(data->bias) + *(data->scale) * filtered * data->recip_max;
   }
 }
 
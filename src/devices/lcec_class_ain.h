@@ -21,6 +21,17 @@
 
 #include "../lcec.h"
 
+// modParam IDs for the per-channel filter settings.  The channel
+// number is added to these, so each needs 8 unused IDs after it.
+// They're kept well away from the device-specific IDs used by
+// drivers that use this class.
+#define LCEC_AIN_MODPARAM_LOWPASS  0x800  ///< `chXLowpass`, float gain of the first-order IIR filter.
+#define LCEC_AIN_MODPARAM_AVERAGE  0x810  ///< `chXAverage`, number of samples in the moving average.
+#define LCEC_AIN_MODPARAM_DECIMATE 0x820  ///< `chXDecimate`, only update `val` every N cycles.
+
+#define LCEC_AIN_MAX_CHANNELS 8    ///< Channels that have filter modParams.
+#define LCEC_AIN_MAX_AVERAGE  256  ///< Largest moving average window.
+
 typedef struct {
   char *name_prefix;               ///< Prefix for device naming, defaults to "aio".
   int has_sync;                    ///< Device supports the sync_err PDO.
@@ -58,6 +69,17 @@ typedef struct {
   unsigned int sync_err_pdo_bp;
   unsigned int val_pdo_os;
   int is_unsigned;
+  double recip_max;      ///< `1.0 / max_value`, so `lcec_ain_read()` doesn't need to divide.
+  double lowpass_gain;   ///< Gain of the first-order IIR filter, 0 if disabled.
+  double lowpass;        ///< IIR filter state, in raw units.
+  int32_t *average_buf;  ///< Last `average_len` raw values, NULL if the moving average is disabled.
+  int64_t average_sum;   ///< Sum of `average_buf`.
+  double average_recip;  ///< `1.0 / average_len`.
+  int average_len;       ///< Moving average window.
+  int average_pos;       ///< Next slot in `average_buf` to replace.
+  int filter_primed;     ///< Filter state has been seeded with a real sample.
+  int decimate;          ///< Only update `val` every `decimate` cycles, 0 or 1 to update every cycle.
+  int decimate_count;    ///< Cycles since `val` was last updated.
   lcec_class_ain_options_t *options;  ///< The options used to create this device.
 } lcec_class_ain_channel_t;
 
@@ -72,3 +94,16 @@ lcec_class_ain_channel_t *lcec_ain_register_channel(struct lcec_slave *slave, in
 void lcec_ain_read(struct lcec_slave *slave, lcec_class_ain_channel_t *data);
 void lcec_ain_read_all(struct lcec_slave *slave, lcec_class_ain_channels_t *channels);
 lcec_class_ain_options_t *lcec_ain_options(void);
+double lcec_ain_filter(lcec_class_ain_channel_t *data, int value);
+const lcec_modparam_desc_t *lcec_ain_modparams(lcec_modparam_desc_t const *device_mps);
+
+/// @brief Register `types`, adding the per-channel filter modParams to each type's own modParams.
+#define ADD_TYPES_WITH_AIN_MODPARAMS(types)                        \
+  static void AddTypes(void) __attribute__((constructor));         \
+  static void AddTypes(void) {                                     \
+    int i;                                                         \
+    for (i = 0; types[i].name != NULL; i++) {                      \
+      types[i].modparams = lcec_ain_modparams(types[i].modparams); \
+    }                                                              \
+    lcec_addtypes(types, __FILE__);                                \
+  }
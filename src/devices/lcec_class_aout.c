@@ -23,6 +23,9 @@
 
 #include "../lcec.h"
 
+/// @brief Channels of all slaves using this class, allocated one after the other.
+static lcec_block_t channel_block;
+
 /// @brief Basic pins common to all analog in devices.
 static const lcec_pindesc_t slave_pins_basic[] = {
     {HAL_FLOAT, HAL_IO, offsetof(lcec_class_aout_channel_t, scale), "%s.%s.%s.%s-%d-scale"},
@@ -49,13 +52,21 @@ static const lcec_pindesc_t slave_pins_basic[] = {
 /// from `lcec_aout_register_channel()`.
 lcec_class_aout_channels_t *lcec_aout_allocate_channels(int count) {
   lcec_class_aout_channels_t *channels;
+  size_t size;
+
+  // room for the channels, their options, and the pointers to them
+  size = LCEC_BLOCK_ALIGN(sizeof(lcec_class_aout_channels_t)) + LCEC_BLOCK_ALIGN(sizeof(lcec_class_aout_channel_t *) * count);
+  size += count * (LCEC_BLOCK_ALIGN(sizeof(lcec_class_aout_channel_t)) + LCEC_BLOCK_ALIGN(sizeof(lcec_class_aout_options_t)));
+  if (lcec_block_reserve(&channel_block, size) < 0) {
+    return NULL;
+  }
 
-  channels = hal_malloc(sizeof(lcec_class_aout_channels_t));
+  channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_aout_channels_t));
   if (channels == NULL) {
     return NULL;
   }
   channels->count = count;
-  channels->channels = hal_malloc(sizeof(lcec_class_aout_channel_t *) * count);
+  channels->channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_aout_channel_t *) * count);
   if (channels->channels == NULL) {
     return NULL;
   }
@@ -68,7 +79,7 @@ lcec_class_aout_channels_t *lcec_aout_allocate_channels(int count) {
 /// `lcec_aout_register_channel`, so we can safely just memset
 /// everything to 0 here.
 lcec_class_aout_options_t *lcec_aout_options(void) {
-  lcec_class_aout_options_t *opts = hal_malloc(sizeof(lcec_class_aout_options_t));
+  lcec_class_aout_options_t *opts = lcec_block_alloc(&channel_block, sizeof(lcec_class_aout_options_t));
   if (opts == NULL) {
     return NULL;
   }
@@ -113,18 +124,19 @@ lcec_class_aout_channel_t *lcec_aout_register_channel(struct lcec_slave *slave,
   if (!opt) {
     opt = lcec_aout_options();
     if (opt == NULL) {
-      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %d failed\n", slave->master->name, slave->name, id);
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %d failed\n",
+          slave->master->name, slave->name, id);
       return NULL;
     }
   }
 
   // Allocate memory for per-channel data.
-  data = hal_malloc(sizeof(lcec_class_aout_channel_t));
+  data = lcec_block_alloc(&channel_block, sizeof(lcec_class_aout_channel_t));
   if (data == NULL) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %d failed\n", slave->master->name, slave->name, id);
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %d failed\n",
+        slave->master->name, slave->name, id);
     return NULL;
   }
-  memset(data, 0, sizeof(lcec_class_aout_channel_t));
 
   // Save important options for later use.  None of the _idx/_sidx will be needed outside of this function.
   data->options = opt;
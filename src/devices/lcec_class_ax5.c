@@ -54,6 +54,37 @@ static const lcec_pindesc_t slave_fb2_params[] = {
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
 };
 
+static const lcec_pindesc_t slave_soe_sample_pins[] = {
+    {HAL_U32, HAL_OUT, offsetof(lcec_class_ax5_chan_t, soe_diag), "%s.%s.%s.%ssrv-soe-diag"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_ax5_chan_t, motor_temp), "%s.%s.%s.%ssrv-motor-temp"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_ax5_chan_t, amp_temp), "%s.%s.%s.%ssrv-amp-temp"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+static const lcec_pindesc_t soe_pins[] = {
+    {HAL_U32, HAL_IN, offsetof(lcec_class_ax5_soe_t, drive), "%s.%s.%s.soe-drive"},
+    {HAL_U32, HAL_IN, offsetof(lcec_class_ax5_soe_t, idn), "%s.%s.%s.soe-idn"},
+    {HAL_U32, HAL_IN, offsetof(lcec_class_ax5_soe_t, write_data), "%s.%s.%s.soe-write-data"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_ax5_soe_t, read), "%s.%s.%s.soe-read"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_ax5_soe_t, write), "%s.%s.%s.soe-write"},
+    {HAL_U32, HAL_OUT, offsetof(lcec_class_ax5_soe_t, data), "%s.%s.%s.soe-data"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_ax5_soe_t, busy), "%s.%s.%s.soe-busy"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_ax5_soe_t, error), "%s.%s.%s.soe-error"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+static const lcec_pindesc_t soe_params[] = {
+    {HAL_U32, HAL_RW, offsetof(lcec_class_ax5_soe_t, write_size), "%s.%s.%s.soe-write-size"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+// IDNs sampled in the background, in this order for each channel
+static const uint16_t soe_sample_idns[LCEC_AX5_SOE_SAMPLE_IDNS] = {
+    LCEC_IDN(LCEC_IDN_TYPE_S, 0, 390),  // diagnostic number
+    LCEC_IDN(LCEC_IDN_TYPE_S, 0, 383),  // motor temperature (0.1 degC)
+    LCEC_IDN(LCEC_IDN_TYPE_S, 0, 384),  // amplifier temperature (0.1 degC)
+};
+
 static int get_param_flag(struct lcec_slave *slave, int id) {
   LCEC_CONF_MODPARAM_VAL_T *pval;
 
@@ -65,6 +96,17 @@ static int get_param_flag(struct lcec_slave *slave, int id) {
   return pval->bit;
 }
 
+static uint32_t get_param_u32(struct lcec_slave *slave, int id) {
+  LCEC_CONF_MODPARAM_VAL_T *pval;
+
+  pval = lcec_modparam_get(slave, id);
+  if (pval == NULL) {
+    return 0;
+  }
+
+  return pval->u32;
+}
+
 int lcec_class_ax5_pdos(struct lcec_slave *slave) {
   int pdo_count = 5;
 
@@ -79,6 +121,17 @@ int lcec_class_ax5_pdos(struct lcec_slave *slave) {
   return pdo_count;
 }
 
+int lcec_class_ax5_preinit(struct lcec_slave *slave, int index) {
+  // queue the idns read by lcec_class_ax5_init()
+  if (lcec_prefetch_idn(slave, index, LCEC_IDN(LCEC_IDN_TYPE_S, 0, 79), 4) ||
+      lcec_prefetch_idn(slave, index, LCEC_IDN(LCEC_IDN_TYPE_S, 0, 45), 2) ||
+      lcec_prefetch_idn(slave, index, LCEC_IDN(LCEC_IDN_TYPE_S, 0, 46), 2)) {
+    return -ENOMEM;
+  }
+
+  return 0;
+}
+
 int lcec_class_ax5_init(struct lcec_slave *slave, lcec_class_ax5_chan_t *chan, int index, const char *pfx) {
   lcec_master_t *master = slave->master;
   int err;
@@ -147,6 +200,13 @@ int lcec_class_ax5_init(struct lcec_slave *slave, lcec_class_ax5_chan_t *chan, i
     }
   }
 
+  chan->soe_sample_enabled = (get_param_u32(slave, LCEC_AX5_PARAM_SOE_SAMPLE_INTERVAL) > 0);
+  if (chan->soe_sample_enabled) {
+    if ((err = lcec_pin_newf_list(chan, slave_soe_sample_pins, LCEC_MODULE_NAME, master->name, slave->name, pfx)) != 0) {
+      return err;
+    }
+  }
+
   // init parameters
   chan->scale = 1.0;
   chan->scale_fb2 = 1.0;
@@ -275,3 +335,180 @@ void lcec_class_ax5_write(struct lcec_slave *slave, lcec_class_ax5_chan_t *chan)
 
   chan->toggle = !chan->toggle;
 }
+
+int lcec_class_ax5_soe_init(struct lcec_slave *slave, lcec_class_ax5_soe_t *soe, lcec_class_ax5_chan_t *chans, int chan_count) {
+  lcec_master_t *master = slave->master;
+  int err;
+
+  // create request objects: one for reads, and one per write size.
+  // A read sets the request's data size to what the drive returned,
+  // so reads can't share a request with writes.
+  if ((soe->req_read = ecrt_slave_config_create_soe_request(slave->config, 0, 0, 4)) == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failed to create SoE request for slave %s.%s\n", master->name, slave->name);
+    return -EIO;
+  }
+  if ((soe->req_16 = ecrt_slave_config_create_soe_request(slave->config, 0, 0, 2)) == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failed to create SoE request for slave %s.%s\n", master->name, slave->name);
+    return -EIO;
+  }
+  if ((soe->req_32 = ecrt_slave_config_create_soe_request(slave->config, 0, 0, 4)) == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failed to create SoE request for slave %s.%s\n", master->name, slave->name);
+    return -EIO;
+  }
+
+  // export pins
+  if ((err = lcec_pin_newf_list(soe, soe_pins, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
+    return err;
+  }
+
+  // export params
+  if ((err = lcec_param_newf_list(soe, soe_params, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
+    return err;
+  }
+  soe->write_size = 4;
+
+  // setup background sampling
+  soe->chans = chans;
+  soe->chan_count = chan_count;
+  soe->sample_interval = (long long)get_param_u32(slave, LCEC_AX5_PARAM_SOE_SAMPLE_INTERVAL) * 1000000LL;
+  if (soe->sample_interval > 0) {
+    if ((soe->sample_req = ecrt_slave_config_create_soe_request(slave->config, 0, soe_sample_idns[0], 4)) == NULL) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failed to create SoE sample request for slave %s.%s\n", master->name, slave->name);
+      return -EIO;
+    }
+  }
+
+  return 0;
+}
+
+static uint32_t soe_request_value(ec_soe_request_t *req) {
+  uint8_t *data = ecrt_soe_request_data(req);
+
+  switch (ecrt_soe_request_data_size(req)) {
+    case 0:
+      return 0;
+    case 1:
+      return EC_READ_U8(data);
+    case 2:
+    case 3:
+      return EC_READ_U16(data);
+    default:
+      return EC_READ_U32(data);
+  }
+}
+
+static void lcec_class_ax5_soe_sample(lcec_class_ax5_soe_t *soe, long period) {
+  lcec_class_ax5_chan_t *chan;
+  uint32_t value;
+  int idn_idx;
+
+  // wait for the running sample to complete
+  if (soe->sample_busy) {
+    switch (ecrt_soe_request_state(soe->sample_req)) {
+      case EC_REQUEST_BUSY:
+        return;
+      case EC_REQUEST_SUCCESS:
+        chan = &soe->chans[soe->sample_idx / LCEC_AX5_SOE_SAMPLE_IDNS];
+        value = soe_request_value(soe->sample_req);
+        switch (soe->sample_idx % LCEC_AX5_SOE_SAMPLE_IDNS) {
+          case 0:
+            *(chan->soe_diag) = value;
+            break;
+          case 1:
+            *(chan->motor_temp) = ((double)(int16_t)value) * 0.1;
+            break;
+          case 2:
+            *(chan->amp_temp) = ((double)(int16_t)value) * 0.1;
+            break;
+        }
+        break;
+      default:
+        // unsupported IDNs just leave their pins untouched
+        break;
+    }
+    soe->sample_busy = 0;
+    soe->sample_idx++;
+  }
+
+  // start a new round once per interval
+  if (soe->sample_idx >= soe->chan_count * LCEC_AX5_SOE_SAMPLE_IDNS) {
+    soe->sample_timer -= period;
+    if (soe->sample_timer > 0) {
+      return;
+    }
+    soe->sample_timer = soe->sample_interval;
+    soe->sample_idx = 0;
+  }
+
+  // skip channels without sample pins
+  while (soe->sample_idx < soe->chan_count * LCEC_AX5_SOE_SAMPLE_IDNS) {
+    if (soe->chans[soe->sample_idx / LCEC_AX5_SOE_SAMPLE_IDNS].soe_sample_enabled) {
+      break;
+    }
+    soe->sample_idx += LCEC_AX5_SOE_SAMPLE_IDNS;
+  }
+  if (soe->sample_idx >= soe->chan_count * LCEC_AX5_SOE_SAMPLE_IDNS) {
+    return;
+  }
+
+  idn_idx = soe->sample_idx % LCEC_AX5_SOE_SAMPLE_IDNS;
+  ecrt_soe_request_idn(soe->sample_req, soe->sample_idx / LCEC_AX5_SOE_SAMPLE_IDNS, soe_sample_idns[idn_idx]);
+  ecrt_soe_request_read(soe->sample_req);
+  soe->sample_busy = 1;
+}
+
+void lcec_class_ax5_soe_read(struct lcec_slave *slave, lcec_class_ax5_soe_t *soe, long period) {
+  int read_edge, write_edge;
+
+  // detect rising edges
+  read_edge = *(soe->read) && !soe->read_last;
+  write_edge = *(soe->write) && !soe->write_last;
+  soe->read_last = *(soe->read);
+  soe->write_last = *(soe->write);
+
+  // check running request
+  if (soe->active != NULL) {
+    switch (ecrt_soe_request_state(soe->active)) {
+      case EC_REQUEST_BUSY:
+        break;
+      case EC_REQUEST_SUCCESS:
+        if (soe->active_read) {
+          *(soe->data) = soe_request_value(soe->active);
+        }
+        *(soe->error) = 0;
+        soe->active = NULL;
+        break;
+      default:
+        *(soe->error) = 1;
+        soe->active = NULL;
+        break;
+    }
+  }
+
+  // start new request
+  if (soe->active == NULL && (read_edge || write_edge)) {
+    if (read_edge) {
+      soe->active = soe->req_read;
+      ecrt_soe_request_idn(soe->active, *(soe->drive), *(soe->idn));
+      ecrt_soe_request_read(soe->active);
+      soe->active_read = 1;
+    } else {
+      if (soe->write_size == 2) {
+        soe->active = soe->req_16;
+        EC_WRITE_U16(ecrt_soe_request_data(soe->active), *(soe->write_data));
+      } else {
+        soe->active = soe->req_32;
+        EC_WRITE_U32(ecrt_soe_request_data(soe->active), *(soe->write_data));
+      }
+      ecrt_soe_request_idn(soe->active, *(soe->drive), *(soe->idn));
+      ecrt_soe_request_write(soe->active);
+      soe->active_read = 0;
+    }
+  }
+  *(soe->busy) = (soe->active != NULL);
+
+  // background sampling
+  if (soe->sample_req != NULL) {
+    lcec_class_ax5_soe_sample(soe, period);
+  }
+}
@@ -25,8 +25,11 @@
 #include "../lcec.h"
 #include "lcec_class_enc.h"
 
-#define LCEC_AX5_PARAM_ENABLE_FB2  1
-#define LCEC_AX5_PARAM_ENABLE_DIAG 2
+#define LCEC_AX5_PARAM_ENABLE_FB2          1
+#define LCEC_AX5_PARAM_ENABLE_DIAG         2
+#define LCEC_AX5_PARAM_SOE_SAMPLE_INTERVAL 3
+
+#define LCEC_AX5_SOE_SAMPLE_IDNS 3  ///< Number of IDNs sampled per channel.
 
 typedef struct {
   hal_bit_t *enable;
@@ -46,6 +49,11 @@ typedef struct {
   hal_float_t *torque_fb_pct;
   hal_u32_t *diag;
 
+  int soe_sample_enabled;
+  hal_u32_t *soe_diag;
+  hal_float_t *motor_temp;
+  hal_float_t *amp_temp;
+
   unsigned int status_pdo_os;
   unsigned int pos_fb_pdo_os;
   unsigned int pos_fb2_pdo_os;
@@ -73,9 +81,47 @@ typedef struct {
 
 } lcec_class_ax5_chan_t;
 
+/// @brief Non-blocking SoE parameter channel for an AX5xxx slave.
+///
+/// Lets HAL read and write arbitrary IDNs while the drive is in OP,
+/// and optionally samples diagnostic and temperature IDNs for each
+/// channel in the background.  All mailbox traffic is done through
+/// EtherLab SoE request objects, so the RT thread never blocks.
+typedef struct {
+  hal_u32_t *drive;
+  hal_u32_t *idn;
+  hal_u32_t *write_data;
+  hal_bit_t *read;
+  hal_bit_t *write;
+  hal_u32_t *data;
+  hal_bit_t *busy;
+  hal_bit_t *error;
+
+  hal_u32_t write_size;
+
+  ec_soe_request_t *req_read;
+  ec_soe_request_t *req_16;
+  ec_soe_request_t *req_32;
+  ec_soe_request_t *active;
+  int active_read;
+  int read_last;
+  int write_last;
+
+  lcec_class_ax5_chan_t *chans;
+  int chan_count;
+  ec_soe_request_t *sample_req;
+  long long sample_interval;
+  long long sample_timer;
+  int sample_idx;
+  int sample_busy;
+} lcec_class_ax5_soe_t;
+
 int lcec_class_ax5_pdos(struct lcec_slave *slave);
+int lcec_class_ax5_preinit(struct lcec_slave *slave, int index);
 int lcec_class_ax5_init(struct lcec_slave *slave, lcec_class_ax5_chan_t *chan, int index, const char *pfx);
 void lcec_class_ax5_read(struct lcec_slave *slave, lcec_class_ax5_chan_t *chan);
 void lcec_class_ax5_write(struct lcec_slave *slave, lcec_class_ax5_chan_t *chan);
+int lcec_class_ax5_soe_init(struct lcec_slave *slave, lcec_class_ax5_soe_t *soe, lcec_class_ax5_chan_t *chans, int chan_count);
+void lcec_class_ax5_soe_read(struct lcec_slave *slave, lcec_class_ax5_soe_t *soe, long period);
 
 #endif
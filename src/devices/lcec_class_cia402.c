@@ -97,6 +97,12 @@
 #define PDO_IDX_OFFSET_opmode 0x60
 #define PDO_IDX_OFFSET_opmode_display 0x61
 #define PDO_IDX_OFFSET_polarity 0x73
+#define PDO_IDX_OFFSET_probe_function 0xb8
+#define PDO_IDX_OFFSET_probe_status 0xb9
+#define PDO_IDX_OFFSET_probe1_pos 0xba
+#define PDO_IDX_OFFSET_probe1_neg 0xbb
+#define PDO_IDX_OFFSET_probe2_pos 0xbc
+#define PDO_IDX_OFFSET_probe2_neg 0xbd
 #define PDO_IDX_OFFSET_profile_accel 0x83
 #define PDO_IDX_OFFSET_profile_decel 0x84
 #define PDO_IDX_OFFSET_profile_end_velocity 0x82
@@ -107,11 +113,13 @@
 #define PDO_IDX_OFFSET_target_velocity 0xff
 #define PDO_IDX_OFFSET_target_vl 0x42
 #define PDO_IDX_OFFSET_torque_demand 0x74
+#define PDO_IDX_OFFSET_torque_offset 0xb2
 #define PDO_IDX_OFFSET_torque_profile_type 0x88
 #define PDO_IDX_OFFSET_torque_slope 0x87
 #define PDO_IDX_OFFSET_velocity_demand 0x6b
 #define PDO_IDX_OFFSET_velocity_error_time 0x6e
 #define PDO_IDX_OFFSET_velocity_error_window 0x6d
+#define PDO_IDX_OFFSET_velocity_offset 0xb1
 #define PDO_IDX_OFFSET_velocity_sensor_selector 0x61
 #define PDO_IDX_OFFSET_velocity_threshold_time 0x70
 #define PDO_IDX_OFFSET_velocity_threshold_window 0x6f
@@ -151,6 +159,12 @@
 #define PDO_SIDX_opmode  0
 #define PDO_SIDX_opmode_display  0
 #define PDO_SIDX_polarity 0
+#define PDO_SIDX_probe_function 0
+#define PDO_SIDX_probe_status 0
+#define PDO_SIDX_probe1_pos 0
+#define PDO_SIDX_probe1_neg 0
+#define PDO_SIDX_probe2_pos 0
+#define PDO_SIDX_probe2_neg 0
 #define PDO_SIDX_profile_accel  0
 #define PDO_SIDX_profile_decel  0
 #define PDO_SIDX_profile_end_velocity  0
@@ -161,11 +175,13 @@
 #define PDO_SIDX_target_velocity  0
 #define PDO_SIDX_target_vl 0
 #define PDO_SIDX_torque_demand 0
+#define PDO_SIDX_torque_offset 0
 #define PDO_SIDX_torque_profile_type 0
 #define PDO_SIDX_torque_slope 0
 #define PDO_SIDX_velocity_demand 0
 #define PDO_SIDX_velocity_error_time 0
 #define PDO_SIDX_velocity_error_window 0
+#define PDO_SIDX_velocity_offset 0
 #define PDO_SIDX_velocity_sensor_selector 0
 #define PDO_SIDX_velocity_threshold_time 0
 #define PDO_SIDX_velocity_threshold_window 0
@@ -205,6 +221,12 @@
 #define PDO_PIN_TYPE_opmode HAL_S32
 #define PDO_PIN_TYPE_opmode_display HAL_S32
 #define PDO_PIN_TYPE_polarity HAL_U32
+#define PDO_PIN_TYPE_probe_function HAL_U32
+#define PDO_PIN_TYPE_probe_status HAL_U32
+#define PDO_PIN_TYPE_probe1_pos HAL_S32
+#define PDO_PIN_TYPE_probe1_neg HAL_S32
+#define PDO_PIN_TYPE_probe2_pos HAL_S32
+#define PDO_PIN_TYPE_probe2_neg HAL_S32
 #define PDO_PIN_TYPE_profile_accel HAL_U32
 #define PDO_PIN_TYPE_profile_decel HAL_U32
 #define PDO_PIN_TYPE_profile_end_velocity HAL_U32
@@ -215,11 +237,13 @@
 #define PDO_PIN_TYPE_target_velocity HAL_S32
 #define PDO_PIN_TYPE_target_vl HAL_S32
 #define PDO_PIN_TYPE_torque_demand HAL_S32
+#define PDO_PIN_TYPE_torque_offset HAL_S32
 #define PDO_PIN_TYPE_torque_profile_type HAL_S32
 #define PDO_PIN_TYPE_torque_slope HAL_U32
 #define PDO_PIN_TYPE_velocity_demand HAL_S32
 #define PDO_PIN_TYPE_velocity_error_time HAL_U32
 #define PDO_PIN_TYPE_velocity_error_window HAL_U32
+#define PDO_PIN_TYPE_velocity_offset HAL_S32
 #define PDO_PIN_TYPE_velocity_sensor_selector HAL_S32
 #define PDO_PIN_TYPE_velocity_threshold_time HAL_U32
 #define PDO_PIN_TYPE_velocity_threshold_window HAL_U32
@@ -259,6 +283,12 @@
 #define PDO_BITS_opmode 8
 #define PDO_BITS_opmode_display 8
 #define PDO_BITS_polarity 8
+#define PDO_BITS_probe_function 16
+#define PDO_BITS_probe_status 16
+#define PDO_BITS_probe1_pos 32
+#define PDO_BITS_probe1_neg 32
+#define PDO_BITS_probe2_pos 32
+#define PDO_BITS_probe2_neg 32
 #define PDO_BITS_profile_accel 32
 #define PDO_BITS_profile_decel 32
 #define PDO_BITS_profile_end_velocity 32
@@ -269,11 +299,13 @@
 #define PDO_BITS_target_velocity 32
 #define PDO_BITS_target_vl 16
 #define PDO_BITS_torque_demand 16
+#define PDO_BITS_torque_offset 16
 #define PDO_BITS_torque_profile_type 16
 #define PDO_BITS_torque_slope 32
 #define PDO_BITS_velocity_demand 32
 #define PDO_BITS_velocity_error_time 16
 #define PDO_BITS_velocity_error_window 16
+#define PDO_BITS_velocity_offset 32
 #define PDO_BITS_velocity_sensor_selector 16
 #define PDO_BITS_velocity_threshold_time 16
 #define PDO_BITS_velocity_threshold_window 16
@@ -312,6 +344,12 @@
 #define PDO_SIGN_opmode S
 #define PDO_SIGN_opmode_display S
 #define PDO_SIGN_polarity U
+#define PDO_SIGN_probe_function U
+#define PDO_SIGN_probe_status U
+#define PDO_SIGN_probe1_pos S
+#define PDO_SIGN_probe1_neg S
+#define PDO_SIGN_probe2_pos S
+#define PDO_SIGN_probe2_neg S
 #define PDO_SIGN_profile_accel U
 #define PDO_SIGN_profile_decel U
 #define PDO_SIGN_profile_end_velocity U
@@ -322,11 +360,13 @@
 #define PDO_SIGN_target_velocity S
 #define PDO_SIGN_target_vl S
 #define PDO_SIGN_torque_demand S
+#define PDO_SIGN_torque_offset S
 #define PDO_SIGN_torque_profile_type S
 #define PDO_SIGN_torque_slope U
 #define PDO_SIGN_velocity_demand S
 #define PDO_SIGN_velocity_error_time U
 #define PDO_SIGN_velocity_error_window U
+#define PDO_SIGN_velocity_offset S
 #define PDO_SIGN_velocity_sensor_selector S
 #define PDO_SIGN_velocity_threshold_time U
 #define PDO_SIGN_velocity_threshold_window U
@@ -369,6 +409,63 @@ static const lcec_pindesc_t pins_required[] = {
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
 };
 
+/// @brief Pins for the in-driver state machine.
+static const lcec_pindesc_t pins_state_machine[] = {
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, sm_enable), "%s.%s.%s.%s-enable"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, sm_fault_reset), "%s.%s.%s.%s-fault-reset"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, sm_quick_stop), "%s.%s.%s.%s-quick-stop"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_cia402_channel_t, sm_enabled), "%s.%s.%s.%s-enabled"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_cia402_channel_t, sm_fault), "%s.%s.%s.%s-fault"},
+    {HAL_U32, HAL_OUT, offsetof(lcec_class_cia402_channel_t, sm_state), "%s.%s.%s.%s-state"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+/// @brief Pins for the touch probe.
+static const lcec_pindesc_t pins_touch_probe[] = {
+    {HAL_U32, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe_function), "%s.%s.%s.%s-probe-function"},
+    {HAL_U32, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe_status), "%s.%s.%s.%s-probe-status"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, probe1_arm_pos), "%s.%s.%s.%s-probe1-arm-pos"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, probe1_arm_neg), "%s.%s.%s.%s-probe1-arm-neg"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, probe1_index), "%s.%s.%s.%s-probe1-index"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe1_pos_valid), "%s.%s.%s.%s-probe1-pos-valid"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe1_neg_valid), "%s.%s.%s.%s-probe1-neg-valid"},
+    {HAL_S32, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe1_pos), "%s.%s.%s.%s-probe1-pos"},
+    {HAL_S32, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe1_neg), "%s.%s.%s.%s-probe1-neg"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, probe2_arm_pos), "%s.%s.%s.%s-probe2-arm-pos"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, probe2_arm_neg), "%s.%s.%s.%s-probe2-arm-neg"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_cia402_channel_t, probe2_index), "%s.%s.%s.%s-probe2-index"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe2_pos_valid), "%s.%s.%s.%s-probe2-pos-valid"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe2_neg_valid), "%s.%s.%s.%s-probe2-neg-valid"},
+    {HAL_S32, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe2_pos), "%s.%s.%s.%s-probe2-pos"},
+    {HAL_S32, HAL_OUT, offsetof(lcec_class_cia402_channel_t, probe2_neg), "%s.%s.%s.%s-probe2-neg"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+/// @brief Pins for in-driver velocity feed-forward.
+static const lcec_pindesc_t pins_feed_forward[] = {
+    {HAL_FLOAT, HAL_IN, offsetof(lcec_class_cia402_channel_t, ff_velocity_scale), "%s.%s.%s.%s-velocity-ff-scale"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+/// @brief Pins for the secondary position.  The encoder pins themselves come from `class_enc_init()`.
+static const lcec_pindesc_t pins_secondary_position[] = {
+    {HAL_FLOAT, HAL_IN, offsetof(lcec_class_cia402_channel_t, enc2_scale), "%s.%s.%s.%s-enc2-scale"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+// Find the secondary position object: 0x60E4:01 (additional position
+// actual value 1) of the channel, unless the options name a vendor
+// object instead.
+static void lcec_cia402_secondary_position(const lcec_class_cia402_options_t *opt, uint16_t base_idx, uint16_t *idx, uint8_t *sidx) {
+  if (opt->secondary_position_idx != 0) {
+    *idx = opt->secondary_position_idx;
+    *sidx = opt->secondary_position_sidx;
+  } else {
+    *idx = base_idx + 0xe4;
+    *sidx = 1;
+  }
+}
+
 /// @brief Create a new, optional pin for reading, using standardized names.
 #define OPTIONAL_PIN_READ(var_name, pin_name)                                                    \
   static const lcec_pindesc_t pins_##var_name[] = {                                                    \
@@ -427,10 +524,12 @@ OPTIONAL_PIN_WRITE(target_position, "target-position");
 OPTIONAL_PIN_WRITE(target_torque, "target-torque");
 OPTIONAL_PIN_WRITE(target_velocity, "target-velocity");
 OPTIONAL_PIN_WRITE(target_vl, "target-vl");
+OPTIONAL_PIN_WRITE(torque_offset, "torque-offset");
 OPTIONAL_PIN_WRITE(torque_profile_type, "torque-profile-type");
 OPTIONAL_PIN_WRITE(torque_slope, "torque-slope");
 OPTIONAL_PIN_WRITE(velocity_error_time, "velocity-error-time");
 OPTIONAL_PIN_WRITE(velocity_error_window, "velocity-error-window");
+OPTIONAL_PIN_WRITE(velocity_offset, "velocity-offset");
 OPTIONAL_PIN_WRITE(velocity_sensor_selector, "velocity-sensor-selector"); 
 OPTIONAL_PIN_WRITE(velocity_threshold_time, "velocity-threshold-time");
 OPTIONAL_PIN_WRITE(velocity_threshold_window, "velocity-threshold-window");
@@ -439,13 +538,12 @@ OPTIONAL_PIN_WRITE(vl_decel, "vl-decel");
 OPTIONAL_PIN_WRITE(vl_maximum, "vl-maximum");
 OPTIONAL_PIN_WRITE(vl_minimum, "vl-minimum");
 
-/// @brief Create a `lcec_class_cia402_enabled_t` from a
+/// @brief Fill in a `lcec_class_cia402_enabled_t` from a
 /// `lcec_class_cia402_options_t`.
-static lcec_class_cia402_enabled_t *lcec_cia402_enabled(lcec_class_cia402_options_t *opt) {
-  lcec_class_cia402_enabled_t *enabled;
-  enabled = hal_malloc(sizeof(lcec_class_cia402_enabled_t));
-  if (enabled == NULL) return NULL;
-
+///
+/// This is only needed while setting up a channel, so callers keep it
+/// on the stack.
+static void lcec_cia402_enabled(const lcec_class_cia402_options_t *opt, lcec_class_cia402_enabled_t *enabled) {
   memset(enabled, 0, sizeof(lcec_class_cia402_enabled_t));
 
   if (opt->enable_opmode) {
@@ -491,6 +589,17 @@ static lcec_class_cia402_enabled_t *lcec_cia402_enabled(lcec_class_cia402_option
   if (opt->enable_cst) {
     // TODO: add cyclic synchronous torque pins once they're added.
   }
+  if (opt->enable_velocity_feed_forward) {
+    enabled->enable_velocity_offset = 1;
+  }
+  if (opt->enable_touch_probe) {
+    enabled->enable_probe_function = 1;
+    enabled->enable_probe_status = 1;
+    enabled->enable_probe1_pos = 1;
+    enabled->enable_probe1_neg = 1;
+    enabled->enable_probe2_pos = 1;
+    enabled->enable_probe2_neg = 1;
+  }
 
   // Set individual pins in `enabled` using values from `opt`.
 #define ENABLE_OPT(pin_name) \
@@ -525,11 +634,13 @@ static lcec_class_cia402_enabled_t *lcec_cia402_enabled(lcec_class_cia402_option
   ENABLE_OPT(target_torque);
   ENABLE_OPT(target_vl);
   ENABLE_OPT(torque_demand);
+  ENABLE_OPT(torque_offset);
   ENABLE_OPT(torque_profile_type);
   ENABLE_OPT(torque_slope);
   ENABLE_OPT(velocity_demand);
   ENABLE_OPT(velocity_error_time);
   ENABLE_OPT(velocity_error_window);
+  ENABLE_OPT(velocity_offset);
   ENABLE_OPT(velocity_sensor_selector); 
   ENABLE_OPT(velocity_threshold_time);
   ENABLE_OPT(velocity_threshold_window);
@@ -537,8 +648,6 @@ static lcec_class_cia402_enabled_t *lcec_cia402_enabled(lcec_class_cia402_option
   ENABLE_OPT(vl_decel);
   ENABLE_OPT(vl_maximum);
   ENABLE_OPT(vl_minimum);
-  
-  return enabled;
 }
 
 /// @brief Allocate a block of memory for holding the results from
@@ -558,6 +667,7 @@ lcec_class_cia402_channels_t *lcec_cia402_allocate_channels(int count) {
     return NULL;
   }
   channels->count = count;
+  channels->layout_state = 0;
   channels->channels = hal_malloc(sizeof(lcec_class_cia402_channel_t *) * count);
   if (channels->channels == NULL) {
     return NULL;
@@ -639,8 +749,9 @@ lcec_syncs_t *lcec_cia402_init_sync(lcec_class_cia402_options_t *options) {
 /// call `lcec_syncs_add_pdo_info(syncs, 0x1601)` and whichever
 /// `lcec_syncs_add_pdo_entry()` calls you need.
 int lcec_cia402_add_output_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t *options) {
-  lcec_class_cia402_enabled_t *enabled = lcec_cia402_enabled(options);
-  if (enabled == NULL) return -1;
+  lcec_class_cia402_enabled_t enabled_buf, *enabled = &enabled_buf;
+
+  lcec_cia402_enabled(options, enabled);
 
   lcec_syncs_add_sync(syncs, EC_DIR_OUTPUT, EC_WD_DEFAULT);
   lcec_syncs_add_pdo_info(syncs, 0x1600);
@@ -662,6 +773,7 @@ int lcec_cia402_add_output_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
   MAP_OPTIONAL_PDO(motor_rated_torque);
   MAP_OPTIONAL_PDO(opmode);          // Operating mode
   MAP_OPTIONAL_PDO(polarity);
+  MAP_OPTIONAL_PDO(probe_function);
   MAP_OPTIONAL_PDO(profile_accel);
   MAP_OPTIONAL_PDO(profile_decel);
   MAP_OPTIONAL_PDO(profile_end_velocity);
@@ -671,10 +783,12 @@ int lcec_cia402_add_output_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
   MAP_OPTIONAL_PDO(target_torque);
   MAP_OPTIONAL_PDO(target_velocity);
   MAP_OPTIONAL_PDO(target_vl);
+  MAP_OPTIONAL_PDO(torque_offset);
   MAP_OPTIONAL_PDO(torque_profile_type);
   MAP_OPTIONAL_PDO(torque_slope);
   MAP_OPTIONAL_PDO(velocity_error_time);
   MAP_OPTIONAL_PDO(velocity_error_window);
+  MAP_OPTIONAL_PDO(velocity_offset);
   MAP_OPTIONAL_PDO(velocity_sensor_selector); 
   MAP_OPTIONAL_PDO(velocity_threshold_time);
   MAP_OPTIONAL_PDO(velocity_threshold_window);
@@ -693,8 +807,9 @@ int lcec_cia402_add_output_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
 /// 0x1a01)` and whichever `lcec_syncs_add_pdo_entry()` calls you
 /// need.
 int lcec_cia402_add_input_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t *options) {
-  lcec_class_cia402_enabled_t *enabled = lcec_cia402_enabled(options);
-  if (enabled == NULL) return -1;
+  lcec_class_cia402_enabled_t enabled_buf, *enabled = &enabled_buf;
+
+  lcec_cia402_enabled(options, enabled);
 
   lcec_syncs_add_sync(syncs, EC_DIR_INPUT, EC_WD_DEFAULT);
   lcec_syncs_add_pdo_info(syncs, 0x1a00);
@@ -710,12 +825,131 @@ int lcec_cia402_add_input_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
   MAP_OPTIONAL_PDO(demand_vl);
   MAP_OPTIONAL_PDO(digital_input);
   MAP_OPTIONAL_PDO(opmode_display);
+  MAP_OPTIONAL_PDO(probe1_neg);
+  MAP_OPTIONAL_PDO(probe1_pos);
+  MAP_OPTIONAL_PDO(probe2_neg);
+  MAP_OPTIONAL_PDO(probe2_pos);
+  MAP_OPTIONAL_PDO(probe_status);
   MAP_OPTIONAL_PDO(torque_demand);
   MAP_OPTIONAL_PDO(velocity_demand);
 
+  if (options->enable_secondary_position) {
+    uint16_t idx;
+    uint8_t sidx;
+
+    lcec_cia402_secondary_position(options, 0x6000, &idx, &sidx);
+    lcec_syncs_add_pdo_entry(syncs, idx, sidx, 32);
+  }
+
   return 0;
 };
 
+#define LCEC_CIA402_MAX_OPS 64
+
+/// @brief Build `read_ops` and `write_ops` from `enabled`.
+///
+/// This runs once, after pins are registered, so the cyclic functions
+/// don't need to test each optional object every cycle.
+static int lcec_cia402_compile_ops(lcec_class_cia402_channel_t *data, const lcec_class_cia402_enabled_t *enabled) {
+  lcec_class_cia402_op_t ops[LCEC_CIA402_MAX_OPS];
+  int n;
+
+#define ADD_OP(pin_name, op_type)         \
+  do {                                    \
+    ops[n].os = 0;                        \
+    ops[n].type = op_type;                \
+    ops[n].pin = data->pin_name;          \
+    ops[n].os_src = &data->pin_name##_os; \
+    n++;                                  \
+  } while (0)
+#define ADD_OPTIONAL_OP(pin_name) \
+  if (enabled->enable_##pin_name) ADD_OP(pin_name, SUBSTJOIN3(LCEC_CIA402_OP_, PDO_SIGN_##pin_name, PDO_BITS_##pin_name))
+
+  n = 0;
+  ADD_OP(statusword, LCEC_CIA402_OP_U16);
+  ADD_OPTIONAL_OP(actual_current);
+  ADD_OPTIONAL_OP(actual_following_error);
+  ADD_OPTIONAL_OP(actual_position);
+  ADD_OPTIONAL_OP(actual_torque);
+  ADD_OPTIONAL_OP(actual_velocity);
+  ADD_OPTIONAL_OP(actual_velocity_sensor);
+  ADD_OPTIONAL_OP(actual_vl);
+  ADD_OPTIONAL_OP(actual_voltage);
+  ADD_OPTIONAL_OP(demand_vl);
+  ADD_OPTIONAL_OP(opmode_display);
+  ADD_OPTIONAL_OP(probe1_neg);
+  ADD_OPTIONAL_OP(probe1_pos);
+  ADD_OPTIONAL_OP(probe2_neg);
+  ADD_OPTIONAL_OP(probe2_pos);
+  ADD_OPTIONAL_OP(probe_status);
+  ADD_OPTIONAL_OP(torque_demand);
+  ADD_OPTIONAL_OP(velocity_demand);
+
+  data->read_ops = hal_malloc(sizeof(lcec_class_cia402_op_t) * n);
+  if (data->read_ops == NULL) return -ENOMEM;
+  memcpy(data->read_ops, ops, sizeof(lcec_class_cia402_op_t) * n);
+  data->read_op_count = n;
+
+  n = 0;
+  ADD_OP(controlword, LCEC_CIA402_OP_U16);
+  if (data->options->enable_state_machine) {
+    ops[n - 1].pin = &data->sm_controlword;
+  }
+  ADD_OPTIONAL_OP(following_error_timeout);
+  ADD_OPTIONAL_OP(following_error_window);
+  ADD_OPTIONAL_OP(home_accel);
+  ADD_OPTIONAL_OP(home_method);
+  ADD_OPTIONAL_OP(home_velocity_fast);
+  ADD_OPTIONAL_OP(home_velocity_slow);
+  ADD_OPTIONAL_OP(interpolation_time_period);
+  ADD_OPTIONAL_OP(maximum_acceleration);
+  ADD_OPTIONAL_OP(maximum_current);
+  ADD_OPTIONAL_OP(maximum_deceleration);
+  ADD_OPTIONAL_OP(maximum_motor_rpm);
+  ADD_OPTIONAL_OP(maximum_torque);
+  ADD_OPTIONAL_OP(motion_profile);
+  ADD_OPTIONAL_OP(motor_rated_current);
+  ADD_OPTIONAL_OP(motor_rated_torque);
+  ADD_OPTIONAL_OP(opmode);
+  ADD_OPTIONAL_OP(polarity);
+  ADD_OPTIONAL_OP(probe_function);
+  ADD_OPTIONAL_OP(profile_accel);
+  ADD_OPTIONAL_OP(profile_decel);
+  ADD_OPTIONAL_OP(profile_end_velocity);
+  ADD_OPTIONAL_OP(profile_max_velocity);
+  ADD_OPTIONAL_OP(profile_velocity);
+  ADD_OPTIONAL_OP(target_position);
+  if (data->options->enable_state_machine && enabled->enable_target_position && enabled->enable_actual_position) {
+    ops[n - 1].pin = &data->sm_target_position;
+  }
+  ADD_OPTIONAL_OP(target_torque);
+  ADD_OPTIONAL_OP(target_velocity);
+  ADD_OPTIONAL_OP(target_vl);
+  ADD_OPTIONAL_OP(torque_offset);
+  ADD_OPTIONAL_OP(torque_profile_type);
+  ADD_OPTIONAL_OP(torque_slope);
+  ADD_OPTIONAL_OP(velocity_error_time);
+  ADD_OPTIONAL_OP(velocity_error_window);
+  ADD_OPTIONAL_OP(velocity_offset);
+  if (data->options->enable_velocity_feed_forward) {
+    ops[n - 1].pin = &data->ff_velocity_offset;
+  }
+  ADD_OPTIONAL_OP(velocity_sensor_selector);
+  ADD_OPTIONAL_OP(velocity_threshold_time);
+  ADD_OPTIONAL_OP(velocity_threshold_window);
+  ADD_OPTIONAL_OP(vl_accel);
+  ADD_OPTIONAL_OP(vl_decel);
+  ADD_OPTIONAL_OP(vl_maximum);
+  ADD_OPTIONAL_OP(vl_minimum);
+
+  data->write_ops = hal_malloc(sizeof(lcec_class_cia402_op_t) * n);
+  if (data->write_ops == NULL) return -ENOMEM;
+  memcpy(data->write_ops, ops, sizeof(lcec_class_cia402_op_t) * n);
+  data->write_op_count = n;
+
+  return 0;
+}
+
 /// @brief Register a new CiA 402 channel.
 ///
 /// This creates a new CiA 402 channel, which is basically a single
@@ -734,7 +968,8 @@ int lcec_cia402_add_input_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
 lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *slave, uint16_t base_idx, lcec_class_cia402_options_t *opt) {
   lcec_class_cia402_channel_t *data;
   int err;
-  lcec_class_cia402_enabled_t *enabled;
+  lcec_class_cia402_enabled_t enabled_buf, *enabled = &enabled_buf;
+  lcec_pinbuilder_t pb;
 
   // The default name depends on the port type.
   char *name_prefix = "srv";
@@ -762,13 +997,9 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
   // Save important options for later use.  None of the _idx/_sidx will be needed outside of this function.
   data->options = opt;
 
-  // Set the `enabled` struct from `opt`.
-  enabled = lcec_cia402_enabled(opt);
-  if (enabled == NULL) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s failed\n", slave->master->name, slave->name);
-    return NULL;
-  }
-  data->enabled = enabled;
+  // Set the `enabled` struct from `opt`.  Everything that needs it
+  // afterwards is compiled into the op lists below.
+  lcec_cia402_enabled(opt, enabled);
 
   // Register PDOs
   lcec_pdo_init(slave, base_idx + 0x40, 0, &data->controlword_os, NULL);
@@ -804,6 +1035,12 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
   INIT_OPTIONAL_PDO(opmode);
   INIT_OPTIONAL_PDO(opmode_display);
   INIT_OPTIONAL_PDO(polarity);
+  INIT_OPTIONAL_PDO(probe1_neg);
+  INIT_OPTIONAL_PDO(probe1_pos);
+  INIT_OPTIONAL_PDO(probe2_neg);
+  INIT_OPTIONAL_PDO(probe2_pos);
+  INIT_OPTIONAL_PDO(probe_function);
+  INIT_OPTIONAL_PDO(probe_status);
   INIT_OPTIONAL_PDO(profile_accel);
   INIT_OPTIONAL_PDO(profile_decel);
   INIT_OPTIONAL_PDO(profile_end_velocity);
@@ -813,12 +1050,14 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
   INIT_OPTIONAL_PDO(target_torque);
   INIT_OPTIONAL_PDO(target_velocity);
   INIT_OPTIONAL_PDO(target_vl);
+  INIT_OPTIONAL_PDO(torque_offset);
   INIT_OPTIONAL_PDO(torque_demand);
   INIT_OPTIONAL_PDO(torque_profile_type);
   INIT_OPTIONAL_PDO(torque_slope);
   INIT_OPTIONAL_PDO(velocity_demand); 
   INIT_OPTIONAL_PDO(velocity_error_time);
   INIT_OPTIONAL_PDO(velocity_error_window);
+  INIT_OPTIONAL_PDO(velocity_offset);
   INIT_OPTIONAL_PDO(velocity_sensor_selector); 
   INIT_OPTIONAL_PDO(velocity_threshold_time);
   INIT_OPTIONAL_PDO(velocity_threshold_window);
@@ -827,19 +1066,32 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
   INIT_OPTIONAL_PDO(vl_maximum);
   INIT_OPTIONAL_PDO(vl_minimum);
 
-  // Register pins
-  err = lcec_pin_newf_list(data, pins_required, LCEC_MODULE_NAME, slave->master->name, slave->name, name_prefix);
+  if (opt->enable_secondary_position) {
+    uint16_t idx;
+    uint8_t sidx;
+
+    lcec_cia402_secondary_position(opt, base_idx, &idx, &sidx);
+    lcec_pdo_init(slave, idx, sidx, &data->secondary_position_os, NULL);
+  }
+
+  // Register pins.  Every table below shares the same
+  // `lcec.<master>.<slave>.<name_prefix>` prefix, so only format it once.
+  err = lcec_pinbuilder_init(&pb, slave, name_prefix);
+  if (err != 0) {
+    return NULL;
+  }
+  err = lcec_pinbuilder_pin_list(&pb, data, pins_required);
   if (err != 0) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_pin_newf_list for slave %s.%s failed\n", slave->master->name, slave->name);
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "registering pins for slave %s.%s failed\n", slave->master->name, slave->name);
     return NULL;
   }
 
 #define REGISTER_OPTIONAL_PINS(pin_name)                                                                                              \
   do {                                                                                                                                \
     if (enabled->enable_##pin_name) {                                                                                                 \
-      err = lcec_pin_newf_list(data, pins_##pin_name, LCEC_MODULE_NAME, slave->master->name, slave->name, name_prefix);               \
+      err = lcec_pinbuilder_pin_list(&pb, data, pins_##pin_name);                                                                     \
       if (err != 0) {                                                                                                                 \
-        rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_pin_newf_list for slave %s.%s failed\n", slave->master->name, slave->name); \
+        rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "registering pins for slave %s.%s failed\n", slave->master->name, slave->name);   \
         return NULL;                                                                                                                  \
       }                                                                                                                               \
     }                                                                                                                                 \
@@ -882,12 +1134,14 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
   REGISTER_OPTIONAL_PINS(target_torque);
   REGISTER_OPTIONAL_PINS(target_velocity);
   REGISTER_OPTIONAL_PINS(target_vl);
+  REGISTER_OPTIONAL_PINS(torque_offset);
   REGISTER_OPTIONAL_PINS(torque_demand);
   REGISTER_OPTIONAL_PINS(torque_profile_type);
   REGISTER_OPTIONAL_PINS(torque_slope);
   REGISTER_OPTIONAL_PINS(velocity_demand);
   REGISTER_OPTIONAL_PINS(velocity_error_time);
   REGISTER_OPTIONAL_PINS(velocity_error_window);
+  REGISTER_OPTIONAL_PINS(velocity_offset);
   REGISTER_OPTIONAL_PINS(velocity_sensor_selector); 
   REGISTER_OPTIONAL_PINS(velocity_threshold_time);
   REGISTER_OPTIONAL_PINS(velocity_threshold_window);
@@ -896,6 +1150,58 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
   REGISTER_OPTIONAL_PINS(vl_maximum);
   REGISTER_OPTIONAL_PINS(vl_minimum);
 
+  if (opt->enable_state_machine) {
+    err = lcec_pinbuilder_pin_list(&pb, data, pins_state_machine);
+    if (err != 0) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "registering pins for slave %s.%s failed\n", slave->master->name, slave->name);
+      return NULL;
+    }
+    data->sm_fault_reset_time =
+        (long long)(opt->fault_reset_time ? opt->fault_reset_time : LCEC_CIA402_FAULT_RESET_TIME_DEFAULT) * 1000000LL;
+  }
+
+  if (opt->enable_touch_probe) {
+    err = lcec_pinbuilder_pin_list(&pb, data, pins_touch_probe);
+    if (err != 0) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "registering pins for slave %s.%s failed\n", slave->master->name, slave->name);
+      return NULL;
+    }
+  }
+
+  if (opt->enable_velocity_feed_forward) {
+    err = lcec_pinbuilder_pin_list(&pb, data, pins_feed_forward);
+    if (err != 0) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "registering pins for slave %s.%s failed\n", slave->master->name, slave->name);
+      return NULL;
+    }
+    *(data->ff_velocity_scale) = 1.0;
+  }
+
+  if (opt->enable_secondary_position) {
+    char enc_prefix[LCEC_CONF_STR_MAXLEN];
+
+    err = lcec_pinbuilder_pin_list(&pb, data, pins_secondary_position);
+    if (err != 0) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "registering pins for slave %s.%s failed\n", slave->master->name, slave->name);
+      return NULL;
+    }
+    *(data->enc2_scale) = 1.0;
+
+    // class_enc keeps its parameters in the same struct as its pins, so it needs HAL memory.
+    data->enc2 = hal_malloc(sizeof(lcec_class_enc_data_t));
+    if (data->enc2 == NULL) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s failed\n", slave->master->name, slave->name);
+      return NULL;
+    }
+    memset(data->enc2, 0, sizeof(lcec_class_enc_data_t));
+
+    snprintf(enc_prefix, sizeof(enc_prefix), "%s-enc2", name_prefix);
+    if (class_enc_init(slave, data->enc2, 32, enc_prefix) != 0) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "registering pins for slave %s.%s failed\n", slave->master->name, slave->name);
+      return NULL;
+    }
+  }
+
   // Set default values for pins here.
   uint32_t modes;
   lcec_read_sdo32(slave, base_idx + 0x502, 0, &modes);
@@ -963,9 +1269,358 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
   SET_OPTIONAL_DEFAULTS(vl_maximum);
   SET_OPTIONAL_DEFAULTS(vl_minimum);
 
+  if (lcec_cia402_compile_ops(data, enabled) != 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s failed\n", slave->master->name, slave->name);
+    return NULL;
+  }
+
   return data;
 }
 
+// Fill in each op's `os` from `os_src`.  This can't happen in
+// `lcec_cia402_compile_ops()`, because PDO offsets are only assigned
+// when the master registers its domain.
+static void lcec_cia402_resolve_ops(lcec_class_cia402_channel_t *data) {
+  int i;
+
+  for (i = 0; i < data->read_op_count; i++) {
+    if (data->read_ops[i].os_src != NULL) data->read_ops[i].os = *(data->read_ops[i].os_src);
+  }
+  for (i = 0; i < data->write_op_count; i++) {
+    if (data->write_ops[i].os_src != NULL) data->write_ops[i].os = *(data->write_ops[i].os_src);
+  }
+  data->ops_resolved = 1;
+}
+
+/// @brief Copy process data into pins, using a compiled op list.
+void lcec_cia402_run_read_ops(uint8_t *pd, const lcec_class_cia402_op_t *ops, int count) {
+  const lcec_class_cia402_op_t *op, *end;
+
+  for (op = ops, end = ops + count; op < end; op++) {
+    switch (op->type) {
+      case LCEC_CIA402_OP_U8:
+        *(hal_u32_t *)op->pin = EC_READ_U8(&pd[op->os]);
+        break;
+      case LCEC_CIA402_OP_S8:
+        *(hal_s32_t *)op->pin = EC_READ_S8(&pd[op->os]);
+        break;
+      case LCEC_CIA402_OP_U16:
+        *(hal_u32_t *)op->pin = EC_READ_U16(&pd[op->os]);
+        break;
+      case LCEC_CIA402_OP_S16:
+        *(hal_s32_t *)op->pin = EC_READ_S16(&pd[op->os]);
+        break;
+      case LCEC_CIA402_OP_U32:
+        *(hal_u32_t *)op->pin = EC_READ_U32(&pd[op->os]);
+        break;
+      case LCEC_CIA402_OP_S32:
+        *(hal_s32_t *)op->pin = EC_READ_S32(&pd[op->os]);
+        break;
+    }
+  }
+}
+
+/// @brief Copy pins into process data, using a compiled op list.
+///
+/// Signedness doesn't matter when writing, values are just truncated
+/// to the object's width.
+void lcec_cia402_run_write_ops(uint8_t *pd, const lcec_class_cia402_op_t *ops, int count) {
+  const lcec_class_cia402_op_t *op, *end;
+
+  for (op = ops, end = ops + count; op < end; op++) {
+    switch (op->type) {
+      case LCEC_CIA402_OP_U8:
+      case LCEC_CIA402_OP_S8:
+        EC_WRITE_U8(&pd[op->os], (uint8_t)(*(hal_u32_t *)op->pin));
+        break;
+      case LCEC_CIA402_OP_U16:
+      case LCEC_CIA402_OP_S16:
+        EC_WRITE_U16(&pd[op->os], (uint16_t)(*(hal_u32_t *)op->pin));
+        break;
+      case LCEC_CIA402_OP_U32:
+      case LCEC_CIA402_OP_S32:
+        EC_WRITE_U32(&pd[op->os], *(hal_u32_t *)op->pin);
+        break;
+    }
+  }
+}
+
+/// @brief Decode the power state machine's state from a statusword.
+uint32_t lcec_cia402_decode_state(uint16_t statusword) {
+  if ((statusword & 0x4f) == 0x40) return LCEC_CIA402_STATE_SWITCH_ON_DISABLED;
+  if ((statusword & 0x6f) == 0x21) return LCEC_CIA402_STATE_READY;
+  if ((statusword & 0x6f) == 0x23) return LCEC_CIA402_STATE_SWITCHED_ON;
+  if ((statusword & 0x6f) == 0x27) return LCEC_CIA402_STATE_OPERATION_ENABLED;
+  if ((statusword & 0x6f) == 0x07) return LCEC_CIA402_STATE_QUICK_STOP_ACTIVE;
+  if ((statusword & 0x4f) == 0x0f) return LCEC_CIA402_STATE_FAULT_REACTION;
+  if ((statusword & 0x4f) == 0x08) return LCEC_CIA402_STATE_FAULT;
+  return LCEC_CIA402_STATE_NOT_READY;
+}
+
+/// @brief Pick the controlword command that moves the drive towards the requested state.
+///
+/// Fault reset isn't handled here, as it needs a pulse.  Returns one
+/// of the `LCEC_CIA402_CW_*` commands.
+uint16_t lcec_cia402_next_controlword(uint32_t state, int enable, int quick_stop) {
+  switch (state) {
+    case LCEC_CIA402_STATE_FAULT:
+    case LCEC_CIA402_STATE_FAULT_REACTION:
+    case LCEC_CIA402_STATE_NOT_READY:
+      return LCEC_CIA402_CW_DISABLE_VOLTAGE;
+  }
+
+  if (quick_stop) return LCEC_CIA402_CW_QUICK_STOP;
+
+  // leaving "quick stop active" always goes through "switch on disabled"
+  if (state == LCEC_CIA402_STATE_QUICK_STOP_ACTIVE) return LCEC_CIA402_CW_DISABLE_VOLTAGE;
+
+  if (!enable) return LCEC_CIA402_CW_SHUTDOWN;
+
+  switch (state) {
+    case LCEC_CIA402_STATE_SWITCH_ON_DISABLED:
+      return LCEC_CIA402_CW_SHUTDOWN;
+    case LCEC_CIA402_STATE_READY:
+      return LCEC_CIA402_CW_SWITCH_ON;
+    default:
+      return LCEC_CIA402_CW_ENABLE_OPERATION;
+  }
+}
+
+/// @brief Build one probe's half of the touch probe function (0x60B8).
+///
+/// The probe is enabled in single-trigger mode while either edge is
+/// armed, so it latches the first matching edge and then holds it.
+/// Dropping both arm inputs disables the probe and clears the latch;
+/// arming again starts over.  For probe 2, shift the result left by 8.
+uint16_t lcec_cia402_probe_function(int arm_pos, int arm_neg, int index) {
+  uint16_t fn = 0;
+
+  if (!arm_pos && !arm_neg) return 0;
+
+  fn = LCEC_CIA402_PROBE_FN_ENABLE;
+  if (index) fn |= LCEC_CIA402_PROBE_FN_INDEX;
+  if (arm_pos) fn |= LCEC_CIA402_PROBE_FN_POS_EDGE;
+  if (arm_neg) fn |= LCEC_CIA402_PROBE_FN_NEG_EDGE;
+  return fn;
+}
+
+/// @brief Compute a velocity offset from two successive target positions.
+///
+/// Returns the velocity implied by moving from `last_position` to
+/// `position` in `period` ns, in position units per second times
+/// `scale`.  Positions are allowed to wrap.
+int32_t lcec_cia402_velocity_feed_forward(int32_t position, int32_t last_position, long period, double scale) {
+  int32_t delta = (int32_t)((uint32_t)position - (uint32_t)last_position);
+  double vel;
+
+  if (period <= 0) return 0;
+
+  vel = (double)delta * 1e9 / (double)period * scale;
+  if (vel > (double)INT32_MAX) return INT32_MAX;
+  if (vel < (double)INT32_MIN) return INT32_MIN;
+  return (int32_t)(vel < 0 ? vel - 0.5 : vel + 0.5);
+}
+
+// Compute the velocity offset for a channel with in-driver
+// feed-forward enabled.  The `velocity-offset` pin is added on top.
+static void lcec_cia402_run_feed_forward(lcec_class_cia402_channel_t *data, long period) {
+  int32_t position;
+  int32_t ff = 0;
+
+  if (data->target_position == NULL) {
+    data->ff_velocity_offset = *(data->velocity_offset);
+    return;
+  }
+
+  // use the position actually sent, which the state machine may have replaced
+  if (data->options->enable_state_machine && data->actual_position != NULL) {
+    position = data->sm_target_position;
+  } else {
+    position = *(data->target_position);
+  }
+
+  if (data->ff_last_valid) {
+    ff = lcec_cia402_velocity_feed_forward(position, data->ff_last_position, period, *(data->ff_velocity_scale));
+  }
+  data->ff_last_position = position;
+  data->ff_last_valid = 1;
+
+  data->ff_velocity_offset = ff + *(data->velocity_offset);
+}
+
+// Compute the controlword (and, while disabled, the target position)
+// for a channel with the in-driver state machine enabled.
+static void lcec_cia402_run_state_machine(lcec_class_cia402_channel_t *data, long period) {
+  uint32_t state = *(data->sm_state);
+  int reset = *(data->sm_fault_reset);
+  uint16_t cw;
+
+  if (reset && !data->sm_fault_reset_last && state == LCEC_CIA402_STATE_FAULT) {
+    data->sm_fault_reset_timer = data->sm_fault_reset_time;
+  }
+  data->sm_fault_reset_last = reset;
+
+  if (data->sm_fault_reset_timer > 0) {
+    data->sm_fault_reset_timer -= period;
+    cw = LCEC_CIA402_CW_FAULT_RESET;
+  } else {
+    cw = lcec_cia402_next_controlword(state, *(data->sm_enable), *(data->sm_quick_stop));
+  }
+
+  // mode-specific bits still come from the controlword pin
+  data->sm_controlword = (*(data->controlword) & ~LCEC_CIA402_CW_MASK) | cw;
+
+  // follow the actual position until enabled, so enabling doesn't jump
+  if (data->target_position != NULL && data->actual_position != NULL) {
+    data->sm_target_position = (state == LCEC_CIA402_STATE_OPERATION_ENABLED) ? *(data->target_position) : *(data->actual_position);
+  }
+}
+
+/// @brief Check whether all channels can share channel 0's op lists.
+///
+/// This is true when every channel has the same ops, in the same
+/// order, and each channel's objects sit at a constant distance from
+/// channel 0's.  Sets each channel's `read_base` and `write_base` to
+/// that distance.  Resolves op offsets, so it must not be called
+/// before the master has registered its domain.
+///
+/// @return 1 if the layout can be shared, -1 if not.
+int lcec_cia402_check_layout(lcec_class_cia402_channels_t *channels) {
+  lcec_class_cia402_channel_t *first = channels->channels[0];
+  int c, i;
+
+  for (c = 0; c < channels->count; c++) {
+    if (!channels->channels[c]->ops_resolved) lcec_cia402_resolve_ops(channels->channels[c]);
+  }
+
+  if (channels->count < 2) return -1;
+
+  for (c = 1; c < channels->count; c++) {
+    lcec_class_cia402_channel_t *data = channels->channels[c];
+
+    if (data->read_op_count != first->read_op_count || data->write_op_count != first->write_op_count) return -1;
+
+    data->read_base = (int)data->read_ops[0].os - (int)first->read_ops[0].os;
+    for (i = 0; i < data->read_op_count; i++) {
+      if (data->read_ops[i].type != first->read_ops[i].type) return -1;
+      if ((int)data->read_ops[i].os - (int)first->read_ops[i].os != data->read_base) return -1;
+    }
+
+    data->write_base = (int)data->write_ops[0].os - (int)first->write_ops[0].os;
+    for (i = 0; i < data->write_op_count; i++) {
+      if (data->write_ops[i].type != first->write_ops[i].type) return -1;
+      if ((int)data->write_ops[i].os - (int)first->write_ops[i].os != data->write_base) return -1;
+    }
+  }
+
+  return 1;
+}
+
+/// @brief Copy process data into pins for all channels, using channel 0's op list.
+///
+/// Only valid once `lcec_cia402_check_layout()` has returned 1.
+void lcec_cia402_run_read_ops_shared(uint8_t *pd, lcec_class_cia402_channels_t *channels) {
+  lcec_class_cia402_channel_t **chans = channels->channels;
+  const lcec_class_cia402_op_t *ops = chans[0]->read_ops;
+  int count = channels->count;
+  int c, i;
+
+#define READ_ALL_CHANNELS(pin_type, read_fn)                                                    \
+  for (c = 0; c < count; c++) {                                                                 \
+    *(pin_type *)chans[c]->read_ops[i].pin = read_fn(&pd[(int)ops[i].os + chans[c]->read_base]); \
+  }                                                                                             \
+  break
+
+  for (i = 0; i < chans[0]->read_op_count; i++) {
+    switch (ops[i].type) {
+      case LCEC_CIA402_OP_U8:
+        READ_ALL_CHANNELS(hal_u32_t, EC_READ_U8);
+      case LCEC_CIA402_OP_S8:
+        READ_ALL_CHANNELS(hal_s32_t, EC_READ_S8);
+      case LCEC_CIA402_OP_U16:
+        READ_ALL_CHANNELS(hal_u32_t, EC_READ_U16);
+      case LCEC_CIA402_OP_S16:
+        READ_ALL_CHANNELS(hal_s32_t, EC_READ_S16);
+      case LCEC_CIA402_OP_U32:
+        READ_ALL_CHANNELS(hal_u32_t, EC_READ_U32);
+      case LCEC_CIA402_OP_S32:
+        READ_ALL_CHANNELS(hal_s32_t, EC_READ_S32);
+    }
+  }
+}
+
+/// @brief Copy pins into process data for all channels, using channel 0's op list.
+///
+/// Only valid once `lcec_cia402_check_layout()` has returned 1.
+void lcec_cia402_run_write_ops_shared(uint8_t *pd, lcec_class_cia402_channels_t *channels) {
+  lcec_class_cia402_channel_t **chans = channels->channels;
+  const lcec_class_cia402_op_t *ops = chans[0]->write_ops;
+  int count = channels->count;
+  int c, i;
+
+#define WRITE_ALL_CHANNELS(value_type, write_fn)                                                                     \
+  for (c = 0; c < count; c++) {                                                                                      \
+    write_fn(&pd[(int)ops[i].os + chans[c]->write_base], (value_type)(*(hal_u32_t *)chans[c]->write_ops[i].pin)); \
+  }                                                                                                                  \
+  break
+
+  for (i = 0; i < chans[0]->write_op_count; i++) {
+    switch (ops[i].type) {
+      case LCEC_CIA402_OP_U8:
+      case LCEC_CIA402_OP_S8:
+        WRITE_ALL_CHANNELS(uint8_t, EC_WRITE_U8);
+      case LCEC_CIA402_OP_U16:
+      case LCEC_CIA402_OP_S16:
+        WRITE_ALL_CHANNELS(uint16_t, EC_WRITE_U16);
+      case LCEC_CIA402_OP_U32:
+      case LCEC_CIA402_OP_S32:
+        WRITE_ALL_CHANNELS(uint32_t, EC_WRITE_U32);
+    }
+  }
+}
+
+// Update pins that are derived from the channel's inputs.
+static void lcec_cia402_read_post(uint8_t *pd, lcec_class_cia402_channel_t *data) {
+  uint32_t state;
+
+  if (data->enc2 != NULL) {
+    // 0x60E4 has no reference mark, so there is no singleturn period to home to
+    class_enc_update(data->enc2, 0, *(data->enc2_scale), EC_READ_U32(&pd[data->secondary_position_os]), 0, 0);
+  }
+
+  if (data->options->enable_state_machine) {
+    state = lcec_cia402_decode_state(*(data->statusword));
+    *(data->sm_state) = state;
+    *(data->sm_enabled) = (state == LCEC_CIA402_STATE_OPERATION_ENABLED);
+    *(data->sm_fault) = (state == LCEC_CIA402_STATE_FAULT || state == LCEC_CIA402_STATE_FAULT_REACTION);
+  }
+
+  if (data->options->enable_touch_probe) {
+    uint32_t status = *(data->probe_status);
+    uint32_t fn = *(data->probe_function);
+
+    // Only trust the stored bits for edges we asked for.
+    *(data->probe1_pos_valid) = (fn & LCEC_CIA402_PROBE_FN_POS_EDGE) && (status & LCEC_CIA402_PROBE_ST_POS_STORED);
+    *(data->probe1_neg_valid) = (fn & LCEC_CIA402_PROBE_FN_NEG_EDGE) && (status & LCEC_CIA402_PROBE_ST_NEG_STORED);
+    *(data->probe2_pos_valid) = (fn & (LCEC_CIA402_PROBE_FN_POS_EDGE << 8)) && (status & (LCEC_CIA402_PROBE_ST_POS_STORED << 8));
+    *(data->probe2_neg_valid) = (fn & (LCEC_CIA402_PROBE_FN_NEG_EDGE << 8)) && (status & (LCEC_CIA402_PROBE_ST_NEG_STORED << 8));
+  }
+}
+
+// Compute values that the driver sends in place of pins.
+static void lcec_cia402_write_pre(lcec_class_cia402_channel_t *data, long period) {
+  if (data->options->enable_state_machine) {
+    lcec_cia402_run_state_machine(data, period);
+  }
+  if (data->options->enable_velocity_feed_forward) {
+    lcec_cia402_run_feed_forward(data, period);
+  }
+  if (data->options->enable_touch_probe) {
+    *(data->probe_function) = lcec_cia402_probe_function(*(data->probe1_arm_pos), *(data->probe1_arm_neg), *(data->probe1_index)) |
+                              lcec_cia402_probe_function(*(data->probe2_arm_pos), *(data->probe2_arm_neg), *(data->probe2_index)) << 8;
+  }
+}
+
 /// @brief Reads data from a single CiA 402 channel (one axis).
 ///
 /// @param slave The `slave`, passed from the per-device `_read`.
@@ -974,24 +1629,9 @@ lcec_class_cia402_channel_t *lcec_cia402_register_channel(struct lcec_slave *sla
 /// Call this once per channel registered, from inside of your device's
 /// read function.  Use `lcec_cia402_read_all` to read all channels.
 void lcec_cia402_read(struct lcec_slave *slave, lcec_class_cia402_channel_t *data) {
-  uint8_t *pd = slave->master->process_data;
-
-#define READ_OPT(pin_name) \
-  if (data->enabled->enable_##pin_name) *(data->pin_name) = (SUBSTJOIN3(EC_READ_, PDO_SIGN_##pin_name, PDO_BITS_##pin_name) (&pd[data->pin_name##_os]))
-
-  *(data->statusword) = EC_READ_U16(&pd[data->statusword_os]);
-  READ_OPT(actual_current);
-  READ_OPT(actual_following_error);
-  READ_OPT(actual_position);
-  READ_OPT(actual_torque);
-  READ_OPT(actual_velocity);
-  READ_OPT(actual_velocity_sensor);
-  READ_OPT(actual_vl);
-  READ_OPT(actual_voltage);
-  READ_OPT(demand_vl);
-  READ_OPT(opmode_display);
-  READ_OPT(torque_demand);
-  READ_OPT(velocity_demand);
+  if (!data->ops_resolved) lcec_cia402_resolve_ops(data);
+  lcec_cia402_run_read_ops(slave->master->process_data, data->read_ops, data->read_op_count);
+  lcec_cia402_read_post(slave->master->process_data, data);
 }
 
 /// @brief Reads data from all CiA 402 input ports.
@@ -999,56 +1639,29 @@ void lcec_cia402_read(struct lcec_slave *slave, lcec_class_cia402_channel_t *dat
 /// @param slave The `slave`, passed from the per-device `_read`.
 /// @param channels An `lcec_class_cia402_channel_t *`, as returned by lcec_cia402_register_channel.
 void lcec_cia402_read_all(struct lcec_slave *slave, lcec_class_cia402_channels_t *channels) {
+  if (channels->layout_state == 0) channels->layout_state = lcec_cia402_check_layout(channels);
+
+  if (channels->layout_state > 0) {
+    lcec_cia402_run_read_ops_shared(slave->master->process_data, channels);
+    for (int i = 0; i < channels->count; i++) {
+      lcec_cia402_read_post(slave->master->process_data, channels->channels[i]);
+    }
+    return;
+  }
+
   for (int i = 0; i < channels->count; i++) {
     lcec_cia402_read(slave, channels->channels[i]);
   }
 }
 
+/// @brief Writes data to a single CiA 402 channel (one axis).
+///
+/// @param slave The `slave`, passed from the per-device `_write`.
+/// @param data  Which channel to write; a `lcec_class_cia402_channel_t *`, as returned by lcec_cia402_register_channel.
 void lcec_cia402_write(struct lcec_slave *slave, lcec_class_cia402_channel_t *data) {
-  uint8_t *pd = slave->master->process_data;
-
-#define WRITE_OPT(name) \
-  if (data->enabled->enable_##name) SUBSTJOIN3(EC_WRITE_, PDO_SIGN_##name, PDO_BITS_##name) (&pd[data->name##_os], *(data->name))
-
-  EC_WRITE_U16(&pd[data->controlword_os], (uint16_t)(*(data->controlword)));
-  WRITE_OPT(following_error_timeout);
-  WRITE_OPT(following_error_window);
-  WRITE_OPT(home_accel);
-  WRITE_OPT(home_method);
-  WRITE_OPT(home_velocity_fast);
-  WRITE_OPT(home_velocity_slow);
-  WRITE_OPT(interpolation_time_period);
-  WRITE_OPT(maximum_acceleration);
-  WRITE_OPT(maximum_current);
-  WRITE_OPT(maximum_deceleration);
-  WRITE_OPT(maximum_motor_rpm);
-  WRITE_OPT(maximum_torque);
-  WRITE_OPT(motion_profile);
-  WRITE_OPT(motor_rated_current);
-  WRITE_OPT(motor_rated_torque);
-  WRITE_OPT(opmode);
-  WRITE_OPT(polarity);
-  WRITE_OPT(profile_accel);
-  WRITE_OPT(profile_decel);
-  WRITE_OPT(profile_end_velocity);
-  WRITE_OPT(profile_max_velocity);
-  WRITE_OPT(profile_velocity);
-  WRITE_OPT(target_position);
-  WRITE_OPT(target_torque);
-  WRITE_OPT(target_velocity);
-  WRITE_OPT(target_vl);
-  WRITE_OPT(torque_profile_type);
-  WRITE_OPT(torque_slope);
-  WRITE_OPT(velocity_demand);
-  WRITE_OPT(velocity_error_time);
-  WRITE_OPT(velocity_error_window);
-  WRITE_OPT(velocity_sensor_selector); 
-  WRITE_OPT(velocity_threshold_time);
-  WRITE_OPT(velocity_threshold_window);
-  WRITE_OPT(vl_accel);
-  WRITE_OPT(vl_decel);
-  WRITE_OPT(vl_maximum);
-  WRITE_OPT(vl_minimum);
+  if (!data->ops_resolved) lcec_cia402_resolve_ops(data);
+  lcec_cia402_write_pre(data, slave->master->period_last);
+  lcec_cia402_run_write_ops(slave->master->process_data, data->write_ops, data->write_op_count);
 }
 
 /// @brief Writess data to all CiA 402 output ports.
@@ -1056,6 +1669,16 @@ void lcec_cia402_write(struct lcec_slave *slave, lcec_class_cia402_channel_t *da
 /// @param slave The `slave`, passed from the per-device `_read`.
 /// @param channels An `lcec_class_cia402_channel_t *`, as returned by lcec_cia402_register_channel.
 void lcec_cia402_write_all(struct lcec_slave *slave, lcec_class_cia402_channels_t *channels) {
+  if (channels->layout_state == 0) channels->layout_state = lcec_cia402_check_layout(channels);
+
+  if (channels->layout_state > 0) {
+    for (int i = 0; i < channels->count; i++) {
+      lcec_cia402_write_pre(channels->channels[i], slave->master->period_last);
+    }
+    lcec_cia402_run_write_ops_shared(slave->master->process_data, channels);
+    return;
+  }
+
   for (int i = 0; i < channels->count; i++) {
     lcec_class_cia402_channel_t *channel = channels->channels[i];
 
@@ -1081,6 +1704,10 @@ static const lcec_modparam_desc_t per_channel_modparams[] = {
     {"probe1Negative", CIA402_MP_PROBE1_NEG, MODPARAM_TYPE_S32},
     {"probe2Positive", CIA402_MP_PROBE2_POS, MODPARAM_TYPE_S32},
     {"probe2Negative", CIA402_MP_PROBE2_NEG, MODPARAM_TYPE_S32},
+    {"faultResetTime", CIA402_MP_FAULT_RESET_TIME, MODPARAM_TYPE_U32},
+    {"storeParameters", CIA402_MP_STORE_PARAMETERS, MODPARAM_TYPE_BIT},
+    {"secondaryPositionIndex", CIA402_MP_SECONDARY_IDX, MODPARAM_TYPE_U32},
+    {"secondaryPositionSubindex", CIA402_MP_SECONDARY_SIDX, MODPARAM_TYPE_U32},
     {"enablePP", CIA402_MP_ENABLE_PP, MODPARAM_TYPE_BIT},
     {"enablePV", CIA402_MP_ENABLE_PV, MODPARAM_TYPE_BIT},
     {"enableCSP", CIA402_MP_ENABLE_CSP, MODPARAM_TYPE_BIT},
@@ -1129,33 +1756,29 @@ static const lcec_modparam_desc_t per_channel_modparams[] = {
     {"enableVelocitySensorSelector", CIA402_MP_ENABLE_VELOCITY_SENSOR_SELECTOR, MODPARAM_TYPE_BIT},
     {"enableVelocityThresholdTime", CIA402_MP_ENABLE_VELOCITY_THRESHOLD_TIME, MODPARAM_TYPE_BIT},
     {"enableVelocityThresholdWindow", CIA402_MP_ENABLE_VELOCITY_THRESHOLD_WINDOW, MODPARAM_TYPE_BIT},
+    {"enableVelocityOffset", CIA402_MP_ENABLE_VELOCITY_OFFSET, MODPARAM_TYPE_BIT},
+    {"enableTorqueOffset", CIA402_MP_ENABLE_TORQUE_OFFSET, MODPARAM_TYPE_BIT},
+    {"enableVelocityFeedForward", CIA402_MP_ENABLE_VELOCITY_FEED_FORWARD, MODPARAM_TYPE_BIT},
+    {"enableTouchProbe", CIA402_MP_ENABLE_TOUCH_PROBE, MODPARAM_TYPE_BIT},
+    {"enableSecondaryPosition", CIA402_MP_ENABLE_SECONDARY_POSITION, MODPARAM_TYPE_BIT},
+    {"enableStateMachine", CIA402_MP_ENABLE_STATE_MACHINE, MODPARAM_TYPE_BIT},
     {NULL},
 };
 
-/// @brief Duplicate modparams with per-channel options
-///
-/// This reads from `lcec_class_cia402_modparams` and produces a new
-/// list of modparams that includes versions of all modparams for 8
-/// distinct channels, for use with multi-axis CiA 402 devices.
+/// @brief Mark modparams as per-channel.
 ///
-/// Specifically, this reads from `lcec_class_cia402_modparams` and
-/// returns a version where each line is duplicated 9 times.  The
-/// first duplicate is just a copy of the entry from
-/// `lcec_class_cia402_modparams`; the other 8 are channel-specific
-/// versions, with names and ID numbers modified from the original.
-/// If there's an entry for `foo` with an ID of 10, then this will
-/// produce 9 outputs:
+/// This returns a copy of `orig` with `channels` set to
+/// `LCEC_CIA402_MAX_CHANNELS` on every entry, for use with multi-axis
+/// CiA 402 devices.  The per-channel names aren't expanded here;
+/// `lcec_modparam_desc_find()` parses them when the XML is read.  If
+/// there's an entry for `foo` with an ID of 0x1000, then:
 ///
-/// - `{"foo", 10}`
-/// - `{"ch1foo", 10}`
-/// - `{"ch2foo", 11}`
-/// - `{"ch3foo", 12}`
-/// - `{"ch4foo", 13}`
-/// - `{"ch5foo", 13}`
-/// - `{"ch6foo", 13}`
-/// - `{"ch7foo", 13}`
+/// - `foo` and `ch0foo` have an ID of 0x1000.
+/// - `ch1foo` has an ID of 0x1001.
+/// - ...
+/// - `ch7foo` has an ID of 0x1007.
 ///
-/// Note that this makes `ch1foo` equivalant to `foo`.  In all cases,
+/// Note that this makes `ch0foo` equivalant to `foo`.  In all cases,
 /// `foo` should set a parameter for the first channel, not all
 /// channels.
 ///
@@ -1163,32 +1786,18 @@ static const lcec_modparam_desc_t per_channel_modparams[] = {
 /// a different list.
 lcec_modparam_desc_t *lcec_cia402_channelized_modparams(lcec_modparam_desc_t const *orig) {
   lcec_modparam_desc_t *mp;
-  int l;
+  int l, i;
 
   l = lcec_modparam_desc_len(orig);
 
-  mp = malloc(sizeof(lcec_modparam_desc_t) * (l * 9 + 1));
+  mp = malloc(sizeof(lcec_modparam_desc_t) * (l + 1));
   if (mp == NULL) {
     return NULL;
   }
 
-  mp[l * 9] = orig[l];  // Copy terminator.
-
-  for (l = 0; orig[l].name != NULL; l++) {
-    mp[l * 9] = orig[l];
-    for (int i = 1; i < 9; i++) {
-      char *name;
-      mp[l * 9 + i] = orig[l];
-
-      name = malloc(strlen(orig[l].name) + 4);
-      if (name == NULL) {
-        free(mp);
-        return NULL;
-      }
-      sprintf(name, "ch%d%s", l, orig[l].name);
-      mp[l * 9 + i].name = name;
-      mp[l * 9 + i].id += i - 1;
-    }
+  for (i = 0; i <= l; i++) {
+    mp[i] = orig[i];
+    if (i < l) mp[i].channels = LCEC_CIA402_MAX_CHANNELS;
   }
 
   return mp;
@@ -1200,12 +1809,150 @@ lcec_modparam_desc_t *lcec_cia402_channelized_modparams(lcec_modparam_desc_t con
 /// @param device_mps a `lcec_modparam_desc_t[]` containing all of the
 /// device-specific `<modParam>`settings.
 lcec_modparam_desc_t *lcec_cia402_modparams(lcec_modparam_desc_t const *device_mps) {
-  const lcec_modparam_desc_t *channelized_mps = lcec_cia402_channelized_modparams(per_channel_modparams);
-  if (channelized_mps == NULL) return NULL;
+  static const lcec_modparam_desc_t *channelized_mps;
+
+  if (channelized_mps == NULL) {
+    channelized_mps = lcec_cia402_channelized_modparams(per_channel_modparams);
+    if (channelized_mps == NULL) return NULL;
+  }
 
   return lcec_modparam_desc_concat(device_mps, channelized_mps);
 }
 
+/// @brief SDO set by a per-channel modParam.
+typedef struct {
+  int id;           ///< ModParam ID, without the channel.
+  uint16_t offset;  ///< Object index, relative to the channel's base (0x6000 for channel 0).
+  uint8_t sidx;     ///< Object subindex.
+  uint8_t size;     ///< Object size in bytes.
+} lcec_cia402_sdo_modparam_t;
+
+static const lcec_cia402_sdo_modparam_t sdo_modparams[] = {
+    {CIA402_MP_POSLIMIT_MIN, 0x7b, 1, 4},
+    {CIA402_MP_POSLIMIT_MAX, 0x7b, 2, 4},
+    {CIA402_MP_SWPOSLIMIT_MIN, 0x7d, 1, 4},
+    {CIA402_MP_SWPOSLIMIT_MAX, 0x7d, 2, 4},
+    {CIA402_MP_HOME_OFFSET, 0x7c, 0, 4},
+    {CIA402_MP_QUICKDECEL, 0x85, 0, 4},
+    {CIA402_MP_OPTCODE_QUICKSTOP, 0x5a, 0, 2},
+    {CIA402_MP_OPTCODE_SHUTDOWN, 0x5b, 0, 2},
+    {CIA402_MP_OPTCODE_DISABLE, 0x5c, 0, 2},
+    {CIA402_MP_OPTCODE_HALT, 0x5d, 0, 2},
+    {CIA402_MP_OPTCODE_FAULT, 0x5e, 0, 2},
+    {CIA402_MP_PROBE_FUNCTION, 0xb8, 0, 2},
+    {CIA402_MP_PROBE1_POS, 0xba, 0, 4},
+    {CIA402_MP_PROBE1_NEG, 0xbb, 0, 4},
+    {CIA402_MP_PROBE2_POS, 0xbc, 0, 4},
+    {CIA402_MP_PROBE2_NEG, 0xbd, 0, 4},
+    {-1},
+};
+
+// find the SDO behind a modparam ID, or NULL if it doesn't set one
+static const lcec_cia402_sdo_modparam_t *find_sdo_modparam(int id) {
+  const lcec_cia402_sdo_modparam_t *sdo;
+
+  if (id < CIA402_MP_BASE) {
+    return NULL;
+  }
+
+  for (sdo = sdo_modparams; sdo->id >= 0; sdo++) {
+    if (sdo->id == (id & ~7)) {
+      return sdo;
+    }
+  }
+
+  return NULL;
+}
+
+// index of a modparam's SDO, for the channel in the low bits of `id`
+static uint16_t sdo_modparam_index(const lcec_cia402_sdo_modparam_t *sdo, int id) { return 0x6000 + 0x800 * (id & 7) + sdo->offset; }
+
+/// @brief Queue reads of the SDOs that this slave's modparams will set.
+///
+/// Call from the driver's `proc_preinit`.  The current values are
+/// read in parallel with every other slave's prefetches, and
+/// `lcec_cia402_handle_modparam()` then skips writing any SDO that
+/// already holds the configured value.  This saves a mailbox
+/// round-trip per parameter on every start after the first.
+///
+/// @return 0 for success, <0 for failure.
+int lcec_cia402_prefetch_modparams(struct lcec_slave *slave) {
+  const lcec_cia402_sdo_modparam_t *sdo;
+  lcec_slave_modparam_t *p;
+
+  for (p = slave->modparams; p != NULL && p->id >= 0; p++) {
+    sdo = find_sdo_modparam(p->id);
+    if (sdo == NULL) continue;
+
+    if (lcec_prefetch_sdo(slave, sdo_modparam_index(sdo, p->id), sdo->sidx, sdo->size) != 0) {
+      return -ENOMEM;
+    }
+  }
+
+  return 0;
+}
+
+// write a modparam's SDO, unless the prefetched value shows that the drive already has it
+static int write_sdo_modparam(
+    struct lcec_slave *slave, const lcec_slave_modparam_t *p, const lcec_cia402_sdo_modparam_t *sdo, lcec_cia402_modparam_ctx_t *ctx) {
+  uint16_t idx = sdo_modparam_index(sdo, p->id);
+  uint8_t data[4];
+  int err;
+
+  // `s32` and `u32` share storage, so this covers signed and unsigned objects alike.
+  switch (sdo->size) {
+    case 2:
+      EC_WRITE_U16(data, p->value.u32);
+      break;
+    default:
+      EC_WRITE_U32(data, p->value.u32);
+      break;
+  }
+
+  if (lcec_prefetch_matches(slave, idx, sdo->sidx, data, sdo->size)) {
+    if (ctx != NULL) ctx->sdos_skipped++;
+    return 0;
+  }
+
+  if (sdo->size == 2) {
+    err = lcec_write_sdo16_modparam(slave, idx, sdo->sidx, p->value.u32, p->name);
+  } else {
+    err = lcec_write_sdo32_modparam(slave, idx, sdo->sidx, p->value.u32, p->name);
+  }
+  if (err == 0 && ctx != NULL) ctx->sdos_written++;
+
+  return err;
+}
+
+/// @brief Finish modparam handling for a slave.
+///
+/// Call after the loop over `slave->modparams`.  This reports how
+/// many parameter writes were skipped because the drive already held
+/// the value, and, if `storeParameters` is set and anything was
+/// actually changed, asks the drive to save its parameters to
+/// non-volatile memory (0x1010:01).
+///
+/// @param slave The `lcec_slave` passed to `_init`.
+/// @param opt The channel's options.
+/// @param ctx The context passed to `lcec_cia402_handle_modparam()`.
+///
+/// @return 0 for success, <0 for failure.
+int lcec_cia402_finish_modparams(struct lcec_slave *slave, const lcec_class_cia402_options_t *opt, const lcec_cia402_modparam_ctx_t *ctx) {
+  if (ctx->sdos_written + ctx->sdos_skipped > 0) {
+    rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "slave %s.%s: %d CiA 402 parameters written, %d already set\n", slave->master->name,
+        slave->name, ctx->sdos_written, ctx->sdos_skipped);
+  }
+
+  if (opt->store_parameters && ctx->sdos_written > 0) {
+    // "save" in ASCII, as required by CiA 301.
+    if (lcec_write_sdo32_modparam(slave, 0x1010, 1, 0x65766173, "storeParameters") < 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
 /// @brief Handle a single modparam entry
 ///
 /// This should be called as part of the slave's modparam handling
@@ -1214,9 +1961,12 @@ lcec_modparam_desc_t *lcec_cia402_modparams(lcec_modparam_desc_t const *device_m
 ///
 /// @param slave The `lcec_slave` passed to `_init`.
 /// @param p The current modparam being processed.
+/// @param opt The channel's options.
+/// @param ctx SDO writes are counted here for `lcec_cia402_finish_modparams()`, may be NULL.
 ///
 /// @return 0 if the modparam was handled, 1 if it was not handled, and <0 if an error occurred.
-int lcec_cia402_handle_modparam(struct lcec_slave *slave, const lcec_slave_modparam_t *p, lcec_class_cia402_options_t *opt) {
+int lcec_cia402_handle_modparam(
+    struct lcec_slave *slave, const lcec_slave_modparam_t *p, lcec_class_cia402_options_t *opt, lcec_cia402_modparam_ctx_t *ctx) {
   if (p->id < CIA402_MP_BASE) {
     return 0;
   }
@@ -1226,52 +1976,37 @@ int lcec_cia402_handle_modparam(struct lcec_slave *slave, const lcec_slave_modpa
   // `ch0foo`: set foo for channel 0.  Identical to `foo`, above.
   // `ch1foo`: set foo for channel 1.
   // ...
-  // `ch8foo`: set foo for channel 8.
+  // `ch7foo`: set foo for channel 7.
   //
   // The `id` for CiA402 modparams needs to be coded so that the channel is the low-order 3 bits.
 
-  // To keep the switch statement from getting weird, this breaks the
-  // channel and ID apart so we can handle them independently.
-  int channel = p->id & 7;
+  // Modparams that just set an SDO are listed in `sdo_modparams`.
+  const lcec_cia402_sdo_modparam_t *sdo = find_sdo_modparam(p->id);
+  if (sdo != NULL) {
+    return write_sdo_modparam(slave, p, sdo, ctx);
+  }
+
+  // To keep the switch statement from getting weird, this strips the
+  // channel from the ID.
   int id = p->id & ~7;
-  int base = 0x6000 + 0x800 * channel;
-
-#define CASE_MP_S8(mp_name, idx, sidx) \
-  case mp_name:                        \
-    return lcec_write_sdo8_modparam(slave, idx, sidx, p->value.s32, p->name)
-#define CASE_MP_S16(mp_name, idx, sidx) \
-  case mp_name:                         \
-    return lcec_write_sdo16_modparam(slave, idx, sidx, p->value.s32, p->name)
-#define CASE_MP_U16(mp_name, idx, sidx) \
-  case mp_name:                         \
-    return lcec_write_sdo16_modparam(slave, idx, sidx, p->value.u32, p->name)
-#define CASE_MP_S32(mp_name, idx, sidx) \
-  case mp_name:                         \
-    return lcec_write_sdo32_modparam(slave, idx, sidx, p->value.s32, p->name)
-#define CASE_MP_U32(mp_name, idx, sidx) \
-  case mp_name:                         \
-    return lcec_write_sdo32_modparam(slave, idx, sidx, p->value.u32, p->name)
+
 #define CASE_MP_ENABLE_BIT(mp_name, pin_name) \
   case mp_name: \
     opt->enable_##pin_name = p->value.bit; \
     return 0;
   switch (id) {
-    CASE_MP_S32(CIA402_MP_POSLIMIT_MIN, base + 0x7b, 1);
-    CASE_MP_S32(CIA402_MP_POSLIMIT_MAX, base + 0x7b, 2);
-    CASE_MP_S32(CIA402_MP_SWPOSLIMIT_MIN, base + 0x7d, 1);
-    CASE_MP_S32(CIA402_MP_SWPOSLIMIT_MAX, base + 0x7d, 2);
-    CASE_MP_S32(CIA402_MP_HOME_OFFSET, base + 0x7c, 0);
-    CASE_MP_U32(CIA402_MP_QUICKDECEL, base + 0x85, 0);
-    CASE_MP_S16(CIA402_MP_OPTCODE_QUICKSTOP, base + 0x5a, 0);
-    CASE_MP_S16(CIA402_MP_OPTCODE_SHUTDOWN, base + 0x5b, 0);
-    CASE_MP_S16(CIA402_MP_OPTCODE_DISABLE, base + 0x5c, 0);
-    CASE_MP_S16(CIA402_MP_OPTCODE_HALT, base + 0x5d, 0);
-    CASE_MP_S16(CIA402_MP_OPTCODE_FAULT, base + 0x5e, 0);
-    CASE_MP_U16(CIA402_MP_PROBE_FUNCTION, base + 0xb8, 0);
-    CASE_MP_U32(CIA402_MP_PROBE1_POS, base + 0xba, 0);
-    CASE_MP_U32(CIA402_MP_PROBE1_NEG, base + 0xbb, 0);
-    CASE_MP_U32(CIA402_MP_PROBE2_POS, base + 0xbc, 0);
-    CASE_MP_U32(CIA402_MP_PROBE2_NEG, base + 0xbd, 0);
+    case CIA402_MP_FAULT_RESET_TIME:
+      opt->fault_reset_time = p->value.u32;
+      return 0;
+    case CIA402_MP_STORE_PARAMETERS:
+      opt->store_parameters = p->value.bit;
+      return 0;
+    case CIA402_MP_SECONDARY_IDX:
+      opt->secondary_position_idx = p->value.u32;
+      return 0;
+    case CIA402_MP_SECONDARY_SIDX:
+      opt->secondary_position_sidx = p->value.u32;
+      return 0;
     CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_PP, pp);
     CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_PV, pv);
     CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_CSP, csp);
@@ -1321,6 +2056,12 @@ int lcec_cia402_handle_modparam(struct lcec_slave *slave, const lcec_slave_modpa
     CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_VL_DECEL, vl_decel );
     CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_VL_MAXIMUM, vl_maximum );
     CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_VL_MINIMUM, vl_minimum );
+    CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_VELOCITY_OFFSET, velocity_offset);
+    CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_TORQUE_OFFSET, torque_offset);
+    CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_VELOCITY_FEED_FORWARD, velocity_feed_forward);
+    CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_TOUCH_PROBE, touch_probe);
+    CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_SECONDARY_POSITION, secondary_position);
+    CASE_MP_ENABLE_BIT(CIA402_MP_ENABLE_STATE_MACHINE, state_machine);
     
     default:
       return 1;
@@ -20,6 +20,7 @@
 /// @brief Library for CiA 402 servo/stepper controllers
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 extern ec_pdo_entry_info_t lcec_cia402_basic_in1[];
 extern ec_pdo_entry_info_t lcec_cia402_basic_out1[];
@@ -94,11 +95,13 @@ typedef struct {
   int enable_target_torque;
   int enable_target_vl;
   int enable_torque_demand;
+  int enable_torque_offset;  ///< If true, enable the torque offset (feed-forward) pin
   int enable_torque_profile_type;
   int enable_torque_slope;
   int enable_velocity_demand;
   int enable_velocity_error_time;
   int enable_velocity_error_window;
+  int enable_velocity_offset;  ///< If true, enable the velocity offset (feed-forward) pin
   int enable_velocity_sensor_selector; 
   int enable_velocity_threshold_time;
   int enable_velocity_threshold_window;
@@ -106,8 +109,27 @@ typedef struct {
   int enable_vl_decel;
   int enable_vl_maximum;
   int enable_vl_minimum;
+
+  int enable_touch_probe;            ///< If true, enable touch probe objects 0x60B8-0x60BD and their pins.
+  int enable_velocity_feed_forward;  ///< If true, compute the velocity offset from the change in target position.
+  int enable_state_machine;   ///< If true, run the CiA 402 power state machine in the driver instead of in HAL.
+  uint32_t fault_reset_time;  ///< Length of the fault reset pulse in ms, 0 for the default.
+  int enable_secondary_position;    ///< If true, map a secondary position (0x60E4:01 by default) and export it as an encoder.
+  uint16_t secondary_position_idx;  ///< Object index of the secondary position, 0 for the channel's 0x60E4.
+  uint8_t secondary_position_sidx;  ///< Object subindex of the secondary position, used with `secondary_position_idx`.
+  int store_parameters;       ///< If true, save parameters to the drive's non-volatile memory when a modParam changed any.
 } lcec_class_cia402_options_t;
 
+/// @brief Per-slave state of one pass over `slave->modparams`.
+///
+/// Zero it before the loop, pass it to each
+/// `lcec_cia402_handle_modparam()` call, and then to
+/// `lcec_cia402_finish_modparams()`.
+typedef struct {
+  int sdos_written;  ///< ModParam SDOs written by `lcec_cia402_handle_modparam()`.
+  int sdos_skipped;  ///< ModParam SDOs skipped because the drive already held the value.
+} lcec_cia402_modparam_ctx_t;
+
 /// This is the internal version of `lcec_class_cia402_options_t`.  It
 /// lists each specific pin (or atomic set of pins, in the case of
 /// `opmode`), and decisions about mapping/etc can be based on this.
@@ -145,6 +167,12 @@ typedef struct {
   int enable_opmode;
   int enable_opmode_display;
   int enable_polarity;
+  int enable_probe1_neg;
+  int enable_probe1_pos;
+  int enable_probe2_neg;
+  int enable_probe2_pos;
+  int enable_probe_function;
+  int enable_probe_status;
   int enable_profile_accel;
   int enable_profile_decel;
   int enable_profile_end_velocity;
@@ -155,11 +183,13 @@ typedef struct {
   int enable_target_velocity;
   int enable_target_vl;
   int enable_torque_demand;
+  int enable_torque_offset;
   int enable_torque_profile_type;
   int enable_torque_slope;
   int enable_velocity_demand;
   int enable_velocity_error_time;
   int enable_velocity_error_window;
+  int enable_velocity_offset;
   int enable_velocity_sensor_selector; 
   int enable_velocity_threshold_time;
   int enable_velocity_threshold_window;
@@ -169,6 +199,67 @@ typedef struct {
   int enable_vl_minimum;
 } lcec_class_cia402_enabled_t;
 
+// States of the CiA 402 power state machine, as decoded from the statusword.
+#define LCEC_CIA402_STATE_NOT_READY          0
+#define LCEC_CIA402_STATE_SWITCH_ON_DISABLED 1
+#define LCEC_CIA402_STATE_READY              2
+#define LCEC_CIA402_STATE_SWITCHED_ON        3
+#define LCEC_CIA402_STATE_OPERATION_ENABLED  4
+#define LCEC_CIA402_STATE_QUICK_STOP_ACTIVE  5
+#define LCEC_CIA402_STATE_FAULT_REACTION     6
+#define LCEC_CIA402_STATE_FAULT              7
+
+// Controlword commands, in bits 0-3 and 7.
+#define LCEC_CIA402_CW_MASK             0x8f
+#define LCEC_CIA402_CW_DISABLE_VOLTAGE  0x00
+#define LCEC_CIA402_CW_QUICK_STOP       0x02
+#define LCEC_CIA402_CW_SHUTDOWN         0x06
+#define LCEC_CIA402_CW_SWITCH_ON        0x07
+#define LCEC_CIA402_CW_ENABLE_OPERATION 0x0f
+#define LCEC_CIA402_CW_FAULT_RESET      0x80
+
+#define LCEC_CIA402_FAULT_RESET_TIME_DEFAULT 10  ///< Default fault reset pulse, in ms.
+
+// Touch probe function (0x60B8) bits for probe 1.  Probe 2 uses the
+// same bits, shifted left by 8.
+#define LCEC_CIA402_PROBE_FN_ENABLE     0x01  ///< Enable the probe.
+#define LCEC_CIA402_PROBE_FN_CONTINUOUS 0x02  ///< Latch on every edge, not just the first.
+#define LCEC_CIA402_PROBE_FN_INDEX      0x04  ///< Latch on the encoder's index pulse instead of the probe input.
+#define LCEC_CIA402_PROBE_FN_POS_EDGE   0x10  ///< Latch on rising edges.
+#define LCEC_CIA402_PROBE_FN_NEG_EDGE   0x20  ///< Latch on falling edges.
+
+// Touch probe status (0x60B9) bits for probe 1.  Probe 2 uses the
+// same bits, shifted left by 8.
+#define LCEC_CIA402_PROBE_ST_ENABLED    0x01  ///< The probe is enabled.
+#define LCEC_CIA402_PROBE_ST_POS_STORED 0x02  ///< A rising edge position has been latched.
+#define LCEC_CIA402_PROBE_ST_NEG_STORED 0x04  ///< A falling edge position has been latched.
+
+/// @brief Width and signedness of a cyclic CiA 402 PDO access.
+typedef enum {
+  LCEC_CIA402_OP_U8,
+  LCEC_CIA402_OP_S8,
+  LCEC_CIA402_OP_U16,
+  LCEC_CIA402_OP_S16,
+  LCEC_CIA402_OP_U32,
+  LCEC_CIA402_OP_S32,
+} lcec_class_cia402_op_type_t;
+
+/// @brief One cyclic copy between the process data and a pin.
+///
+/// `lcec_cia402_register_channel()` compiles the enabled objects of
+/// each channel into a list of these, so the cyclic read and write
+/// functions only touch objects that are actually mapped.
+///
+/// PDO offsets aren't known until the master registers its domain,
+/// which happens after the slave's init, so `os` is copied from
+/// `os_src` on the first cycle.
+typedef struct {
+  unsigned int os;                   ///< Offset in the master's process data.
+  lcec_class_cia402_op_type_t type;  ///< Width and signedness of the object.
+  volatile void *pin;                ///< The pin's `hal_u32_t` or `hal_s32_t` storage.
+  const unsigned int *os_src;        ///< Where to find `os` once it's known, NULL if `os` is already set.
+} lcec_class_cia402_op_t;
+
 typedef struct {
   // Out
   hal_u32_t *controlword;
@@ -180,7 +271,9 @@ typedef struct {
   hal_s32_t *target_torque;
   hal_s32_t *target_velocity;
   hal_s32_t *target_vl;
+  hal_s32_t *torque_offset;
   hal_s32_t *torque_profile_type;
+  hal_s32_t *velocity_offset;
   hal_s32_t *velocity_sensor_selector; 
   hal_s32_t *vl_maximum;
   hal_s32_t *vl_minimum;
@@ -226,10 +319,52 @@ typedef struct {
   hal_s32_t *actual_velocity_sensor;
   hal_s32_t *actual_vl;
   hal_s32_t *demand_vl;
+  hal_s32_t *probe1_neg;
+  hal_s32_t *probe1_pos;
+  hal_s32_t *probe2_neg;
+  hal_s32_t *probe2_pos;
   hal_s32_t *torque_demand;
   hal_s32_t *velocity_demand;
   hal_u32_t *actual_following_error;
   hal_u32_t *actual_voltage;
+  hal_u32_t *probe_status;
+
+  // Touch probe, if `options->enable_touch_probe` is set.
+  hal_u32_t *probe_function;     ///< Touch probe function sent to the drive, built from the pins below.
+  hal_bit_t *probe1_arm_pos;     ///< Arm probe 1 for a rising edge.
+  hal_bit_t *probe1_arm_neg;     ///< Arm probe 1 for a falling edge.
+  hal_bit_t *probe1_index;       ///< Probe 1 latches on the encoder index instead of the probe input.
+  hal_bit_t *probe1_pos_valid;   ///< `probe1_pos` holds a position latched since probe 1 was armed.
+  hal_bit_t *probe1_neg_valid;   ///< `probe1_neg` holds a position latched since probe 1 was armed.
+  hal_bit_t *probe2_arm_pos;     ///< Arm probe 2 for a rising edge.
+  hal_bit_t *probe2_arm_neg;     ///< Arm probe 2 for a falling edge.
+  hal_bit_t *probe2_index;       ///< Probe 2 latches on the encoder index instead of the probe input.
+  hal_bit_t *probe2_pos_valid;   ///< `probe2_pos` holds a position latched since probe 2 was armed.
+  hal_bit_t *probe2_neg_valid;   ///< `probe2_neg` holds a position latched since probe 2 was armed.
+
+  // State machine, if `options->enable_state_machine` is set.
+  hal_bit_t *sm_enable;            ///< Request operation enabled.
+  hal_bit_t *sm_fault_reset;       ///< A rising edge sends a fault reset pulse.
+  hal_bit_t *sm_quick_stop;        ///< Request a quick stop.
+  hal_bit_t *sm_enabled;           ///< The drive is in "operation enabled".
+  hal_bit_t *sm_fault;             ///< The drive is in "fault" or "fault reaction active".
+  hal_u32_t *sm_state;             ///< The decoded state, one of `LCEC_CIA402_STATE_*`.
+  hal_u32_t sm_controlword;        ///< Controlword sent to the drive, in place of the `controlword` pin.
+  hal_s32_t sm_target_position;    ///< Target position sent to the drive, follows the actual position while disabled.
+  int sm_fault_reset_last;         ///< `sm_fault_reset` in the previous cycle.
+  long long sm_fault_reset_time;   ///< Length of a fault reset pulse, in ns.
+  long long sm_fault_reset_timer;  ///< ns left in the current fault reset pulse.
+
+  // Velocity feed-forward, if `options->enable_velocity_feed_forward` is set.
+  hal_float_t *ff_velocity_scale;  ///< Velocity offset units per position unit per second.
+  hal_s32_t ff_velocity_offset;    ///< Velocity offset sent to the drive, in place of the `velocity_offset` pin.
+  int32_t ff_last_position;        ///< Target position sent in the previous cycle.
+  int ff_last_valid;               ///< `ff_last_position` is valid.
+
+  // Secondary position, if `options->enable_secondary_position` is set.
+  hal_float_t *enc2_scale;             ///< Position units per count of the secondary encoder.
+  lcec_class_enc_data_t *enc2;         ///< 64-bit extension, position reset, and scaling of the secondary position.
+  unsigned int secondary_position_os;  ///< The secondary position's offset in the master's PDO data structure.
 
   unsigned int controlword_os;           ///< The controlword's offset in the master's PDO data structure.
   unsigned int following_error_timeout_os;
@@ -249,6 +384,7 @@ typedef struct {
   unsigned int motor_rated_torque_os;
   unsigned int opmode_os;                ///< The opmode's offset in the master's PDO data structure.
   unsigned int polarity_os;
+  unsigned int probe_function_os;
   unsigned int profile_accel_os;         ///< The target accleeration for the next move in `pp` mode.
   unsigned int profile_decel_os;         ///< The target deceleration for the next move in `pp` mode.
   unsigned int profile_end_velocity_os;  ///< The end velocity for the next move in `pp` mode.  Almost always 0.
@@ -259,10 +395,12 @@ typedef struct {
   unsigned int target_torque_os;
   unsigned int target_velocity_os;       ///< The target velocity's offset in the master's PDO data structure.
   unsigned int target_vl_os;
+  unsigned int torque_offset_os;
   unsigned int torque_profile_type_os;
   unsigned int torque_slope_os;
   unsigned int velocity_error_time_os;
   unsigned int velocity_error_window_os;
+  unsigned int velocity_offset_os;
   unsigned int velocity_sensor_selector_os; 
   unsigned int velocity_threshold_time_os;
   unsigned int velocity_threshold_window_os;
@@ -281,17 +419,38 @@ typedef struct {
   unsigned int actual_voltage_os;
   unsigned int demand_vl_os;
   unsigned int opmode_display_os;   ///< The opmode display's offset in the master's PDO data structure.
+  unsigned int probe1_neg_os;
+  unsigned int probe1_pos_os;
+  unsigned int probe2_neg_os;
+  unsigned int probe2_pos_os;
+  unsigned int probe_status_os;
   unsigned int statusword_os;       ///< The statusword's offset in the master's PDO data structure.
   unsigned int torque_demand_os;
   unsigned int velocity_demand_os;
 
   lcec_class_cia402_options_t *options;  ///< The options used to create this device.
-  lcec_class_cia402_enabled_t *enabled;
+
+  lcec_class_cia402_op_t *read_ops;   ///< Objects copied to pins by `lcec_cia402_read()`.
+  int read_op_count;                  ///< Number of entries in `read_ops`.
+  lcec_class_cia402_op_t *write_ops;  ///< Objects copied from pins by `lcec_cia402_write()`.
+  int write_op_count;                 ///< Number of entries in `write_ops`.
+  int ops_resolved;                   ///< The ops' `os` fields have been filled in from `os_src`.
+  int read_base;                      ///< Offset of this channel's inputs from channel 0's, with a shared layout.
+  int write_base;                     ///< Offset of this channel's outputs from channel 0's, with a shared layout.
 } lcec_class_cia402_channel_t;
 
+/// @brief All of the channels (axes) of a single device.
+///
+/// Multi-axis devices usually map the same objects for every axis,
+/// in the same order.  When that's true, all channels share channel
+/// 0's op lists, with a per-channel base offset, and
+/// `lcec_cia402_read_all()` and `lcec_cia402_write_all()` decode each
+/// op once for all channels instead of once per channel.  This is
+/// checked on the first cycle, once PDO offsets are known.
 typedef struct {
   int count;                               ///< The number of channels described by this structure.
   lcec_class_cia402_channel_t **channels;  ///< a dynamic array of `lcec_class_cia402_channel_t` channels.  There should be 1 per axis.
+  int layout_state;                        ///< 0 until checked, 1 if all channels share channel 0's layout, -1 if not.
 } lcec_class_cia402_channels_t;
 
 lcec_class_cia402_channels_t *lcec_cia402_allocate_channels(int count);
@@ -300,9 +459,21 @@ void lcec_cia402_read(struct lcec_slave *slave, lcec_class_cia402_channel_t *dat
 void lcec_cia402_read_all(struct lcec_slave *slave, lcec_class_cia402_channels_t *channels);
 void lcec_cia402_write(struct lcec_slave *slave, lcec_class_cia402_channel_t *data);
 void lcec_cia402_write_all(struct lcec_slave *slave, lcec_class_cia402_channels_t *channels);
+void lcec_cia402_run_read_ops(uint8_t *pd, const lcec_class_cia402_op_t *ops, int count);
+void lcec_cia402_run_write_ops(uint8_t *pd, const lcec_class_cia402_op_t *ops, int count);
+int lcec_cia402_check_layout(lcec_class_cia402_channels_t *channels);
+void lcec_cia402_run_read_ops_shared(uint8_t *pd, lcec_class_cia402_channels_t *channels);
+void lcec_cia402_run_write_ops_shared(uint8_t *pd, lcec_class_cia402_channels_t *channels);
+uint32_t lcec_cia402_decode_state(uint16_t statusword);
+uint16_t lcec_cia402_next_controlword(uint32_t state, int enable, int quick_stop);
+uint16_t lcec_cia402_probe_function(int arm_pos, int arm_neg, int index);
+int32_t lcec_cia402_velocity_feed_forward(int32_t position, int32_t last_position, long period, double scale);
 lcec_class_cia402_options_t *lcec_cia402_options_single_axis(void);
-lcec_class_cia402_options_t *lcec_cia402_options_multi_axis(void);
-int lcec_cia402_handle_modparam(struct lcec_slave *slave, const lcec_slave_modparam_t *p, lcec_class_cia402_options_t *opt);
+lcec_class_cia402_options_t *lcec_cia402_options_multi_axes(int axis);
+int lcec_cia402_handle_modparam(
+    struct lcec_slave *slave, const lcec_slave_modparam_t *p, lcec_class_cia402_options_t *opt, lcec_cia402_modparam_ctx_t *ctx);
+int lcec_cia402_prefetch_modparams(struct lcec_slave *slave);
+int lcec_cia402_finish_modparams(struct lcec_slave *slave, const lcec_class_cia402_options_t *opt, const lcec_cia402_modparam_ctx_t *ctx);
 lcec_modparam_desc_t *lcec_cia402_channelized_modparams(lcec_modparam_desc_t const *orig);
 lcec_modparam_desc_t *lcec_cia402_modparams(lcec_modparam_desc_t const *device_mps);
 lcec_syncs_t *lcec_cia402_init_sync(lcec_class_cia402_options_t *options);
@@ -321,6 +492,8 @@ int lcec_cia402_add_input_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
     lcec_addtypes(types, __FILE__);                        \
   }
 
+#define LCEC_CIA402_MAX_CHANNELS 8  ///< Channels (axes) addressable with `ch<N>` modParam prefixes.
+
 // modParam IDs
 //
 // These need to:
@@ -328,8 +501,8 @@ int lcec_cia402_add_input_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
 //   (b) be a multiple of 8, with 7 unused IDs between each.
 //       That is, the hex version should end in 0 or 8.
 //
-// These are run through `lcec_cia402_channelized_modparams()` which
-// creates additional versions of these for 8 different channels (or
+// These are run through `lcec_cia402_channelized_modparams()`, which
+// makes them accept `ch<N>` prefixes for 8 different channels (or
 // axes).
 
 #define CIA402_MP_BASE              0x1000
@@ -350,6 +523,10 @@ int lcec_cia402_add_input_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
 #define CIA402_MP_PROBE1_NEG        0x1170  // 0x60bb:00 "touch probe 1 negative value" S32
 #define CIA402_MP_PROBE2_POS        0x1180  // 0x60bc:00 "touch probe 2 positive value" S32
 #define CIA402_MP_PROBE2_NEG        0x1190  // 0x60bd:00 "touch probe 2 negative value" S32
+#define CIA402_MP_FAULT_RESET_TIME  0x11a0  // Driver-side fault reset pulse length, in ms.
+#define CIA402_MP_STORE_PARAMETERS  0x11b0  // Save parameters via 0x1010:01 if any modParam SDO changed.
+#define CIA402_MP_SECONDARY_IDX     0x11c0  // Object index of the secondary position, instead of 0x60e4.
+#define CIA402_MP_SECONDARY_SIDX    0x11d0  // Object subindex of the secondary position.
 
 #define CIA402_MP_ENABLE_ACTUAL_CURRENT 0x22d0 
 #define CIA402_MP_ENABLE_ACTUAL_FOLLOWING_ERROR 0x2100
@@ -400,4 +577,10 @@ int lcec_cia402_add_input_sync(lcec_syncs_t *syncs, lcec_class_cia402_options_t
 #define CIA402_MP_ENABLE_VL_DECEL 0x2370
 #define CIA402_MP_ENABLE_VL_MAXIMUM 0x2350
 #define CIA402_MP_ENABLE_VL_MINIMUM 0x2340
+#define CIA402_MP_ENABLE_STATE_MACHINE 0x2380
+#define CIA402_MP_ENABLE_VELOCITY_OFFSET 0x2390
+#define CIA402_MP_ENABLE_TORQUE_OFFSET 0x23a0
+#define CIA402_MP_ENABLE_VELOCITY_FEED_FORWARD 0x23b0
+#define CIA402_MP_ENABLE_TOUCH_PROBE 0x23c0
+#define CIA402_MP_ENABLE_SECONDARY_POSITION 0x23d0
 
@@ -25,6 +25,9 @@
 
 #include "../lcec.h"
 
+/// @brief Channels of all slaves using this class, allocated one after the other.
+static lcec_block_t channel_block;
+
 static const lcec_pindesc_t slave_pins[] = {
     {HAL_BIT, HAL_OUT, offsetof(lcec_class_din_channel_t, in), "%s.%s.%s.%s"},
     {HAL_BIT, HAL_OUT, offsetof(lcec_class_din_channel_t, in_not), "%s.%s.%s.%s-not"},
@@ -40,17 +43,38 @@ static const lcec_pindesc_t slave_pins[] = {
 /// @param count The number of input pins to allocate memory for.
 lcec_class_din_channels_t *lcec_din_allocate_channels(int count) {
   lcec_class_din_channels_t *channels;
+  size_t size;
+
+  // room for the channels, the pointers to them, and the bulk read arrays
+  size = LCEC_BLOCK_ALIGN(sizeof(lcec_class_din_channels_t)) + LCEC_BLOCK_ALIGN(sizeof(lcec_class_din_channel_t *) * count);
+  size += count * LCEC_BLOCK_ALIGN(sizeof(lcec_class_din_channel_t));
+  size += LCEC_BLOCK_ALIGN(sizeof(uint8_t) * count) + 2 * LCEC_BLOCK_ALIGN(sizeof(hal_bit_t *) * count);
+  if (lcec_block_reserve(&channel_block, size) < 0) {
+    return NULL;
+  }
 
-  channels = hal_malloc(sizeof(lcec_class_din_channels_t));
+  channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_din_channels_t));
   if (channels == NULL) {
     return NULL;
   }
   channels->count = count;
-  channels->channels = hal_malloc(sizeof(lcec_class_din_channel_t *) * count);
+  channels->channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_din_channel_t *) * count);
   if (channels->channels == NULL) {
     return NULL;
   }
 
+  // room for bulk reads, see `lcec_din_read_all()`
+  channels->bulk = -1;
+  if (count > 0 && count <= LCEC_DIN_BULK_MAX_CHANNELS) {
+    channels->bulk_bit = lcec_block_alloc(&channel_block, sizeof(uint8_t) * count);
+    channels->bulk_in = lcec_block_alloc(&channel_block, sizeof(hal_bit_t *) * count);
+    channels->bulk_in_not = lcec_block_alloc(&channel_block, sizeof(hal_bit_t *) * count);
+    if (channels->bulk_bit == NULL || channels->bulk_in == NULL || channels->bulk_in_not == NULL) {
+      return NULL;
+    }
+    channels->bulk = 0;
+  }
+
   return channels;
 }
 
@@ -84,12 +108,12 @@ lcec_class_din_channel_t *lcec_din_register_channel_named(struct lcec_slave *sla
   lcec_class_din_channel_t *data;
   int err;
 
-  data = hal_malloc(sizeof(lcec_class_din_channel_t));
+  data = lcec_block_alloc(&channel_block, sizeof(lcec_class_din_channel_t));
   if (data == NULL) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %s failed\n", slave->master->name, slave->name, name);
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %s failed\n",
+        slave->master->name, slave->name, name);
     return NULL;
   }
-  memset(data, 0, sizeof(lcec_class_din_channel_t));
   data->name = name;
   data->pdo_bp_packed = 0xffff;  // Flag value, this isn't a packed channel.
 
@@ -121,12 +145,12 @@ lcec_class_din_channel_t *lcec_din_register_channel_packed(struct lcec_slave *sl
   lcec_class_din_channel_t *data;
   int err;
 
-  data = hal_malloc(sizeof(lcec_class_din_channel_t));
+  data = lcec_block_alloc(&channel_block, sizeof(lcec_class_din_channel_t));
   if (data == NULL) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %s failed\n", slave->master->name, slave->name, name);
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %s failed\n",
+        slave->master->name, slave->name, name);
     return NULL;
   }
-  memset(data, 0, sizeof(lcec_class_din_channel_t));
   data->name = name;
 
   // Register the whole PDO, hopefully this does the sane thing if we register the same PDO repeatedly.
@@ -174,14 +198,87 @@ void lcec_din_read(struct lcec_slave *slave, lcec_class_din_channel_t *data) {
   *(data->in_not) = !s;
 }
 
+/// @brief Returns a channel's bit offset from the start of the process image.
+static unsigned int lcec_din_bitpos(lcec_class_din_channel_t *data) {
+  if (data->pdo_bp_packed != 0xffff) {
+    return (data->pdo_os << 3) + data->pdo_bp_packed;
+  }
+  return (data->pdo_os << 3) + data->pdo_bp;
+}
+
+/// @brief Decides whether `lcec_din_read_all()` can read all channels as one word.
+///
+/// That is the case when every channel's bit is within the same 8
+/// bytes of process data, which covers EL1xxx terminals, EP/EJ
+/// modules, and packed inputs alike.  Runs on the first read, as PDO
+/// offsets aren't known before then.
+static void lcec_din_bulk_init(struct lcec_slave *slave, lcec_class_din_channels_t *channels) {
+  unsigned int pos, lo = ~0U, hi = 0;
+  int i, span, nbytes;
+
+  channels->bulk = -1;
+
+  for (i = 0; i < channels->count; i++) {
+    if (channels->channels[i] == NULL) {
+      return;
+    }
+    pos = lcec_din_bitpos(channels->channels[i]);
+    if (pos < lo) lo = pos;
+    if (pos > hi) hi = pos;
+  }
+
+  span = (hi >> 3) - (lo >> 3) + 1;
+  if (span > 8) {
+    return;
+  }
+
+  // prefer a naturally sized load, unless that would run past the end of the process image
+  nbytes = 1;
+  while (nbytes < span) {
+    nbytes <<= 1;
+  }
+  if ((lo >> 3) + nbytes > slave->master->process_data_len) {
+    nbytes = span;
+  }
+
+  channels->bulk_os = lo >> 3;
+  channels->bulk_nbytes = nbytes;
+  for (i = 0; i < channels->count; i++) {
+    channels->bulk_bit[i] = lcec_din_bitpos(channels->channels[i]) - (channels->bulk_os << 3);
+    channels->bulk_in[i] = channels->channels[i]->in;
+    channels->bulk_in_not[i] = channels->channels[i]->in_not;
+  }
+  channels->bulk = 1;
+}
+
 /// @brief reads data from all digital in ports.
 ///
+/// When all channels live in the same 8 bytes of process data, this
+/// loads them as one word and scatters the bits to the pins, instead
+/// of reading each channel separately.
+///
 /// @param slave The slave, passed from the per-device `_read`.
 /// @param channels An `lcec_class_din_channels_t *`, as returned by `lcec_din_allocate_channels()`.
 void lcec_din_read_all(struct lcec_slave *slave, lcec_class_din_channels_t *channels) {
-  for (int i = 0; i < channels->count; i++) {
-    lcec_class_din_channel_t *channel = channels->channels[i];
+  uint64_t w;
+  hal_bit_t s;
+  int i;
+
+  if (channels->bulk == 0) {
+    lcec_din_bulk_init(slave, channels);
+  }
+
+  if (channels->bulk < 0) {
+    for (i = 0; i < channels->count; i++) {
+      lcec_din_read(slave, channels->channels[i]);
+    }
+    return;
+  }
 
-    lcec_din_read(slave, channel);
+  w = lcec_pd_read_word(slave->master->process_data, channels->bulk_os, channels->bulk_nbytes);
+  for (i = 0; i < channels->count; i++) {
+    s = (w >> channels->bulk_bit[i]) & 1;
+    *(channels->bulk_in[i]) = s;
+    *(channels->bulk_in_not[i]) = !s;
   }
 }
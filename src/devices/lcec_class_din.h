@@ -30,9 +30,17 @@ typedef struct {
   unsigned int pdo_bp_packed;  ///< This bit's bit position in the master's PDO data structure, for packed din.
 } lcec_class_din_channel_t;
 
+#define LCEC_DIN_BULK_MAX_CHANNELS 64  ///< Most channels that `lcec_din_read_all()` can read as one word.
+
 typedef struct {
   int count;                            ///< The number of channels described by this structure.
   lcec_class_din_channel_t **channels;  ///< a dynamic array of `lcec_class_din_channel_t` channels.
+  int bulk;                             ///< Bulk mode: 0 until the first read, then 1 if all channels are read as one word, -1 if not.
+  unsigned int bulk_os;                 ///< Byte offset of the word holding all channels.
+  int bulk_nbytes;                      ///< Size of that word, in bytes.
+  uint8_t *bulk_bit;                    ///< Bit position of each channel in the word.
+  hal_bit_t **bulk_in;                  ///< `in` pin of each channel.
+  hal_bit_t **bulk_in_not;              ///< `in_not` pin of each channel.
 } lcec_class_din_channels_t;
 
 lcec_class_din_channels_t *lcec_din_allocate_channels(int count);
@@ -25,6 +25,9 @@
 
 #include "../lcec.h"
 
+/// @brief Channels of all slaves using this class, allocated one after the other.
+static lcec_block_t channel_block;
+
 static const lcec_pindesc_t slave_pins[] = {
     {HAL_BIT, HAL_IN, offsetof(lcec_class_dout_channel_t, out), "%s.%s.%s.%s"},
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
@@ -44,17 +47,38 @@ static const lcec_pindesc_t slave_params[] = {
 /// @param count The number of channels to allocate room for.
 lcec_class_dout_channels_t *lcec_dout_allocate_channels(int count) {
   lcec_class_dout_channels_t *channels;
+  size_t size;
+
+  // room for the channels, the pointers to them, and the bulk write arrays
+  size = LCEC_BLOCK_ALIGN(sizeof(lcec_class_dout_channels_t)) + LCEC_BLOCK_ALIGN(sizeof(lcec_class_dout_channel_t *) * count);
+  size += count * LCEC_BLOCK_ALIGN(sizeof(lcec_class_dout_channel_t));
+  size += LCEC_BLOCK_ALIGN(sizeof(uint8_t) * count) + 2 * LCEC_BLOCK_ALIGN(sizeof(hal_bit_t *) * count);
+  if (lcec_block_reserve(&channel_block, size) < 0) {
+    return NULL;
+  }
 
-  channels = hal_malloc(sizeof(lcec_class_dout_channels_t));
+  channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_dout_channels_t));
   if (channels == NULL) {
     return NULL;
   }
   channels->count = count;
-  channels->channels = hal_malloc(sizeof(lcec_class_dout_channel_t *) * count);
+  channels->channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_dout_channel_t *) * count);
   if (channels->channels == NULL) {
     return NULL;
   }
 
+  // room for bulk writes, see `lcec_dout_write_all()`
+  channels->bulk = -1;
+  if (count > 0 && count <= LCEC_DOUT_BULK_MAX_CHANNELS) {
+    channels->bulk_bit = lcec_block_alloc(&channel_block, sizeof(uint8_t) * count);
+    channels->bulk_out = lcec_block_alloc(&channel_block, sizeof(hal_bit_t *) * count);
+    channels->bulk_invert = lcec_block_alloc(&channel_block, sizeof(hal_bit_t *) * count);
+    if (channels->bulk_bit == NULL || channels->bulk_out == NULL || channels->bulk_invert == NULL) {
+      return NULL;
+    }
+    channels->bulk = 0;
+  }
+
   return channels;
 }
 
@@ -87,12 +111,12 @@ lcec_class_dout_channel_t *lcec_dout_register_channel_named(struct lcec_slave *s
   lcec_class_dout_channel_t *data;
   int err;
 
-  data = hal_malloc(sizeof(lcec_class_dout_channel_t));
+  data = lcec_block_alloc(&channel_block, sizeof(lcec_class_dout_channel_t));
   if (data == NULL) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %s failed\n", slave->master->name, slave->name, name);
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %s failed\n",
+        slave->master->name, slave->name, name);
     return NULL;
   }
-  memset(data, 0, sizeof(lcec_class_dout_channel_t));
   data->name = name;
   data->pdo_bp_packed = 0xffff;
 
@@ -129,12 +153,12 @@ lcec_class_dout_channel_t *lcec_dout_register_channel_packed(struct lcec_slave *
   lcec_class_dout_channel_t *data;
   int err;
 
-  data = hal_malloc(sizeof(lcec_class_dout_channel_t));
+  data = lcec_block_alloc(&channel_block, sizeof(lcec_class_dout_channel_t));
   if (data == NULL) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s pin %s failed\n", slave->master->name, slave->name, name);
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s pin %s failed\n",
+        slave->master->name, slave->name, name);
     return NULL;
   }
-  memset(data, 0, sizeof(lcec_class_dout_channel_t));
 
   // Register the whole PDO, hopefully this does the sane thing if we register the same PDO repeatedly.
   lcec_pdo_init(slave, idx, sidx, &data->pdo_os, &data->pdo_bp);
@@ -182,15 +206,94 @@ void lcec_dout_write(struct lcec_slave *slave, lcec_class_dout_channel_t *data)
   EC_WRITE_BIT(&pd[os], bp, s);
 }
 
+/// @brief Returns a channel's bit offset from the start of the process image.
+static unsigned int lcec_dout_bitpos(lcec_class_dout_channel_t *data) {
+  if (data->pdo_bp_packed != 0xffff) {
+    return (data->pdo_os << 3) + data->pdo_bp_packed;
+  }
+  return (data->pdo_os << 3) + data->pdo_bp;
+}
+
+/// @brief Decides whether `lcec_dout_write_all()` can write all channels as one word.
+///
+/// Same rules as for digital inputs: every channel's bit has to be
+/// within the same 8 bytes of process data.  Runs on the first write,
+/// as PDO offsets aren't known before then.
+static void lcec_dout_bulk_init(struct lcec_slave *slave, lcec_class_dout_channels_t *channels) {
+  unsigned int pos, lo = ~0U, hi = 0;
+  int i, span, nbytes;
+
+  channels->bulk = -1;
+
+  for (i = 0; i < channels->count; i++) {
+    if (channels->channels[i] == NULL) {
+      return;
+    }
+    pos = lcec_dout_bitpos(channels->channels[i]);
+    if (pos < lo) lo = pos;
+    if (pos > hi) hi = pos;
+  }
+
+  span = (hi >> 3) - (lo >> 3) + 1;
+  if (span > 8) {
+    return;
+  }
+
+  // prefer a naturally sized access, unless that would run past the end of the process image
+  nbytes = 1;
+  while (nbytes < span) {
+    nbytes <<= 1;
+  }
+  if ((lo >> 3) + nbytes > slave->master->process_data_len) {
+    nbytes = span;
+  }
+
+  channels->bulk_os = lo >> 3;
+  channels->bulk_nbytes = nbytes;
+  channels->bulk_mask = 0;
+  for (i = 0; i < channels->count; i++) {
+    channels->bulk_bit[i] = lcec_dout_bitpos(channels->channels[i]) - (channels->bulk_os << 3);
+    channels->bulk_out[i] = channels->channels[i]->out;
+    channels->bulk_invert[i] = &channels->channels[i]->invert;
+    channels->bulk_mask |= 1ULL << channels->bulk_bit[i];
+  }
+  channels->bulk = 1;
+}
+
 /// @brief Write data to all digital out channels attached to this device.
 ///
+/// When all channels live in the same 8 bytes of process data, this
+/// gathers the pins into one word, applies the `invert` params as a
+/// single XOR mask, and updates the process data with one
+/// read-modify-write, instead of one per channel.  As with separate
+/// writes, the last channel wins if several share a bit.
+///
 /// @param slave The slave, passed from the per-device `_write`.
 /// @param channels A `lcec_class_dout_channels_t *`, as returned by
 /// `lcec_dout_register_channel`.
 void lcec_dout_write_all(struct lcec_slave *slave, lcec_class_dout_channels_t *channels) {
-  for (int i = 0; i < channels->count; i++) {
-    lcec_class_dout_channel_t *channel = channels->channels[i];
+  uint8_t *pd = slave->master->process_data;
+  uint64_t w, val = 0, invert = 0, bit;
+  int i;
+
+  if (channels->bulk == 0) {
+    lcec_dout_bulk_init(slave, channels);
+  }
 
-    lcec_dout_write(slave, channel);
+  if (channels->bulk < 0) {
+    for (i = 0; i < channels->count; i++) {
+      lcec_dout_write(slave, channels->channels[i]);
+    }
+    return;
   }
+
+  for (i = 0; i < channels->count; i++) {
+    bit = 1ULL << channels->bulk_bit[i];
+    val = *(channels->bulk_out[i]) ? (val | bit) : (val & ~bit);
+    invert = *(channels->bulk_invert[i]) ? (invert | bit) : (invert & ~bit);
+  }
+
+  w = lcec_pd_read_word(pd, channels->bulk_os, channels->bulk_nbytes);
+  w = (w & ~channels->bulk_mask) | ((val ^ invert) & channels->bulk_mask);
+  lcec_pd_write_word(pd, channels->bulk_os, channels->bulk_nbytes, w);
 }
@@ -30,9 +30,18 @@ typedef struct {
   unsigned int pdo_bp_packed;  ///< Controls is this is a packed-bit port, where more than one channel is found in a single PDO entry.
 } lcec_class_dout_channel_t;
 
+#define LCEC_DOUT_BULK_MAX_CHANNELS 64  ///< Most channels that `lcec_dout_write_all()` can write as one word.
+
 typedef struct {
   int count;
   lcec_class_dout_channel_t **channels;
+  int bulk;                  ///< Bulk mode: 0 until the first write, then 1 if all channels are written as one word, -1 if not.
+  unsigned int bulk_os;      ///< Byte offset of the word holding all channels.
+  int bulk_nbytes;           ///< Size of that word, in bytes.
+  uint64_t bulk_mask;        ///< Bits of the word that belong to channels.
+  uint8_t *bulk_bit;         ///< Bit position of each channel in the word.
+  hal_bit_t **bulk_out;      ///< `out` pin of each channel.
+  hal_bit_t **bulk_invert;   ///< `invert` param of each channel.
 } lcec_class_dout_channels_t;
 
 lcec_class_dout_channels_t *lcec_dout_allocate_channels(int count);
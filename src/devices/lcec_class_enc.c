@@ -34,11 +34,25 @@ static const lcec_pindesc_t slave_pins[] = {
     {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_enc_data_t, pos_enc), "%s.%s.%s.%s-pos-enc"},
     {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_enc_data_t, pos_abs), "%s.%s.%s.%s-pos-abs"},
     {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_enc_data_t, pos), "%s.%s.%s.%s-pos"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_enc_data_t, latch_valid), "%s.%s.%s.%s-latch-valid"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_enc_data_t, latch_pos), "%s.%s.%s.%s-latch-pos"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_enc_data_t, latch_time), "%s.%s.%s.%s-latch-time"},
     {HAL_BIT, HAL_OUT, offsetof(lcec_class_enc_data_t, on_home_neg), "%s.%s.%s.%s-on-home-neg"},
     {HAL_BIT, HAL_OUT, offsetof(lcec_class_enc_data_t, on_home_pos), "%s.%s.%s.%s-on-home-pos"},
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
 };
 
+static const lcec_pindesc_t vel_pins[] = {
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_enc_vel_t, vel), "%s.%s.%s.%s-vel"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+static const lcec_pindesc_t vel_params[] = {
+    {HAL_U32, HAL_RW, offsetof(lcec_class_enc_vel_t, mode), "%s.%s.%s.%s-vel-mode"},
+    {HAL_U32, HAL_RW, offsetof(lcec_class_enc_vel_t, window), "%s.%s.%s.%s-vel-window"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
 static const lcec_pindesc_t slave_params[] = {
     {HAL_U32, HAL_RW, offsetof(lcec_class_enc_data_t, raw_home), "%s.%s.%s.%s-raw-home"},
     {HAL_U32, HAL_RO, offsetof(lcec_class_enc_data_t, raw_bits), "%s.%s.%s.%s-raw-bits"},
@@ -64,6 +78,12 @@ int class_enc_init(struct lcec_slave *slave, lcec_class_enc_data_t *hal_data, in
     return err;
   }
 
+  // export velocity estimator
+  if ((err = class_enc_vel_init(slave, &hal_data->vel, pfx)) != 0) {
+    return err;
+  }
+
+  hal_data->master = master;
   hal_data->do_init = 1;
   hal_data->index_sign = 0;
 
@@ -79,7 +99,7 @@ int class_enc_init(struct lcec_slave *slave, lcec_class_enc_data_t *hal_data, in
 
 void class_enc_update(
     lcec_class_enc_data_t *hal_data, uint64_t pprev, double scale, uint32_t raw, uint32_t ext_latch_raw, int ext_latch_ena) {
-  long long pos, mod;
+  long long pos, mod, latch;
   uint32_t ovfl_win;
   int sign;
   double pos_scale;
@@ -112,6 +132,10 @@ void class_enc_update(
 
   // set raw encoder pos
   *(hal_data->pos_enc) = ((double)pos) * pos_scale;
+  if (hal_data->do_init) {
+    class_enc_vel_reset(&hal_data->vel);
+  }
+  class_enc_vel_update(&hal_data->vel, hal_data->master->period_last, pos, pos_scale);
 
   // calculate home based abs pos
   pos += raw_diff(hal_data->raw_shift, 0, hal_data->raw_home);
@@ -141,9 +165,16 @@ void class_enc_update(
   }
 
   // handle external latch
+  *(hal_data->latch_valid) = ext_latch_ena;
   if (ext_latch_ena) {
-    set_ref(hal_data, pos + raw_diff(hal_data->raw_shift, ext_latch_raw, raw));
+    latch = pos + raw_diff(hal_data->raw_shift, ext_latch_raw, raw);
+    set_ref(hal_data, latch);
+    hal_data->ref_frac = hal_data->latch_frac;
+    *(hal_data->latch_pos) = ((double)latch + hal_data->latch_frac) * pos_scale;
+    *(hal_data->latch_time) = (double)hal_data->latch_dt * 1e-9;
   }
+  hal_data->latch_frac = 0.0;
+  hal_data->latch_dt = 0;
 
   // handle rel position init
   if (hal_data->do_init || *(hal_data->pos_reset)) {
@@ -152,14 +183,179 @@ void class_enc_update(
 
   // calculate rel pos
   pos -= ((long long)*(hal_data->ref_hi) << 32) | *(hal_data->ref_lo);
-  *(hal_data->pos) = ((double)pos) * pos_scale;
+  *(hal_data->pos) = ((double)pos - hal_data->ref_frac) * pos_scale;
 
   hal_data->do_init = 0;
 }
 
+/// @brief Export the pins and parameters of a velocity estimator.
+///
+/// Exports `<pfx>-vel`, `<pfx>-vel-mode`, and `<pfx>-vel-window`.
+/// `class_enc_init()` calls this for its own estimator; drivers that
+/// keep their own counters can embed a `lcec_class_enc_vel_t` and
+/// feed it with `class_enc_vel_update()`.
+///
+/// @param slave The slave.
+/// @param vel The estimator, in HAL memory.
+/// @param pfx The pin name prefix, e.g. `enc`.
+/// @return 0 on success, a HAL error otherwise.
+int class_enc_vel_init(struct lcec_slave *slave, lcec_class_enc_vel_t *vel, const char *pfx) {
+  lcec_master_t *master = slave->master;
+  int err;
+
+  if ((err = lcec_pin_newf_list(vel, vel_pins, LCEC_MODULE_NAME, master->name, slave->name, pfx)) != 0) {
+    return err;
+  }
+  if ((err = lcec_param_newf_list(vel, vel_params, LCEC_MODULE_NAME, master->name, slave->name, pfx)) != 0) {
+    return err;
+  }
+
+  vel->mode = LCEC_ENC_VEL_DIFF;
+  vel->window = 8;
+  vel->period = 0;
+  vel->do_init = 1;
+
+  return 0;
+}
+
+/// @brief Restart a velocity estimator.
+///
+/// Call this whenever the position passed to `class_enc_vel_update()`
+/// jumps, e.g. when the device's counter is set.  The next update
+/// then outputs 0 and starts estimating from there.
+void class_enc_vel_reset(lcec_class_enc_vel_t *vel) { vel->do_init = 1; }
+
+/// @brief Estimate velocity from a position.
+///
+/// Runs once per read cycle.
+///
+/// @param vel The estimator.
+/// @param period The time since the previous position in ns, usually the thread period.
+/// @param pos The position in counts, continuous across counter wraps.
+/// @param pos_scale Position units per count.
+void class_enc_vel_update(lcec_class_enc_vel_t *vel, long period, long long pos, double pos_scale) {
+  uint32_t window;
+  long long delta;
+  double bound;
+  int i;
+
+  if (period <= 0) {
+    *(vel->vel) = 0.0;
+    return;
+  }
+  if (period != vel->period) {
+    vel->period = period;
+    vel->period_recip = 1e9 / (double)period;
+  }
+
+  window = vel->window;
+  if (window < 1) window = 1;
+  if (window > LCEC_ENC_VEL_MAX_WINDOW) window = LCEC_ENC_VEL_MAX_WINDOW;
+
+  // start over on init and whenever the estimator changes
+  if (vel->do_init || vel->mode != vel->mode_last || window != vel->window_last) {
+    vel->do_init = 0;
+    vel->mode_last = vel->mode;
+    vel->window_last = window;
+    vel->window_recip = 1.0 / (double)window;
+    vel->last_pos = pos;
+    vel->edge_pos = pos;
+    vel->edge_time = 0;
+    vel->hist_pos = 0;
+    for (i = 0; i < window; i++) {
+      vel->hist[i] = pos;
+    }
+    *(vel->vel) = 0.0;
+    return;
+  }
+
+  switch (vel->mode) {
+    case LCEC_ENC_VEL_DIFF:
+      *(vel->vel) = (double)(pos - vel->last_pos) * pos_scale * vel->period_recip;
+      break;
+
+    case LCEC_ENC_VEL_WINDOW:
+      // hist holds the last `window` positions, oldest first at hist_pos
+      delta = pos - vel->hist[vel->hist_pos];
+      vel->hist[vel->hist_pos] = pos;
+      if (++vel->hist_pos >= window) vel->hist_pos = 0;
+      *(vel->vel) = (double)delta * pos_scale * vel->period_recip * vel->window_recip;
+      break;
+
+    case LCEC_ENC_VEL_PERIOD:
+      vel->edge_time += period;
+      delta = pos - vel->edge_pos;
+      if (delta != 0) {
+        *(vel->vel) = (double)delta * pos_scale * 1e9 / (double)vel->edge_time;
+        vel->edge_pos = pos;
+        vel->edge_time = 0;
+      } else if (vel->edge_time >= LCEC_ENC_VEL_TIMEOUT) {
+        *(vel->vel) = 0.0;
+        vel->edge_time = LCEC_ENC_VEL_TIMEOUT;
+      } else {
+        // no new count yet, so the axis is moving at most one count per elapsed time
+        bound = fabs(pos_scale) * 1e9 / (double)vel->edge_time;
+        if (*(vel->vel) > bound) {
+          *(vel->vel) = bound;
+        } else if (*(vel->vel) < -bound) {
+          *(vel->vel) = -bound;
+        }
+      }
+      break;
+
+    default:
+      *(vel->vel) = 0.0;
+      break;
+  }
+
+  vel->last_pos = pos;
+}
+
+/// @brief Update an encoder whose latch reports a DC time instead of a count.
+///
+/// The latched position is interpolated between the previous and the
+/// current sample, using `raw_time` (the DC time `raw` was sampled
+/// at) and `latch_time` (the DC time of the latch event).  Both are
+/// the low 32 bits of the DC system time in ns.  Apart from the
+/// latch, this behaves exactly like `class_enc_update()`.
+void class_enc_update_timed(
+    lcec_class_enc_data_t *hal_data, uint64_t pprev, double scale, uint32_t raw, uint32_t raw_time, uint32_t latch_time, int latch_ena) {
+  int32_t span, offset, delta;
+  double count;
+  long long whole;
+
+  if (latch_ena) {
+    span = (int32_t)(raw_time - hal_data->raw_time_last);
+    offset = (int32_t)(latch_time - hal_data->raw_time_last);
+
+    // without a previous sample to interpolate from, latch the current position
+    if (hal_data->do_init || span <= 0) {
+      offset = span;
+    } else if (offset < 0) {
+      offset = 0;
+    } else if (offset > span) {
+      offset = span;
+    }
+
+    delta = raw_diff(hal_data->raw_shift, raw, *(hal_data->raw));
+    count = (span > 0) ? (double)delta * (double)offset / (double)span : (double)delta;
+    whole = (long long)floor(count);
+
+    // counts relative to the current sample, so class_enc_update() can extend them to 64 bits
+    hal_data->latch_frac = count - (double)whole;
+    hal_data->latch_dt = offset - span;
+    class_enc_update(hal_data, pprev, scale, raw, *(hal_data->raw) + (uint32_t)whole, 1);
+  } else {
+    class_enc_update(hal_data, pprev, scale, raw, 0, 0);
+  }
+
+  hal_data->raw_time_last = raw_time;
+}
+
 static int32_t raw_diff(int shift, uint32_t a, uint32_t b) { return ((int32_t)(a << shift) - (int32_t)(b << shift)) >> shift; }
 
 static void set_ref(lcec_class_enc_data_t *hal_data, long long ref) {
+  hal_data->ref_frac = 0.0;
   *(hal_data->ref_hi) = (uint32_t)(ref >> 32);
   *(hal_data->ref_lo) = (uint32_t)ref;
 }
@@ -24,6 +24,37 @@
 
 #include "../lcec.h"
 
+// Velocity estimators, selected with the `<pfx>-vel-mode` parameter.
+#define LCEC_ENC_VEL_OFF    0  ///< No velocity estimate, `<pfx>-vel` stays at 0.
+#define LCEC_ENC_VEL_DIFF   1  ///< Position difference of the last cycle.
+#define LCEC_ENC_VEL_WINDOW 2  ///< Position difference over the last `<pfx>-vel-window` cycles.
+#define LCEC_ENC_VEL_PERIOD 3  ///< Counts divided by the time between count changes (1/T).
+
+#define LCEC_ENC_VEL_MAX_WINDOW 64            ///< Largest supported `<pfx>-vel-window`.
+#define LCEC_ENC_VEL_TIMEOUT    1000000000LL  ///< ns without a count change before the 1/T estimate drops to 0.
+
+/// @brief Velocity estimator state, see `class_enc_vel_init()`.
+///
+/// Embedded in `lcec_class_enc_data_t`, and in the channel data of
+/// drivers that keep their own counters.
+typedef struct {
+  hal_u32_t mode;    ///< Estimator, one of `LCEC_ENC_VEL_*`.
+  hal_u32_t window;  ///< Window size in cycles for `LCEC_ENC_VEL_WINDOW`.
+  hal_float_t *vel;  ///< Estimated velocity, in position units per second.
+
+  int do_init;
+  uint32_t mode_last;
+  uint32_t window_last;
+  long period;
+  double period_recip;
+  double window_recip;
+  long long last_pos;
+  long long edge_pos;
+  long long edge_time;
+  int hist_pos;
+  long long hist[LCEC_ENC_VEL_MAX_WINDOW];
+} lcec_class_enc_vel_t;
+
 typedef struct {
   hal_s32_t raw_home;
   hal_u32_t raw_bits;
@@ -42,6 +73,10 @@ typedef struct {
   hal_float_t *pos_abs;
   hal_float_t *pos;
 
+  hal_bit_t *latch_valid;
+  hal_float_t *latch_pos;
+  hal_float_t *latch_time;
+
   hal_bit_t *on_home_neg;
   hal_bit_t *on_home_pos;
 
@@ -54,10 +89,24 @@ typedef struct {
 
   int index_sign;
 
+  double ref_frac;
+  double latch_frac;
+  int32_t latch_dt;
+  uint32_t raw_time_last;
+
+  lcec_master_t *master;
+
+  lcec_class_enc_vel_t vel;
+
 } lcec_class_enc_data_t;
 
+int class_enc_vel_init(struct lcec_slave *slave, lcec_class_enc_vel_t *vel, const char *pfx);
+void class_enc_vel_reset(lcec_class_enc_vel_t *vel);
+void class_enc_vel_update(lcec_class_enc_vel_t *vel, long period, long long pos, double pos_scale);
 int class_enc_init(struct lcec_slave *slave, lcec_class_enc_data_t *hal_data, int raw_bits, const char *pfx);
 void class_enc_update(
     lcec_class_enc_data_t *hal_data, uint64_t pprev, double scale, uint32_t raw, uint32_t ext_latch_raw, int ext_latch_ena);
+void class_enc_update_timed(
+    lcec_class_enc_data_t *hal_data, uint64_t pprev, double scale, uint32_t raw, uint32_t raw_time, uint32_t latch_time, int latch_ena);
 
 #endif
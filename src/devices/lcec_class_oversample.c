@@ -0,0 +1,475 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Library for oversampling devices.
+///
+/// Oversampling devices transfer several samples per channel in every
+/// cycle, taken (or output) at equal intervals, triggered by the
+/// slave's distributed clock.  This class maps the sample arrays,
+/// publishes per-cycle summaries as HAL pins, and optionally streams
+/// every sample into a shared memory ring (see `lcec_samples.h`) for
+/// userspace tools, so full-rate data is available without running a
+/// HAL thread at the sample rate.
+
+#include "lcec_class_oversample.h"
+
+#include "../lcec.h"
+
+#define LCEC_OVERSAMPLE_MAX_RING 65536  ///< Largest sample ring, in cycles.
+
+/// @brief Devices using this class, allocated one after the other.
+static lcec_block_t channel_block;
+
+/// @brief HAL pins for analog inputs.
+static const lcec_pindesc_t slave_pins_ain[] = {
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, min), "%s.%s.%s.%s-%d-min"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, max), "%s.%s.%s.%s-%d-max"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, mean), "%s.%s.%s.%s-%d-mean"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, last), "%s.%s.%s.%s-%d-last"},
+    {HAL_S32, HAL_OUT, offsetof(lcec_class_oversample_channel_t, raw), "%s.%s.%s.%s-%d-raw"},
+    {HAL_FLOAT, HAL_IO, offsetof(lcec_class_oversample_channel_t, scale), "%s.%s.%s.%s-%d-scale"},
+    {HAL_FLOAT, HAL_IO, offsetof(lcec_class_oversample_channel_t, bias), "%s.%s.%s.%s-%d-bias"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+/// @brief HAL pins for digital inputs.
+static const lcec_pindesc_t slave_pins_din[] = {
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, bit), "%s.%s.%s.%s-%d"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, bit_min), "%s.%s.%s.%s-%d-min"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, bit_max), "%s.%s.%s.%s-%d-max"},
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_class_oversample_channel_t, mean), "%s.%s.%s.%s-%d-mean"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+/// @brief HAL pins for analog outputs.
+static const lcec_pindesc_t slave_pins_aout[] = {
+    {HAL_FLOAT, HAL_IN, offsetof(lcec_class_oversample_channel_t, value), "%s.%s.%s.%s-%d-value"},
+    {HAL_FLOAT, HAL_IO, offsetof(lcec_class_oversample_channel_t, scale), "%s.%s.%s.%s-%d-scale"},
+    {HAL_FLOAT, HAL_IO, offsetof(lcec_class_oversample_channel_t, offset), "%s.%s.%s.%s-%d-offset"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_oversample_channel_t, enable), "%s.%s.%s.%s-%d-enable"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_oversample_channel_t, interpolate), "%s.%s.%s.%s-%d-interpolate"},
+    {HAL_S32, HAL_OUT, offsetof(lcec_class_oversample_channel_t, raw), "%s.%s.%s.%s-%d-raw"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+/// @brief HAL pins for digital outputs.
+static const lcec_pindesc_t slave_pins_dout[] = {
+    {HAL_BIT, HAL_IN, offsetof(lcec_class_oversample_channel_t, bit), "%s.%s.%s.%s-%d"},
+    {HAL_FLOAT, HAL_IN, offsetof(lcec_class_oversample_channel_t, edge), "%s.%s.%s.%s-%d-edge"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
+// Builds the sync manager config for `samples` samples per channel.
+//
+// This easily needs more PDOs and entries than fit into an
+// `lcec_syncs_t`, so it is allocated like a generic slave's config
+// and freed by `lcec_slave_release_config()` once the master is
+// active.
+static int init_syncs(struct lcec_slave *slave, const lcec_class_oversample_options_t *opt, int samples) {
+  const lcec_class_oversample_map_t *map;
+  ec_pdo_entry_info_t *entries, *entry;
+  ec_pdo_info_t *pdos, *pdo;
+  ec_sync_info_t *syncs;
+  int pdo_count = 0;
+  int ch, k;
+
+  for (ch = 0; ch < opt->channel_count; ch++) {
+    pdo_count += (opt->maps[ch].pdo_step != 0) ? samples : 1;
+  }
+
+  entries = lcec_zalloc(sizeof(ec_pdo_entry_info_t) * opt->channel_count * samples);
+  pdos = lcec_zalloc(sizeof(ec_pdo_info_t) * pdo_count);
+  syncs = lcec_zalloc(sizeof(ec_sync_info_t) * 2);
+  if (entries == NULL || pdos == NULL || syncs == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "Unable to allocate sync config for slave %s.%s\n", slave->master->name, slave->name);
+    if (entries != NULL) lcec_free(entries);
+    if (pdos != NULL) lcec_free(pdos);
+    if (syncs != NULL) lcec_free(syncs);
+    return -ENOMEM;
+  }
+
+  entry = entries;
+  pdo = pdos;
+  for (ch = 0; ch < opt->channel_count; ch++) {
+    map = &opt->maps[ch];
+    for (k = 0; k < samples; k++) {
+      if (k == 0 || map->pdo_step != 0) {
+        pdo->index = map->pdo_idx + k * map->pdo_step;
+        pdo->entries = entry;
+        pdo++;
+      }
+      (pdo - 1)->n_entries++;
+
+      entry->index = map->entry_idx + k * map->entry_idx_step;
+      entry->subindex = map->entry_sidx + k * map->entry_sidx_step;
+      entry->bit_length = opt->sample_bits;
+      entry++;
+    }
+  }
+
+  syncs[0].index = opt->sync_index;
+  syncs[0].dir = opt->is_output ? EC_DIR_OUTPUT : EC_DIR_INPUT;
+  syncs[0].n_pdos = pdo_count;
+  syncs[0].pdos = pdos;
+  syncs[0].watchdog_mode = EC_WD_DEFAULT;
+  syncs[1].index = 0xff;
+
+  slave->generic_pdo_entries = entries;
+  slave->generic_pdos = pdos;
+  slave->generic_sync_managers = syncs;
+  slave->sync_info = syncs;
+  return 0;
+}
+
+// Creates the shared memory sample ring, rounding `size` up to a power of two.
+static int init_ring(struct lcec_slave *slave, lcec_class_oversample_t *data, uint32_t size) {
+  LCEC_SAMPLES_RING_T *ring;
+  void *shmem_ptr;
+  uint32_t blocks;
+  size_t length;
+
+  for (blocks = 1; blocks < size; blocks <<= 1)
+    ;
+  length = LCEC_SAMPLES_BYTES(blocks, data->channel_count, data->samples);
+
+  data->ring_shmem_id = rtapi_shmem_new(LCEC_SAMPLES_SHMEM_KEY(slave->master->index, slave->index), data->comp_id, length);
+  if (data->ring_shmem_id < 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "couldn't allocate sample ring for slave %s.%s\n", slave->master->name, slave->name);
+    return -ENOMEM;
+  }
+  if (lcec_rtapi_shmem_getptr(data->ring_shmem_id, &shmem_ptr) < 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "couldn't map sample ring for slave %s.%s\n", slave->master->name, slave->name);
+    rtapi_shmem_delete(data->ring_shmem_id, data->comp_id);
+    return -ENOMEM;
+  }
+
+  ring = shmem_ptr;
+  memset(ring, 0, length);
+  ring->length = length;
+  ring->master_index = slave->master->index;
+  ring->slave_index = slave->index;
+  ring->size = blocks;
+  ring->channels = data->channel_count;
+  ring->samples = data->samples;
+  ring->block_size = LCEC_SAMPLES_BLOCK_BYTES(data->channel_count, data->samples);
+  ring->is_output = data->options->is_output;
+  lcec_wmb();
+  ring->magic = LCEC_SAMPLES_SHMEM_MAGIC;
+
+  data->ring = ring;
+  return 0;
+}
+
+/// @brief Set up an oversampling device.
+///
+/// Configures the slave's sync manager for `samples` samples per
+/// channel, registers the PDO entries and HAL pins for each channel,
+/// and creates the sample ring if `ring_size` is set.
+///
+/// @param comp_id The HAL component ID, from `_init`.
+/// @param slave The slave, from `_init`.
+/// @param opt Description of the device.  Must stay valid for the lifetime of the device.
+/// @param samples Samples per channel and cycle (the oversampling factor).
+/// @param ring_size Number of cycles to keep in the sample ring, 0 to disable it.
+/// @return A `lcec_class_oversample_t` for use with `lcec_oversample_read()` or `lcec_oversample_write()`, or NULL on failure.
+lcec_class_oversample_t *lcec_oversample_register(
+    int comp_id, struct lcec_slave *slave, const lcec_class_oversample_options_t *opt, int samples, uint32_t ring_size) {
+  lcec_master_t *master = slave->master;
+  const lcec_class_oversample_map_t *map;
+  lcec_class_oversample_channel_t *chan;
+  lcec_class_oversample_t *data;
+  const lcec_pindesc_t *pins;
+  size_t size;
+  int ch, err;
+
+  if (samples < 1 || samples > opt->max_samples) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "slave %s.%s: oversampling factor must be between 1 and %d, not %d\n", master->name,
+        slave->name, opt->max_samples, samples);
+    return NULL;
+  }
+  if (ring_size > LCEC_OVERSAMPLE_MAX_RING) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "slave %s.%s: sample ring can hold at most %d cycles, not %u\n", master->name,
+        slave->name, LCEC_OVERSAMPLE_MAX_RING, ring_size);
+    return NULL;
+  }
+
+  size = LCEC_BLOCK_ALIGN(sizeof(lcec_class_oversample_t)) + LCEC_BLOCK_ALIGN(sizeof(lcec_class_oversample_channel_t) * opt->channel_count);
+  if (lcec_block_reserve(&channel_block, size) < 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_reserve() for slave %s.%s failed\n", master->name, slave->name);
+    return NULL;
+  }
+  data = lcec_block_alloc(&channel_block, sizeof(lcec_class_oversample_t));
+  if (data == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s failed\n", master->name, slave->name);
+    return NULL;
+  }
+  data->channels = lcec_block_alloc(&channel_block, sizeof(lcec_class_oversample_channel_t) * opt->channel_count);
+  if (data->channels == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_block_alloc() for slave %s.%s failed\n", master->name, slave->name);
+    return NULL;
+  }
+  data->options = opt;
+  data->samples = samples;
+  data->channel_count = opt->channel_count;
+  data->recip_max = (opt->max_value != 0) ? 1.0 / (double)opt->max_value : 1.0;
+  data->recip_samples = 1.0 / (double)samples;
+  data->comp_id = comp_id;
+
+  if (init_syncs(slave, opt, samples) != 0) {
+    return NULL;
+  }
+
+  if (opt->is_output) {
+    pins = (opt->sample_bits == 1) ? slave_pins_dout : slave_pins_aout;
+  } else {
+    pins = (opt->sample_bits == 1) ? slave_pins_din : slave_pins_ain;
+  }
+
+  for (ch = 0; ch < data->channel_count; ch++) {
+    chan = &data->channels[ch];
+    map = &opt->maps[ch];
+
+    // Only the first and last sample are registered.  The ones in
+    // between follow the first, as EtherLab maps a sync manager's PDOs
+    // back to back; `check_layout()` verifies that on the first cycle.
+    lcec_pdo_init(slave, map->entry_idx, map->entry_sidx, &chan->first_os, &chan->first_bp);
+    if (samples > 1) {
+      lcec_pdo_init(slave, map->entry_idx + (samples - 1) * map->entry_idx_step, map->entry_sidx + (samples - 1) * map->entry_sidx_step,
+          &chan->last_os, &chan->last_bp);
+    }
+
+    err = lcec_pin_newf_list(chan, pins, LCEC_MODULE_NAME, master->name, slave->name, opt->name_prefix, ch);
+    if (err != 0) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_pin_newf_list for slave %s.%s channel %d failed\n", master->name, slave->name, ch);
+      return NULL;
+    }
+    if (chan->scale != NULL) *(chan->scale) = 1.0;
+  }
+
+  if (slave->dc_conf == NULL) {
+    rtapi_print_msg(RTAPI_MSG_WARN, LCEC_MSG_PFX "slave %s.%s: oversampling devices need a <dcConf> to sample at regular intervals\n",
+        master->name, slave->name);
+  }
+
+  if (ring_size > 0 && init_ring(slave, data, ring_size) != 0) {
+    return NULL;
+  }
+
+  return data;
+}
+
+/// @brief Release resources held by an oversampling device.
+///
+/// Call this from the device's `proc_cleanup`.
+void lcec_oversample_cleanup(lcec_class_oversample_t *data) {
+  if (data != NULL && data->ring != NULL) {
+    rtapi_shmem_delete(data->ring_shmem_id, data->comp_id);
+    data->ring = NULL;
+  }
+}
+
+// Checks that each channel's samples ended up back to back in the process data.
+static int check_layout(struct lcec_slave *slave, lcec_class_oversample_t *data) {
+  lcec_class_oversample_channel_t *chan;
+  unsigned int first, last;
+  int ch;
+
+  if (data->samples == 1) {
+    return 1;
+  }
+
+  for (ch = 0; ch < data->channel_count; ch++) {
+    chan = &data->channels[ch];
+    first = chan->first_os * 8 + chan->first_bp;
+    last = chan->last_os * 8 + chan->last_bp;
+    if (last != first + (data->samples - 1) * data->options->sample_bits) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "slave %s.%s channel %d: samples are not contiguous in the process data, disabling\n",
+          slave->master->name, slave->name, ch);
+      return -1;
+    }
+  }
+  return 1;
+}
+
+// Reads sample `k` of a channel.
+static inline int32_t read_sample(const uint8_t *pd, const lcec_class_oversample_channel_t *chan, int bits, int k) {
+  unsigned int bit;
+
+  if (bits == 1) {
+    bit = chan->first_bp + k;
+    return EC_READ_BIT(&pd[chan->first_os + bit / 8], bit % 8);
+  }
+  return EC_READ_S16(&pd[chan->first_os + 2 * k]);
+}
+
+// Writes sample `k` of a channel.
+static inline void write_sample(uint8_t *pd, const lcec_class_oversample_channel_t *chan, int bits, int k, int32_t value) {
+  unsigned int bit;
+
+  if (bits == 1) {
+    bit = chan->first_bp + k;
+    EC_WRITE_BIT(&pd[chan->first_os + bit / 8], bit % 8, value);
+    return;
+  }
+  EC_WRITE_S16(&pd[chan->first_os + 2 * k], value);
+}
+
+/// @brief Read all samples of an oversampling input device.
+///
+/// Updates the per-cycle pins of each channel and appends the samples
+/// to the sample ring, if enabled.  The samples delivered in a cycle
+/// were taken during the previous cycle; their timestamps are derived
+/// from the master's application time.
+///
+/// @param slave The `slave`, passed from the per-device `_read`.
+/// @param data The device, as returned by `lcec_oversample_register()`.
+/// @param period The thread period, passed from the per-device `_read`.
+void lcec_oversample_read(struct lcec_slave *slave, lcec_class_oversample_t *data, long period) {
+  lcec_master_t *master = slave->master;
+  uint8_t *pd = master->process_data;
+  int bits = data->options->sample_bits;
+  lcec_class_oversample_channel_t *chan;
+  LCEC_SAMPLES_BLOCK_T *block = NULL;
+  int32_t value = 0, value_min = 0, value_max = 0;
+  int64_t sum;
+  double factor;
+  int ch, k;
+
+  if (data->layout_state == 0) data->layout_state = check_layout(slave, data);
+  if (data->layout_state < 0) return;
+
+  if (data->ring != NULL) block = LCEC_SAMPLES_BLOCK(data->ring, data->ring->head);
+
+  for (ch = 0; ch < data->channel_count; ch++) {
+    chan = &data->channels[ch];
+    sum = 0;
+    for (k = 0; k < data->samples; k++) {
+      value = read_sample(pd, chan, bits, k);
+      if (k == 0 || value < value_min) value_min = value;
+      if (k == 0 || value > value_max) value_max = value;
+      sum += value;
+      if (block != NULL) block->samples[k * data->channel_count + ch] = value;
+    }
+
+    if (bits == 1) {
+      *(chan->bit) = value;
+      *(chan->bit_min) = value_min;
+      *(chan->bit_max) = value_max;
+      *(chan->mean) = (double)sum * data->recip_samples;
+    } else {
+      factor = *(chan->scale) * data->recip_max;
+      *(chan->min) = *(chan->bias) + factor * (double)value_min;
+      *(chan->max) = *(chan->bias) + factor * (double)value_max;
+      *(chan->mean) = *(chan->bias) + factor * (double)sum * data->recip_samples;
+      *(chan->last) = *(chan->bias) + factor * (double)value;
+      *(chan->raw) = value;
+    }
+  }
+
+  if (block != NULL) {
+    block->timestamp = lcec_master_app_time(master) - period;
+    block->interval = period / data->samples;
+    lcec_wmb();
+    data->ring->head++;
+  }
+}
+
+/// @brief Write all samples of an oversampling output device.
+///
+/// Analog channels either step to the new value at the start of the
+/// cycle or, with `interpolate` set, ramp linearly from the previous
+/// cycle's value.  Digital channels switch at the position given by
+/// `edge` when their value changes.  Samples written are appended to
+/// the sample ring, if enabled.
+///
+/// @param slave The `slave`, passed from the per-device `_write`.
+/// @param data The device, as returned by `lcec_oversample_register()`.
+/// @param period The thread period, passed from the per-device `_write`.
+void lcec_oversample_write(struct lcec_slave *slave, lcec_class_oversample_t *data, long period) {
+  lcec_master_t *master = slave->master;
+  uint8_t *pd = master->process_data;
+  int bits = data->options->sample_bits;
+  int max_value = data->options->max_value;
+  lcec_class_oversample_channel_t *chan;
+  LCEC_SAMPLES_BLOCK_T *block = NULL;
+  int32_t target, value;
+  double edge, dc;
+  int ch, k, switch_at;
+
+  if (data->layout_state == 0) data->layout_state = check_layout(slave, data);
+  if (data->layout_state < 0) return;
+
+  if (data->ring != NULL) block = LCEC_SAMPLES_BLOCK(data->ring, data->ring->head);
+
+  for (ch = 0; ch < data->channel_count; ch++) {
+    chan = &data->channels[ch];
+
+    if (bits == 1) {
+      target = *(chan->bit) ? 1 : 0;
+      switch_at = 0;
+      if (target != chan->prev_raw) {
+        edge = *(chan->edge);
+        if (edge < 0.0) edge = 0.0;
+        if (edge > 1.0) edge = 1.0;
+        switch_at = (int)(edge * data->samples + 0.5);
+      }
+      for (k = 0; k < data->samples; k++) {
+        value = (k < switch_at) ? chan->prev_raw : target;
+        write_sample(pd, chan, bits, k, value);
+        if (block != NULL) block->samples[k * data->channel_count + ch] = value;
+      }
+    } else {
+      // do scale calcs only when scale changes
+      if (*(chan->scale) != chan->old_scale) {
+        if ((*(chan->scale) < 1e-20) && (*(chan->scale) > -1e-20)) {
+          // value too small, divide by zero is a bad thing
+          *(chan->scale) = 1.0;
+        }
+        chan->old_scale = *(chan->scale);
+        chan->scale_recip = 1.0 / *(chan->scale);
+      }
+
+      target = 0;
+      if (*(chan->enable)) {
+        dc = *(chan->value) * chan->scale_recip + *(chan->offset);
+        if (dc > 1.0) dc = 1.0;
+        if (dc < -1.0) dc = -1.0;
+        target = (int32_t)(dc * (double)max_value);
+      }
+
+      for (k = 0; k < data->samples; k++) {
+        value = target;
+        if (*(chan->interpolate)) {
+          value = chan->prev_raw + (target - chan->prev_raw) * (k + 1) / data->samples;
+        }
+        write_sample(pd, chan, bits, k, value);
+        if (block != NULL) block->samples[k * data->channel_count + ch] = value;
+      }
+      *(chan->raw) = target;
+    }
+    chan->prev_raw = target;
+  }
+
+  if (block != NULL) {
+    block->timestamp = lcec_master_app_time(master);
+    block->interval = period / data->samples;
+    lcec_wmb();
+    data->ring->head++;
+  }
+}
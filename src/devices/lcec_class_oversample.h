@@ -0,0 +1,98 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Library for oversampling devices
+
+#include "../lcec.h"
+#include "../lcec_samples.h"
+
+#define LCEC_OVERSAMPLE_MAX_CHANNELS 4  ///< Channels per device.
+
+/// @brief Where one channel's samples live in the object dictionary.
+///
+/// Sample `k` is entry `entry_idx + k * entry_idx_step`, subindex
+/// `entry_sidx + k * entry_sidx_step`, in PDO `pdo_idx + k *
+/// pdo_step`.  With a `pdo_step` of 0, all samples are entries of a
+/// single PDO.
+typedef struct {
+  uint16_t pdo_idx;         ///< PDO holding sample 0.
+  uint16_t pdo_step;        ///< PDO index increment per sample, 0 if all samples share one PDO.
+  uint16_t entry_idx;       ///< Object index of sample 0.
+  uint16_t entry_idx_step;  ///< Object index increment per sample.
+  uint8_t entry_sidx;       ///< Object subindex of sample 0.
+  uint8_t entry_sidx_step;  ///< Object subindex increment per sample.
+} lcec_class_oversample_map_t;
+
+/// @brief Description of an oversampling device.
+typedef struct {
+  char *name_prefix;     ///< Pin name prefix: "ain", "din", "aout", or "dout".
+  int is_output;         ///< Device writes samples instead of reading them.
+  int sample_bits;       ///< Bits per sample, 1 for digital or 16 for analog devices.
+  int max_value;         ///< Full scale raw value for analog devices.
+  int max_samples;       ///< Largest supported oversampling factor.
+  uint8_t sync_index;    ///< Sync manager that holds the samples.
+  int channel_count;     ///< Number of channels.
+  lcec_class_oversample_map_t maps[LCEC_OVERSAMPLE_MAX_CHANNELS];  ///< Object mapping of each channel.
+} lcec_class_oversample_options_t;
+
+/// @brief Data for a single oversampling channel.
+typedef struct {
+  hal_float_t *min;          ///< Smallest sample of the cycle (analog inputs).
+  hal_float_t *max;          ///< Largest sample of the cycle (analog inputs).
+  hal_float_t *mean;         ///< Mean of the cycle's samples (inputs).
+  hal_float_t *last;         ///< Last sample of the cycle (analog inputs).
+  hal_float_t *scale;        ///< Scale between `raw` / `max_value` and the value pins (analog).
+  hal_float_t *bias;         ///< Added to analog input values.
+  hal_float_t *offset;       ///< Added to the analog output value, in fractions of full scale.
+  hal_float_t *value;        ///< Analog output command.
+  hal_float_t *edge;         ///< Where in the cycle a changed digital output switches, 0.0 to 1.0.
+  hal_bit_t *bit;            ///< Last sample (digital inputs) or output command (digital outputs).
+  hal_bit_t *bit_min;        ///< All samples of the cycle were high (digital inputs).
+  hal_bit_t *bit_max;        ///< Any sample of the cycle was high (digital inputs).
+  hal_bit_t *enable;         ///< Analog output enable.
+  hal_bit_t *interpolate;    ///< Ramp analog outputs from last cycle's value instead of stepping.
+  hal_s32_t *raw;            ///< Last raw sample.
+  unsigned int first_os;     ///< Byte offset of sample 0.
+  unsigned int first_bp;     ///< Bit position of sample 0.
+  unsigned int last_os;      ///< Byte offset of the last sample, used to check the layout.
+  unsigned int last_bp;      ///< Bit position of the last sample, used to check the layout.
+  int32_t prev_raw;          ///< Last sample written in the previous cycle (outputs).
+  double old_scale;          ///< `scale` when `scale_recip` was computed (analog outputs).
+  double scale_recip;        ///< `1.0 / scale` (analog outputs).
+} lcec_class_oversample_channel_t;
+
+/// @brief Data for an oversampling device.
+typedef struct {
+  const lcec_class_oversample_options_t *options;  ///< The options used to create this device.
+  int samples;                                     ///< Samples per channel and cycle.
+  int channel_count;                               ///< Number of channels.
+  lcec_class_oversample_channel_t *channels;       ///< Array of `channel_count` channels.
+  double recip_max;                                ///< `1.0 / max_value`.
+  double recip_samples;                            ///< `1.0 / samples`.
+  int layout_state;                                ///< 0 until checked, 1 if samples are contiguous, -1 if not.
+  int comp_id;                                     ///< HAL component ID, needed to delete the ring.
+  int ring_shmem_id;                               ///< Shared memory ID of the sample ring.
+  LCEC_SAMPLES_RING_T *ring;                       ///< Sample ring, NULL if disabled.
+} lcec_class_oversample_t;
+
+lcec_class_oversample_t *lcec_oversample_register(
+    int comp_id, struct lcec_slave *slave, const lcec_class_oversample_options_t *opt, int samples, uint32_t ring_size);
+void lcec_oversample_read(struct lcec_slave *slave, lcec_class_oversample_t *data, long period);
+void lcec_oversample_write(struct lcec_slave *slave, lcec_class_oversample_t *data, long period);
+void lcec_oversample_cleanup(lcec_class_oversample_t *data);
@@ -41,7 +41,7 @@ static lcec_typelist_t types[] = {
     {"EasyIO", LCEC_ABET_VID, 0x0debacca, 0, NULL, lcec_easyio_init},
     {NULL},
 };
-ADD_TYPES(types)
+ADD_TYPES_WITH_AIN_MODPARAMS(types)
 
 static void lcec_easyio_write(struct lcec_slave *slave, long period);
 static void lcec_easyio_read(struct lcec_slave *slave, long period);
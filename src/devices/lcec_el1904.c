@@ -119,6 +119,10 @@ static int lcec_el1904_init(int comp_id, struct lcec_slave *slave) {
     lcec_pdo_init(slave, 0x6001, 0x01 + i, &in->fsoe_in_os, &in->fsoe_in_bp);
   }
 
+  // let the logic device's FSoE routes find this slave's frames
+  slave->fsoe_local_slave_offset = &hal_data->fsoe_slave_cmd_os;
+  slave->fsoe_local_master_offset = &hal_data->fsoe_master_cmd_os;
+
   // export pins
   if ((err = lcec_pin_newf_list(hal_data, slave_pins, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
     return err;
@@ -139,8 +143,6 @@ static void lcec_el1904_read(struct lcec_slave *slave, long period) {
   int i;
   lcec_el1904_data_in_t *in;
 
-  copy_fsoe_data(slave, hal_data->fsoe_slave_cmd_os, hal_data->fsoe_master_cmd_os);
-
   *(hal_data->fsoe_slave_cmd) = EC_READ_U8(&pd[hal_data->fsoe_slave_cmd_os]);
   *(hal_data->fsoe_slave_crc) = EC_READ_U16(&pd[hal_data->fsoe_slave_crc_os]);
   *(hal_data->fsoe_slave_connid) = EC_READ_U16(&pd[hal_data->fsoe_slave_connid_os]);
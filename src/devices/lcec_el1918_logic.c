@@ -50,6 +50,7 @@ typedef struct {
 
 typedef struct {
   struct lcec_slave *fsoe_slave;
+  int data_channels;
 
   hal_u32_t *fsoe_master_cmd;
   hal_u32_t *fsoe_master_connid;
@@ -248,13 +249,14 @@ int lcec_el1918_logic_init(int comp_id, struct lcec_slave *slave) {
       fsoe_slave->fsoe_slave_offset = &fsoe_data->fsoe_slave_cmd_os;
       fsoe_slave->fsoe_master_offset = &fsoe_data->fsoe_master_cmd_os;
       fsoeConf = fsoe_slave->fsoeConf;
+      fsoe_data->data_channels = fsoeConf->data_channels;
 
       // alloc crc hal memory
       if ((fsoe_data->fsoe_crc = hal_malloc(fsoeConf->data_channels * sizeof(lcec_el1918_logic_fsoe_crc_t))) == NULL) {
         rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for fsoe_slave %s.%s crc data failed\n", master->name, fsoe_slave->name);
         return -EIO;
       }
-      memset(fsoe_data->fsoe_crc, 0, sizeof(lcec_el1918_logic_fsoe_crc_t));
+      memset(fsoe_data->fsoe_crc, 0, fsoeConf->data_channels * sizeof(lcec_el1918_logic_fsoe_crc_t));
 
       // initialize POD entries
       lcec_pdo_init(slave, 0x7080 + (fsoe_idx << 4), 0x01, &fsoe_data->fsoe_slave_cmd_os, NULL);
@@ -292,8 +294,6 @@ void lcec_el1918_logic_read(struct lcec_slave *slave, long period) {
   int i, crc_idx;
   uint8_t std_out;
   lcec_el1918_logic_fsoe_crc_t *crc;
-  struct lcec_slave *fsoe_slave;
-  const LCEC_CONF_FSOE_T *fsoeConf;
 
   *(hal_data->state) = EC_READ_U8(&pd[hal_data->state_os]);
   *(hal_data->cycle_counter) = EC_READ_U8(&pd[hal_data->cycle_counter_os]);
@@ -306,13 +306,11 @@ void lcec_el1918_logic_read(struct lcec_slave *slave, long period) {
   }
 
   for (i = 0, fsoe_data = hal_data->fsoe; i < hal_data->fsoe_count; i++, fsoe_data++) {
-    fsoe_slave = fsoe_data->fsoe_slave;
-    fsoeConf = fsoe_slave->fsoeConf;
     *(fsoe_data->fsoe_master_cmd) = EC_READ_U8(&pd[fsoe_data->fsoe_master_cmd_os]);
     *(fsoe_data->fsoe_master_connid) = EC_READ_U16(&pd[fsoe_data->fsoe_master_connid_os]);
     *(fsoe_data->fsoe_slave_cmd) = EC_READ_U8(&pd[fsoe_data->fsoe_slave_cmd_os]);
     *(fsoe_data->fsoe_slave_connid) = EC_READ_U16(&pd[fsoe_data->fsoe_slave_connid_os]);
-    for (crc_idx = 0, crc = fsoe_data->fsoe_crc; crc_idx < fsoeConf->data_channels; crc_idx++, crc++) {
+    for (crc_idx = 0, crc = fsoe_data->fsoe_crc; crc_idx < fsoe_data->data_channels; crc_idx++, crc++) {
       *(crc->fsoe_master_crc) = EC_READ_U16(&pd[crc->fsoe_master_crc_os]);
       *(crc->fsoe_slave_crc) = EC_READ_U16(&pd[crc->fsoe_slave_crc_os]);
     }
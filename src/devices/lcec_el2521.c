@@ -30,10 +30,11 @@
 // - travel distance control active (8000:0A) must be FALSE (0x00, default)
 // ****************************************************************************
 
+static int lcec_el2521_preinit(struct lcec_slave *slave);
 static int lcec_el2521_init(int comp_id, struct lcec_slave *slave);
 
 static lcec_typelist_t types[] = {
-    {"EL2521", LCEC_BECKHOFF_VID, 0x09d93052, 0, NULL, lcec_el2521_init},
+    {"EL2521", LCEC_BECKHOFF_VID, 0x09d93052, 0, lcec_el2521_preinit, lcec_el2521_init},
     {NULL},
 };
 ADD_TYPES(types);
@@ -134,6 +135,16 @@ static void lcec_el2521_check_scale(lcec_el2521_data_t *hal_data);
 static void lcec_el2521_read(struct lcec_slave *slave, long period);
 static void lcec_el2521_write(struct lcec_slave *slave, long period);
 
+static int lcec_el2521_preinit(struct lcec_slave *slave) {
+  // queue the sdos read by init
+  if (lcec_prefetch_sdo(slave, 0x8001, 0x02, 4) || lcec_prefetch_sdo(slave, 0x8001, 0x04, 2) || lcec_prefetch_sdo(slave, 0x8001, 0x05, 2) ||
+      lcec_prefetch_sdo(slave, 0x8000, 0x07, 1) || lcec_prefetch_sdo(slave, 0x8800, 0x02, 2)) {
+    return -ENOMEM;
+  }
+
+  return 0;
+}
+
 static int lcec_el2521_init(int comp_id, struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
   lcec_el2521_data_t *hal_data;
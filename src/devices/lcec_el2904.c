@@ -136,6 +136,10 @@ static int lcec_el2904_init(int comp_id, struct lcec_slave *slave) {
   lcec_pdo_init(slave, 0x6000, 0x03, &hal_data->fsoe_slave_crc_os, NULL);
   lcec_pdo_init(slave, 0x6000, 0x04, &hal_data->fsoe_slave_connid_os, NULL);
 
+  // let the logic device's FSoE routes find this slave's frames
+  slave->fsoe_local_slave_offset = &hal_data->fsoe_slave_cmd_os;
+  slave->fsoe_local_master_offset = &hal_data->fsoe_master_cmd_os;
+
   // export pins
   if ((err = lcec_pin_newf_list(hal_data, slave_pins, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
     return err;
@@ -149,8 +153,6 @@ static void lcec_el2904_read(struct lcec_slave *slave, long period) {
   lcec_el2904_data_t *hal_data = (lcec_el2904_data_t *)slave->hal_data;
   uint8_t *pd = master->process_data;
 
-  copy_fsoe_data(slave, hal_data->fsoe_slave_cmd_os, hal_data->fsoe_master_cmd_os);
-
   *(hal_data->fsoe_slave_cmd) = EC_READ_U8(&pd[hal_data->fsoe_slave_cmd_os]);
   *(hal_data->fsoe_slave_crc) = EC_READ_U16(&pd[hal_data->fsoe_slave_crc_os]);
   *(hal_data->fsoe_slave_connid) = EC_READ_U16(&pd[hal_data->fsoe_slave_connid_os]);
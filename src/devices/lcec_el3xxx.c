@@ -211,7 +211,7 @@ static lcec_typelist_t types[] = {
     BECKHOFF_AIN_DEVICE("EM3712", 0x0e803452, F_CHANNELS(2) | F_PRESSURE),
     {NULL},
 };
-ADD_TYPES(types)
+ADD_TYPES_WITH_AIN_MODPARAMS(types)
 
 static void lcec_el3xxx_read(struct lcec_slave *slave, long period);
 static int set_sensor_type(lcec_slave_t *slave, char *sensortype, lcec_class_ain_channel_t *chan, int idx, int sidx);
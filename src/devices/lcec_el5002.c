@@ -22,6 +22,7 @@
 #include "lcec_el5002.h"
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static int lcec_el5002_init(int comp_id, struct lcec_slave *slave);
 
@@ -90,6 +91,9 @@ typedef struct {
   int32_t last_count;
   double old_scale;
   double scale;
+
+  lcec_class_enc_vel_t vel;
+  long long vel_count;
 } lcec_el5002_chan_t;
 
 typedef struct {
@@ -158,6 +162,7 @@ static int lcec_el5002_init(int comp_id, struct lcec_slave *slave) {
   lcec_el5002_data_t *hal_data;
   int i;
   lcec_el5002_chan_t *chan;
+  char pfx[HAL_NAME_LEN];
   int err;
 
   // set config patameters
@@ -268,6 +273,10 @@ static int lcec_el5002_init(int comp_id, struct lcec_slave *slave) {
     if ((err = lcec_pin_newf_list(chan, slave_pins, LCEC_MODULE_NAME, master->name, slave->name, i)) != 0) {
       return err;
     }
+    rtapi_snprintf(pfx, HAL_NAME_LEN, "enc-%d", i);
+    if ((err = class_enc_vel_init(slave, &chan->vel, pfx)) != 0) {
+      return err;
+    }
 
     // initialize pins
     *(chan->pos_scale) = 1.0;
@@ -327,6 +336,7 @@ static void lcec_el5002_read(struct lcec_slave *slave, long period) {
     // check for operational change of slave
     if (!hal_data->last_operational) {
       chan->last_count = raw_count;
+      class_enc_vel_reset(&chan->vel);
     }
 
     // update raw values
@@ -344,6 +354,10 @@ static void lcec_el5002_read(struct lcec_slave *slave, long period) {
     chan->last_count = raw_count;
     *(chan->count) += raw_delta;
 
+    // velocity from the raw counts, which keep counting through reset
+    chan->vel_count += raw_delta;
+    class_enc_vel_update(&chan->vel, period, chan->vel_count, chan->scale);
+
     // scale count to make floating point position
     if (*(chan->abs_mode)) {
       *(chan->pos) = *(chan->raw_count) * chan->scale;
@@ -22,6 +22,7 @@
 #include "lcec_el5032.h"
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static int lcec_el5032_init(int comp_id, struct lcec_slave *slave);
 
@@ -64,6 +65,9 @@ typedef struct {
   int64_t last_count;
   double old_scale;
   double scale;
+
+  lcec_class_enc_vel_t vel;
+  long long vel_count;
 } lcec_el5032_chan_t;
 
 typedef struct {
@@ -132,6 +136,7 @@ static int lcec_el5032_init(int comp_id, struct lcec_slave *slave) {
   lcec_el5032_data_t *hal_data;
   int i;
   lcec_el5032_chan_t *chan;
+  char pfx[HAL_NAME_LEN];
   int err;
 
   // initialize callbacks
@@ -168,6 +173,10 @@ static int lcec_el5032_init(int comp_id, struct lcec_slave *slave) {
     if ((err = lcec_pin_newf_list(chan, slave_pins, LCEC_MODULE_NAME, master->name, slave->name, i)) != 0) {
       return err;
     }
+    rtapi_snprintf(pfx, HAL_NAME_LEN, "enc-%d", i);
+    if ((err = class_enc_vel_init(slave, &chan->vel, pfx)) != 0) {
+      return err;
+    }
 
     // initialize pins
     *(chan->pos_scale) = 1.0;
@@ -229,6 +238,7 @@ static void lcec_el5032_read(struct lcec_slave *slave, long period) {
     // check for operational change of slave
     if (!hal_data->last_operational) {
       chan->last_count = raw_count;
+      class_enc_vel_reset(&chan->vel);
     }
 
     // update raw values
@@ -247,6 +257,10 @@ static void lcec_el5032_read(struct lcec_slave *slave, long period) {
     chan->last_count = raw_count;
     *(chan->count) += raw_delta;
 
+    // velocity from the raw counts, which keep counting through reset
+    chan->vel_count += raw_delta;
+    class_enc_vel_update(&chan->vel, period, chan->vel_count, chan->scale);
+
     // scale count to make floating point position
     if (*(chan->abs_mode)) {
       *(chan->pos) = raw_count * chan->scale;
@@ -22,6 +22,7 @@
 #include "lcec_el5101.h"
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static int lcec_el5101_init(int comp_id, struct lcec_slave *slave);
 
@@ -80,6 +81,10 @@ typedef struct {
   double old_scale;
   double scale;
 
+  lcec_class_enc_vel_t vel;
+  long long vel_count;
+  int16_t vel_last_raw;
+
   int last_operational;
 } lcec_el5101_data_t;
 
@@ -182,6 +187,9 @@ static int lcec_el5101_init(int comp_id, struct lcec_slave *slave) {
   if ((err = lcec_pin_newf_list(hal_data, slave_pins, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
     return err;
   }
+  if ((err = class_enc_vel_init(slave, &hal_data->vel, "enc")) != 0) {
+    return err;
+  }
 
   // initialize pins
   *(hal_data->pos_scale) = 1.0;
@@ -241,12 +249,14 @@ static void lcec_el5101_read(struct lcec_slave *slave, long period) {
   // check for operational change of slave
   if (!hal_data->last_operational) {
     hal_data->last_count = raw_count;
+    class_enc_vel_reset(&hal_data->vel);
   }
 
   // check for counter set done
   if (raw_status & LCEC_EL5101_STATUS_CNTSET_ACC) {
     hal_data->last_count = raw_count;
     *(hal_data->set_raw_count) = 0;
+    class_enc_vel_reset(&hal_data->vel);
   }
 
   // update raw values
@@ -287,6 +297,11 @@ static void lcec_el5101_read(struct lcec_slave *slave, long period) {
   // scale count to make floating point position
   *(hal_data->pos) = *(hal_data->count) * hal_data->scale;
 
+  // velocity from the raw counter, which keeps counting through reset and index
+  hal_data->vel_count += (int16_t)(raw_count - hal_data->vel_last_raw);
+  hal_data->vel_last_raw = raw_count;
+  class_enc_vel_update(&hal_data->vel, period, hal_data->vel_count, hal_data->scale);
+
   // scale period
   *(hal_data->frequency) = ((double)(*(hal_data->raw_frequency))) * LCEC_EL5101_FREQUENCY_SCALE;
   *(hal_data->period) = ((double)(*(hal_data->raw_period))) * LCEC_EL5101_PERIOD_SCALE;
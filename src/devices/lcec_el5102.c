@@ -22,6 +22,7 @@
 #include <stdio.h>
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static int lcec_el5102_init(int comp_id, struct lcec_slave *slave);
 
@@ -96,6 +97,10 @@ typedef struct {
   double old_scale;
   double scale;
 
+  lcec_class_enc_vel_t vel;
+  long long vel_count;
+  int16_t vel_last_raw;
+
   int last_operational;
 } lcec_el5102_channel_data_t;
 
@@ -196,6 +201,9 @@ static int lcec_el5102_init(int comp_id, struct lcec_slave *slave) {
     if ((err = lcec_pin_newf_list(data, slave_pins, LCEC_MODULE_NAME, master->name, slave->name, channellabel)) != 0) {
       return err;
     }
+    if ((err = class_enc_vel_init(slave, &data->vel, channellabel)) != 0) {
+      return err;
+    }
 
     // initialize pins
     *(data->pos_scale) = 1.0;
@@ -262,10 +270,12 @@ static void lcec_el5102_read_channel(struct lcec_slave *slave, long period, int
   if (EC_READ_BIT(&pd[data->status_set_counter_done_os], data->status_set_counter_done_bp)) {
     data->last_count = raw_count;
     *(data->set_raw_count) = 0;
+    class_enc_vel_reset(&data->vel);
   }
   // check for operational change of slave
   if (!data->last_operational) {
     data->last_count = raw_count;
+    class_enc_vel_reset(&data->vel);
   }
 
   // update raw values
@@ -305,6 +315,11 @@ static void lcec_el5102_read_channel(struct lcec_slave *slave, long period, int
   // scale count to make floating point position
   *(data->pos) = *(data->count) * data->scale;
 
+  // velocity from the raw counter, which keeps counting through reset and index
+  data->vel_count += (int16_t)(raw_count - data->vel_last_raw);
+  data->vel_last_raw = raw_count;
+  class_enc_vel_update(&data->vel, period, data->vel_count, data->scale);
+
   // scale period
   //*(data->frequency) = ((double)(*(data->raw_frequency))) * LCEC_EL5102_FREQUENCY_SCALE;
   //*(data->period) = ((double)(*(data->raw_period))) * LCEC_EL5102_PERIOD_SCALE;
@@ -22,11 +22,19 @@
 #include "lcec_el5151.h"
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static int lcec_el5151_init(int comp_id, struct lcec_slave *slave);
 
+#define LCEC_EL5151_MODPARAM_EDGE_TIMESTAMP 0
+
+static const lcec_modparam_desc_t lcec_el5151_modparams[] = {
+    {"edgeTimestamp", LCEC_EL5151_MODPARAM_EDGE_TIMESTAMP, MODPARAM_TYPE_BIT},
+    {NULL},
+};
+
 static lcec_typelist_t types[] = {
-    {"EL5151", LCEC_BECKHOFF_VID, 0x141f3052, 0, NULL, lcec_el5151_init},
+    {"EL5151", LCEC_BECKHOFF_VID, 0x141f3052, 0, NULL, lcec_el5151_init, lcec_el5151_modparams},
     {NULL},
 };
 ADD_TYPES(types);
@@ -54,6 +62,7 @@ typedef struct {
   hal_float_t *pos_scale;
   hal_float_t *pos;
   hal_float_t *period;
+  hal_float_t *edge_time;
 
   unsigned int ena_latch_c_pdo_os;
   unsigned int ena_latch_c_pdo_bp;
@@ -87,12 +96,18 @@ typedef struct {
   unsigned int count_pdo_os;
   unsigned int latch_pdo_os;
   unsigned int period_pdo_os;
+  unsigned int timestamp_pdo_os;
+  int has_timestamp;
 
   int do_init;
   int32_t last_count;
   double old_scale;
   double scale;
 
+  lcec_class_enc_vel_t vel;
+  long long vel_count;
+  int32_t vel_last_raw;
+
   int last_operational;
 } lcec_el5151_data_t;
 
@@ -122,6 +137,11 @@ static const lcec_pindesc_t slave_pins[] = {
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
 };
 
+static const lcec_pindesc_t slave_edge_pins[] = {
+    {HAL_FLOAT, HAL_OUT, offsetof(lcec_el5151_data_t, edge_time), "%s.%s.%s.enc-edge-time"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
 static ec_pdo_entry_info_t lcec_el5151_in[] = {
     {0x6000, 0x01, 1},   // Latch C valid
     {0x6000, 0x02, 1},   // Latch extern valid
@@ -171,12 +191,31 @@ static ec_sync_info_t lcec_el5151_syncs[] = {
     {0xff},
 };
 
+static ec_pdo_entry_info_t lcec_el5151_timestamp[] = {
+    {0x6000, 0x16, 32},  // Timestamp
+};
+
+static ec_pdo_info_t lcec_el5151_pdos_in_timestamp[] = {
+    {0x1A00, 15, lcec_el5151_in},
+    {0x1A02, 1, lcec_el5151_period},
+    {0x1A04, 1, lcec_el5151_timestamp},
+};
+
+static ec_sync_info_t lcec_el5151_syncs_timestamp[] = {
+    {0, EC_DIR_OUTPUT, 0, NULL},
+    {1, EC_DIR_INPUT, 0, NULL},
+    {2, EC_DIR_OUTPUT, 1, lcec_el5151_pdos_out},
+    {3, EC_DIR_INPUT, 3, lcec_el5151_pdos_in_timestamp},
+    {0xff},
+};
+
 static void lcec_el5151_read(struct lcec_slave *slave, long period);
 static void lcec_el5151_write(struct lcec_slave *slave, long period);
 
 static int lcec_el5151_init(int comp_id, struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
   lcec_el5151_data_t *hal_data;
+  LCEC_CONF_MODPARAM_VAL_T *pval;
   int err;
 
   // initialize callbacks
@@ -197,6 +236,14 @@ static int lcec_el5151_init(int comp_id, struct lcec_slave *slave) {
   // initialize global data
   hal_data->last_operational = 0;
 
+  // with edgeTimestamp, map the DC time of the last counter change, see `lcec_el5151_read()`
+  pval = lcec_modparam_get(slave, LCEC_EL5151_MODPARAM_EDGE_TIMESTAMP);
+  if (pval != NULL && pval->bit) {
+    slave->sync_info = lcec_el5151_syncs_timestamp;
+    lcec_pdo_init(slave, 0x6000, 0x16, &hal_data->timestamp_pdo_os, NULL);
+    hal_data->has_timestamp = 1;
+  }
+
   // initialize POD entries
   lcec_pdo_init(slave, 0x6000, 0x01, &hal_data->latch_c_valid_pdo_os, &hal_data->latch_c_valid_pdo_bp);
   lcec_pdo_init(slave, 0x6000, 0x02, &hal_data->latch_ext_valid_pdo_os, &hal_data->latch_ext_valid_pdo_bp);
@@ -221,6 +268,14 @@ static int lcec_el5151_init(int comp_id, struct lcec_slave *slave) {
   if ((err = lcec_pin_newf_list(hal_data, slave_pins, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
     return err;
   }
+  if ((err = class_enc_vel_init(slave, &hal_data->vel, "enc")) != 0) {
+    return err;
+  }
+  if (hal_data->has_timestamp) {
+    if ((err = lcec_pin_newf_list(hal_data, slave_edge_pins, LCEC_MODULE_NAME, master->name, slave->name)) != 0) {
+      return err;
+    }
+  }
 
   // initialize pins
   *(hal_data->pos_scale) = 1.0;
@@ -279,12 +334,14 @@ static void lcec_el5151_read(struct lcec_slave *slave, long period) {
   // check for operational change of slave
   if (!hal_data->last_operational) {
     hal_data->last_count = raw_count;
+    class_enc_vel_reset(&hal_data->vel);
   }
 
   // check for counter set done
   if (EC_READ_BIT(&pd[hal_data->set_count_done_pdo_os], hal_data->set_count_done_pdo_bp)) {
     hal_data->last_count = raw_count;
     *(hal_data->set_raw_count) = 0;
+    class_enc_vel_reset(&hal_data->vel);
   }
 
   // update raw values
@@ -323,9 +380,20 @@ static void lcec_el5151_read(struct lcec_slave *slave, long period) {
   // scale count to make floating point position
   *(hal_data->pos) = *(hal_data->count) * hal_data->scale;
 
+  // velocity from the raw counter, which keeps counting through reset and index
+  hal_data->vel_count += (int32_t)(raw_count - hal_data->vel_last_raw);
+  hal_data->vel_last_raw = raw_count;
+  class_enc_vel_update(&hal_data->vel, period, hal_data->vel_count, hal_data->scale);
+
   // scale period
   *(hal_data->period) = ((double)(*(hal_data->raw_period))) * LCEC_EL5151_PERIOD_SCALE;
 
+  // time of the last counter change relative to the counter sample,
+  // which is taken at the DC time the previous frame was sent with
+  if (hal_data->has_timestamp) {
+    *(hal_data->edge_time) = (double)(int32_t)(EC_READ_U32(&pd[hal_data->timestamp_pdo_os]) - master->app_time_last) * 1e-9;
+  }
+
   hal_data->last_operational = 1;
 }
 
@@ -22,6 +22,7 @@
 #include "lcec_el5152.h"
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static int lcec_el5152_init(int comp_id, struct lcec_slave *slave);
 
@@ -69,6 +70,10 @@ typedef struct {
   int last_index;
   double old_scale;
   double scale;
+
+  lcec_class_enc_vel_t vel;
+  long long vel_count;
+  int32_t vel_last_raw;
 } lcec_el5152_chan_t;
 
 typedef struct {
@@ -167,6 +172,7 @@ static int lcec_el5152_init(int comp_id, struct lcec_slave *slave) {
   lcec_el5152_data_t *hal_data;
   int i;
   lcec_el5152_chan_t *chan;
+  char pfx[HAL_NAME_LEN];
   int err;
 
   // initialize callbacks
@@ -206,6 +212,10 @@ static int lcec_el5152_init(int comp_id, struct lcec_slave *slave) {
     if ((err = lcec_pin_newf_list(chan, slave_pins, LCEC_MODULE_NAME, master->name, slave->name, i)) != 0) {
       return err;
     }
+    rtapi_snprintf(pfx, HAL_NAME_LEN, "enc-%d", i);
+    if ((err = class_enc_vel_init(slave, &chan->vel, pfx)) != 0) {
+      return err;
+    }
 
     // initialize pins
     *(chan->pos_scale) = 1.0;
@@ -266,12 +276,14 @@ static void lcec_el5152_read(struct lcec_slave *slave, long period) {
     // check for operational change of slave
     if (!hal_data->last_operational) {
       chan->last_count = raw_count;
+      class_enc_vel_reset(&chan->vel);
     }
 
     // check for counter set done
     if (EC_READ_BIT(&pd[chan->set_count_done_pdo_os], chan->set_count_done_pdo_bp)) {
       chan->last_count = raw_count;
       *(chan->set_raw_count) = 0;
+      class_enc_vel_reset(&chan->vel);
     }
 
     // update raw values
@@ -312,6 +324,11 @@ static void lcec_el5152_read(struct lcec_slave *slave, long period) {
     // scale count to make floating point position
     *(chan->pos) = *(chan->count) * chan->scale;
 
+    // velocity from the raw counter, which keeps counting through reset and index
+    chan->vel_count += (int32_t)(raw_count - chan->vel_last_raw);
+    chan->vel_last_raw = raw_count;
+    class_enc_vel_update(&chan->vel, period, chan->vel_count, chan->scale);
+
     // scale period
     *(chan->period) = ((double)(*(chan->raw_period))) * LCEC_EL5152_PERIOD_SCALE;
   }
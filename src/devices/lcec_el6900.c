@@ -58,6 +58,7 @@ typedef struct {
 
 typedef struct {
   struct lcec_slave *fsoe_slave;
+  int data_channels;
 
   hal_u32_t *fsoe_master_cmd;
   hal_u32_t *fsoe_master_connid;
@@ -84,10 +85,10 @@ typedef struct {
   hal_bit_t *output_size_missmatch;
 
   int std_ins_count;
-  lcec_el6900_fsoe_io_t std_ins[LCEC_EL6900_DIO_MAX_COUNT];
+  lcec_el6900_fsoe_io_t *std_ins;
 
   int std_outs_count;
-  lcec_el6900_fsoe_io_t std_outs[LCEC_EL6900_DIO_MAX_COUNT];
+  lcec_el6900_fsoe_io_t *std_outs;
 
   unsigned int control_os;
   unsigned int state_os;
@@ -156,52 +157,45 @@ static int init_std_pdos(struct lcec_slave *slave, int pid, lcec_el6900_fsoe_io_
 static int lcec_el6900_preinit(struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
   lcec_slave_modparam_t *p;
-  int index, stdin_count, stdout_count;
+  int index;
   struct lcec_slave *fsoe_slave;
   const LCEC_CONF_FSOE_T *fsoeConf;
 
-  stdin_count = 0;
-  stdout_count = 0;
   for (p = slave->modparams; p != NULL && p->id >= 0; p++) {
-    switch (p->id) {
-      case LCEC_EL6900_PARAM_SLAVEID:
-        // find slave
-        index = p->value.u32;
-        fsoe_slave = lcec_slave_by_index(master, index);
-        if (fsoe_slave == NULL) {
-          rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "%s.%s: slave index %d not found\n", master->name, slave->name, index);
-          return -EINVAL;
-        }
-
-        fsoeConf = fsoe_slave->fsoeConf;
-        if (fsoeConf == NULL) {
-          rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "%s.%s: slave index %d is not a fsoe slave\n", master->name, slave->name, index);
-          return -EINVAL;
-        }
+    if (p->id != LCEC_EL6900_PARAM_SLAVEID) {
+      continue;
+    }
 
-        break;
+    // find slave
+    index = p->value.u32;
+    fsoe_slave = lcec_slave_by_index(master, index);
+    if (fsoe_slave == NULL) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "%s.%s: slave index %d not found\n", master->name, slave->name, index);
+      return -EINVAL;
+    }
 
-      case LCEC_EL6900_PARAM_STDIN_NAME:
-        stdin_count++;
-        if (stdin_count > LCEC_EL6900_DIO_MAX_COUNT) {
-          rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "%s.%s: maximum stdin count exceeded.\n", master->name, slave->name);
-          return -EINVAL;
-        }
+    fsoeConf = fsoe_slave->fsoeConf;
+    if (fsoeConf == NULL) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "%s.%s: slave index %d is not a fsoe slave\n", master->name, slave->name, index);
+      return -EINVAL;
+    }
+  }
 
-        break;
+  return 0;
+}
 
-      case LCEC_EL6900_PARAM_STDOUT_NAME:
-        stdout_count++;
-        if (stdout_count > LCEC_EL6900_DIO_MAX_COUNT) {
-          rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "%s.%s: maximum stdout count exceeded.\n", master->name, slave->name);
-          return -EINVAL;
-        }
+// counts the modParams with a given id
+static int count_modparams(struct lcec_slave *slave, int pid) {
+  lcec_slave_modparam_t *p;
+  int count = 0;
 
-        break;
+  for (p = slave->modparams; p != NULL && p->id >= 0; p++) {
+    if (p->id == pid) {
+      count++;
     }
   }
 
-  return 0;
+  return count;
 }
 
 static int lcec_el6900_init(int comp_id, struct lcec_slave *slave) {
@@ -209,7 +203,7 @@ static int lcec_el6900_init(int comp_id, struct lcec_slave *slave) {
   lcec_el6900_data_t *hal_data;
   lcec_el6900_fsoe_t *fsoe_data;
   lcec_slave_modparam_t *p;
-  int fsoe_idx, index, err;
+  int fsoe_idx, index, err, std_ins_count, std_outs_count;
   lcec_el6900_fsoe_crc_t *crc;
   struct lcec_slave *fsoe_slave;
   const LCEC_CONF_FSOE_T *fsoeConf;
@@ -218,12 +212,10 @@ static int lcec_el6900_init(int comp_id, struct lcec_slave *slave) {
   slave->proc_read = lcec_el6900_read;
   slave->proc_write = lcec_el6900_write;
 
-  // count fsoe slaves
-  for (fsoe_idx = 0, p = slave->modparams; p != NULL && p->id >= 0; p++) {
-    if (p->id == LCEC_EL6900_PARAM_SLAVEID) {
-      fsoe_idx++;
-    }
-  }
+  // count fsoe slaves and standard I/Os
+  fsoe_idx = count_modparams(slave, LCEC_EL6900_PARAM_SLAVEID);
+  std_ins_count = count_modparams(slave, LCEC_EL6900_PARAM_STDIN_NAME);
+  std_outs_count = count_modparams(slave, LCEC_EL6900_PARAM_STDOUT_NAME);
 
   // alloc hal memory
   if ((hal_data = hal_malloc(sizeof(lcec_el6900_data_t) + fsoe_idx * sizeof(lcec_el6900_fsoe_t))) == NULL) {
@@ -246,6 +238,16 @@ static int lcec_el6900_init(int comp_id, struct lcec_slave *slave) {
     return err;
   }
 
+  // alloc stdio memory
+  if (std_ins_count + std_outs_count > 0) {
+    if ((hal_data->std_ins = hal_malloc((std_ins_count + std_outs_count) * sizeof(lcec_el6900_fsoe_io_t))) == NULL) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s stdio data failed\n", master->name, slave->name);
+      return -EIO;
+    }
+    memset(hal_data->std_ins, 0, (std_ins_count + std_outs_count) * sizeof(lcec_el6900_fsoe_io_t));
+    hal_data->std_outs = hal_data->std_ins + std_ins_count;
+  }
+
   // map and export stdios
   hal_data->std_ins_count = init_std_pdos(slave, LCEC_EL6900_PARAM_STDIN_NAME, hal_data->std_ins, 0xf201, HAL_IN);
   if (hal_data->std_ins_count < 0) {
@@ -266,13 +268,14 @@ static int lcec_el6900_init(int comp_id, struct lcec_slave *slave) {
       fsoe_slave->fsoe_slave_offset = &fsoe_data->fsoe_slave_cmd_os;
       fsoe_slave->fsoe_master_offset = &fsoe_data->fsoe_master_cmd_os;
       fsoeConf = fsoe_slave->fsoeConf;
+      fsoe_data->data_channels = fsoeConf->data_channels;
 
       // alloc crc hal memory
       if ((fsoe_data->fsoe_crc = hal_malloc(fsoeConf->data_channels * sizeof(lcec_el6900_fsoe_crc_t))) == NULL) {
         rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for fsoe_slave %s.%s crc data failed\n", master->name, fsoe_slave->name);
         return -EIO;
       }
-      memset(fsoe_data->fsoe_crc, 0, sizeof(lcec_el6900_fsoe_crc_t));
+      memset(fsoe_data->fsoe_crc, 0, fsoeConf->data_channels * sizeof(lcec_el6900_fsoe_crc_t));
 
       // initialize POD entries
       lcec_pdo_init(slave, 0x7000 + (fsoe_idx << 4), 0x01, &fsoe_data->fsoe_slave_cmd_os, NULL);
@@ -310,8 +313,6 @@ void lcec_el6900_read(struct lcec_slave *slave, long period) {
   int i, crc_idx;
   lcec_el6900_fsoe_io_t *io;
   lcec_el6900_fsoe_crc_t *crc;
-  struct lcec_slave *fsoe_slave;
-  const LCEC_CONF_FSOE_T *fsoeConf;
 
   *(hal_data->state) = EC_READ_U8(&pd[hal_data->state_os]) & 0x03;
   *(hal_data->login_active) = EC_READ_BIT(&pd[hal_data->login_active_os], hal_data->login_active_bp);
@@ -323,13 +324,11 @@ void lcec_el6900_read(struct lcec_slave *slave, long period) {
   }
 
   for (i = 0, fsoe_data = hal_data->fsoe; i < hal_data->fsoe_count; i++, fsoe_data++) {
-    fsoe_slave = fsoe_data->fsoe_slave;
-    fsoeConf = fsoe_slave->fsoeConf;
     *(fsoe_data->fsoe_master_cmd) = EC_READ_U8(&pd[fsoe_data->fsoe_master_cmd_os]);
     *(fsoe_data->fsoe_master_connid) = EC_READ_U16(&pd[fsoe_data->fsoe_master_connid_os]);
     *(fsoe_data->fsoe_slave_cmd) = EC_READ_U8(&pd[fsoe_data->fsoe_slave_cmd_os]);
     *(fsoe_data->fsoe_slave_connid) = EC_READ_U16(&pd[fsoe_data->fsoe_slave_connid_os]);
-    for (crc_idx = 0, crc = fsoe_data->fsoe_crc; crc_idx < fsoeConf->data_channels; crc_idx++, crc++) {
+    for (crc_idx = 0, crc = fsoe_data->fsoe_crc; crc_idx < fsoe_data->data_channels; crc_idx++, crc++) {
       *(crc->fsoe_master_crc) = EC_READ_U16(&pd[crc->fsoe_master_crc_os]);
       *(crc->fsoe_slave_crc) = EC_READ_U16(&pd[crc->fsoe_slave_crc_os]);
     }
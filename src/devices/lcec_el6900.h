@@ -28,5 +28,4 @@
 #define LCEC_EL6900_PARAM_STDIN_NAME  2
 #define LCEC_EL6900_PARAM_STDOUT_NAME 3
 
-#define LCEC_EL6900_DIO_MAX_COUNT 32
 #endif
@@ -21,6 +21,7 @@
 /// @brief Driver for Beckhoff EL7041 Stepper drives
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static int lcec_el7041_init(int comp_id, struct lcec_slave *s);
 static void lcec_el7041_read(struct lcec_slave *s, long period);
@@ -194,6 +195,9 @@ typedef struct {
 
   int enc_do_init;
   int16_t enc_last_count;
+  lcec_class_enc_vel_t enc_vel;
+  long long enc_vel_count;
+  int16_t enc_vel_last_raw;
   double enc_old_scale;
   double enc_scale_recip;
   double dcm_old_scale;
@@ -564,6 +568,9 @@ static int lcec_el7041_init(int comp_id, struct lcec_slave *s) {
   if ((err = lcec_pin_newf_list(hd, slave_pins, LCEC_MODULE_NAME, m->name, s->name)) != 0) {
     return err;
   }
+  if ((err = class_enc_vel_init(s, &hd->enc_vel, "enc")) != 0) {
+    return err;
+  }
 
   // initialize pins
   *(hd->pos_scale) = 1.0;
@@ -653,12 +660,14 @@ static void lcec_el7041_read(struct lcec_slave *s, long period) {
   // check for operational change of slave
   if (!hd->last_operational) {
     hd->enc_last_count = raw_count;
+    class_enc_vel_reset(&hd->enc_vel);
   }
 
   // check for counter set done
   if (EC_READ_BIT(&pd[hd->set_count_done_pdo_os], hd->set_count_done_pdo_bp)) {
     hd->enc_last_count = raw_count;
     *(hd->set_raw_count) = 0;
+    class_enc_vel_reset(&hd->enc_vel);
   }
 
   // update raw values
@@ -711,6 +720,11 @@ static void lcec_el7041_read(struct lcec_slave *s, long period) {
   // scale count to make floating point position
   *(hd->pos) = *(hd->count) * hd->enc_scale_recip;
 
+  // velocity from the raw counter, which keeps counting through reset and index
+  hd->enc_vel_count += (int16_t)(raw_count - hd->enc_vel_last_raw);
+  hd->enc_vel_last_raw = raw_count;
+  class_enc_vel_update(&hd->enc_vel, period, hd->enc_vel_count, hd->enc_scale_recip);
+
   hd->last_operational = 1;
 }
 
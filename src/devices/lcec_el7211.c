@@ -31,9 +31,9 @@
 static int lcec_el7201_9014_init(int comp_id, struct lcec_slave *slave);
 
 static lcec_typelist_t types[] = {
-    {"EL7201_9014", LCEC_BECKHOFF_VID, 0x1C213052, 0, NULL, lcec_el7201_9014_init},
-    {"EL7211", LCEC_BECKHOFF_VID, 0x1C2B3052, 0, NULL, lcec_el7211_init},
-    {"EL7221", LCEC_BECKHOFF_VID, 0x1C353052, 0, NULL, lcec_el7211_init},
+    {"EL7201_9014", LCEC_BECKHOFF_VID, 0x1C213052, 0, lcec_el7211_preinit, lcec_el7201_9014_init},
+    {"EL7211", LCEC_BECKHOFF_VID, 0x1C2B3052, 0, lcec_el7211_preinit, lcec_el7211_init},
+    {"EL7221", LCEC_BECKHOFF_VID, 0x1C353052, 0, lcec_el7211_preinit, lcec_el7211_init},
     {NULL},
 };
 ADD_TYPES(types);
@@ -274,6 +274,15 @@ static int lcec_el7211_export_pins(lcec_master_t *master, struct lcec_slave *sla
   return 0;
 }
 
+int lcec_el7211_preinit(struct lcec_slave *slave) {
+  // queue the sdos read by lcec_el7211_export_pins()
+  if (lcec_prefetch_sdo(slave, 0x9010, 0x14, 4) || lcec_prefetch_sdo(slave, 0x9010, 0x15, 4)) {
+    return -ENOMEM;
+  }
+
+  return 0;
+}
+
 // TODO: lcec_el7411_init calls this.  Fix?
 /*static*/ int lcec_el7211_init(int comp_id, struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
@@ -24,5 +24,6 @@
 
 #include "../lcec.h"
 
+int lcec_el7211_preinit(struct lcec_slave *slave);
 int lcec_el7211_init(int comp_id, struct lcec_slave *slave);
 #endif
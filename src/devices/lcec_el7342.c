@@ -39,10 +39,11 @@
 
 static void lcec_el7342_read(struct lcec_slave *slave, long period);
 static void lcec_el7342_write(struct lcec_slave *slave, long period);
+static int lcec_el7342_preinit(struct lcec_slave *slave);
 static int lcec_el7342_init(int comp_id, struct lcec_slave *slave);
 
 static lcec_typelist_t types[] = {
-    {"EL7342", LCEC_BECKHOFF_VID, 0x1cae3052, 0, NULL, lcec_el7342_init},
+    {"EL7342", LCEC_BECKHOFF_VID, 0x1cae3052, 0, lcec_el7342_preinit, lcec_el7342_init},
     {NULL},
 };
 ADD_TYPES(types);
@@ -382,6 +383,19 @@ static ec_sync_info_t lcec_el7342_syncs[] = {
 
 static void lcec_el7342_set_info(lcec_el7342_chan_t *chan, hal_s32_t *raw_info, hal_u32_t *sel_info);
 
+static int lcec_el7342_preinit(struct lcec_slave *slave) {
+  int i;
+
+  // queue the info selector sdos read by init
+  for (i = 0; i < LCEC_EL7342_CHANS; i++) {
+    if (lcec_prefetch_sdo(slave, 0x8022 + (i << 4), 0x11, 1) || lcec_prefetch_sdo(slave, 0x8022 + (i << 4), 0x19, 1)) {
+      return -ENOMEM;
+    }
+  }
+
+  return 0;
+}
+
 static int lcec_el7342_init(int comp_id, struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
   lcec_el7342_data_t *hal_data;
@@ -48,7 +48,7 @@ static lcec_modparam_desc_t lcec_el7411_modparams[] = {
 };
 
 static lcec_typelist_t types[] = {
-    {"EL7411", LCEC_BECKHOFF_VID, 0x1Cf33052, 0, NULL, lcec_el7411_init, lcec_el7411_modparams},
+    {"EL7411", LCEC_BECKHOFF_VID, 0x1Cf33052, 0, lcec_el7211_preinit, lcec_el7411_init, lcec_el7411_modparams},
     {NULL},
 };
 ADD_TYPES(types);
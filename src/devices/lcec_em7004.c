@@ -22,6 +22,7 @@
 #include "lcec_em7004.h"
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
 
 static void lcec_em7004_read(struct lcec_slave *slave, long period);
 static void lcec_em7004_write(struct lcec_slave *slave, long period);
@@ -107,6 +108,10 @@ typedef struct {
   int16_t last_count;
   double old_scale;
   double scale;
+
+  lcec_class_enc_vel_t vel;
+  long long vel_count;
+  int16_t vel_last_raw;
 } lcec_em7004_enc_t;
 
 typedef struct {
@@ -176,6 +181,7 @@ static int lcec_em7004_init(int comp_id, struct lcec_slave *slave) {
   lcec_em7004_enc_t *enc;
   int i;
   int err;
+  char pfx[HAL_NAME_LEN];
 
   // initialize callbacks
   slave->proc_read = lcec_em7004_read;
@@ -257,6 +263,10 @@ static int lcec_em7004_init(int comp_id, struct lcec_slave *slave) {
     if ((err = lcec_pin_newf_list(enc, slave_enc_pins, LCEC_MODULE_NAME, master->name, slave->name, i)) != 0) {
       return err;
     }
+    rtapi_snprintf(pfx, HAL_NAME_LEN, "enc-%d", i);
+    if ((err = class_enc_vel_init(slave, &enc->vel, pfx)) != 0) {
+      return err;
+    }
 
     // initialize pins
     *(enc->pos_scale) = 1.0;
@@ -322,12 +332,14 @@ static void lcec_em7004_read(struct lcec_slave *slave, long period) {
     // check for operational change of slave
     if (!hal_data->last_operational) {
       enc->last_count = raw_count;
+      class_enc_vel_reset(&enc->vel);
     }
 
     // check for counter set done
     if (EC_READ_BIT(&pd[enc->set_count_done_pdo_os], enc->set_count_done_pdo_bp)) {
       enc->last_count = raw_count;
       *(enc->set_raw_count) = 0;
+      class_enc_vel_reset(&enc->vel);
     }
 
     // update raw values
@@ -358,6 +370,11 @@ static void lcec_em7004_read(struct lcec_slave *slave, long period) {
 
     // scale count to make floating point position
     *(enc->pos) = *(enc->count) * enc->scale;
+
+    // velocity from the raw counter, which keeps counting through reset and index
+    enc->vel_count += (int16_t)(raw_count - enc->vel_last_raw);
+    enc->vel_last_raw = raw_count;
+    class_enc_vel_update(&enc->vel, period, enc->vel_count, enc->scale);
   }
 
   hal_data->last_operational = 1;
@@ -20,6 +20,9 @@
 /// @brief Driver for EpoCAT FR4000 controllers
 
 #include "../lcec.h"
+#include "lcec_class_enc.h"
+
+#define LCEC_FR4000_ENC_COUNT 5
 
 static int lcec_fr4000_init(int comp_id, struct lcec_slave *slave);
 
@@ -137,6 +140,10 @@ typedef struct {
   hal_bit_t update_02_position;
   hal_bit_t update_03_position;
   hal_bit_t update_04_position;
+
+  lcec_class_enc_vel_t enc_vel[LCEC_FR4000_ENC_COUNT];
+  long long enc_vel_count[LCEC_FR4000_ENC_COUNT];
+  int last_operational;
 } lcec_fr4000_data_t;
 
 static const lcec_pindesc_t slave_pins[] = {
@@ -370,7 +377,8 @@ void lcec_fr4000_write(struct lcec_slave *slave, long period);
 int lcec_fr4000_init(int comp_id, struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
   lcec_fr4000_data_t *hal_data;
-  int err;
+  int i, err;
+  char pfx[HAL_NAME_LEN];
 
   // initialize callbacks
   slave->proc_read = lcec_fr4000_read;
@@ -414,6 +422,14 @@ int lcec_fr4000_init(int comp_id, struct lcec_slave *slave) {
     return err;
   }
 
+  // export velocity estimators
+  for (i = 0; i < LCEC_FR4000_ENC_COUNT; i++) {
+    rtapi_snprintf(pfx, HAL_NAME_LEN, "axis%d-enc", i);
+    if ((err = class_enc_vel_init(slave, &hal_data->enc_vel[i], pfx)) != 0) {
+      return err;
+    }
+  }
+
   // initialize variables
   raw_counts_old[0] = 0;
   raw_counts_old[1] = 0;
@@ -461,6 +477,8 @@ void lcec_fr4000_read(struct lcec_slave *slave, long period) {
 
   uint16_t raw_counts[5];
   int32_t raw_forced_counts[5];
+  double enc_scales[LCEC_FR4000_ENC_COUNT];
+  int i;
 
   *(hal_data->IN_0) = EC_READ_BIT(&pd[hal_data->off_dig_inp], 0);
   *(hal_data->IN_1) = EC_READ_BIT(&pd[hal_data->off_dig_inp], 1);
@@ -524,6 +542,7 @@ void lcec_fr4000_read(struct lcec_slave *slave, long period) {
 
   if (hal_data->update_00_position == true) {
     hal_data->update_00_position = false;
+    class_enc_vel_reset(&hal_data->enc_vel[0]);
 
     raw_forced_counts[0] = hal_data->set_00_position / hal_data->enc_00_scale;
 
@@ -531,6 +550,7 @@ void lcec_fr4000_read(struct lcec_slave *slave, long period) {
   }
   if (hal_data->update_01_position == true) {
     hal_data->update_01_position = false;
+    class_enc_vel_reset(&hal_data->enc_vel[1]);
 
     raw_forced_counts[1] = hal_data->set_01_position / hal_data->enc_01_scale;
 
@@ -538,6 +558,7 @@ void lcec_fr4000_read(struct lcec_slave *slave, long period) {
   }
   if (hal_data->update_02_position == true) {
     hal_data->update_02_position = false;
+    class_enc_vel_reset(&hal_data->enc_vel[2]);
 
     raw_forced_counts[2] = hal_data->set_02_position / hal_data->enc_02_scale;
 
@@ -545,6 +566,7 @@ void lcec_fr4000_read(struct lcec_slave *slave, long period) {
   }
   if (hal_data->update_03_position == true) {
     hal_data->update_03_position = false;
+    class_enc_vel_reset(&hal_data->enc_vel[3]);
 
     raw_forced_counts[3] = hal_data->set_03_position / hal_data->enc_03_scale;
 
@@ -552,12 +574,30 @@ void lcec_fr4000_read(struct lcec_slave *slave, long period) {
   }
   if (hal_data->update_04_position == true) {
     hal_data->update_04_position = false;
+    class_enc_vel_reset(&hal_data->enc_vel[4]);
 
     raw_forced_counts[4] = hal_data->set_04_position / hal_data->enc_04_scale;
 
     counts[4] = (int32_t)raw_forced_counts[4];
   }
 
+  // velocity from the raw counters, which keep counting through index and set-position
+  if (!hal_data->last_operational) {
+    for (i = 0; i < LCEC_FR4000_ENC_COUNT; i++) {
+      class_enc_vel_reset(&hal_data->enc_vel[i]);
+    }
+  }
+  hal_data->last_operational = slave->state.operational;
+  enc_scales[0] = hal_data->enc_00_scale;
+  enc_scales[1] = hal_data->enc_01_scale;
+  enc_scales[2] = hal_data->enc_02_scale;
+  enc_scales[3] = hal_data->enc_03_scale;
+  enc_scales[4] = hal_data->enc_04_scale;
+  for (i = 0; i < LCEC_FR4000_ENC_COUNT; i++) {
+    hal_data->enc_vel_count[i] += (int16_t)(raw_counts[i] - raw_counts_old[i]);
+    class_enc_vel_update(&hal_data->enc_vel[i], period, hal_data->enc_vel_count[i], enc_scales[i]);
+  }
+
   counts[0] += (int16_t)(raw_counts[0] - raw_counts_old[0]);
   raw_counts_old[0] = raw_counts[0];
 
@@ -32,10 +32,7 @@ ADD_TYPES(types)
 void lcec_generic_read(struct lcec_slave *slave, long period);
 void lcec_generic_write(struct lcec_slave *slave, long period);
 
-hal_s32_t lcec_generic_read_s32(uint8_t *pd, lcec_generic_pin_t *hal_data);
-hal_u32_t lcec_generic_read_u32(uint8_t *pd, lcec_generic_pin_t *hal_data);
-void lcec_generic_write_s32(uint8_t *pd, lcec_generic_pin_t *hal_data, hal_s32_t sval);
-void lcec_generic_write_u32(uint8_t *pd, lcec_generic_pin_t *hal_data, hal_u32_t uval);
+static void lcec_generic_compile(struct lcec_slave *slave, lcec_generic_data_t *data);
 
 /// @brief Initialize a generic device.
 ///
@@ -44,9 +41,19 @@ void lcec_generic_write_u32(uint8_t *pd, lcec_generic_pin_t *hal_data, hal_u32_t
 int lcec_generic_init(int comp_id, struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
   lcec_generic_pin_t *hal_data = (lcec_generic_pin_t *)slave->hal_data;
-  int i, j;
+  lcec_generic_data_t *data;
+  int i, j, n;
   int err;
 
+  // allocate per-slave data; `hal_data` stays the pin array set up by `lcec_main`
+  if ((data = hal_malloc(sizeof(lcec_generic_data_t))) == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s failed\n", master->name, slave->name);
+    return -EIO;
+  }
+  memset(data, 0, sizeof(lcec_generic_data_t));
+  data->pins = hal_data;
+  data->pin_count = slave->generic_pdo_entry_count;
+
   // initialize callbacks
   slave->proc_read = lcec_generic_read;
   slave->proc_write = lcec_generic_write;
@@ -94,9 +101,26 @@ int lcec_generic_init(int comp_id, struct lcec_slave *slave) {
         }
         break;
 
-      case HAL_FLOAT:
+      case HAL_S64:
+      case HAL_U64:
         // check data size
-        if ((hal_data->bitLength > 32) && (hal_data->subType != lcecPdoEntTypeFloatDoubleIeee)) {
+        if (hal_data->bitLength > 64) {
+          rtapi_print_msg(RTAPI_MSG_WARN, LCEC_MSG_PFX "unable to export pin %s.%s.%s.%s: invalid process data bitlen!\n", LCEC_MODULE_NAME,
+              master->name, slave->name, hal_data->name);
+          continue;
+        }
+
+        // export pin
+        err = lcec_pin_newf(
+            hal_data->type, hal_data->dir, &hal_data->pin[0], "%s.%s.%s.%s", LCEC_MODULE_NAME, master->name, slave->name, hal_data->name);
+        if (err != 0) {
+          return err;
+        }
+        break;
+
+      case HAL_FLOAT:
+        // check data size; integer fields may be up to 64 bits
+        if ((hal_data->bitLength > 64) || ((hal_data->bitLength > 32) && (hal_data->subType == lcecPdoEntTypeFloatIeee))) {
           rtapi_print_msg(RTAPI_MSG_WARN, LCEC_MSG_PFX "unable to export pin %s.%s.%s.%s: invalid process data bitlen!\n", LCEC_MODULE_NAME,
               master->name, slave->name, hal_data->name);
           continue;
@@ -115,228 +139,302 @@ int lcec_generic_init(int comp_id, struct lcec_slave *slave) {
     }
   }
 
+  // size the op array; it is filled in by the first read or write,
+  // once PDO registration has set the final offsets
+  for (i = 0, hal_data = data->pins; i < data->pin_count; i++, hal_data++) {
+    n = 0;
+    while (n < LCEC_CONF_GENERIC_MAX_SUBPINS && hal_data->pin[n] != NULL) {
+      n++;
+    }
+    if (hal_data->dir == HAL_OUT) {
+      data->read_count += n;
+    } else if (hal_data->dir == HAL_IN) {
+      data->write_count += n;
+    }
+  }
+  if (data->read_count + data->write_count > 0) {
+    data->ops = hal_malloc(sizeof(lcec_generic_op_t) * (data->read_count + data->write_count));
+    if (data->ops == NULL) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for slave %s.%s failed\n", master->name, slave->name);
+      return -EIO;
+    }
+    memset(data->ops, 0, sizeof(lcec_generic_op_t) * (data->read_count + data->write_count));
+  }
+
+  slave->hal_data = data;
   return 0;
 }
 
-/// @brief Read from a generic device.
-void lcec_generic_read(struct lcec_slave *slave, long period) {
+// Fill in one op for a field of `bits` bits, starting at bit `bitpos` of the process image.
+static void lcec_generic_op_init(lcec_generic_op_t *op, lcec_generic_op_type_t type, void *pin, unsigned int bitpos, int bits,
+    const lcec_generic_pin_t *hal_data, int pd_len) {
+  op->type = type;
+  op->pin = pin;
+  op->byte = bitpos >> 3;
+  op->wide = (op->byte + 8 <= pd_len);
+  op->shift = bitpos & 0x07;
+  op->ext = 64 - bits;
+  op->split = (op->shift + bits > 64);
+  op->nbytes = (op->shift + bits + 7) >> 3;
+  if (op->nbytes > 8) op->nbytes = 8;
+  op->mask = (~0ULL >> op->ext) << op->shift;
+  op->hi_mask = op->split ? (~0ULL >> op->ext) >> (64 - op->shift) : 0;
+  if (type == LCEC_GENERIC_OP_S32 || type == LCEC_GENERIC_OP_S64 || type == LCEC_GENERIC_OP_FLOAT_S) {
+    op->max = (~0ULL >> op->ext) >> 1;
+    op->min = -(int64_t)op->max - 1;
+  } else {
+    op->max = ~0ULL >> op->ext;
+    op->min = 0;
+  }
+  op->scale = hal_data->floatScale;
+  op->offset = hal_data->floatOffset;
+}
+
+/// @brief Compile the pin list into a flat array of reads and writes.
+///
+/// Runs once, from the first read or write, since PDO offsets aren't
+/// known until all slaves have registered their PDOs.
+static void lcec_generic_compile(struct lcec_slave *slave, lcec_generic_data_t *data) {
   lcec_master_t *master = slave->master;
-  lcec_generic_pin_t *hal_data = (lcec_generic_pin_t *)slave->hal_data;
-  uint8_t *pd = master->process_data;
-  int i, j, offset;
-  hal_float_t fval;
+  lcec_generic_pin_t *hal_data;
+  lcec_generic_op_t *rop = data->ops;
+  lcec_generic_op_t *wop = data->ops + data->read_count;
+  lcec_generic_op_t *op;
+  lcec_generic_op_type_t type;
+  unsigned int bitpos;
+  int i, j;
 
-  // read data
-  for (i = 0; i < slave->generic_pdo_entry_count; i++, hal_data++) {
-    // skip wrong direction and uninitialized pins
-    if (hal_data->dir != HAL_OUT || hal_data->pin[0] == NULL) {
+  for (i = 0, hal_data = data->pins; i < data->pin_count; i++, hal_data++) {
+    // skip uninitialized pins and pins without a direction
+    if (hal_data->pin[0] == NULL || (hal_data->dir != HAL_OUT && hal_data->dir != HAL_IN)) {
       continue;
     }
 
-    switch (hal_data->type) {
-      case HAL_BIT:
-        offset = ((hal_data->pdo_os << 3) | (hal_data->pdo_bp & 0x07)) + hal_data->bitOffset;
-        for (j = 0; j < LCEC_CONF_GENERIC_MAX_SUBPINS && hal_data->pin[j] != NULL; j++, offset++) {
-          *((hal_bit_t *)hal_data->pin[j]) = EC_READ_BIT(&pd[offset >> 3], offset & 0x07);
-        }
-        break;
+    bitpos = ((hal_data->pdo_os << 3) | (hal_data->pdo_bp & 0x07)) + hal_data->bitOffset;
 
+    if (hal_data->type == HAL_BIT) {
+      for (j = 0; j < LCEC_CONF_GENERIC_MAX_SUBPINS && hal_data->pin[j] != NULL; j++) {
+        op = (hal_data->dir == HAL_OUT) ? rop++ : wop++;
+        lcec_generic_op_init(op, LCEC_GENERIC_OP_BIT, hal_data->pin[j], bitpos + j, 1, hal_data, master->process_data_len);
+      }
+      continue;
+    }
+
+    switch (hal_data->type) {
       case HAL_S32:
-        *((hal_s32_t *)hal_data->pin[0]) = lcec_generic_read_s32(pd, hal_data);
+        type = LCEC_GENERIC_OP_S32;
         break;
-
       case HAL_U32:
-        *((hal_u32_t *)hal_data->pin[0]) = lcec_generic_read_u32(pd, hal_data);
+        type = LCEC_GENERIC_OP_U32;
         break;
-
-      case HAL_FLOAT:
+      case HAL_S64:
+        type = LCEC_GENERIC_OP_S64;
+        break;
+      case HAL_U64:
+        type = LCEC_GENERIC_OP_U64;
+        break;
+      default:
         if (hal_data->subType == lcecPdoEntTypeFloatUnsigned) {
-          fval = lcec_generic_read_u32(pd, hal_data);
+          type = LCEC_GENERIC_OP_FLOAT_U;
         } else if (hal_data->subType == lcecPdoEntTypeFloatIeee) {
-          fval = EC_READ_REAL(&pd[hal_data->pdo_os]);
+          type = LCEC_GENERIC_OP_REAL;
         } else if (hal_data->subType == lcecPdoEntTypeFloatDoubleIeee) {
-          fval = EC_READ_LREAL(&pd[hal_data->pdo_os]);
+          type = LCEC_GENERIC_OP_LREAL;
         } else {
-          fval = lcec_generic_read_s32(pd, hal_data);
+          type = LCEC_GENERIC_OP_FLOAT_S;
         }
-
-        fval *= hal_data->floatScale;
-        fval += hal_data->floatOffset;
-        *((hal_float_t *)hal_data->pin[0]) = fval;
         break;
+    }
 
-      default:
-        continue;
+    op = (hal_data->dir == HAL_OUT) ? rop++ : wop++;
+    if (type == LCEC_GENERIC_OP_REAL) {
+      // IEEE floats are always byte aligned
+      lcec_generic_op_init(op, type, hal_data->pin[0], hal_data->pdo_os << 3, 32, hal_data, master->process_data_len);
+    } else if (type == LCEC_GENERIC_OP_LREAL) {
+      lcec_generic_op_init(op, type, hal_data->pin[0], hal_data->pdo_os << 3, 64, hal_data, master->process_data_len);
+    } else {
+      lcec_generic_op_init(op, type, hal_data->pin[0], bitpos, hal_data->bitLength, hal_data, master->process_data_len);
     }
   }
+
+  data->compiled = 1;
 }
 
-/// @brief Write to a generic device.
-void lcec_generic_write(struct lcec_slave *slave, long period) {
+/// @brief Load the 64-bit word starting at an op's first byte.
+///
+/// Fields too close to the end of the process image for a full word
+/// only load the bytes they touch.
+static inline uint64_t lcec_generic_load(const uint8_t *pd, const lcec_generic_op_t *op) {
+  return lcec_pd_read_word(pd, op->byte, op->wide ? 8 : op->nbytes);
+}
+
+/// @brief Store the 64-bit word starting at an op's first byte.
+static inline void lcec_generic_store(uint8_t *pd, const lcec_generic_op_t *op, uint64_t w) {
+  lcec_pd_write_word(pd, op->byte, op->wide ? 8 : op->nbytes, w);
+}
+
+/// @brief Get an op's field, shifted down to bit 0 but not yet zero- or sign-extended.
+static inline uint64_t lcec_generic_get(const uint8_t *pd, const lcec_generic_op_t *op) {
+  uint64_t v = lcec_generic_load(pd, op) >> op->shift;
+
+  // unaligned fields of more than 57 bits continue into a ninth byte
+  if (op->split) {
+    v |= (uint64_t)pd[op->byte + 8] << (64 - op->shift);
+  }
+  return v;
+}
+
+/// @brief Get an op's field as an unsigned integer.
+static inline uint64_t lcec_generic_get_u(const uint8_t *pd, const lcec_generic_op_t *op) {
+  return (lcec_generic_get(pd, op) << op->ext) >> op->ext;
+}
+
+/// @brief Get an op's field as a signed integer.
+static inline int64_t lcec_generic_get_s(const uint8_t *pd, const lcec_generic_op_t *op) {
+  return (int64_t)(lcec_generic_get(pd, op) << op->ext) >> op->ext;
+}
+
+/// @brief Merge a value into an op's field.
+static inline void lcec_generic_set(uint8_t *pd, const lcec_generic_op_t *op, uint64_t val) {
+  lcec_generic_store(pd, op, (lcec_generic_load(pd, op) & ~op->mask) | ((val << op->shift) & op->mask));
+  if (op->split) {
+    pd[op->byte + 8] = (pd[op->byte + 8] & ~op->hi_mask) | ((val >> (64 - op->shift)) & op->hi_mask);
+  }
+}
+
+/// @brief Clamp a signed value to what fits in an op's field.
+static inline uint64_t lcec_generic_clamp_s(const lcec_generic_op_t *op, int64_t val) {
+  if (val > (int64_t)op->max) val = op->max;
+  if (val < op->min) val = op->min;
+  return (uint64_t)val;
+}
+
+/// @brief Clamp an unsigned value to what fits in an op's field.
+static inline uint64_t lcec_generic_clamp_u(const lcec_generic_op_t *op, uint64_t val) {
+  if (val > op->max) val = op->max;
+  return val;
+}
+
+/// @brief Convert a float to what fits in an op's field, rounding towards zero.
+static inline uint64_t lcec_generic_clamp_f(const lcec_generic_op_t *op, hal_float_t fval) {
+  // (hal_float_t)max may round up to 2^63 or 2^64, which doesn't
+  // convert back; anything that large is clamped to max anyway.
+  if (op->min < 0) {
+    if (fval >= (hal_float_t)(int64_t)op->max) return op->max;
+    if (fval <= (hal_float_t)op->min) return (uint64_t)op->min;
+    return (uint64_t)(int64_t)fval;
+  }
+
+  if (fval >= (hal_float_t)op->max) return op->max;
+  if (fval <= 0.0) return 0;
+  return (uint64_t)fval;
+}
+
+/// @brief Read from a generic device.
+void lcec_generic_read(struct lcec_slave *slave, long period) {
   lcec_master_t *master = slave->master;
-  lcec_generic_pin_t *hal_data = (lcec_generic_pin_t *)slave->hal_data;
+  lcec_generic_data_t *data = (lcec_generic_data_t *)slave->hal_data;
   uint8_t *pd = master->process_data;
-  int i, j, offset;
-  hal_float_t fval;
+  const lcec_generic_op_t *op, *end;
 
-  // write data
-  for (i = 0; i < slave->generic_pdo_entry_count; i++, hal_data++) {
-    // skip wrong direction and uninitialized pins
-    if (hal_data->dir != HAL_IN || hal_data->pin[0] == NULL) {
-      continue;
-    }
+  if (!data->compiled) {
+    lcec_generic_compile(slave, data);
+  }
 
-    switch (hal_data->type) {
-      case HAL_BIT:
-        offset = ((hal_data->pdo_os << 3) | (hal_data->pdo_bp & 0x07)) + hal_data->bitOffset;
-        for (j = 0; j < LCEC_CONF_GENERIC_MAX_SUBPINS && hal_data->pin[j] != NULL; j++, offset++) {
-          EC_WRITE_BIT(&pd[offset >> 3], offset & 0x07, *((hal_bit_t *)hal_data->pin[j]));
-        }
+  // read data
+  for (op = data->ops, end = op + data->read_count; op < end; op++) {
+    switch (op->type) {
+      case LCEC_GENERIC_OP_BIT:
+        *((hal_bit_t *)op->pin) = (lcec_generic_load(pd, op) >> op->shift) & 1;
         break;
 
-      case HAL_S32:
-        lcec_generic_write_s32(pd, hal_data, *((hal_s32_t *)hal_data->pin[0]));
+      case LCEC_GENERIC_OP_U32:
+        *((hal_u32_t *)op->pin) = lcec_generic_get_u(pd, op);
         break;
 
-      case HAL_U32:
-        lcec_generic_write_u32(pd, hal_data, *((hal_u32_t *)hal_data->pin[0]));
+      case LCEC_GENERIC_OP_S32:
+        *((hal_s32_t *)op->pin) = lcec_generic_get_s(pd, op);
         break;
 
-      case HAL_FLOAT:
-        fval = *((hal_float_t *)hal_data->pin[0]);
-        fval += hal_data->floatOffset;
-        fval *= hal_data->floatScale;
+      case LCEC_GENERIC_OP_U64:
+        *((hal_u64_t *)op->pin) = lcec_generic_get_u(pd, op);
+        break;
 
-        if (hal_data->subType == lcecPdoEntTypeFloatUnsigned) {
-          lcec_generic_write_u32(pd, hal_data, (hal_u32_t)fval);
-        } else if (hal_data->subType == lcecPdoEntTypeFloatIeee) {
-          EC_WRITE_REAL(&pd[hal_data->pdo_os], fval);
-        } else if (hal_data->subType == lcecPdoEntTypeFloatDoubleIeee) {
-          EC_WRITE_LREAL(&pd[hal_data->pdo_os], fval);
-        } else {
-          lcec_generic_write_s32(pd, hal_data, (hal_s32_t)fval);
-        }
+      case LCEC_GENERIC_OP_S64:
+        *((hal_s64_t *)op->pin) = lcec_generic_get_s(pd, op);
         break;
 
-      default:
-        continue;
+      case LCEC_GENERIC_OP_FLOAT_U:
+        *((hal_float_t *)op->pin) = (hal_float_t)lcec_generic_get_u(pd, op) * op->scale + op->offset;
+        break;
+
+      case LCEC_GENERIC_OP_FLOAT_S:
+        *((hal_float_t *)op->pin) = (hal_float_t)lcec_generic_get_s(pd, op) * op->scale + op->offset;
+        break;
+
+      case LCEC_GENERIC_OP_REAL:
+        *((hal_float_t *)op->pin) = EC_READ_REAL(&pd[op->byte]) * op->scale + op->offset;
+        break;
+
+      case LCEC_GENERIC_OP_LREAL:
+        *((hal_float_t *)op->pin) = EC_READ_LREAL(&pd[op->byte]) * op->scale + op->offset;
+        break;
     }
   }
 }
 
-/// @brief Read a possibly-misaligned signed integer.
-hal_s32_t lcec_generic_read_s32(uint8_t *pd, lcec_generic_pin_t *hal_data) {
-  int i, offset;
-  hal_s32_t sval;
-
-  if (hal_data->pdo_bp == 0 && hal_data->bitOffset == 0) {
-    switch (hal_data->bitLength) {
-      case 8:
-        return EC_READ_S8(&pd[hal_data->pdo_os]);
-      case 16:
-        return EC_READ_S16(&pd[hal_data->pdo_os]);
-      case 32:
-        return EC_READ_S32(&pd[hal_data->pdo_os]);
-    }
-  }
+/// @brief Write to a generic device.
+void lcec_generic_write(struct lcec_slave *slave, long period) {
+  lcec_master_t *master = slave->master;
+  lcec_generic_data_t *data = (lcec_generic_data_t *)slave->hal_data;
+  uint8_t *pd = master->process_data;
+  const lcec_generic_op_t *op, *end;
+  uint64_t val;
 
-  offset = ((hal_data->pdo_os << 3) | (hal_data->pdo_bp & 0x07)) + hal_data->bitOffset;
-  for (sval = 0, i = 0; i < hal_data->bitLength; i++, offset++) {
-    if (EC_READ_BIT(&pd[offset >> 3], offset & 0x07)) {
-      sval |= (1 << i);
-    }
+  if (!data->compiled) {
+    lcec_generic_compile(slave, data);
   }
 
-  // sign-extend shorter length integers
-  switch (hal_data->bitLength) {
-    case 8:
-      return (int8_t)sval;
-    case 16:
-      return (int16_t)sval;
-  }
+  // write data
+  for (op = data->ops + data->read_count, end = op + data->write_count; op < end; op++) {
+    switch (op->type) {
+      case LCEC_GENERIC_OP_BIT:
+        val = *((hal_bit_t *)op->pin) ? 1 : 0;
+        break;
 
-  return sval;
-}
+      case LCEC_GENERIC_OP_U32:
+        val = lcec_generic_clamp_u(op, *((hal_u32_t *)op->pin));
+        break;
 
-/// @brief Read a possibly-misaligned unsigned integer.
-hal_u32_t lcec_generic_read_u32(uint8_t *pd, lcec_generic_pin_t *hal_data) {
-  int i, offset;
-  hal_u32_t uval;
-
-  if (hal_data->pdo_bp == 0 && hal_data->bitOffset == 0) {
-    switch (hal_data->bitLength) {
-      case 8:
-        return EC_READ_U8(&pd[hal_data->pdo_os]);
-      case 16:
-        return EC_READ_U16(&pd[hal_data->pdo_os]);
-      case 32:
-        return EC_READ_U32(&pd[hal_data->pdo_os]);
-    }
-  }
+      case LCEC_GENERIC_OP_S32:
+        val = lcec_generic_clamp_s(op, *((hal_s32_t *)op->pin));
+        break;
 
-  offset = ((hal_data->pdo_os << 3) | (hal_data->pdo_bp & 0x07)) + hal_data->bitOffset;
-  for (uval = 0, i = 0; i < hal_data->bitLength; i++, offset++) {
-    if (EC_READ_BIT(&pd[offset >> 3], offset & 0x07)) {
-      uval |= (1 << i);
-    }
-  }
-  return uval;
-}
+      case LCEC_GENERIC_OP_U64:
+        val = lcec_generic_clamp_u(op, *((hal_u64_t *)op->pin));
+        break;
 
-/// @brief Write a possibly-misaligned signed integer.
-void lcec_generic_write_s32(uint8_t *pd, lcec_generic_pin_t *hal_data, hal_s32_t sval) {
-  int i, offset;
-
-  hal_s32_t lim = ((1LL << hal_data->bitLength) >> 1) - 1LL;
-  if (sval > lim) sval = lim;
-  lim = ~lim;
-  if (sval < lim) sval = lim;
-
-  if (hal_data->pdo_bp == 0 && hal_data->bitOffset == 0) {
-    switch (hal_data->bitLength) {
-      case 8:
-        EC_WRITE_S8(&pd[hal_data->pdo_os], sval);
-        return;
-      case 16:
-        EC_WRITE_S16(&pd[hal_data->pdo_os], sval);
-        return;
-      case 32:
-        EC_WRITE_S32(&pd[hal_data->pdo_os], sval);
-        return;
-    }
-  }
+      case LCEC_GENERIC_OP_S64:
+        val = lcec_generic_clamp_s(op, *((hal_s64_t *)op->pin));
+        break;
 
-  offset = ((hal_data->pdo_os << 3) | (hal_data->pdo_bp & 0x07)) + hal_data->bitOffset;
-  for (i = 0; i < hal_data->bitLength; i++, offset++) {
-    EC_WRITE_BIT(&pd[offset >> 3], offset & 0x07, sval & 1);
-    sval >>= 1;
-  }
-}
+      case LCEC_GENERIC_OP_FLOAT_U:
+      case LCEC_GENERIC_OP_FLOAT_S:
+        val = lcec_generic_clamp_f(op, (*((hal_float_t *)op->pin) + op->offset) * op->scale);
+        break;
+
+      case LCEC_GENERIC_OP_REAL:
+        EC_WRITE_REAL(&pd[op->byte], (*((hal_float_t *)op->pin) + op->offset) * op->scale);
+        continue;
+
+      case LCEC_GENERIC_OP_LREAL:
+        EC_WRITE_LREAL(&pd[op->byte], (*((hal_float_t *)op->pin) + op->offset) * op->scale);
+        continue;
 
-/// @brief Write a possibly-misaligned unsigned integer.
-void lcec_generic_write_u32(uint8_t *pd, lcec_generic_pin_t *hal_data, hal_u32_t uval) {
-  int i, offset;
-
-  hal_u32_t lim = (1LL << hal_data->bitLength) - 1LL;
-  if (uval > lim) uval = lim;
-
-  if (hal_data->pdo_bp == 0 && hal_data->bitOffset == 0) {
-    switch (hal_data->bitLength) {
-      case 8:
-        EC_WRITE_U8(&pd[hal_data->pdo_os], uval);
-        return;
-      case 16:
-        EC_WRITE_U16(&pd[hal_data->pdo_os], uval);
-        return;
-      case 32:
-        EC_WRITE_U32(&pd[hal_data->pdo_os], uval);
-        return;
+      default:
+        continue;
     }
-  }
 
-  offset = ((hal_data->pdo_os << 3) | (hal_data->pdo_bp & 0x07)) + hal_data->bitOffset;
-  for (i = 0; i < hal_data->bitLength; i++, offset++) {
-    EC_WRITE_BIT(&pd[offset >> 3], offset & 0x07, uval & 1);
-    uval >>= 1;
+    lcec_generic_set(pd, op, val);
   }
 }
@@ -41,6 +41,53 @@ typedef struct {
   unsigned int pdo_bp;
 } lcec_generic_pin_t;
 
+/// @brief Kind of access performed by a compiled `lcec_generic_op_t`.
+typedef enum {
+  LCEC_GENERIC_OP_BIT,      ///< `hal_bit_t` pin, a single bit.
+  LCEC_GENERIC_OP_U32,      ///< `hal_u32_t` pin, unsigned field of up to 32 bits.
+  LCEC_GENERIC_OP_S32,      ///< `hal_s32_t` pin, signed field of up to 32 bits.
+  LCEC_GENERIC_OP_U64,      ///< `hal_u64_t` pin, unsigned field of up to 64 bits.
+  LCEC_GENERIC_OP_S64,      ///< `hal_s64_t` pin, signed field of up to 64 bits.
+  LCEC_GENERIC_OP_FLOAT_U,  ///< `hal_float_t` pin, scaled unsigned field of up to 64 bits.
+  LCEC_GENERIC_OP_FLOAT_S,  ///< `hal_float_t` pin, scaled signed field of up to 64 bits.
+  LCEC_GENERIC_OP_REAL,     ///< `hal_float_t` pin, scaled 32-bit IEEE float.
+  LCEC_GENERIC_OP_LREAL,    ///< `hal_float_t` pin, scaled 64-bit IEEE float.
+} lcec_generic_op_type_t;
+
+/// @brief A single compiled pin access.
+///
+/// Integer fields are accessed through the little-endian 64-bit word
+/// that starts at the field's first byte.  Reads shift the field down
+/// and zero- or sign-extend it with a shift pair; writes merge it back
+/// in with `mask`.  Only unaligned fields of more than 57 bits spill
+/// into a ninth byte (`split`).
+typedef struct {
+  lcec_generic_op_type_t type;  ///< Kind of access.
+  void *pin;                    ///< HAL pin data.
+  unsigned int byte;            ///< Offset of the field's first byte in the process image.
+  uint8_t wide;                 ///< Set if all 8 bytes starting at `byte` are inside the process image.
+  uint8_t nbytes;               ///< Number of bytes of the word the field touches, for fields at the end of the image.
+  uint8_t shift;                ///< Bit position of the field in the word.
+  uint8_t ext;                  ///< 64 minus the field width, for zero- or sign-extension.
+  uint8_t split;                ///< Set if the field continues into the byte after the word.
+  uint64_t mask;                ///< The field's bits in the word.
+  uint8_t hi_mask;              ///< The field's bits in the byte after the word, if `split`.
+  int64_t min;                  ///< Smallest value that fits the field.
+  uint64_t max;                 ///< Largest value that fits the field.
+  hal_float_t scale;            ///< Scale for float pins.
+  hal_float_t offset;           ///< Offset for float pins.
+} lcec_generic_op_t;
+
+/// @brief Per-slave data for generic devices.
+typedef struct {
+  lcec_generic_pin_t *pins;  ///< Pins, as set up from the XML config.
+  int pin_count;             ///< Number of entries in `pins`.
+  lcec_generic_op_t *ops;    ///< Compiled accesses, `read_count` reads followed by `write_count` writes.
+  int read_count;            ///< Number of read ops.
+  int write_count;           ///< Number of write ops.
+  int compiled;              ///< Set once `ops` has been filled in from the final PDO offsets.
+} lcec_generic_data_t;
+
 int lcec_generic_init(int comp_id, struct lcec_slave *slave);
 
 #endif
@@ -0,0 +1,146 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Driver for Beckhoff oversampling terminals (EL1262, EL2262, EL3702, EL3742, EL4732)
+
+#include "../lcec.h"
+#include "lcec_class_oversample.h"
+
+#define LCEC_OVERSAMPLE_MODPARAM_OVERSAMPLING 0
+#define LCEC_OVERSAMPLE_MODPARAM_SAMPLE_RING  1
+
+#define LCEC_OVERSAMPLE_DEFAULT_SAMPLES 10
+
+static int lcec_oversample_init(int comp_id, struct lcec_slave *slave);
+
+/// @brief Modparams settings available via XML.
+static const lcec_modparam_desc_t modparams[] = {
+    {"oversampling", LCEC_OVERSAMPLE_MODPARAM_OVERSAMPLING, MODPARAM_TYPE_U32},
+    {"sampleRing", LCEC_OVERSAMPLE_MODPARAM_SAMPLE_RING, MODPARAM_TYPE_U32},
+    {NULL},
+};
+
+/// Flags for describing devices, an index into `devices`.
+#define F_EL1262 0
+#define F_EL2262 1
+#define F_EL37X2 2
+#define F_EL4732 3
+
+/// @brief Object dictionary layout of each device family, from Beckhoff's documentation.
+static const lcec_class_oversample_options_t devices[] = {
+    // EL1262: one PDO per channel, one bit entry per sample.
+    [F_EL1262] = {"din", 0, 1, 0, 100, 3, 2,
+        {
+            {0x1a00, 0, 0x6000, 0, 0x01, 1},
+            {0x1a01, 0, 0x6010, 0, 0x01, 1},
+        }},
+    // EL2262: one PDO per channel, one bit entry per sample.
+    [F_EL2262] = {"dout", 1, 1, 0, 100, 2, 2,
+        {
+            {0x1600, 0, 0x7000, 0, 0x01, 1},
+            {0x1601, 0, 0x7010, 0, 0x01, 1},
+        }},
+    // EL3702/EL3742: one PDO per sample, sample k of both channels in object 0x6000 + 16k.
+    [F_EL37X2] = {"ain", 0, 16, 0x7fff, 100, 3, 2,
+        {
+            {0x1a00, 1, 0x6000, 0x10, 0x01, 0},
+            {0x1a80, 1, 0x6000, 0x10, 0x02, 0},
+        }},
+    // EL4732: one PDO per sample, sample k of both channels in object 0x7000 + 16k.
+    [F_EL4732] = {"aout", 1, 16, 0x7fff, 100, 2, 2,
+        {
+            {0x1600, 1, 0x7000, 0x10, 0x01, 0},
+            {0x1680, 1, 0x7000, 0x10, 0x02, 0},
+        }},
+};
+
+/// Macro to avoid repeating all of the unchanging fields in
+/// `lcec_typelist_t`.
+#define BECKHOFF_OVERSAMPLE_DEVICE(name, pid, flags) \
+  { name, LCEC_BECKHOFF_VID, pid, 0, NULL, lcec_oversample_init, modparams, flags }
+
+static lcec_typelist_t types[] = {
+    BECKHOFF_OVERSAMPLE_DEVICE("EL1262", 0x04ee3052, F_EL1262),
+    BECKHOFF_OVERSAMPLE_DEVICE("EL2262", 0x08d63052, F_EL2262),
+    BECKHOFF_OVERSAMPLE_DEVICE("EL3702", 0x0e763052, F_EL37X2),
+    BECKHOFF_OVERSAMPLE_DEVICE("EL3742", 0x0e9e3052, F_EL37X2),
+    BECKHOFF_OVERSAMPLE_DEVICE("EL4732", 0x127c3052, F_EL4732),
+    {NULL},
+};
+ADD_TYPES(types)
+
+static void lcec_oversample_read_in(struct lcec_slave *slave, long period);
+static void lcec_oversample_write_out(struct lcec_slave *slave, long period);
+static void lcec_oversample_cleanup_slave(struct lcec_slave *slave);
+
+/// @brief Initialize an oversampling device.
+static int lcec_oversample_init(int comp_id, struct lcec_slave *slave) {
+  const lcec_class_oversample_options_t *opt = &devices[slave->flags];
+  LCEC_CONF_MODPARAM_VAL_T *pval;
+  lcec_class_oversample_t *hal_data;
+  int samples = LCEC_OVERSAMPLE_DEFAULT_SAMPLES;
+  uint32_t ring_size = 0;
+
+  // <modParam name="oversampling" value="20"/>
+  pval = lcec_modparam_get(slave, LCEC_OVERSAMPLE_MODPARAM_OVERSAMPLING);
+  if (pval != NULL) samples = pval->u32;
+
+  // <modParam name="sampleRing" value="1000"/>
+  pval = lcec_modparam_get(slave, LCEC_OVERSAMPLE_MODPARAM_SAMPLE_RING);
+  if (pval != NULL) ring_size = pval->u32;
+
+  hal_data = lcec_oversample_register(comp_id, slave, opt, samples, ring_size);
+  if (hal_data == NULL) {
+    return -EIO;
+  }
+  slave->hal_data = hal_data;
+  slave->proc_cleanup = lcec_oversample_cleanup_slave;
+
+  if (opt->is_output) {
+    slave->proc_write = lcec_oversample_write_out;
+  } else {
+    slave->proc_read = lcec_oversample_read_in;
+  }
+
+  return 0;
+}
+
+static void lcec_oversample_read_in(struct lcec_slave *slave, long period) {
+  lcec_class_oversample_t *hal_data = (lcec_class_oversample_t *)slave->hal_data;
+
+  // wait for slave to be operational
+  if (!slave->state.operational) {
+    return;
+  }
+
+  lcec_oversample_read(slave, hal_data, period);
+}
+
+static void lcec_oversample_write_out(struct lcec_slave *slave, long period) {
+  lcec_class_oversample_t *hal_data = (lcec_class_oversample_t *)slave->hal_data;
+
+  // wait for slave to be operational
+  if (!slave->state.operational) {
+    return;
+  }
+
+  lcec_oversample_write(slave, hal_data, period);
+}
+
+static void lcec_oversample_cleanup_slave(struct lcec_slave *slave) { lcec_oversample_cleanup((lcec_class_oversample_t *)slave->hal_data); }
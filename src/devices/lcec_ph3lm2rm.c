@@ -38,7 +38,6 @@ typedef struct {
   hal_bit_t *latch_ena_neg;
 
   hal_bit_t *error;
-  hal_bit_t *latch_valid;
   hal_bit_t *latch_state;
   hal_bit_t *latch_state_not;
 
@@ -99,7 +98,6 @@ typedef struct {
 static const lcec_pindesc_t enc_pins[] = {{HAL_BIT, HAL_IO, offsetof(lcec_ph3lm2rm_enc_data_t, latch_ena_pos), "%s.%s.%s.%s-latch-ena-pos"},
     {HAL_BIT, HAL_IO, offsetof(lcec_ph3lm2rm_enc_data_t, latch_ena_neg), "%s.%s.%s.%s-latch-ena-neg"},
     {HAL_BIT, HAL_OUT, offsetof(lcec_ph3lm2rm_enc_data_t, error), "%s.%s.%s.%s-error"},
-    {HAL_BIT, HAL_OUT, offsetof(lcec_ph3lm2rm_enc_data_t, latch_valid), "%s.%s.%s.%s-latch-valid"},
     {HAL_BIT, HAL_OUT, offsetof(lcec_ph3lm2rm_enc_data_t, latch_state), "%s.%s.%s.%s-latch-state"},
     {HAL_BIT, HAL_OUT, offsetof(lcec_ph3lm2rm_enc_data_t, latch_state_not), "%s.%s.%s.%s-latch-state-not"},
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL}};
@@ -289,10 +287,11 @@ static void lcec_ph3lm2rm_read(struct lcec_slave *slave, long period) {
 
 static void lcec_ph3lm2rm_enc_read(uint8_t *pd, lcec_ph3lm2rm_enc_data_t *ch) {
   uint32_t counter, latch;
+  int latch_valid;
 
-  // read bit values
+  // read bit values, `<pfx>-latch-valid` is set by the encoder class
   *(ch->error) = EC_READ_BIT(&pd[ch->error_os], ch->error_bp);
-  *(ch->latch_valid) = EC_READ_BIT(&pd[ch->latch_valid_os], ch->latch_valid_bp);
+  latch_valid = EC_READ_BIT(&pd[ch->latch_valid_os], ch->latch_valid_bp);
   *(ch->latch_state) = EC_READ_BIT(&pd[ch->latch_state_os], ch->latch_state_bp);
   *(ch->latch_state_not) = !*(ch->latch_state);
 
@@ -301,10 +300,10 @@ static void lcec_ph3lm2rm_enc_read(uint8_t *pd, lcec_ph3lm2rm_enc_data_t *ch) {
   latch = EC_READ_U32(&pd[ch->latch_os]);
 
   // update encoder
-  class_enc_update(&ch->enc, 0, ch->scale, counter, latch, *(ch->latch_valid));
+  class_enc_update(&ch->enc, 0, ch->scale, counter, latch, latch_valid);
 
   // reset latch enable, if captured
-  if (*(ch->latch_valid)) {
+  if (latch_valid) {
     *(ch->latch_ena_pos) = 0;
     *(ch->latch_ena_neg) = 0;
   }
@@ -90,17 +90,18 @@ static const lcec_modparam_desc_t modparams_rtec[] = {
     {NULL},
 };
 
+static int lcec_rtec_preinit(struct lcec_slave *slave);
 static int lcec_rtec_init(int comp_id, struct lcec_slave *slave);
 
 static lcec_typelist_t types[] = {
-    {"ECR60", LCEC_RTELLIGENT_VID, 0x0a880001, 0, NULL, lcec_rtec_init, /* modparams_rtec */},
-    {"ECR60x2", LCEC_RTELLIGENT_VID, 0x0a880005, 0, NULL, lcec_rtec_init,
+    {"ECR60", LCEC_RTELLIGENT_VID, 0x0a880001, 0, lcec_rtec_preinit, lcec_rtec_init, /* modparams_rtec */},
+    {"ECR60x2", LCEC_RTELLIGENT_VID, 0x0a880005, 0, lcec_rtec_preinit, lcec_rtec_init,
         /* modparams_rtec */},  // Only one channel supported right now
-    {"ECT60", LCEC_RTELLIGENT_VID, 0x0a880002, 0, NULL, lcec_rtec_init, /* modparams_rtec */},
-    {"ECT60x2", LCEC_RTELLIGENT_VID, 0x0a880006, 0, NULL, lcec_rtec_init,
+    {"ECT60", LCEC_RTELLIGENT_VID, 0x0a880002, 0, lcec_rtec_preinit, lcec_rtec_init, /* modparams_rtec */},
+    {"ECT60x2", LCEC_RTELLIGENT_VID, 0x0a880006, 0, lcec_rtec_preinit, lcec_rtec_init,
         /* modparams_rtec */},  // Only one channel supported right now
-    {"ECR86", LCEC_RTELLIGENT_VID, 0x0a880003, 0, NULL, lcec_rtec_init, /* modparams_rtec */},
-    {"ECT86", LCEC_RTELLIGENT_VID, 0x0a880004, 0, NULL, lcec_rtec_init, /* modparams_rtec */},
+    {"ECR86", LCEC_RTELLIGENT_VID, 0x0a880003, 0, lcec_rtec_preinit, lcec_rtec_init, /* modparams_rtec */},
+    {"ECT86", LCEC_RTELLIGENT_VID, 0x0a880004, 0, lcec_rtec_preinit, lcec_rtec_init, /* modparams_rtec */},
     {NULL},
 };
 ADD_TYPES_WITH_CIA402_MODPARAMS(types, modparams_rtec)
@@ -186,6 +187,7 @@ static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_
   uint16_t input_polarity = 0, input_polarity_set = 0;
   uint16_t output_polarity = 0, output_polarity_set = 0;
   uint32_t uval;
+  lcec_cia402_modparam_ctx_t ctx;
   int v;
 
   // Read current polarity values, so we don't overwrite them all.
@@ -194,6 +196,7 @@ static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_
 
   // We'll need to byte-swap here, for big-endian systems.
 
+  memset(&ctx, 0, sizeof(ctx));
   for (p = slave->modparams; p != NULL && p->id >= 0; p++) {
     switch (p->id) {
       case M_PEAKCURRENT:
@@ -363,7 +366,7 @@ static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_
         if (lcec_write_sdo16_modparam(slave, 0x2022, 0, p->value.u32, p->name) < 0) return -1;
         break;
       default:
-        v = lcec_cia402_handle_modparam(slave, p, opt);
+        v = lcec_cia402_handle_modparam(slave, p, opt, &ctx);
 
         if (v > 0) {
           rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "unknown modparam %s for slave %s.%s\n", p->name, master->name, slave->name);
@@ -378,6 +381,10 @@ static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_
     }
   }
 
+  if (lcec_cia402_finish_modparams(slave, opt, &ctx) != 0) {
+    return -1;
+  }
+
   if (output_polarity_set) {
     rtapi_print_msg(
         RTAPI_MSG_ERR, LCEC_MSG_PFX "Setting output polarity to 0x%x for slave %s.%s\n", output_polarity, master->name, slave->name);
@@ -400,6 +407,20 @@ static int handle_modparams(struct lcec_slave *slave, lcec_class_cia402_options_
   return 0;
 }
 
+static int lcec_rtec_preinit(struct lcec_slave *slave) {
+  // queue the polarity sdos read by handle_modparams()
+  if (lcec_prefetch_sdo(slave, 0x2006, 0, 2) || lcec_prefetch_sdo(slave, 0x2008, 0, 2)) {
+    return -ENOMEM;
+  }
+
+  // and the current values of the generic CiA 402 parameters
+  if (lcec_cia402_prefetch_modparams(slave) != 0) {
+    return -ENOMEM;
+  }
+
+  return 0;
+}
+
 static int lcec_rtec_init(int comp_id, struct lcec_slave *slave) {
   lcec_master_t *master = slave->master;
   lcec_rtec_data_t *hal_data;
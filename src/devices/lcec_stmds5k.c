@@ -242,6 +242,11 @@ static int lcec_stmds5k_preinit(struct lcec_slave *slave) {
     }
   }
 
+  // queue the sdos read by init
+  if (lcec_prefetch_sdo(slave, 0x2212, 0x00, 4) || lcec_prefetch_sdo(slave, 0x2401, 0x00, 4) || lcec_prefetch_sdo(slave, 0x2602, 0x00, 4)) {
+    return -ENOMEM;
+  }
+
   return 0;
 }
 
@@ -26,7 +26,11 @@
 #include "ecrt.h"
 #include "hal.h"
 #include "lcec_conf.h"
+#include "lcec_emcy.h"
+#include "lcec_layout.h"
+#include "lcec_record.h"
 #include "lcec_rtapi.h"
+#include "lcec_timing.h"
 #include "rtapi_ctype.h"
 #include "rtapi_math.h"
 #include "rtapi_string.h"
@@ -82,6 +86,9 @@
 #define LCEC_MAX_PDO_INFO_COUNT  8    ///< The maximum number of PDOs in a sync.
 #define LCEC_MAX_SYNC_COUNT      4    ///< The maximum number of syncs.
 
+#define LCEC_PREFETCH_MAX_THREADS 32    ///< The maximum number of slaves with mailbox reads in flight during startup.
+#define LCEC_BLOCK_ALIGN(size)    (((size) + 7) & ~(size_t)7)  ///< Round `size` up the way `lcec_block_alloc()` does.
+
 struct lcec_master;
 struct lcec_slave;
 
@@ -98,10 +105,17 @@ typedef enum {
   MODPARAM_TYPE_STRING  ///< Modparam value is a string.
 } lcec_modparam_type_t;
 
+/// @brief Description of a `<modParam>` that a device accepts.
+///
+/// Per-channel modParams set `channels`, and are matched by
+/// `lcec_modparam_desc_find()` both as `name` (for channel 0) and as
+/// `ch<N>name`, for channels 0 through `channels - 1`.  Channel N's
+/// ID is `id + N`.
 typedef struct {
   const char *name;           ///< the name that appears in the XML.
   int id;                     ///< Numeric ID, should be unique per device driver.
   lcec_modparam_type_t type;  ///< The type (bit, int, float, string) of this modParam.
+  int channels;               ///< If nonzero, also accept `ch<N>` prefixes for this many channels.
 } lcec_modparam_desc_t;
 
 /// @brief Definition of a device that LinuxCNC-Ethercat supports.
@@ -129,6 +143,13 @@ typedef struct {
   int data_channels;    ///< Number of data channels.
 } LCEC_CONF_FSOE_T;
 
+/// @brief One copy of FSoE frame data within a master's process data, see `lcec_master_build_fsoe_routes()`.
+typedef struct {
+  unsigned int src;  ///< Byte offset to copy from.
+  unsigned int dst;  ///< Byte offset to copy to.
+  unsigned int len;  ///< Number of bytes.
+} lcec_fsoe_route_t;
+
 typedef struct lcec_master_data {
   hal_u32_t *slaves_responding;
   hal_bit_t *state_init;
@@ -137,6 +158,9 @@ typedef struct lcec_master_data {
   hal_bit_t *state_op;
   hal_bit_t *link_up;
   hal_bit_t *all_op;
+  hal_bit_t *record_trigger;  ///< Freezes the flight recorder on a rising edge.  Only exported if `recordDepth` is set.
+  hal_bit_t *record_reset;    ///< Restarts a frozen flight recorder on a rising edge.
+  hal_bit_t *record_frozen;   ///< Set while the flight recorder is frozen.
 #ifdef RTAPI_TASK_PLL_SUPPORT
   hal_s32_t *pll_err;
   hal_s32_t *pll_out;
@@ -147,12 +171,16 @@ typedef struct lcec_master_data {
 } lcec_master_data_t;
 
 typedef struct lcec_slave_state {
-  hal_bit_t *online;        ///< Is device online?  Equivalent to the `.slave-online` HAL pin.
-  hal_bit_t *operational;   ///< Is device operational?  Equivalent to the `.slave-oper` HAL pin.
-  hal_bit_t *state_init;    ///< Is the device in state `INIT`?  Equivalant to the `.slave-state-init` HAL pin.
-  hal_bit_t *state_preop;   ///< Is the device in state `PREOP`?  Equivalant to the `.slave-state-preop` HAL pin.
-  hal_bit_t *state_safeop;  ///< Is the device in state `SAFEOP`?  Equivalant to the `.slave-state-safeop` HAL pin.
-  hal_bit_t *state_op;      ///< Is the device in state `OP`?  Equivalant to the `.slave-state-op` HAL pin.
+  hal_bit_t *online;           ///< Is device online?  Equivalent to the `.slave-online` HAL pin.
+  hal_bit_t *operational;      ///< Is device operational?  Equivalent to the `.slave-oper` HAL pin.
+  hal_bit_t *state_init;       ///< Is the device in state `INIT`?  Equivalant to the `.slave-state-init` HAL pin.
+  hal_bit_t *state_preop;      ///< Is the device in state `PREOP`?  Equivalant to the `.slave-state-preop` HAL pin.
+  hal_bit_t *state_safeop;     ///< Is the device in state `SAFEOP`?  Equivalant to the `.slave-state-safeop` HAL pin.
+  hal_bit_t *state_op;         ///< Is the device in state `OP`?  Equivalant to the `.slave-state-op` HAL pin.
+  hal_u32_t *emcy_count;       ///< Number of EMCY messages received.  Only exported if `emcyQueueSize` is set.
+  hal_u32_t *emcy_error_code;  ///< Error code of the last EMCY message.
+  hal_u32_t *emcy_error_reg;   ///< Error register of the last EMCY message.
+  hal_u32_t *emcy_overruns;    ///< Number of EMCY messages lost due to a full EtherLab queue.
 } lcec_slave_state_t;
 
 typedef struct lcec_master {
@@ -168,6 +196,10 @@ typedef struct lcec_master {
   int process_data_len;
   struct lcec_slave *first_slave;
   struct lcec_slave *last_slave;
+  struct lcec_slave_rt *slave_rt;  ///< Per-cycle slave data, built once the master is active.
+  int slave_rt_count;              ///< Number of entries in `slave_rt`.
+  lcec_fsoe_route_t *fsoe_routes;  ///< FSoE frame copies between safety slaves and logic devices, run once per read.
+  int fsoe_route_count;            ///< Number of entries in `fsoe_routes`.
   lcec_master_data_t *hal_data;
   uint64_t app_time_base;
   uint32_t app_time_period;
@@ -176,9 +208,22 @@ typedef struct lcec_master {
   int sync_ref_cycles;
   long long state_update_timer;
   ec_master_state_t ms;
+  int emcy_shmem_id;                               ///< Shared memory ID of the EMCY ring, if any.
+  LCEC_EMCY_RING_T *emcy_ring;                     ///< EMCY ring, NULL if no slave on this master has EMCY capture enabled.
+  long long timing_ns[LCEC_TIMING_MASTER_PHASES];  ///< Startup time spent per phase.
+  long long activate_time;                         ///< `rtapi_get_time()` right after `ecrt_master_activate()`.
+  LCEC_TIMING_MASTER_T *timing;                    ///< Shared memory timing record, if `lcec_conf` provided one.
+  unsigned int record_depth;                       ///< Number of frames in the flight recorder, 0 disables it.
+  int record_shmem_id;                             ///< Shared memory ID of the flight recorder, if any.
+  LCEC_RECORD_T *record;                           ///< Flight recorder, NULL if disabled.
+  uint8_t *record_frames;                          ///< First frame of the flight recorder.
+  uint32_t record_pos;                             ///< Frame to write next.
+  int record_trigger_last;                         ///< `record-trigger` in the previous cycle.
+  int record_reset_last;                           ///< `record-reset` in the previous cycle.
+  int record_fault_last;                           ///< Whether the previous cycle looked like a fault.
+  uint32_t app_time_last;                          ///< Low 32 bits of the DC application time sent with the last frame.
 #ifdef RTAPI_TASK_PLL_SUPPORT
   uint64_t dc_ref;
-  uint32_t app_time_last;
   int dc_time_valid_last;
 #endif
 } lcec_master_t;
@@ -221,6 +266,22 @@ typedef struct {
   uint8_t data[];
 } lcec_slave_idnconf_t;
 
+/// @brief Mailbox read queued by a driver's `proc_preinit`.
+///
+/// Reads are issued for all slaves of a master in parallel before any
+/// `proc_init` runs; `lcec_read_sdo()` and `lcec_read_idn()` then
+/// answer matching requests from here instead of going to the bus.
+typedef struct lcec_slave_mbxread {
+  struct lcec_slave_mbxread *next;  ///< Next queued read.
+  int is_idn;                       ///< 1 for an SoE IDN read, 0 for a CoE SDO upload.
+  uint8_t drive_no;                 ///< SoE drive number (IDN only).
+  uint16_t index;                   ///< SDO index or IDN.
+  uint8_t subindex;                 ///< SDO subindex (SDO only).
+  size_t size;                      ///< Number of bytes to read.
+  int valid;                        ///< Set once the read succeeded with exactly `size` bytes.
+  uint8_t data[];                   ///< Result.
+} lcec_slave_mbxread_t;
+
 /// @brief ModParam definition.
 typedef struct {
   int id;                          /// The integer ID from the modparam definition.  Use this as the key for comparison.
@@ -229,26 +290,34 @@ typedef struct {
 } lcec_slave_modparam_t;
 
 /// @brief EtherCAT slave.
+///
+/// The fields used by the cyclic read/write functions come first, so
+/// that a driver's `proc_read`/`proc_write` only touches the first
+/// cache line of this struct.  Everything after `emcy_queue_size` is
+/// only used while setting up the slave; the larger parts of that are
+/// freed by `lcec_slave_release_config()` once the master is active.
 typedef struct lcec_slave {
-  struct lcec_slave *prev;                   ///< Next slave
-  struct lcec_slave *next;                   ///< Previous slave
-  struct lcec_master *master;                ///< Master for this slave
+  struct lcec_slave *next;             ///< Next slave.
+  struct lcec_master *master;          ///< Master for this slave
+  void *hal_data;                      ///< HAL data, device driver specific.
+  lcec_slave_rw_t proc_read;           ///< Callback for reading from the device.
+  lcec_slave_rw_t proc_write;          ///< Callback for writing to the device.
+  ec_slave_config_t *config;           ///< Configuration data.
+  lcec_slave_state_t *hal_state_data;  ///< HAL state data.
+  ec_slave_config_state_t state;       ///< Slave state.
+  unsigned int emcy_queue_size;        ///< Size of the EtherLab EMCY queue, 0 disables EMCY capture.
+
+  struct lcec_slave *prev;                   ///< Previous slave.
   int index;                                 ///< Index of this slave.
   char name[LCEC_CONF_STR_MAXLEN];           ///< Slave name.
   uint32_t vid;                              ///< Slave's vendor ID
   uint32_t pid;                              ///< Slave's EtherCAT PID/device ID.
   ec_sync_info_t *sync_info;                 ///< Sync Manager configuration.
-  ec_slave_config_t *config;                 ///< Configuration data.
-  ec_slave_config_state_t state;             ///< Slave state.
   lcec_slave_dc_t *dc_conf;                  ///< Distributed Clock configuration.
   lcec_slave_watchdog_t *wd_conf;            ///< Watchdog configuration.
   lcec_slave_preinit_t proc_preinit;         ///< Callback for pre-init, if any.
   lcec_slave_init_t proc_init;               ///< Callback for initializing device.
   lcec_slave_cleanup_t proc_cleanup;         ///< Calback for cleaning up the device.
-  lcec_slave_rw_t proc_read;                 ///< Callback for reading from the device.
-  lcec_slave_rw_t proc_write;                ///< Callback for writing to the device.
-  lcec_slave_state_t *hal_state_data;        ///< HAL state data.
-  void *hal_data;                            ///< HAL data, device driver specific.
   int generic_pdo_entry_count;               ///< The number of generic PDO entries.
   ec_pdo_entry_info_t *generic_pdo_entries;  ///< Generic PDO entries.
   ec_pdo_info_t *generic_pdos;               ///< Generic PDOs.
@@ -258,12 +327,31 @@ typedef struct lcec_slave {
   lcec_slave_modparam_t *modparams;          ///< modParams.
   const LCEC_CONF_FSOE_T *fsoeConf;          ///< Safety config.
   int is_fsoe_logic;                         ///< Device supports FSoE safety logic.
-  unsigned int *fsoe_slave_offset;           ///< FSoE slave offset.
-  unsigned int *fsoe_master_offset;          ///< FSoE master offset.
+  unsigned int *fsoe_slave_offset;           ///< FSoE slave frame offset in the logic device's PDOs, set by the logic device.
+  unsigned int *fsoe_master_offset;          ///< FSoE master frame offset in the logic device's PDOs, set by the logic device.
+  unsigned int *fsoe_local_slave_offset;     ///< FSoE slave frame offset in this slave's own PDOs, set by its driver.
+  unsigned int *fsoe_local_master_offset;    ///< FSoE master frame offset in this slave's own PDOs, set by its driver.
   uint64_t flags;                            ///< Flags, as defined by the driver itself.
+  lcec_slave_mbxread_t *mbx_reads;           ///< Mailbox reads to issue before `proc_init`.
   lcec_pdo_entry_reg_t *regs;
+  long long timing_ns[LCEC_TIMING_SLAVE_PHASES];  ///< Startup time spent per phase.
 } lcec_slave_t;
 
+/// @brief Per-cycle view of a slave, see `lcec_master_build_slave_rt()`.
+///
+/// A master keeps one of these per slave in a single array, so the
+/// cyclic loop in `lcec_read_master()`/`lcec_write_master()` walks
+/// contiguous memory instead of following `next` pointers through
+/// the (much larger) `lcec_slave_t` structs.
+typedef struct lcec_slave_rt {
+  lcec_slave_t *slave;                 ///< The slave itself, passed to the callbacks.
+  lcec_slave_rw_t proc_read;           ///< Copy of `slave->proc_read`.
+  lcec_slave_rw_t proc_write;          ///< Copy of `slave->proc_write`.
+  ec_slave_config_t *config;           ///< Copy of `slave->config`.
+  lcec_slave_state_t *hal_state_data;  ///< Copy of `slave->hal_state_data`.
+  unsigned int emcy_queue_size;        ///< Copy of `slave->emcy_queue_size`.
+} lcec_slave_rt_t;
+
 /// @brief HAL pin description.
 typedef struct {
   hal_type_t type;    ///< HAL type of this pin (`HAL_BIT`, `HAL_FLOAT`, `HAL_S32`, or `HAL_U32`).
@@ -272,6 +360,13 @@ typedef struct {
   const char *fmt;    ///< Format string for generating pin names via sprintf().
 } lcec_pindesc_t;
 
+/// @brief Pin name builder, holding a preformatted `lcec.<master>.<slave>.` prefix.
+typedef struct {
+  char name[HAL_NAME_LEN + 1];  ///< The prefix, followed by the suffix of the most recent pin.
+  int prefix_len;               ///< Length of the prefix.
+  int prefix_args;              ///< Number of leading `%s` arguments in `lcec_pindesc_t` formats that the prefix covers.
+} lcec_pinbuilder_t;
+
 /// @brief Sync manager configuration.
 typedef struct {
   int sync_count;                                 ///< Number of syncs.
@@ -287,6 +382,12 @@ typedef struct {
   ec_pdo_entry_info_t pdo_entries[LCEC_MAX_PDO_ENTRY_COUNT];  ///< PDO entry definitions.
 } lcec_syncs_t;
 
+/// @brief Block allocator state, see `lcec_block_alloc()`.
+typedef struct {
+  uint8_t *next;  ///< Next free byte in the current chunk.
+  size_t avail;   ///< Bytes left in the current chunk.
+} lcec_block_t;
+
 /// @brief Lookup table mapping string to int
 typedef struct {
   const char *key;
@@ -300,6 +401,11 @@ typedef struct {
 } lcec_lookuptable_double_t;
 
 lcec_slave_t *lcec_slave_by_index(struct lcec_master *master, int index) __attribute__((nonnull));
+int lcec_master_build_slave_rt(struct lcec_master *master) __attribute__((nonnull));
+int lcec_master_build_fsoe_routes(struct lcec_master *master) __attribute__((nonnull));
+void lcec_master_route_fsoe(struct lcec_master *master) __attribute__((nonnull));
+uint64_t lcec_master_app_time(struct lcec_master *master) __attribute__((nonnull));
+void lcec_slave_release_config(struct lcec_slave *slave) __attribute__((nonnull));
 
 int lcec_read_sdo(struct lcec_slave *slave, uint16_t index, uint8_t subindex, uint8_t *target, size_t size);
 int lcec_read_sdo8(struct lcec_slave *slave, uint16_t index, uint8_t subindex, uint8_t *result);
@@ -313,6 +419,11 @@ int lcec_read_sdo32_pin_U32(struct lcec_slave *slave, uint16_t index, uint8_t su
 int lcec_read_sdo32_pin_S32(struct lcec_slave *slave, uint16_t index, uint8_t subindex, volatile int32_t *result);
 int lcec_read_idn(struct lcec_slave *slave, uint8_t drive_no, uint16_t idn, uint8_t *target, size_t size);
 int lcec_write_sdo(struct lcec_slave *slave, uint16_t index, uint8_t subindex, uint8_t *value, size_t size);
+int lcec_prefetch_sdo(struct lcec_slave *slave, uint16_t index, uint8_t subindex, size_t size);
+int lcec_prefetch_idn(struct lcec_slave *slave, uint8_t drive_no, uint16_t idn, size_t size);
+void lcec_prefetch_exec(struct lcec_slave *slave);
+void lcec_prefetch_clear(struct lcec_slave *slave);
+int lcec_prefetch_matches(struct lcec_slave *slave, uint16_t index, uint8_t subindex, const uint8_t *value, size_t size);
 int lcec_write_sdo8(struct lcec_slave *slave, uint16_t index, uint8_t subindex, uint8_t value);
 int lcec_write_sdo16(struct lcec_slave *slave, uint16_t index, uint8_t subindex, uint16_t value);
 int lcec_write_sdo32(struct lcec_slave *slave, uint16_t index, uint8_t subindex, uint32_t value);
@@ -324,8 +435,12 @@ int lcec_pin_newf(hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr, cons
 int lcec_pin_newf_list(void *base, const lcec_pindesc_t *list, ...);
 int lcec_param_newf(hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *fmt, ...);
 int lcec_param_newf_list(void *base, const lcec_pindesc_t *list, ...);
+int lcec_pinbuilder_init(lcec_pinbuilder_t *pb, struct lcec_slave *slave, const char *pfx);
+int lcec_pinbuilder_pin(lcec_pinbuilder_t *pb, hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr, const char *suffix);
+int lcec_pinbuilder_param(lcec_pinbuilder_t *pb, hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *suffix);
+int lcec_pinbuilder_pin_list(lcec_pinbuilder_t *pb, void *base, const lcec_pindesc_t *list);
+int lcec_pinbuilder_param_list(lcec_pinbuilder_t *pb, void *base, const lcec_pindesc_t *list);
 
-void copy_fsoe_data(struct lcec_slave *slave, unsigned int slave_offset, unsigned int master_offset) __attribute__((nonnull));
 void lcec_syncs_init(lcec_syncs_t *syncs) __attribute__((nonnull));
 void lcec_syncs_add_sync(lcec_syncs_t *syncs, ec_direction_t dir, ec_watchdog_mode_t watchdog_mode);
 void lcec_syncs_add_pdo_info(lcec_syncs_t *syncs, uint16_t index);
@@ -342,11 +457,60 @@ double lcec_lookupdouble_i(const lcec_lookuptable_double_t *table, const char *k
 
 LCEC_CONF_MODPARAM_VAL_T *lcec_modparam_get(struct lcec_slave *slave, int id) __attribute__((nonnull));
 int lcec_modparam_desc_len(const lcec_modparam_desc_t *mp) __attribute__((nonnull));
+const lcec_modparam_desc_t *lcec_modparam_desc_find(const lcec_modparam_desc_t *mp, const char *name, int *id) __attribute__((nonnull));
 lcec_modparam_desc_t *lcec_modparam_desc_concat(lcec_modparam_desc_t const *a, lcec_modparam_desc_t const *b) __attribute__((nonnull));
 
+int lcec_block_reserve(lcec_block_t *block, size_t size) __attribute__((nonnull));
+void *lcec_block_alloc(lcec_block_t *block, size_t size) __attribute__((nonnull));
 lcec_pdo_entry_reg_t *lcec_allocate_pdo_entry_reg(int size);
 int lcec_pdo_init(struct lcec_slave *slave, uint16_t idx, uint16_t sidx, unsigned int *os, unsigned int *bp);
 int lcec_pdo_entry_reg_len(lcec_pdo_entry_reg_t *reg);
 int lcec_append_pdo_entry_reg(lcec_pdo_entry_reg_t *dest, lcec_pdo_entry_reg_t *src);
 
+/// @brief Read `nbytes` (1 to 8) bytes of little-endian process data at `os` as one word.
+static inline uint64_t lcec_pd_read_word(const uint8_t *pd, unsigned int os, int nbytes) {
+  uint64_t w = 0;
+  int i;
+
+  switch (nbytes) {
+    case 1:
+      return EC_READ_U8(&pd[os]);
+    case 2:
+      return EC_READ_U16(&pd[os]);
+    case 4:
+      return EC_READ_U32(&pd[os]);
+    case 8:
+      return EC_READ_U64(&pd[os]);
+  }
+
+  for (i = nbytes - 1; i >= 0; i--) {
+    w = (w << 8) | pd[os + i];
+  }
+  return w;
+}
+
+/// @brief Write the low `nbytes` (1 to 8) bytes of `w` as little-endian process data at `os`.
+static inline void lcec_pd_write_word(uint8_t *pd, unsigned int os, int nbytes, uint64_t w) {
+  int i;
+
+  switch (nbytes) {
+    case 1:
+      EC_WRITE_U8(&pd[os], w);
+      return;
+    case 2:
+      EC_WRITE_U16(&pd[os], w);
+      return;
+    case 4:
+      EC_WRITE_U32(&pd[os], w);
+      return;
+    case 8:
+      EC_WRITE_U64(&pd[os], w);
+      return;
+  }
+
+  for (i = 0; i < nbytes; i++, w >>= 8) {
+    pd[os + i] = w & 0xff;
+  }
+}
+
 #endif
@@ -22,19 +22,27 @@
 #include "lcec_conf.h"
 
 #include <ctype.h>
+#include <errno.h>
 #include <expat.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/eventfd.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "hal.h"
 #include "lcec.h"
 #include "lcec_conf_priv.h"
+#include "lcec_layout.h"
 #include "lcec_rtapi.h"
+#include "lcec_timing.h"
 #include "rtapi.h"
 
+// how often to check if the realtime module filled in the timing and layout reports
+#define TIMING_POLL_MS 100
+
 typedef struct {
   hal_u32_t *master_count;
   hal_u32_t *slave_count;
@@ -43,6 +51,10 @@ typedef struct {
 static int hal_comp_id;
 static LCEC_CONF_HAL_T *conf_hal_data;
 static int shmem_id;
+static int timing_shmem_id;
+static LCEC_TIMING_T *timing;
+static int layout_shmem_id = -1;
+static LCEC_LAYOUT_T *layout;
 
 static int exitEvent;
 
@@ -97,6 +109,9 @@ static const LCEC_CONF_XML_HANLDER_T xml_states[] = {
 
 static int parseSyncCycle(LCEC_CONF_XML_STATE_T *state, const char *nptr);
 
+static void waitForExit(const char *timing_file, const char *layout_file);
+static int writeTimingReport(const char *filename);
+
 static void exitHandler(int sig) {
   uint64_t u = 1;
   if (write(exitEvent, &u, sizeof(uint64_t)) < 0) {
@@ -115,6 +130,12 @@ int main(int argc, char **argv) {
   LCEC_CONF_HEADER_T *header;
   uint64_t u;
   LCEC_CONF_XML_STATE_T state;
+  const char *timing_file = NULL;
+  const char *layout_file = NULL;
+  const char *suggest_file = NULL;
+  int entry_max;
+  struct timespec parse_start, parse_end;
+  int opt;
 
   // initialize component
   hal_comp_id = hal_init(modname);
@@ -151,12 +172,29 @@ int main(int argc, char **argv) {
   signal(SIGINT, exitHandler);
   signal(SIGTERM, exitHandler);
 
-  // get config file name
-  if (argc != 2) {
+  // get options and config file name
+  while ((opt = getopt(argc, argv, "t:l:L:")) != -1) {
+    switch (opt) {
+      case 't':
+        timing_file = optarg;
+        break;
+      case 'l':
+        layout_file = optarg;
+        break;
+      case 'L':
+        suggest_file = optarg;
+        break;
+      default:
+        fprintf(stderr, "%s: ERROR: invalid arguments\n", modname);
+        goto fail2;
+    }
+  }
+  if (optind != argc - 1) {
     fprintf(stderr, "%s: ERROR: invalid arguments\n", modname);
     goto fail2;
   }
-  filename = argv[1];
+  filename = argv[optind];
+  clock_gettime(CLOCK_MONOTONIC, &parse_start);
 
   // open file
   file = fopen(filename, "r");
@@ -198,6 +236,7 @@ int main(int argc, char **argv) {
     goto fail4;
   }
   end->confType = lcecConfTypeNone;
+  clock_gettime(CLOCK_MONOTONIC, &parse_end);
 
   // setup shared mem for config
   shmem_id = rtapi_shmem_new(LCEC_CONF_SHMEM_KEY, hal_comp_id, sizeof(LCEC_CONF_HEADER_T) + state.outputBuf.len);
@@ -219,15 +258,69 @@ int main(int argc, char **argv) {
   // copy data and free buffer
   copyFreeOutputBuffer(&state.outputBuf, shmem_ptr);
 
+  // setup shared mem for the startup timing report
+  timing_shmem_id = rtapi_shmem_new(LCEC_TIMING_SHMEM_KEY, hal_comp_id,
+      LCEC_TIMING_BYTES(*(conf_hal_data->master_count), *(conf_hal_data->slave_count)));
+  if (timing_shmem_id < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't allocate user/RT shared memory for timing report\n", modname);
+    goto fail5;
+  }
+  if (lcec_rtapi_shmem_getptr(timing_shmem_id, &shmem_ptr) < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't map user/RT shared memory for timing report\n", modname);
+    goto fail6;
+  }
+  timing = shmem_ptr;
+  memset(timing, 0, LCEC_TIMING_BYTES(*(conf_hal_data->master_count), *(conf_hal_data->slave_count)));
+  timing->master_count = *(conf_hal_data->master_count);
+  timing->slave_count = *(conf_hal_data->slave_count);
+  timing->parse_ns = (parse_end.tv_sec - parse_start.tv_sec) * 1000000000LL + (parse_end.tv_nsec - parse_start.tv_nsec);
+  lcec_wmb();
+  timing->magic = LCEC_TIMING_SHMEM_MAGIC;
+
+  // setup shared mem for the PDO layout report
+  if (layout_file != NULL) {
+    entry_max = *(conf_hal_data->slave_count) * LCEC_MAX_PDO_REG_COUNT;
+    layout_shmem_id = rtapi_shmem_new(LCEC_LAYOUT_SHMEM_KEY, hal_comp_id,
+        LCEC_LAYOUT_BYTES(*(conf_hal_data->master_count), *(conf_hal_data->slave_count), entry_max));
+    if (layout_shmem_id < 0) {
+      fprintf(stderr, "%s: ERROR: couldn't allocate user/RT shared memory for layout report\n", modname);
+      goto fail6;
+    }
+    if (lcec_rtapi_shmem_getptr(layout_shmem_id, &shmem_ptr) < 0) {
+      fprintf(stderr, "%s: ERROR: couldn't map user/RT shared memory for layout report\n", modname);
+      goto fail7;
+    }
+    layout = shmem_ptr;
+    memset(layout, 0, LCEC_LAYOUT_BYTES(*(conf_hal_data->master_count), *(conf_hal_data->slave_count), entry_max));
+    layout->master_count = *(conf_hal_data->master_count);
+    layout->slave_count = *(conf_hal_data->slave_count);
+    layout->entry_max = entry_max;
+    lcec_wmb();
+    layout->magic = LCEC_LAYOUT_SHMEM_MAGIC;
+  }
+
+  // suggest an aligned layout for generic slaves, this only needs the parsed config
+  if (suggest_file != NULL && writeLayoutSuggestion((char *)header + sizeof(LCEC_CONF_HEADER_T), suggest_file) != 0) {
+    goto fail7;
+  }
+
   // everything is fine
   ret = 0;
   hal_ready(hal_comp_id);
 
   // wait for SIGTERM
-  if (read(exitEvent, &u, sizeof(uint64_t)) < 0) {
+  if (timing_file != NULL || layout_file != NULL) {
+    waitForExit(timing_file, layout_file);
+  } else if (read(exitEvent, &u, sizeof(uint64_t)) < 0) {
     fprintf(stderr, "%s: ERROR: error reading exit event\n", modname);
   }
 
+fail7:
+  if (layout_shmem_id >= 0) {
+    rtapi_shmem_delete(layout_shmem_id, hal_comp_id);
+  }
+fail6:
+  rtapi_shmem_delete(timing_shmem_id, hal_comp_id);
 fail5:
   rtapi_shmem_delete(shmem_id, hal_comp_id);
 fail4:
@@ -243,6 +336,128 @@ fail0:
   return ret;
 }
 
+// true once the realtime module is initialized and all masters reached OP
+static int timingComplete(void) {
+  LCEC_TIMING_MASTER_T *tm = LCEC_TIMING_MASTERS(timing);
+  int i;
+
+  if (!timing->init_done) {
+    return 0;
+  }
+  lcec_rmb();
+  for (i = 0; i < timing->master_count; i++) {
+    if (tm[i].phase_ns[LCEC_TIMING_MASTER_ALL_OP] < 0) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// waits for the exit event, writing the timing and layout reports as soon as they are complete
+static void waitForExit(const char *timing_file, const char *layout_file) {
+  struct pollfd pfd;
+  int timing_written = (timing_file == NULL);
+  int layout_written = (layout_file == NULL);
+  int ret;
+
+  pfd.fd = exitEvent;
+  pfd.events = POLLIN;
+  while ((ret = poll(&pfd, 1, (timing_written && layout_written) ? -1 : TIMING_POLL_MS)) <= 0) {
+    if (ret < 0 && errno != EINTR) {
+      fprintf(stderr, "%s: ERROR: error waiting for exit event\n", modname);
+      break;
+    }
+    if (!timing_written && timingComplete()) {
+      writeTimingReport(timing_file);
+      timing_written = 1;
+    }
+    // offsets are final once the realtime module is initialized
+    if (!layout_written && layout->init_done) {
+      lcec_rmb();
+      writeLayoutReport(layout, layout_file);
+      layout_written = 1;
+    }
+  }
+
+  // write what we have if some master never reached OP
+  if (!timing_written && timing->init_done) {
+    writeTimingReport(timing_file);
+  }
+}
+
+static void writeJsonString(FILE *file, const char *s) {
+  fputc('"', file);
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') {
+      fputc('\\', file);
+    }
+    fputc(*s, file);
+  }
+  fputc('"', file);
+}
+
+// microseconds, or null if the phase was never reached
+static void writeJsonTime(FILE *file, const char *name, long long ns) {
+  if (ns < 0) {
+    fprintf(file, "\"%s_us\": null", name);
+  } else {
+    fprintf(file, "\"%s_us\": %lld", name, ns / 1000);
+  }
+}
+
+static int writeTimingReport(const char *filename) {
+  static const char *master_phases[] = LCEC_TIMING_MASTER_PHASE_NAMES;
+  static const char *slave_phases[] = LCEC_TIMING_SLAVE_PHASE_NAMES;
+  LCEC_TIMING_MASTER_T *tm = LCEC_TIMING_MASTERS(timing);
+  LCEC_TIMING_SLAVE_T *ts;
+  FILE *file;
+  int i, j, k;
+
+  file = fopen(filename, "w");
+  if (file == NULL) {
+    fprintf(stderr, "%s: ERROR: unable to open timing report file %s\n", modname, filename);
+    return -1;
+  }
+
+  lcec_rmb();
+  fprintf(file, "{\n  ");
+  writeJsonTime(file, "parse", timing->parse_ns);
+  fprintf(file, ",\n  ");
+  writeJsonTime(file, "handoff", timing->handoff_ns);
+  fprintf(file, ",\n  ");
+  writeJsonTime(file, "total", timing->total_ns);
+  fprintf(file, ",\n  \"masters\": [");
+  for (i = 0; i < timing->master_count; i++, tm++) {
+    fprintf(file, "%s\n    {\"index\": %d, \"name\": ", i ? "," : "", tm->index);
+    writeJsonString(file, tm->name);
+    for (j = 0; j < LCEC_TIMING_MASTER_PHASES; j++) {
+      fprintf(file, ", ");
+      writeJsonTime(file, master_phases[j], tm->phase_ns[j]);
+    }
+    fprintf(file, ",\n     \"slaves\": [");
+    ts = &LCEC_TIMING_SLAVES(timing)[tm->first_slave];
+    for (j = 0; j < tm->slave_count; j++, ts++) {
+      fprintf(file, "%s\n       {\"index\": %d, \"name\": ", j ? "," : "", ts->index);
+      writeJsonString(file, ts->name);
+      for (k = 0; k < LCEC_TIMING_SLAVE_PHASES; k++) {
+        fprintf(file, ", ");
+        writeJsonTime(file, slave_phases[k], ts->phase_ns[k]);
+      }
+      fprintf(file, "}");
+    }
+    fprintf(file, "]}");
+  }
+  fprintf(file, "]\n}\n");
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "%s: ERROR: unable to write timing report file %s\n", modname, filename);
+    return -1;
+  }
+
+  return 0;
+}
+
 static void parseMasterAttrs(LCEC_CONF_XML_INST_T *inst, int next, const char **attr) {
   LCEC_CONF_XML_STATE_T *state = (LCEC_CONF_XML_STATE_T *)inst;
 
@@ -282,6 +497,18 @@ static void parseMasterAttrs(LCEC_CONF_XML_INST_T *inst, int next, const char **
       continue;
     }
 
+    // parse recordDepth
+    if (strcmp(name, "recordDepth") == 0) {
+      int tmp = atoi(val);
+      if (tmp < 0) {
+        fprintf(stderr, "%s: ERROR: Invalid master recordDepth %d\n", modname, tmp);
+        XML_StopParser(inst->parser, 0);
+        return;
+      }
+      p->recordDepth = tmp;
+      continue;
+    }
+
     // handle error
     fprintf(stderr, "%s: ERROR: Invalid master attribute %s\n", modname, name);
     XML_StopParser(inst->parser, 0);
@@ -371,6 +598,18 @@ static void parseSlaveAttrs(LCEC_CONF_XML_INST_T *inst, int next, const char **a
       continue;
     }
 
+    // parse emcyQueueSize
+    if (strcmp(name, "emcyQueueSize") == 0) {
+      int tmp = atoi(val);
+      if (tmp < 0) {
+        fprintf(stderr, "%s: ERROR: Invalid slave emcyQueueSize %d\n", modname, tmp);
+        XML_StopParser(inst->parser, 0);
+        return;
+      }
+      p->emcyQueueSize = tmp;
+      continue;
+    }
+
     // generic only attributes
     if (!strcmp(p->typename, "generic")) {
       // parse vid (hex value)
@@ -948,6 +1187,16 @@ static void parsePdoEntryAttrs(LCEC_CONF_XML_INST_T *inst, int next, const char
         p->halType = HAL_U32;
         continue;
       }
+      if (strcasecmp(val, "s64") == 0) {
+        p->subType = lcecPdoEntTypeSimple;
+        p->halType = HAL_S64;
+        continue;
+      }
+      if (strcasecmp(val, "u64") == 0) {
+        p->subType = lcecPdoEntTypeSimple;
+        p->halType = HAL_U64;
+        continue;
+      }
       if (strcasecmp(val, "float") == 0) {
         p->subType = lcecPdoEntTypeFloatSigned;
         p->halType = HAL_FLOAT;
@@ -1100,6 +1349,16 @@ static void parseComplexEntryAttrs(LCEC_CONF_XML_INST_T *inst, int next, const c
         p->halType = HAL_U32;
         continue;
       }
+      if (strcasecmp(val, "s64") == 0) {
+        p->subType = lcecPdoEntTypeSimple;
+        p->halType = HAL_S64;
+        continue;
+      }
+      if (strcasecmp(val, "u64") == 0) {
+        p->subType = lcecPdoEntTypeSimple;
+        p->halType = HAL_U64;
+        continue;
+      }
       if (strcasecmp(val, "float") == 0) {
         p->subType = lcecPdoEntTypeFloatSigned;
         p->halType = HAL_FLOAT;
@@ -1177,6 +1436,7 @@ static void parseModParamAttrs(LCEC_CONF_XML_INST_T *inst, int next, const char
 
   const char *pname, *pval;
   const lcec_modparam_desc_t *modparams;
+  int id;
 
   if (state->currSlaveType->modparams == NULL) {
     fprintf(stderr, "%s: ERROR: modparam not allowed for this slave\n", modname);
@@ -1231,19 +1491,15 @@ static void parseModParamAttrs(LCEC_CONF_XML_INST_T *inst, int next, const char
   }
 
   // search for matching param name
-  for (modparams = state->currSlaveType->modparams; modparams->name != NULL; modparams++) {
-    if (strcmp(pname, modparams->name) == 0) {
-      break;
-    }
-  }
-  if (modparams->name == NULL) {
+  modparams = lcec_modparam_desc_find(state->currSlaveType->modparams, pname, &id);
+  if (modparams == NULL) {
     fprintf(stderr, "%s: ERROR: Invalid modparam '%s'\n", modname, pname);
     XML_StopParser(inst->parser, 0);
     return;
   }
 
   // set id
-  p->id = modparams->id;
+  p->id = id;
 
   // set name (for error messages)
   strncpy(p->name, pname, LCEC_CONF_STR_MAXLEN - 1);
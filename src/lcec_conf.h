@@ -73,6 +73,7 @@ typedef struct {
   int index;
   uint32_t appTimePeriod;
   int refClockSyncCycles;
+  unsigned int recordDepth;
   char name[LCEC_CONF_STR_MAXLEN];
 } LCEC_CONF_MASTER_T;
 
@@ -90,6 +91,7 @@ typedef struct {
   size_t sdoConfigLength;
   size_t idnConfigLength;
   unsigned int modParamCount;
+  unsigned int emcyQueueSize;
   char name[LCEC_CONF_STR_MAXLEN];
 } LCEC_CONF_SLAVE_T;
 
@@ -180,4 +182,15 @@ typedef struct {
   LCEC_CONF_MODPARAM_VAL_T value;
 } LCEC_CONF_MODPARAM_T;
 
+/// @brief A registered PDO entry, as described in the flight recorder and layout blocks.
+typedef struct {
+  uint32_t slave;    ///< Index into the slave table of the block.
+  uint32_t offset;   ///< Byte offset in the domain's process data.
+  uint16_t index;    ///< PDO entry index.
+  uint8_t subindex;  ///< PDO entry subindex.
+  uint8_t bit_pos;   ///< Bit position within the byte at `offset`.
+  uint8_t bit_len;   ///< Length in bits, 0 if the slave's sync config doesn't say.
+  uint8_t reserved[3];
+} LCEC_PDO_ENTRY_DESC_T;
+
 #endif
@@ -0,0 +1,539 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief PDO layout report and suggested generic slave layouts for `lcec_conf`.
+///
+/// The report (`lcec_conf -l`) lists where every registered PDO entry
+/// ended up in its master's domain, as published by the realtime
+/// module, and flags entries of whole bytes that don't start on a
+/// byte boundary.  Those can't be read or written as plain bytes, and
+/// entries that span more than 8 bytes also need an extra byte access
+/// in `lcec_generic`.
+///
+/// The suggestion (`lcec_conf -L`) only needs the parsed config.  For
+/// each generic slave with `configPdos="true"` whose whole-byte entries
+/// aren't all byte aligned, it writes the slave's `<syncManager>`
+/// elements with every PDO's whole-byte entries moved to the front,
+/// largest first, and padding added at the end of each PDO that
+/// doesn't end on a byte boundary.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcec_conf.h"
+#include "lcec_conf_priv.h"
+#include "lcec_layout.h"
+
+/// @brief A PDO entry of the parsed config, with the complexEntry records that follow it.
+typedef struct {
+  const LCEC_CONF_PDOENTRY_T *entry;
+  const LCEC_CONF_COMPLEXENTRY_T *complex;
+  int complex_count;
+} LAYOUT_PDOENTRY_T;
+
+static int cmpEntryPos(const void *a, const void *b) {
+  const LCEC_PDO_ENTRY_DESC_T *ea = *(const LCEC_PDO_ENTRY_DESC_T **)a;
+  const LCEC_PDO_ENTRY_DESC_T *eb = *(const LCEC_PDO_ENTRY_DESC_T **)b;
+
+  if (ea->offset != eb->offset) {
+    return (ea->offset > eb->offset) - (ea->offset < eb->offset);
+  }
+  return (int)ea->bit_pos - (int)eb->bit_pos;
+}
+
+// whole-byte entries that don't start on a byte boundary
+static int entryUnaligned(const LCEC_PDO_ENTRY_DESC_T *e) { return e->bit_len != 0 && (e->bit_len & 0x07) == 0 && e->bit_pos != 0; }
+
+int writeLayoutReport(const LCEC_LAYOUT_T *layout, const char *filename) {
+  const LCEC_LAYOUT_MASTER_T *lm = LCEC_LAYOUT_MASTERS(layout);
+  const LCEC_LAYOUT_SLAVE_T *slaves = LCEC_LAYOUT_SLAVES(layout);
+  const LCEC_PDO_ENTRY_DESC_T **sorted;
+  const LCEC_PDO_ENTRY_DESC_T *e;
+  int unaligned, spans, pad_bits;
+  const char *sep;
+  FILE *file;
+  int i, j;
+
+  sorted = malloc(sizeof(LCEC_PDO_ENTRY_DESC_T *) * (layout->entry_count + 1));
+  if (sorted == NULL) {
+    fprintf(stderr, "%s: ERROR: out of memory\n", modname);
+    return -1;
+  }
+
+  file = fopen(filename, "w");
+  if (file == NULL) {
+    fprintf(stderr, "%s: ERROR: unable to open layout report file %s\n", modname, filename);
+    free(sorted);
+    return -1;
+  }
+
+  fprintf(file, "# PDO layout, offsets are byte.bit in the master's domain\n");
+  if (layout->entries_dropped > 0) {
+    fprintf(file, "# WARNING: %d entries didn't fit into the report\n", layout->entries_dropped);
+  }
+
+  for (i = 0; i < layout->master_count; i++, lm++) {
+    // list entries in domain order
+    for (j = 0; j < lm->entry_count; j++) {
+      sorted[j] = &LCEC_LAYOUT_ENTRIES(layout)[lm->first_entry + j];
+    }
+    qsort(sorted, lm->entry_count, sizeof(LCEC_PDO_ENTRY_DESC_T *), cmpEntryPos);
+
+    fprintf(file, "\nmaster %d (%s): domain %u bytes, %d slaves, %d entries\n", lm->index, lm->name, lm->domain_size, lm->slave_count,
+        lm->entry_count);
+    fprintf(file, "  %9s %4s  %-*s %-7s  %s\n", "offset", "bits", LCEC_CONF_STR_MAXLEN / 2, "slave", "entry", "notes");
+
+    unaligned = 0;
+    spans = 0;
+    pad_bits = 0;
+    for (j = 0; j < lm->entry_count; j++) {
+      e = sorted[j];
+      fprintf(file, "  %7u.%u %4u  %-*s %04x:%02x", e->offset, e->bit_pos, e->bit_len, LCEC_CONF_STR_MAXLEN / 2, slaves[e->slave].name,
+          e->index, e->subindex);
+      sep = "  ";
+      if (e->bit_len == 0) {
+        fprintf(file, "%slength unknown", sep);
+        sep = ", ";
+      }
+      if (entryUnaligned(e)) {
+        fprintf(file, "%sunaligned, needs %d bits of padding before it", sep, 8 - e->bit_pos);
+        sep = ", ";
+        unaligned++;
+        pad_bits += 8 - e->bit_pos;
+      } else if (e->bit_len > 1 && (e->bit_len & 0x07) != 0) {
+        fprintf(file, "%snot whole bytes", sep);
+        sep = ", ";
+      }
+      if (e->bit_pos + e->bit_len > 64) {
+        fprintf(file, "%sspans more than 8 bytes", sep);
+        spans++;
+      }
+      fprintf(file, "\n");
+    }
+
+    fprintf(file, "  %d unaligned entries", unaligned);
+    if (unaligned > 0) {
+      fprintf(file, ", up to %d bits of padding or moving whole-byte entries to the front of their PDO would align them", pad_bits);
+    }
+    fprintf(file, "\n");
+    if (spans > 0) {
+      fprintf(file, "  %d entries span more than 8 bytes\n", spans);
+    }
+  }
+
+  free(sorted);
+  if (fclose(file) != 0) {
+    fprintf(stderr, "%s: ERROR: unable to write layout report file %s\n", modname, filename);
+    return -1;
+  }
+
+  return 0;
+}
+
+// size of a config record, 0 if it isn't a known record type
+static size_t confRecordSize(const void *conf) {
+  switch (((const LCEC_CONF_NULL_T *)conf)->confType) {
+    case lcecConfTypeMaster:
+      return sizeof(LCEC_CONF_MASTER_T);
+    case lcecConfTypeSlave:
+      return sizeof(LCEC_CONF_SLAVE_T);
+    case lcecConfTypeDcConf:
+      return sizeof(LCEC_CONF_DC_T);
+    case lcecConfTypeWatchdog:
+      return sizeof(LCEC_CONF_WATCHDOG_T);
+    case lcecConfTypeSyncManager:
+      return sizeof(LCEC_CONF_SYNCMANAGER_T);
+    case lcecConfTypePdo:
+      return sizeof(LCEC_CONF_PDO_T);
+    case lcecConfTypePdoEntry:
+      return sizeof(LCEC_CONF_PDOENTRY_T);
+    case lcecConfTypeComplexEntry:
+      return sizeof(LCEC_CONF_COMPLEXENTRY_T);
+    case lcecConfTypeSdoConfig:
+      return sizeof(LCEC_CONF_SDOCONF_T) + ((const LCEC_CONF_SDOCONF_T *)conf)->length;
+    case lcecConfTypeIdnConfig:
+      return sizeof(LCEC_CONF_IDNCONF_T) + ((const LCEC_CONF_IDNCONF_T *)conf)->length;
+    case lcecConfTypeModParam:
+      return sizeof(LCEC_CONF_MODPARAM_T);
+    default:
+      return 0;
+  }
+}
+
+// halType attribute value for a pdoEntry or complexEntry, NULL if it has none
+static const char *halTypeName(hal_type_t type, LCEC_PDOENT_TYPE_T subType) {
+  if (subType == lcecPdoEntTypeComplex) {
+    return "complex";
+  }
+  switch (type) {
+    case HAL_BIT:
+      return "bit";
+    case HAL_S32:
+      return "s32";
+    case HAL_U32:
+      return "u32";
+    case HAL_S64:
+      return "s64";
+    case HAL_U64:
+      return "u64";
+    case HAL_FLOAT:
+      switch (subType) {
+        case lcecPdoEntTypeFloatUnsigned:
+          return "float-unsigned";
+        case lcecPdoEntTypeFloatIeee:
+          return "float-ieee";
+        case lcecPdoEntTypeFloatDoubleIeee:
+          return "float-double-ieee";
+        default:
+          return "float";
+      }
+    default:
+      return NULL;
+  }
+}
+
+static void writeXmlString(FILE *file, const char *s) {
+  for (; *s; s++) {
+    switch (*s) {
+      case '&':
+        fputs("&amp;", file);
+        break;
+      case '<':
+        fputs("&lt;", file);
+        break;
+      case '>':
+        fputs("&gt;", file);
+        break;
+      case '"':
+        fputs("&quot;", file);
+        break;
+      default:
+        fputc(*s, file);
+    }
+  }
+}
+
+// writes halPin, halType, scale and offset attributes shared by pdoEntry and complexEntry
+static void writePinAttrs(
+    FILE *file, const char *halPin, hal_type_t type, LCEC_PDOENT_TYPE_T subType, hal_float_t scale, hal_float_t offset) {
+  const char *typeName = halTypeName(type, subType);
+
+  if (halPin[0] != 0) {
+    fprintf(file, " halPin=\"");
+    writeXmlString(file, halPin);
+    fprintf(file, "\"");
+  }
+  if (typeName != NULL) {
+    fprintf(file, " halType=\"%s\"", typeName);
+  }
+  if (type == HAL_FLOAT && scale != 1.0) {
+    fprintf(file, " scale=\"%.15g\"", scale);
+  }
+  if (type == HAL_FLOAT && offset != 0.0) {
+    fprintf(file, " offset=\"%.15g\"", offset);
+  }
+}
+
+// collects the entries of the PDO at `pdo`, and returns the record after the PDO
+static const char *readPdoEntries(const LCEC_CONF_PDO_T *pdo, LAYOUT_PDOENTRY_T *entries) {
+  const char *conf = (const char *)pdo + sizeof(LCEC_CONF_PDO_T);
+  unsigned int i;
+
+  for (i = 0; i < pdo->pdoEntryCount; i++) {
+    entries[i].entry = (const LCEC_CONF_PDOENTRY_T *)conf;
+    conf += sizeof(LCEC_CONF_PDOENTRY_T);
+    entries[i].complex = (const LCEC_CONF_COMPLEXENTRY_T *)conf;
+    entries[i].complex_count = 0;
+    while (((const LCEC_CONF_NULL_T *)conf)->confType == lcecConfTypeComplexEntry) {
+      entries[i].complex_count++;
+      conf += sizeof(LCEC_CONF_COMPLEXENTRY_T);
+    }
+  }
+
+  return conf;
+}
+
+// puts whole-byte entries first, largest first, and drops existing gaps; returns the new entry count
+static int reorderPdoEntries(LAYOUT_PDOENTRY_T *entries, int count) {
+  LAYOUT_PDOENTRY_T *out;
+  LAYOUT_PDOENTRY_T tmp;
+  int i, j, n = 0;
+
+  out = malloc(sizeof(LAYOUT_PDOENTRY_T) * (count + 1));
+  if (out == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < count; i++) {
+    if (entries[i].entry->index != 0 && (entries[i].entry->bitLength & 0x07) == 0) {
+      // stable insertion by descending size
+      tmp = entries[i];
+      for (j = n; j > 0 && out[j - 1].entry->bitLength < tmp.entry->bitLength; j--) {
+        out[j] = out[j - 1];
+      }
+      out[j] = tmp;
+      n++;
+    }
+  }
+  for (i = 0; i < count; i++) {
+    if (entries[i].entry->index != 0 && (entries[i].entry->bitLength & 0x07) != 0) {
+      out[n++] = entries[i];
+    }
+  }
+
+  memcpy(entries, out, sizeof(LAYOUT_PDOENTRY_T) * n);
+  free(out);
+  return n;
+}
+
+// counts whole-byte entries of a slave's sync managers that don't start on a byte boundary
+static int countUnaligned(const char *conf, const char *end, LAYOUT_PDOENTRY_T *entries) {
+  const LCEC_CONF_PDO_T *pdo;
+  unsigned int bitpos = 0;
+  int count = 0;
+  unsigned int i;
+
+  while (conf < end) {
+    switch (((const LCEC_CONF_NULL_T *)conf)->confType) {
+      case lcecConfTypeSyncManager:
+        bitpos = 0;
+        conf += sizeof(LCEC_CONF_SYNCMANAGER_T);
+        break;
+      case lcecConfTypePdo:
+        pdo = (const LCEC_CONF_PDO_T *)conf;
+        conf = readPdoEntries(pdo, entries);
+        for (i = 0; i < pdo->pdoEntryCount; i++) {
+          if ((entries[i].entry->bitLength & 0x07) == 0 && (bitpos & 0x07) != 0 && entries[i].entry->index != 0) {
+            count++;
+          }
+          bitpos += entries[i].entry->bitLength;
+        }
+        break;
+      default:
+        conf += confRecordSize(conf);
+    }
+  }
+
+  return count;
+}
+
+// writes the reordered sync managers of one slave, returns the number of padding bits added or -1 on error
+static int writeSlaveSyncManagers(FILE *file, const char *conf, const char *end, LAYOUT_PDOENTRY_T *entries) {
+  const LCEC_CONF_SYNCMANAGER_T *sm = NULL;
+  const LCEC_CONF_PDO_T *pdo;
+  const LCEC_CONF_COMPLEXENTRY_T *ce;
+  const LAYOUT_PDOENTRY_T *e;
+  unsigned int pdo_idx = 0;
+  unsigned int bits;
+  int pad_total = 0;
+  int i, j, n;
+
+  while (conf < end) {
+    switch (((const LCEC_CONF_NULL_T *)conf)->confType) {
+      case lcecConfTypeSyncManager:
+        if (sm != NULL) {
+          fprintf(file, "      </syncManager>\n");
+        }
+        sm = (const LCEC_CONF_SYNCMANAGER_T *)conf;
+        pdo_idx = 0;
+        fprintf(file, "      <syncManager idx=\"%u\" dir=\"%s\">\n", sm->index, (sm->dir == EC_DIR_INPUT) ? "in" : "out");
+        conf += sizeof(LCEC_CONF_SYNCMANAGER_T);
+        break;
+
+      case lcecConfTypePdo:
+        pdo = (const LCEC_CONF_PDO_T *)conf;
+        conf = readPdoEntries(pdo, entries);
+        if ((n = reorderPdoEntries(entries, pdo->pdoEntryCount)) < 0) {
+          return -1;
+        }
+        pdo_idx++;
+
+        fprintf(file, "        <pdo idx=\"%04x\">\n", pdo->index);
+        for (i = 0, e = entries, bits = 0; i < n; i++, e++) {
+          fprintf(file, "          <pdoEntry idx=\"%04x\" subIdx=\"%02x\" bitLen=\"%u\"", e->entry->index, e->entry->subindex,
+              e->entry->bitLength);
+          writePinAttrs(file, e->entry->halPin, e->entry->halType, e->entry->subType, e->entry->floatScale, e->entry->floatOffset);
+          bits += e->entry->bitLength;
+          if (e->complex_count == 0) {
+            fprintf(file, "/>\n");
+            continue;
+          }
+          fprintf(file, ">\n");
+          for (j = 0, ce = e->complex; j < e->complex_count; j++, ce++) {
+            fprintf(file, "            <complexEntry bitLen=\"%u\"", ce->bitLength);
+            writePinAttrs(file, ce->halPin, ce->halType, ce->subType, ce->floatScale, ce->floatOffset);
+            fprintf(file, "/>\n");
+          }
+          fprintf(file, "          </pdoEntry>\n");
+        }
+
+        // pad to a byte boundary if another PDO follows in this sync manager
+        if ((bits & 0x07) != 0 && sm != NULL && pdo_idx < sm->pdoCount) {
+          fprintf(file, "          <pdoEntry idx=\"0000\" subIdx=\"00\" bitLen=\"%u\"/>\n", 8 - (bits & 0x07));
+          pad_total += 8 - (bits & 0x07);
+        }
+        fprintf(file, "        </pdo>\n");
+        break;
+
+      default:
+        conf += confRecordSize(conf);
+    }
+  }
+  if (sm != NULL) {
+    fprintf(file, "      </syncManager>\n");
+  }
+
+  return pad_total;
+}
+
+// returns the record after the last one that belongs to the slave at `conf`
+static const char *slaveEnd(const char *conf) {
+  size_t size;
+
+  conf += sizeof(LCEC_CONF_SLAVE_T);
+  for (;;) {
+    switch (((const LCEC_CONF_NULL_T *)conf)->confType) {
+      case lcecConfTypeNone:
+      case lcecConfTypeMaster:
+      case lcecConfTypeSlave:
+        return conf;
+      default:
+        if ((size = confRecordSize(conf)) == 0) {
+          return NULL;
+        }
+        conf += size;
+    }
+  }
+}
+
+int writeLayoutSuggestion(const void *conf_data, const char *filename) {
+  const char *conf = conf_data;
+  const char *end;
+  const LCEC_CONF_MASTER_T *master = NULL;
+  const LCEC_CONF_SLAVE_T *slave;
+  LAYOUT_PDOENTRY_T *entries;
+  int master_open = 0;
+  int unaligned, pad_bits;
+  size_t size;
+  FILE *file;
+
+  file = fopen(filename, "w");
+  if (file == NULL) {
+    fprintf(stderr, "%s: ERROR: unable to open layout suggestion file %s\n", modname, filename);
+    return -1;
+  }
+
+  fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf(file, "<!--\n");
+  fprintf(file, "  Suggested PDO layout for generic slaves with unaligned whole-byte PDO entries.\n");
+  fprintf(file, "  Replace each listed slave's syncManager elements with the ones below, keeping\n");
+  fprintf(file, "  the slave's other attributes and child elements.  The slave must accept the\n");
+  fprintf(file, "  new PDO mapping, and padding entries need support for gaps in the mapping.\n");
+  fprintf(file, "-->\n");
+  fprintf(file, "<masters>\n");
+
+  while (((const LCEC_CONF_NULL_T *)conf)->confType != lcecConfTypeNone) {
+    switch (((const LCEC_CONF_NULL_T *)conf)->confType) {
+      case lcecConfTypeMaster:
+        if (master_open) {
+          fprintf(file, "  </master>\n");
+          master_open = 0;
+        }
+        master = (const LCEC_CONF_MASTER_T *)conf;
+        conf += sizeof(LCEC_CONF_MASTER_T);
+        break;
+
+      case lcecConfTypeSlave:
+        slave = (const LCEC_CONF_SLAVE_T *)conf;
+        if ((end = slaveEnd(conf)) == NULL) {
+          fprintf(stderr, "%s: ERROR: unknown config item type\n", modname);
+          goto fail;
+        }
+        conf += sizeof(LCEC_CONF_SLAVE_T);
+        if (slave->syncManagerCount == 0 || slave->pdoEntryCount == 0) {
+          conf = end;
+          break;
+        }
+
+        entries = malloc(sizeof(LAYOUT_PDOENTRY_T) * (slave->pdoEntryCount + 1));
+        if (entries == NULL) {
+          fprintf(stderr, "%s: ERROR: out of memory\n", modname);
+          goto fail;
+        }
+        unaligned = countUnaligned(conf, end, entries);
+        if (unaligned == 0) {
+          free(entries);
+          conf = end;
+          break;
+        }
+
+        if (!master_open && master != NULL) {
+          fprintf(file, "  <master idx=\"%d\" name=\"", master->index);
+          writeXmlString(file, master->name);
+          fprintf(file, "\">\n");
+          master_open = 1;
+        }
+        if (!slave->configPdos) {
+          fprintf(file, "    <!-- slave %s: %d unaligned entries, but its PDO mapping is fixed (configPdos is not set) -->\n", slave->name,
+              unaligned);
+          free(entries);
+          conf = end;
+          break;
+        }
+
+        fprintf(file, "    <slave idx=\"%d\" type=\"%s\" vid=\"%08x\" pid=\"%08x\" name=\"", slave->index, slave->typename, slave->vid,
+            slave->pid);
+        writeXmlString(file, slave->name);
+        fprintf(file, "\" configPdos=\"true\">\n");
+        pad_bits = writeSlaveSyncManagers(file, conf, end, entries);
+        free(entries);
+        if (pad_bits < 0) {
+          fprintf(stderr, "%s: ERROR: out of memory\n", modname);
+          goto fail;
+        }
+        fprintf(file, "    </slave>\n");
+        fprintf(file, "    <!-- slave %s: aligns %d entries with %d bits of padding -->\n", slave->name, unaligned, pad_bits);
+        conf = end;
+        break;
+
+      default:
+        if ((size = confRecordSize(conf)) == 0) {
+          fprintf(stderr, "%s: ERROR: unknown config item type\n", modname);
+          goto fail;
+        }
+        conf += size;
+    }
+  }
+  if (master_open) {
+    fprintf(file, "  </master>\n");
+  }
+  fprintf(file, "</masters>\n");
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "%s: ERROR: unable to write layout suggestion file %s\n", modname, filename);
+    return -1;
+  }
+
+  return 0;
+
+fail:
+  fclose(file);
+  return -1;
+}
@@ -23,6 +23,8 @@
 
 #include <expat.h>
 
+#include "lcec_layout.h"
+
 #define BUFFSIZE 8192
 
 struct LCEC_CONF_XML_HANLDER;
@@ -64,4 +66,7 @@ int initXmlInst(LCEC_CONF_XML_INST_T *inst, const LCEC_CONF_XML_HANLDER_T *state
 
 int parseHex(const char *s, int slen, uint8_t *buf);
 
+int writeLayoutReport(const LCEC_LAYOUT_T *layout, const char *filename);
+int writeLayoutSuggestion(const void *conf_data, const char *filename);
+
 #endif
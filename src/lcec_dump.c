@@ -0,0 +1,238 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Code for `lcec_dump` tool, which writes the flight recorder of a master as CSV.
+///
+/// Usage: `lcec_dump [-x] [master-index]`
+///
+/// Prints one line per recorded cycle, oldest first, with the cycle's
+/// timestamp, working counter, and master state, followed by one
+/// column per registered PDO entry.  With `-x`, PDO values are
+/// printed in hex instead of decimal.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "lcec_rtapi.h"
+#include "lcec_record.h"
+#include "rtapi.h"
+
+static const char *modname = "lcec_dump";
+
+static const char *state_names[] = {"running", "trigger", "fault"};
+
+/// @brief A frame that survived the copy, and how old it is.
+typedef struct {
+  uint32_t age;
+  const LCEC_RECORD_FRAME_T *frame;
+} frame_ref_t;
+
+static void usage(void) { fprintf(stderr, "usage: %s [-x] [master-index]\n", modname); }
+
+static int cmp_age(const void *a, const void *b) {
+  uint32_t age_a = ((const frame_ref_t *)a)->age;
+  uint32_t age_b = ((const frame_ref_t *)b)->age;
+
+  // oldest first
+  return (age_a < age_b) - (age_a > age_b);
+}
+
+/// @brief Extract a little-endian bit field from the process data.
+static uint64_t get_bits(const uint8_t *pd, uint32_t data_len, uint32_t offset, int bit_pos, int bit_len) {
+  uint64_t val = 0;
+  uint32_t byte;
+  int i, bit;
+
+  for (i = 0; i < bit_len && i < 64; i++) {
+    bit = bit_pos + i;
+    byte = offset + bit / 8;
+    if (byte >= data_len) {
+      break;
+    }
+    if ((pd[byte] >> (bit % 8)) & 1) {
+      val |= (uint64_t)1 << i;
+    }
+  }
+  return val;
+}
+
+static void print_entry(const LCEC_PDO_ENTRY_DESC_T *entry, const uint8_t *pd, uint32_t data_len, int hex) {
+  uint64_t val;
+  int i;
+
+  if (entry->bit_len == 0) {
+    // length unknown, show the first byte
+    printf(",0x%02x", (entry->offset < data_len) ? pd[entry->offset] : 0);
+    return;
+  }
+
+  if (entry->bit_len > 64) {
+    printf(",0x");
+    for (i = (entry->bit_len + 7) / 8 - 1; i >= 0; i--) {
+      printf("%02x", (entry->offset + i < data_len) ? pd[entry->offset + i] : 0);
+    }
+    return;
+  }
+
+  val = get_bits(pd, data_len, entry->offset, entry->bit_pos, entry->bit_len);
+  if (hex) {
+    printf(",0x%0*llx", (entry->bit_len + 3) / 4, (unsigned long long)val);
+  } else {
+    printf(",%llu", (unsigned long long)val);
+  }
+}
+
+int main(int argc, char **argv) {
+  int ret = 1;
+  int hex = 0;
+  int master_index = 0;
+  int comp_id;
+  int shmem_id;
+  void *shmem_ptr;
+  LCEC_RECORD_T *rec, *copy = NULL;
+  const LCEC_RECORD_SLAVE_T *slaves;
+  const LCEC_PDO_ENTRY_DESC_T *entries, *entry;
+  const LCEC_RECORD_FRAME_T *frame;
+  frame_ref_t *frames = NULL;
+  uint32_t head, head_after, age, state, i, j, count;
+  size_t length;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "xh")) != -1) {
+    switch (opt) {
+      case 'x':
+        hex = 1;
+        break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+  if (optind < argc) {
+    master_index = atoi(argv[optind]);
+  }
+
+  // initialize component
+  comp_id = hal_init(modname);
+  if (comp_id < 1) {
+    fprintf(stderr, "%s: ERROR: hal_init failed\n", modname);
+    goto fail0;
+  }
+
+  // map the header to get the size of the recorder
+  shmem_id = rtapi_shmem_new(LCEC_RECORD_SHMEM_KEY(master_index), comp_id, sizeof(LCEC_RECORD_T));
+  if (shmem_id < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't allocate user/RT shared memory\n", modname);
+    goto fail1;
+  }
+  if (lcec_rtapi_shmem_getptr(shmem_id, &shmem_ptr) < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't map user/RT shared memory\n", modname);
+    goto fail2;
+  }
+  rec = shmem_ptr;
+  if (rec->magic != LCEC_RECORD_SHMEM_MAGIC) {
+    fprintf(stderr, "%s: ERROR: no flight recorder active on master %d\n", modname, master_index);
+    goto fail2;
+  }
+  lcec_rmb();
+  length = rec->length;
+  rtapi_shmem_delete(shmem_id, comp_id);
+
+  // reopen with the proper size
+  shmem_id = rtapi_shmem_new(LCEC_RECORD_SHMEM_KEY(master_index), comp_id, length);
+  if (shmem_id < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't allocate user/RT shared memory\n", modname);
+    goto fail1;
+  }
+  if (lcec_rtapi_shmem_getptr(shmem_id, &shmem_ptr) < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't map user/RT shared memory\n", modname);
+    goto fail2;
+  }
+  rec = shmem_ptr;
+
+  // take a private copy, so a running recorder doesn't change frames under us
+  copy = malloc(length);
+  frames = malloc(sizeof(frame_ref_t) * (rec->depth + 1));
+  if (copy == NULL || frames == NULL) {
+    fprintf(stderr, "%s: ERROR: out of memory\n", modname);
+    goto fail3;
+  }
+  head = rec->head;
+  state = rec->state;
+  lcec_rmb();
+  memcpy(copy, rec, length);
+  lcec_rmb();
+  head_after = rec->head;
+  if (state == LCEC_RECORD_RUNNING) {
+    fprintf(stderr, "%s: WARNING: recorder on master %d is still running\n", modname, master_index);
+  }
+
+  // keep frames written before the copy started that weren't overwritten during it
+  count = 0;
+  for (i = 0; i < copy->depth; i++) {
+    frame = LCEC_RECORD_FRAME(copy, i);
+    if (frame->timestamp == 0) {
+      continue;
+    }
+    age = head_after - frame->seq;
+    if (age <= head_after - head || age > copy->depth) {
+      continue;
+    }
+    frames[count].age = age;
+    frames[count].frame = frame;
+    count++;
+  }
+  qsort(frames, count, sizeof(frame_ref_t), cmp_age);
+
+  // header
+  slaves = LCEC_RECORD_SLAVES(copy);
+  entries = LCEC_RECORD_ENTRIES(copy);
+  printf("# master %d, %u of %u frames, state %s\n", copy->master_index, count, copy->depth,
+      (state < sizeof(state_names) / sizeof(state_names[0])) ? state_names[state] : "unknown");
+  printf("seq,timestamp,working_counter,wc_state,al_states,slaves_responding,link_up");
+  for (j = 0, entry = entries; j < copy->entry_count; j++, entry++) {
+    printf(",%s.%04x:%02x", slaves[entry->slave].name, entry->index, entry->subindex);
+  }
+  printf("\n");
+
+  // frames
+  for (i = 0; i < count; i++) {
+    frame = frames[i].frame;
+    printf("%u,%llu,%u,%u,0x%x,%u,%u", frame->seq, (unsigned long long)frame->timestamp, frame->working_counter, frame->wc_state,
+        frame->al_states, frame->slaves_responding, frame->link_up);
+    for (j = 0, entry = entries; j < copy->entry_count; j++, entry++) {
+      print_entry(entry, frame->data, copy->data_len, hex);
+    }
+    printf("\n");
+  }
+  ret = 0;
+
+fail3:
+  free(frames);
+  free(copy);
+fail2:
+  rtapi_shmem_delete(shmem_id, comp_id);
+fail1:
+  hal_exit(comp_id);
+fail0:
+  return ret;
+}
@@ -0,0 +1,161 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Code for `lcec_emcy` tool, which prints CoE emergency messages collected by the realtime driver.
+///
+/// Usage: `lcec_emcy [-f] [master-index]`
+///
+/// Prints all messages still held in the master's EMCY ring.  With
+/// `-f`, keeps running and prints new messages as they arrive until
+/// interrupted.
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "lcec_emcy.h"
+#include "lcec_rtapi.h"
+#include "rtapi.h"
+
+// offset between the EtherCAT epoch (2000-01-01) and the unix epoch
+#define EC_EPOCH_OFFSET 946684800ULL
+
+#define POLL_INTERVAL_US 100000
+
+static const char *modname = "lcec_emcy";
+static volatile int done = 0;
+
+static void exitHandler(int sig) { done = 1; }
+
+static void usage(void) { fprintf(stderr, "usage: %s [-f] [master-index]\n", modname); }
+
+static void print_msg(const LCEC_EMCY_RING_T *ring, const LCEC_EMCY_MSG_T *msg) {
+  char buf[32];
+  time_t sec = (time_t)(msg->timestamp / 1000000000ULL + EC_EPOCH_OFFSET);
+  struct tm tm;
+  int i;
+
+  localtime_r(&sec, &tm);
+  strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+  printf("%s.%03u master %d slave %u: error code 0x%04x, error reg 0x%02x, data", buf,
+      (unsigned int)((msg->timestamp / 1000000ULL) % 1000), ring->master_index, msg->slave_index, msg->error_code, msg->error_reg);
+  for (i = 0; i < LCEC_EMCY_DATA_LEN; i++) {
+    printf(" %02x", msg->data[i]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  int ret = 1;
+  int follow = 0;
+  int master_index = 0;
+  int comp_id;
+  int shmem_id;
+  void *shmem_ptr;
+  LCEC_EMCY_RING_T *ring;
+  LCEC_EMCY_MSG_T msg;
+  uint32_t pos, head;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "fh")) != -1) {
+    switch (opt) {
+      case 'f':
+        follow = 1;
+        break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+  if (optind < argc) {
+    master_index = atoi(argv[optind]);
+  }
+
+  // initialize component
+  comp_id = hal_init(modname);
+  if (comp_id < 1) {
+    fprintf(stderr, "%s: ERROR: hal_init failed\n", modname);
+    goto fail0;
+  }
+
+  // map ring header
+  shmem_id = rtapi_shmem_new(LCEC_EMCY_SHMEM_KEY(master_index), comp_id, LCEC_EMCY_RING_BYTES(LCEC_EMCY_RING_SIZE));
+  if (shmem_id < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't allocate user/RT shared memory\n", modname);
+    goto fail1;
+  }
+  if (lcec_rtapi_shmem_getptr(shmem_id, &shmem_ptr) < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't map user/RT shared memory\n", modname);
+    goto fail2;
+  }
+  ring = shmem_ptr;
+  if (ring->magic != LCEC_EMCY_SHMEM_MAGIC) {
+    fprintf(stderr, "%s: ERROR: no EMCY capture active on master %d\n", modname, master_index);
+    goto fail2;
+  }
+  lcec_rmb();
+
+  signal(SIGINT, exitHandler);
+  signal(SIGTERM, exitHandler);
+
+  // start with the oldest message still in the ring.  The slot at
+  // head - size is the one the writer will overwrite next, so it is
+  // never read.
+  head = ring->head;
+  pos = (head >= ring->size) ? head - ring->size + 1 : 0;
+  ret = 0;
+  while (!done) {
+    head = ring->head;
+    lcec_rmb();
+    while (pos != head) {
+      // skip messages that were overwritten before we got to them
+      if (head - pos >= ring->size) {
+        fprintf(stderr, "%s: WARNING: lost %u messages\n", modname, head - pos - ring->size + 1);
+        pos = head - ring->size + 1;
+      }
+      msg = ring->msgs[pos & (ring->size - 1)];
+      lcec_rmb();
+
+      // the writer may have lapped us while copying
+      if (ring->head - pos >= ring->size) {
+        head = ring->head;
+        continue;
+      }
+
+      print_msg(ring, &msg);
+      pos++;
+    }
+    fflush(stdout);
+
+    if (!follow) {
+      break;
+    }
+    usleep(POLL_INTERVAL_US);
+  }
+
+fail2:
+  rtapi_shmem_delete(shmem_id, comp_id);
+fail1:
+  hal_exit(comp_id);
+fail0:
+  return ret;
+}
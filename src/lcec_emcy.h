@@ -0,0 +1,60 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Shared memory layout for CoE emergency (EMCY) message capture.
+///
+/// Each master with at least one slave that sets `emcyQueueSize` gets
+/// its own ring in user/RT shared memory.  The realtime side is the
+/// only writer; readers (like `lcec_emcy`) keep their own read
+/// position and never modify the ring, so the RT thread never waits
+/// on userspace.  When a reader falls behind by more than
+/// `LCEC_EMCY_RING_SIZE` messages, the oldest messages are lost.
+
+#ifndef _LCEC_EMCY_H_
+#define _LCEC_EMCY_H_
+
+#include "lcec_conf.h"
+
+#define LCEC_EMCY_SHMEM_KEY(master_idx) (0xACB57300 + (master_idx))
+#define LCEC_EMCY_SHMEM_MAGIC           0x454D4359
+
+#define LCEC_EMCY_RING_SIZE 256  ///< Number of messages per ring, must be a power of two.
+#define LCEC_EMCY_DATA_LEN  5    ///< Length of the manufacturer specific error field.
+
+/// @brief A single emergency message, as stored in the ring.
+typedef struct {
+  uint64_t timestamp;                ///< EtherCAT application time (ns since 2000-01-01) when the message was collected.
+  uint32_t slave_index;              ///< Bus position of the slave that sent the message.
+  uint16_t error_code;               ///< CiA 301 emergency error code.
+  uint8_t error_reg;                 ///< Error register (0x1001).
+  uint8_t data[LCEC_EMCY_DATA_LEN];  ///< Manufacturer specific error field.
+} LCEC_EMCY_MSG_T;
+
+/// @brief Ring header, followed by `LCEC_EMCY_RING_SIZE` messages.
+typedef struct {
+  uint32_t magic;
+  uint32_t size;           ///< Number of message slots.
+  int master_index;        ///< Index of the master that owns this ring.
+  volatile uint32_t head;  ///< Sequence number of the next message to be written.
+  LCEC_EMCY_MSG_T msgs[];
+} LCEC_EMCY_RING_T;
+
+#define LCEC_EMCY_RING_BYTES(size) (sizeof(LCEC_EMCY_RING_T) + (size) * sizeof(LCEC_EMCY_MSG_T))
+
+#endif
@@ -22,8 +22,9 @@
 
 #include "lcec.h"
 
-static int lcec_param_newfv(hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *fmt, va_list ap);
-static int lcec_param_newfv_list(void *base, const lcec_pindesc_t *list, va_list ap);
+static int lcec_prefetch_lookup(struct lcec_slave *slave, int is_idn, uint8_t drive_no, uint16_t index, uint8_t subindex, uint8_t *target,
+    size_t size);
+static void lcec_prefetch_invalidate(struct lcec_slave *slave, uint16_t index, uint8_t subindex);
 int lcec_comp_id = -1;
 
 /// @brief Find the slave with a specified index underneath a specific master.
@@ -39,23 +40,239 @@ lcec_slave_t *lcec_slave_by_index(struct lcec_master *master, int index) {
   return NULL;
 }
 
-/// @brief Copy FSoE (Safety over EtherCAT / FailSafe over EtherCAT) data between slaves and masters.
-void copy_fsoe_data(struct lcec_slave *slave, unsigned int slave_offset, unsigned int master_offset) {
-  lcec_master_t *master = slave->master;
-  uint8_t *pd = master->process_data;
-  const LCEC_CONF_FSOE_T *fsoeConf = slave->fsoeConf;
+/// @brief Build the per-cycle slave array for a master.
+///
+/// Copies the fields that `lcec_read_master()` and
+/// `lcec_write_master()` need for every slave into one contiguous
+/// array of `lcec_slave_rt_t`.  Call this once all slaves have been
+/// initialized, since drivers may still change `proc_read` or
+/// `proc_write` in their init functions.
+///
+/// @return 0 on success, -ENOMEM if allocation failed.
+int lcec_master_build_slave_rt(struct lcec_master *master) {
+  lcec_slave_t *slave;
+  lcec_slave_rt_t *rt;
+  int count = 0;
+
+  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+    count++;
+  }
+
+  master->slave_rt_count = 0;
+  master->slave_rt = NULL;
+  if (count == 0) {
+    return 0;
+  }
+
+  rt = hal_malloc(sizeof(lcec_slave_rt_t) * count);
+  if (rt == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for master %s slave data failed\n", master->name);
+    return -ENOMEM;
+  }
+  memset(rt, 0, sizeof(lcec_slave_rt_t) * count);
+
+  master->slave_rt = rt;
+  for (slave = master->first_slave; slave != NULL; slave = slave->next, rt++) {
+    rt->slave = slave;
+    rt->proc_read = slave->proc_read;
+    rt->proc_write = slave->proc_write;
+    rt->config = slave->config;
+    rt->hal_state_data = slave->hal_state_data;
+    rt->emcy_queue_size = slave->emcy_queue_size;
+  }
+  master->slave_rt_count = count;
+
+  return 0;
+}
+
+/// @brief Free a slave's configuration data that is only needed until the master is active.
+///
+/// Releases the SDO/IDN configs, modParams, generic PDO definitions,
+/// DC and watchdog configs, and any leftover prefetched mailbox
+/// reads.  Safe to call more than once.
+void lcec_slave_release_config(struct lcec_slave *slave) {
+  lcec_prefetch_clear(slave);
+  if (slave->modparams != NULL) {
+    lcec_free(slave->modparams);
+    slave->modparams = NULL;
+  }
+  if (slave->sdo_config != NULL) {
+    lcec_free(slave->sdo_config);
+    slave->sdo_config = NULL;
+  }
+  if (slave->idn_config != NULL) {
+    lcec_free(slave->idn_config);
+    slave->idn_config = NULL;
+  }
+  if (slave->generic_pdo_entries != NULL) {
+    lcec_free(slave->generic_pdo_entries);
+    slave->generic_pdo_entries = NULL;
+  }
+  if (slave->generic_pdos != NULL) {
+    lcec_free(slave->generic_pdos);
+    slave->generic_pdos = NULL;
+  }
+  if (slave->generic_sync_managers != NULL) {
+    if (slave->sync_info == slave->generic_sync_managers) {
+      slave->sync_info = NULL;
+    }
+    lcec_free(slave->generic_sync_managers);
+    slave->generic_sync_managers = NULL;
+  }
+  if (slave->dc_conf != NULL) {
+    lcec_free(slave->dc_conf);
+    slave->dc_conf = NULL;
+  }
+  if (slave->wd_conf != NULL) {
+    lcec_free(slave->wd_conf);
+    slave->wd_conf = NULL;
+  }
+}
+
+// adds a route, merging it into the previous one if both source and destination are contiguous
+static int lcec_fsoe_route_add(lcec_fsoe_route_t *routes, int count, unsigned int src, unsigned int dst, unsigned int len) {
+  lcec_fsoe_route_t *prev;
+
+  if (count > 0) {
+    prev = &routes[count - 1];
+    if (prev->src + prev->len == src && prev->dst + prev->len == dst) {
+      prev->len += len;
+      return count;
+    }
+  }
+
+  routes[count].src = src;
+  routes[count].dst = dst;
+  routes[count].len = len;
+  return count + 1;
+}
+
+/// @brief Build the FSoE routing table for a master.
+///
+/// Safety slaves and FSoE logic devices (EL6900, EL1918) exchange
+/// their safety frames through the master's process data: each cycle
+/// the frame a safety slave sent is copied into the logic device's
+/// outputs, and the frame the logic device sent is copied into the
+/// safety slave's outputs.  This turns every connection set up by a
+/// logic device into two (source, destination, length) copies, sorted
+/// by source offset so that connections with adjacent PDOs merge into
+/// one copy.  Needs the final PDO offsets, so call it after PDO
+/// registration.
+///
+/// @return 0 on success, -ENOMEM if allocation failed, -EINVAL if a
+/// route doesn't fit into the process data.
+int lcec_master_build_fsoe_routes(struct lcec_master *master) {
+  lcec_slave_t *slave;
+  const LCEC_CONF_FSOE_T *fsoeConf;
+  lcec_fsoe_route_t *raw, *routes, tmp;
+  int raw_count = 0, count = 0;
+  int i, j;
+
+  master->fsoe_routes = NULL;
+  master->fsoe_route_count = 0;
+
+  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+    if (slave->fsoeConf != NULL) {
+      raw_count += 2;
+    }
+  }
+  if (raw_count == 0) {
+    return 0;
+  }
+
+  raw = lcec_zalloc(sizeof(lcec_fsoe_route_t) * raw_count);
+  if (raw == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "lcec_zalloc() for master %s FSoE routes failed\n", master->name);
+    return -ENOMEM;
+  }
+
+  // collect the copies for all connected safety slaves
+  raw_count = 0;
+  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+    fsoeConf = slave->fsoeConf;
+    if (fsoeConf == NULL) {
+      continue;
+    }
+    if (slave->fsoe_slave_offset != NULL && slave->fsoe_local_slave_offset != NULL) {
+      raw[raw_count].src = *(slave->fsoe_local_slave_offset);
+      raw[raw_count].dst = *(slave->fsoe_slave_offset);
+      raw[raw_count].len = LCEC_FSOE_SIZE(fsoeConf->data_channels, fsoeConf->slave_data_len);
+      raw_count++;
+    }
+    if (slave->fsoe_master_offset != NULL && slave->fsoe_local_master_offset != NULL) {
+      raw[raw_count].src = *(slave->fsoe_master_offset);
+      raw[raw_count].dst = *(slave->fsoe_local_master_offset);
+      raw[raw_count].len = LCEC_FSOE_SIZE(fsoeConf->data_channels, fsoeConf->master_data_len);
+      raw_count++;
+    }
+  }
 
-  if (fsoeConf == NULL) {
-    return;
+  for (i = 0; i < raw_count; i++) {
+    if (raw[i].src + raw[i].len > master->process_data_len || raw[i].dst + raw[i].len > master->process_data_len) {
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "master %s FSoE route %u -> %u (%u bytes) is outside of the process data\n", master->name,
+          raw[i].src, raw[i].dst, raw[i].len);
+      lcec_free(raw);
+      return -EINVAL;
+    }
+  }
+
+  // sort by source, so adjacent frames become one copy
+  for (i = 1; i < raw_count; i++) {
+    tmp = raw[i];
+    for (j = i; j > 0 && raw[j - 1].src > tmp.src; j--) {
+      raw[j] = raw[j - 1];
+    }
+    raw[j] = tmp;
   }
 
-  if (slave->fsoe_slave_offset != NULL) {
-    memcpy(&pd[*(slave->fsoe_slave_offset)], &pd[slave_offset], LCEC_FSOE_SIZE(fsoeConf->data_channels, fsoeConf->slave_data_len));
+  // no safety slave is connected to a logic device
+  if (raw_count == 0) {
+    lcec_free(raw);
+    return 0;
   }
 
-  if (slave->fsoe_master_offset != NULL) {
-    memcpy(&pd[master_offset], &pd[*(slave->fsoe_master_offset)], LCEC_FSOE_SIZE(fsoeConf->data_channels, fsoeConf->master_data_len));
+  routes = hal_malloc(sizeof(lcec_fsoe_route_t) * raw_count);
+  if (routes == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "hal_malloc() for master %s FSoE routes failed\n", master->name);
+    lcec_free(raw);
+    return -ENOMEM;
+  }
+  for (i = 0; i < raw_count; i++) {
+    count = lcec_fsoe_route_add(routes, count, raw[i].src, raw[i].dst, raw[i].len);
   }
+  master->fsoe_routes = routes;
+  master->fsoe_route_count = count;
+
+  lcec_free(raw);
+  return 0;
+}
+
+/// @brief Copy all FSoE frames of a master, see `lcec_master_build_fsoe_routes()`.
+void lcec_master_route_fsoe(struct lcec_master *master) {
+  uint8_t *pd = master->process_data;
+  const lcec_fsoe_route_t *route, *end;
+
+  for (route = master->fsoe_routes, end = route + master->fsoe_route_count; route < end; route++) {
+    memcpy(&pd[route->dst], &pd[route->src], route->len);
+  }
+}
+
+/// @brief The current EtherCAT application time of a master.
+///
+/// This is the time `lcec_write_master()` sends to the master with
+/// `ecrt_master_application_time()`, in ns since 2000-01-01.  When the
+/// master cycle is synced to the reference clock, it is derived from
+/// `dc_ref`, which `lcec_read_master()` advances at the start of each
+/// cycle, rather than from `rtapi_get_time()`.
+uint64_t lcec_master_app_time(struct lcec_master *master) {
+  long long now = rtapi_get_time();
+
+#ifdef RTAPI_TASK_PLL_SUPPORT
+  if (master->sync_ref_cycles < 0) {
+    return master->app_time_base + master->dc_ref + (now - rtapi_task_pll_get_reference());
+  }
+#endif
+  return master->app_time_base + now;
 }
 
 /// @brief Initialize syncs to 0.
@@ -110,6 +327,10 @@ int lcec_read_sdo(struct lcec_slave *slave, uint16_t index, uint8_t subindex, ui
   size_t result_size;
   uint32_t abort_code;
 
+  if (lcec_prefetch_lookup(slave, 0, 0, index, subindex, target, size) == 0) {
+    return 0;
+  }
+
   if ((err = ecrt_master_sdo_upload(master->master, slave->index, index, subindex, target, size, &result_size, &abort_code))) {
     rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "slave %s.%s: Failed to execute SDO upload (0x%04x:0x%02x, error %d, abort_code %08x)\n",
         master->name, slave->name, index, subindex, err, abort_code);
@@ -311,6 +532,7 @@ int lcec_write_sdo(struct lcec_slave *slave, uint16_t index, uint8_t subindex, u
         master->name, slave->name, index, subindex, (int)size, (int)value[0], err, abort_code);
     return -1;
   }
+  lcec_prefetch_invalidate(slave, index, subindex);
 
   if (ecrt_slave_config_sdo(slave->config, index, subindex, value, size) != 0) {
     rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "slave %s.%s: Failed to configure slave SDO (0x%04x:0x%02x)\n", master->name, slave->name,
@@ -439,6 +661,10 @@ int lcec_read_idn(struct lcec_slave *slave, uint8_t drive_no, uint16_t idn, uint
   size_t result_size;
   uint16_t error_code;
 
+  if (lcec_prefetch_lookup(slave, 1, drive_no, idn, 0, target, size) == 0) {
+    return 0;
+  }
+
   if ((err = ecrt_master_read_idn(master->master, slave->index, drive_no, idn, target, size, &result_size, &error_code))) {
     rtapi_print_msg(RTAPI_MSG_ERR,
         LCEC_MSG_PFX "slave %s.%s: Failed to execute IDN read (drive %u idn %c-%u-%u, error %d, error_code %08x)\n", master->name,
@@ -456,82 +682,137 @@ int lcec_read_idn(struct lcec_slave *slave, uint8_t drive_no, uint16_t idn, uint
   return 0;
 }
 
-static int lcec_param_newfv(hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *fmt, va_list ap) {
-  char name[HAL_NAME_LEN + 1];
-  int sz;
-  int err;
-
-  sz = rtapi_vsnprintf(name, sizeof(name), fmt, ap);
-  if (sz == -1 || sz > HAL_NAME_LEN) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "length %d too long for name starting '%s'\n", sz, name);
-    return -ENOMEM;
-  }
+static int lcec_prefetch_add(struct lcec_slave *slave, int is_idn, uint8_t drive_no, uint16_t index, uint8_t subindex, size_t size) {
+  lcec_slave_mbxread_t *read, **tail;
 
-  err = hal_param_new(name, type, dir, data_addr, lcec_comp_id);
-  if (err) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "exporting param %s failed\n", name);
-    return err;
+  if ((read = lcec_zalloc(sizeof(lcec_slave_mbxread_t) + size)) == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "Unable to allocate mailbox read for slave %s.%s\n", slave->master->name, slave->name);
+    return -1;
   }
+  read->is_idn = is_idn;
+  read->drive_no = drive_no;
+  read->index = index;
+  read->subindex = subindex;
+  read->size = size;
 
-  switch (type) {
-    case HAL_BIT:
-      *((hal_bit_t *)data_addr) = 0;
-      break;
-    case HAL_FLOAT:
-      *((hal_float_t *)data_addr) = 0.0;
-      break;
-    case HAL_S32:
-      *((hal_s32_t *)data_addr) = 0;
-      break;
-    case HAL_U32:
-      *((hal_u32_t *)data_addr) = 0;
-      break;
-    default:
-      break;
-  }
+  // keep the driver's order, so reads hit the slave in the same sequence as before
+  for (tail = &slave->mbx_reads; *tail != NULL; tail = &(*tail)->next);
+  *tail = read;
 
   return 0;
 }
 
-/// @brief Create a new LinuxCNC `param` dynamically.
-int lcec_param_newf(hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *fmt, ...) {
-  va_list ap;
+/// @brief Queue an SDO upload to be done before `proc_init`.
+///
+/// Call from a driver's `proc_preinit`.  All queued reads for all
+/// slaves on a master are issued in parallel before the first
+/// `proc_init` runs, so the mailbox round-trips of different slaves
+/// overlap.  A later `lcec_read_sdo()` with the same index, subindex,
+/// and size returns the prefetched data without touching the bus.  If
+/// the prefetch failed, `lcec_read_sdo()` simply retries and reports
+/// the error itself.
+///
+/// @param slave The slave.
+/// @param index The CoE object index to read.
+/// @param subindex The CoE object subindex to read.
+/// @param size The number of bytes to read.
+/// @return 0 for success, <0 for failure.
+int lcec_prefetch_sdo(struct lcec_slave *slave, uint16_t index, uint8_t subindex, size_t size) {
+  return lcec_prefetch_add(slave, 0, 0, index, subindex, size);
+}
+
+/// @brief Queue an IDN read to be done before `proc_init`.
+///
+/// The SoE equivalent of `lcec_prefetch_sdo()`, matched by
+/// `lcec_read_idn()`.
+int lcec_prefetch_idn(struct lcec_slave *slave, uint8_t drive_no, uint16_t idn, size_t size) {
+  return lcec_prefetch_add(slave, 1, drive_no, idn, 0, size);
+}
+
+/// @brief Issue all queued mailbox reads for a slave.
+///
+/// Blocks until all of the slave's reads are done, one request at a
+/// time.  Safe to call for different slaves from different threads.
+/// Failures are not reported here; see `lcec_prefetch_sdo()`.
+void lcec_prefetch_exec(struct lcec_slave *slave) {
+  lcec_master_t *master = slave->master;
+  lcec_slave_mbxread_t *read;
+  size_t result_size;
+  uint32_t abort_code;
+  uint16_t error_code;
   int err;
 
-  va_start(ap, fmt);
-  err = lcec_param_newfv(type, dir, data_addr, fmt, ap);
-  va_end(ap);
+  for (read = slave->mbx_reads; read != NULL; read = read->next) {
+    if (read->is_idn) {
+      err = ecrt_master_read_idn(
+          master->master, slave->index, read->drive_no, read->index, read->data, read->size, &result_size, &error_code);
+    } else {
+      err = ecrt_master_sdo_upload(
+          master->master, slave->index, read->index, read->subindex, read->data, read->size, &result_size, &abort_code);
+    }
+    read->valid = (err == 0 && result_size == read->size);
+  }
+}
 
-  return err;
+/// @brief Free all prefetched mailbox reads for a slave.
+void lcec_prefetch_clear(struct lcec_slave *slave) {
+  lcec_slave_mbxread_t *read, *next;
+
+  for (read = slave->mbx_reads; read != NULL; read = next) {
+    next = read->next;
+    lcec_free(read);
+  }
+  slave->mbx_reads = NULL;
 }
 
-static int lcec_param_newfv_list(void *base, const lcec_pindesc_t *list, va_list ap) {
-  va_list ac;
-  int err;
-  const lcec_pindesc_t *p;
-
-  for (p = list; p->type != HAL_TYPE_UNSPECIFIED; p++) {
-    va_copy(ac, ap);
-    err = lcec_param_newfv(p->type, p->dir, (void *)(base + p->offset), p->fmt, ac);
-    va_end(ac);
-    if (err) {
-      return err;
+static int lcec_prefetch_lookup(struct lcec_slave *slave, int is_idn, uint8_t drive_no, uint16_t index, uint8_t subindex, uint8_t *target,
+    size_t size) {
+  lcec_slave_mbxread_t *read;
+
+  for (read = slave->mbx_reads; read != NULL; read = read->next) {
+    if (read->valid && read->is_idn == is_idn && read->drive_no == drive_no && read->index == index && read->subindex == subindex &&
+        read->size == size) {
+      memcpy(target, read->data, size);
+      return 0;
     }
   }
 
-  return 0;
+  return -1;
 }
 
-/// @brief Create a list of new LinuxCNC params dynamically, using sprintf() to create names.
-int lcec_param_newf_list(void *base, const lcec_pindesc_t *list, ...) {
-  va_list ap;
-  int err;
+/// @brief Check if a prefetched SDO already holds a value.
+///
+/// Used to skip SDO downloads that wouldn't change anything.  Unlike
+/// `lcec_read_sdo()`, this never goes to the bus; if the SDO wasn't
+/// prefetched (or the prefetch failed), it simply reports no match.
+///
+/// @param slave The slave.
+/// @param index The CoE object index.
+/// @param subindex The CoE object subindex.
+/// @param value The value to compare against, in EtherCAT byte order.
+/// @param size The number of bytes in `value`.
+/// @return 1 if the prefetched data matches `value`, 0 otherwise.
+int lcec_prefetch_matches(struct lcec_slave *slave, uint16_t index, uint8_t subindex, const uint8_t *value, size_t size) {
+  lcec_slave_mbxread_t *read;
+
+  for (read = slave->mbx_reads; read != NULL; read = read->next) {
+    if (read->valid && !read->is_idn && read->index == index && read->subindex == subindex && read->size == size) {
+      return memcmp(read->data, value, size) == 0;
+    }
+  }
 
-  va_start(ap, list);
-  err = lcec_param_newfv_list(base, list, ap);
-  va_end(ap);
+  return 0;
+}
 
-  return err;
+// drop prefetched data that a later SDO download made stale
+static void lcec_prefetch_invalidate(struct lcec_slave *slave, uint16_t index, uint8_t subindex) {
+  lcec_slave_mbxread_t *read;
+
+  for (read = slave->mbx_reads; read != NULL; read = read->next) {
+    if (!read->is_idn && read->index == index && read->subindex == subindex) {
+      read->valid = 0;
+    }
+  }
 }
 
 /// @brief Get an XML `<modParam>` value for a specified slave.
@@ -567,6 +848,66 @@ lcec_pdo_entry_reg_t *lcec_allocate_pdo_entry_reg(int size) {
   return reg;
 }
 
+/// @brief Reserve room in a block for upcoming allocations.
+///
+/// Class drivers call this from their `allocate_channels()` function
+/// with the total size of everything a slave is going to allocate
+/// from `block`, so the chunk is sized to what the slave actually
+/// needs instead of a fixed size.  If the current chunk still has
+/// enough room, nothing happens.  Whatever was left in the previous
+/// chunk is abandoned, like the tail of any other `hal_malloc()`.
+///
+/// @param block The block to reserve room in.
+/// @param size The number of bytes to reserve, before alignment.
+/// @return 0 on success, -1 if allocation failed.
+int lcec_block_reserve(lcec_block_t *block, size_t size) {
+  if (size <= block->avail) {
+    return 0;
+  }
+
+  block->next = hal_malloc(size);
+  if (block->next == NULL) {
+    block->avail = 0;
+    return -1;
+  }
+  memset(block->next, 0, size);
+  block->avail = size;
+  return 0;
+}
+
+/// @brief Allocate zeroed HAL memory from a contiguous block.
+///
+/// Carves allocations out of the chunk reserved with
+/// `lcec_block_reserve()`, one after the other, so the channels of a
+/// slave end up next to each other instead of scattered over HAL
+/// memory, which keeps the per-cycle loops over them cache friendly.
+/// Allocations that don't fit into what is left of the chunk go
+/// straight to `hal_malloc()`.  Like `hal_malloc()`, there is no way
+/// to free the memory again.
+///
+/// @param block The block to allocate from, zero-initialized before first use.
+/// @param size The number of bytes needed.
+/// @return The memory, or NULL if allocation failed.
+void *lcec_block_alloc(lcec_block_t *block, size_t size) {
+  void *p;
+
+  // keep every allocation 8-byte aligned
+  size = LCEC_BLOCK_ALIGN(size);
+
+  if (size > block->avail) {
+    p = hal_malloc(size);
+    if (p != NULL) {
+      memset(p, 0, size);
+    }
+    return p;
+  }
+
+  p = block->next;
+  block->next += size;
+  block->avail -= size;
+  return p;
+}
+
 /// @brief Register a new PDO entry.
 ///
 /// This replaces the old LCEC_PDO_INIT() macro.  It has error
@@ -0,0 +1,73 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Shared memory layout for the PDO layout report.
+///
+/// `lcec_conf -l <file>` creates the layout block next to the config
+/// block, sized for the masters and slaves it parsed and for up to
+/// `LCEC_MAX_PDO_REG_COUNT` registered PDO entries per slave.  Once
+/// PDO entries are registered and each master is activated, the
+/// realtime module records the domain size and the final byte and
+/// bit offset of every registered entry.  `lcec_conf` then writes the
+/// report, flagging entries that aren't byte aligned.
+
+#ifndef _LCEC_LAYOUT_H_
+#define _LCEC_LAYOUT_H_
+
+#include "lcec_conf.h"
+
+#define LCEC_LAYOUT_SHMEM_KEY   0xACB572C9
+#define LCEC_LAYOUT_SHMEM_MAGIC 0x4C41594F
+
+/// @brief One slave.
+typedef struct {
+  int index;                        ///< Bus position.
+  char name[LCEC_CONF_STR_MAXLEN];  ///< Slave name.
+} LCEC_LAYOUT_SLAVE_T;
+
+/// @brief One master and its domain.
+typedef struct {
+  int index;                        ///< Master index.
+  char name[LCEC_CONF_STR_MAXLEN];  ///< Master name.
+  uint32_t domain_size;             ///< Size of the domain's process data in bytes.
+  int first_slave;                  ///< Index of this master's first slave in the slave table.
+  int slave_count;                  ///< Number of slaves on this master.
+  int first_entry;                  ///< Index of this master's first entry in the entry table.
+  int entry_count;                  ///< Number of entries registered on this master.
+} LCEC_LAYOUT_MASTER_T;
+
+/// @brief Layout block header, followed by `master_count` masters, `slave_count` slaves, and `entry_max` entries.
+typedef struct {
+  uint32_t magic;
+  int master_count;        ///< Number of masters.
+  int slave_count;         ///< Number of slaves, over all masters.
+  int entry_max;           ///< Room in the entry table.
+  int entry_count;         ///< Number of entries used.
+  int entries_dropped;     ///< Entries that didn't fit into the table.
+  volatile int init_done;  ///< Set once all masters are filled in.
+} LCEC_LAYOUT_T;
+
+#define LCEC_LAYOUT_BYTES(master_count, slave_count, entry_max)                                                              \
+  (sizeof(LCEC_LAYOUT_T) + (size_t)(master_count) * sizeof(LCEC_LAYOUT_MASTER_T) + (size_t)(slave_count) * sizeof(LCEC_LAYOUT_SLAVE_T) + \
+      (size_t)(entry_max) * sizeof(LCEC_PDO_ENTRY_DESC_T))
+#define LCEC_LAYOUT_MASTERS(layout) ((LCEC_LAYOUT_MASTER_T *)((char *)(layout) + sizeof(LCEC_LAYOUT_T)))
+#define LCEC_LAYOUT_SLAVES(layout)  ((LCEC_LAYOUT_SLAVE_T *)(LCEC_LAYOUT_MASTERS(layout) + (layout)->master_count))
+#define LCEC_LAYOUT_ENTRIES(layout) ((LCEC_PDO_ENTRY_DESC_T *)(LCEC_LAYOUT_SLAVES(layout) + (layout)->slave_count))
+
+#endif
@@ -50,6 +50,14 @@ static const lcec_pindesc_t master_pins[] = {
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
 };
 
+/// @brief Master flight recorder pins, only exported for masters with `recordDepth` set.
+static const lcec_pindesc_t master_record_pins[] = {
+    {HAL_BIT, HAL_IN, offsetof(lcec_master_data_t, record_trigger), "%s.record-trigger"},
+    {HAL_BIT, HAL_IN, offsetof(lcec_master_data_t, record_reset), "%s.record-reset"},
+    {HAL_BIT, HAL_OUT, offsetof(lcec_master_data_t, record_frozen), "%s.record-frozen"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
 /// @brief Master params
 static const lcec_pindesc_t master_params[] = {
 #ifdef RTAPI_TASK_PLL_SUPPORT
@@ -70,6 +78,15 @@ static const lcec_pindesc_t slave_pins[] = {
     {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
 };
 
+/// @brief Slave EMCY pins, only exported for slaves with `emcyQueueSize` set.
+static const lcec_pindesc_t slave_emcy_pins[] = {
+    {HAL_U32, HAL_OUT, offsetof(lcec_slave_state_t, emcy_count), "%s.%s.%s.emcy-count"},
+    {HAL_U32, HAL_OUT, offsetof(lcec_slave_state_t, emcy_error_code), "%s.%s.%s.emcy-error-code"},
+    {HAL_U32, HAL_OUT, offsetof(lcec_slave_state_t, emcy_error_reg), "%s.%s.%s.emcy-error-reg"},
+    {HAL_U32, HAL_OUT, offsetof(lcec_slave_state_t, emcy_overruns), "%s.%s.%s.emcy-overruns"},
+    {HAL_TYPE_UNSPECIFIED, HAL_DIR_UNSPECIFIED, -1, NULL},
+};
+
 static lcec_master_t *first_master = NULL;
 static lcec_master_t *last_master = NULL;
 extern int lcec_comp_id;
@@ -77,6 +94,12 @@ extern int lcec_comp_id;
 static lcec_master_data_t *global_hal_data;
 static ec_master_state_t global_ms;
 
+static int timing_shmem_id = -1;
+static LCEC_TIMING_T *timing = NULL;
+
+static int layout_shmem_id = -1;
+static LCEC_LAYOUT_T *layout = NULL;
+
 int lcec_parse_config(void);
 void lcec_clear_config(void);
 
@@ -85,11 +108,28 @@ static void lcec_request_lock(void *data);
 static void lcec_release_lock(void *data);
 #endif
 
-lcec_master_data_t *lcec_init_master_hal(const char *pfx, int global);
-lcec_slave_state_t *lcec_init_slave_state_hal(char *master_name, char *slave_name);
+lcec_master_data_t *lcec_init_master_hal(const char *pfx, int global, int record);
+lcec_slave_state_t *lcec_init_slave_state_hal(char *master_name, char *slave_name, int emcy);
 void lcec_update_master_hal(lcec_master_data_t *hal_data, ec_master_state_t *ms);
 void lcec_update_slave_state_hal(lcec_slave_state_t *hal_data, ec_slave_config_state_t *ss);
 
+static long long lcec_timing_lap(long long *start);
+void lcec_timing_init(int slave_count);
+void lcec_timing_report(long long handoff_ns, long long total_ns);
+void lcec_timing_all_op(lcec_master_t *master);
+
+void lcec_layout_init(int slave_count);
+void lcec_layout_master(lcec_master_t *master);
+void lcec_layout_done(void);
+
+int lcec_prefetch_master(lcec_master_t *master);
+int lcec_init_emcy_ring(lcec_master_t *master);
+void lcec_read_emcy(lcec_master_t *master, lcec_slave_t *slave, int check_states);
+
+int lcec_init_record(lcec_master_t *master);
+int lcec_describe_pdo_entries(lcec_master_t *master, LCEC_PDO_ENTRY_DESC_T *dst, int max, uint32_t slave_base);
+void lcec_record_cycle(lcec_master_t *master, ec_domain_state_t *ds);
+
 void lcec_read_all(void *arg, long period);
 void lcec_write_all(void *arg, long period);
 void lcec_read_master(void *arg, long period);
@@ -105,6 +145,7 @@ int rtapi_app_main(void) {
   lcec_slave_idnconf_t *idn_config;
   struct timeval tv;
   int pdo_entry_count = 0;
+  long long start_time, handoff_ns, t, slave_t;
 
   // connect to the HAL
   if ((lcec_comp_id = hal_init(LCEC_MODULE_NAME)) < 0) {
@@ -113,17 +154,23 @@ int rtapi_app_main(void) {
   }
 
   // parse configuration
+  start_time = rtapi_get_time();
   if ((slave_count = lcec_parse_config()) < 0) {
     goto fail1;
   }
+  handoff_ns = rtapi_get_time() - start_time;
+  lcec_timing_init(slave_count);
+  lcec_layout_init(slave_count);
 
   // init global hal data
-  if ((global_hal_data = lcec_init_master_hal(LCEC_MODULE_NAME, 1)) == NULL) {
+  if ((global_hal_data = lcec_init_master_hal(LCEC_MODULE_NAME, 1, 0)) == NULL) {
     goto fail2;
   }
 
   // initialize masters
   for (master = first_master; master != NULL; master = master->next) {
+    t = rtapi_get_time();
+
     // request ethercat master
     if (!(master->master = ecrt_request_master(master->index))) {
       rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "requesting master %s (index %d) failed\n", master->name, master->index);
@@ -141,16 +188,34 @@ int rtapi_app_main(void) {
       goto fail2;
     }
 
+    master->timing_ns[LCEC_TIMING_MASTER_REQUEST] = lcec_timing_lap(&t);
+
+    // issue the mailbox reads queued by preinit for all slaves at once
+    if (lcec_prefetch_master(master) != 0) {
+      goto fail2;
+    }
+    master->timing_ns[LCEC_TIMING_MASTER_PREFETCH] = lcec_timing_lap(&t);
+
     // initialize slaves
     for (slave = master->first_slave; slave != NULL; slave = slave->next) {
-      // read slave config
+      slave_t = rtapi_get_time();
 
+      // read slave config
       rtapi_print_msg(RTAPI_MSG_DBG, LCEC_MSG_PFX "calling ecrt_master_slave_config for slave %s.%s\n", master->name, slave->name);
       if (!(slave->config = ecrt_master_slave_config(master->master, 0, slave->index, slave->vid, slave->pid))) {
         rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "fail to read slave %s.%s configuration\n", master->name, slave->name);
         goto fail2;
       }
 
+      // enable emergency message queue
+      if (slave->emcy_queue_size > 0) {
+        if (ecrt_slave_config_emerg_size(slave->config, slave->emcy_queue_size) != 0) {
+          rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failed to set EMCY queue size for slave %s.%s\n", master->name, slave->name);
+          goto fail2;
+        }
+      }
+      slave->timing_ns[LCEC_TIMING_SLAVE_CONFIG] = lcec_timing_lap(&slave_t);
+
       // initialize sdos
       if (slave->sdo_config != NULL) {
         for (sdo_config = slave->sdo_config; sdo_config->index != 0xffff;
@@ -182,6 +247,8 @@ int rtapi_app_main(void) {
         }
       }
 
+      slave->timing_ns[LCEC_TIMING_SLAVE_SDO_IDN] = lcec_timing_lap(&slave_t);
+
       slave->regs = lcec_allocate_pdo_entry_reg(LCEC_MAX_PDO_REG_COUNT);
       if (slave->regs == NULL) {
         rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failure allocating PDO entries for slave %s.%s\n", master->name, slave->name);
@@ -196,6 +263,8 @@ int rtapi_app_main(void) {
           goto fail2;
         }
       }
+      lcec_prefetch_clear(slave);
+      slave->timing_ns[LCEC_TIMING_SLAVE_INIT] = lcec_timing_lap(&slave_t);
 
       // configure dc for this slave
       if (slave->dc_conf != NULL) {
@@ -221,15 +290,25 @@ int rtapi_app_main(void) {
         }
       }
 
+      slave->timing_ns[LCEC_TIMING_SLAVE_PDOS] = lcec_timing_lap(&slave_t);
+
       // export state pins
       rtapi_print_msg(RTAPI_MSG_DBG, LCEC_MSG_PFX "init slave state hal for slave %s.%s\n", master->name, slave->name);
-      if ((slave->hal_state_data = lcec_init_slave_state_hal(master->name, slave->name)) == NULL) {
+      if ((slave->hal_state_data = lcec_init_slave_state_hal(master->name, slave->name, slave->emcy_queue_size > 0)) == NULL) {
         rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failure to export slave pins for slave %s.%s\n", master->name, slave->name);
         goto fail2;
       }
 
+      slave->timing_ns[LCEC_TIMING_SLAVE_PINS] = lcec_timing_lap(&slave_t);
+
       pdo_entry_count += lcec_pdo_entry_reg_len(slave->regs);
     }
+    master->timing_ns[LCEC_TIMING_MASTER_SLAVES] = lcec_timing_lap(&t);
+
+    // setup EMCY ring, if any slave requested it
+    if (lcec_init_emcy_ring(master) != 0) {
+      goto fail2;
+    }
 
     lcec_pdo_entry_reg_t *master_regs = lcec_allocate_pdo_entry_reg(pdo_entry_count + 1);
     for (slave = master->first_slave; slave != NULL; slave = slave->next) {
@@ -245,6 +324,7 @@ int rtapi_app_main(void) {
       rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "master %s PDO entry registration failed\n", master->name);
       goto fail2;
     }
+    master->timing_ns[LCEC_TIMING_MASTER_PDO_REG] = lcec_timing_lap(&t);
 
     // initialize application time
     rtapi_print_msg(RTAPI_MSG_DBG, LCEC_MSG_PFX "Setting time\n");
@@ -266,18 +346,41 @@ int rtapi_app_main(void) {
 
     // activating master
     rtapi_print_msg(RTAPI_MSG_DBG, LCEC_MSG_PFX "Activating master\n");
+    t = rtapi_get_time();
     if (ecrt_master_activate(master->master)) {
       rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failed to activate master %s\n", master->name);
       goto fail2;
     }
+    master->timing_ns[LCEC_TIMING_MASTER_ACTIVATE] = lcec_timing_lap(&t);
+    master->activate_time = t;
+    master->timing_ns[LCEC_TIMING_MASTER_ALL_OP] = -1;
 
     // Get internal process data for domain
     master->process_data = ecrt_domain_data(master->domain);
     master->process_data_len = ecrt_domain_size(master->domain);
 
+    // publish the domain layout, needs the final PDO offsets and the slaves' sync info
+    lcec_layout_master(master);
+
+    // setup flight recorder, needs the final PDO offsets and the slaves' sync info
+    if (lcec_init_record(master) != 0) {
+      goto fail2;
+    }
+
+    // gather per-cycle slave data, and drop config that is no longer needed
+    if (lcec_master_build_slave_rt(master) != 0) {
+      goto fail2;
+    }
+    if (lcec_master_build_fsoe_routes(master) != 0) {
+      goto fail2;
+    }
+    for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+      lcec_slave_release_config(slave);
+    }
+
     // init hal data
     rtapi_snprintf(name, HAL_NAME_LEN, "%s.%s", LCEC_MODULE_NAME, master->name);
-    if ((master->hal_data = lcec_init_master_hal(name, 0)) == NULL) {
+    if ((master->hal_data = lcec_init_master_hal(name, 0, master->record != NULL)) == NULL) {
       rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "failure to init hal pins for slave %s.%s\n", master->name, slave->name);
       goto fail2;
     }
@@ -301,6 +404,7 @@ int rtapi_app_main(void) {
       rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "master %s write funct export failed\n", master->name);
       goto fail2;
     }
+    master->timing_ns[LCEC_TIMING_MASTER_PINS] = lcec_timing_lap(&t);
   }
 
   // export read-all function
@@ -317,6 +421,8 @@ int rtapi_app_main(void) {
   }
 
   rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "installed driver for %d slaves\n", slave_count);
+  lcec_timing_report(handoff_ns, rtapi_get_time() - start_time);
+  lcec_layout_done();
   hal_ready(lcec_comp_id);
   return 0;
 
@@ -450,6 +556,7 @@ int lcec_parse_config(void) {
         master->name[LCEC_CONF_STR_MAXLEN - 1] = 0;
         master->app_time_period = master_conf->appTimePeriod;
         master->sync_ref_cycles = master_conf->refClockSyncCycles;
+        master->record_depth = master_conf->recordDepth;
 
         // add master to list
         LCEC_LIST_APPEND(first_master, last_master, master);
@@ -499,6 +606,7 @@ int lcec_parse_config(void) {
         strncpy(slave->name, slave_conf->name, LCEC_CONF_STR_MAXLEN);
         slave->name[LCEC_CONF_STR_MAXLEN - 1] = 0;
         slave->master = master;
+        slave->emcy_queue_size = slave_conf->emcyQueueSize;
 
         // add slave to list
         LCEC_LIST_APPEND(master->first_slave, master->last_slave, slave);
@@ -966,30 +1074,7 @@ void lcec_clear_config(void) {
       }
 
       // free slave
-      if (slave->modparams != NULL) {
-        lcec_free(slave->modparams);
-      }
-      if (slave->sdo_config != NULL) {
-        lcec_free(slave->sdo_config);
-      }
-      if (slave->idn_config != NULL) {
-        lcec_free(slave->idn_config);
-      }
-      if (slave->generic_pdo_entries != NULL) {
-        lcec_free(slave->generic_pdo_entries);
-      }
-      if (slave->generic_pdos != NULL) {
-        lcec_free(slave->generic_pdos);
-      }
-      if (slave->generic_sync_managers != NULL) {
-        lcec_free(slave->generic_sync_managers);
-      }
-      if (slave->dc_conf != NULL) {
-        lcec_free(slave->dc_conf);
-      }
-      if (slave->wd_conf != NULL) {
-        lcec_free(slave->wd_conf);
-      }
+      lcec_slave_release_config(slave);
       lcec_free(slave);
       slave = prev_slave;
     }
@@ -999,6 +1084,16 @@ void lcec_clear_config(void) {
       ecrt_release_master(master->master);
     }
 
+    // free EMCY ring
+    if (master->emcy_ring != NULL) {
+      rtapi_shmem_delete(master->emcy_shmem_id, lcec_comp_id);
+    }
+
+    // free flight recorder
+    if (master->record != NULL) {
+      rtapi_shmem_delete(master->record_shmem_id, lcec_comp_id);
+    }
+
     // free PDO entry memory
     if (master->pdo_entry_regs != NULL) {
       lcec_free(master->pdo_entry_regs);
@@ -1008,6 +1103,20 @@ void lcec_clear_config(void) {
     lcec_free(master);
     master = prev_master;
   }
+
+  // release timing report
+  if (timing_shmem_id >= 0) {
+    rtapi_shmem_delete(timing_shmem_id, lcec_comp_id);
+    timing_shmem_id = -1;
+    timing = NULL;
+  }
+
+  // release layout report
+  if (layout_shmem_id >= 0) {
+    rtapi_shmem_delete(layout_shmem_id, lcec_comp_id);
+    layout_shmem_id = -1;
+    layout = NULL;
+  }
 }
 
 #ifdef __KERNEL__
@@ -1025,7 +1134,7 @@ static void lcec_release_lock(void *data) {
 #endif
 
 /// @brief Initialize LinuxCNC HAL pins for the master device.
-lcec_master_data_t *lcec_init_master_hal(const char *pfx, int global) {
+lcec_master_data_t *lcec_init_master_hal(const char *pfx, int global, int record) {
   lcec_master_data_t *hal_data;
 
   // alloc hal data
@@ -1047,12 +1156,17 @@ lcec_master_data_t *lcec_init_master_hal(const char *pfx, int global) {
       return NULL;
     }
   }
+  if (record) {
+    if (lcec_pin_newf_list(hal_data, master_record_pins, pfx) != 0) {
+      return NULL;
+    }
+  }
 
   return hal_data;
 }
 
 /// @brief Initialize generic LinuxCNC HAL pins for a slave
-lcec_slave_state_t *lcec_init_slave_state_hal(char *master_name, char *slave_name) {
+lcec_slave_state_t *lcec_init_slave_state_hal(char *master_name, char *slave_name, int emcy) {
   lcec_slave_state_t *hal_data;
 
   // alloc hal data
@@ -1066,10 +1180,573 @@ lcec_slave_state_t *lcec_init_slave_state_hal(char *master_name, char *slave_nam
   if (lcec_pin_newf_list(hal_data, slave_pins, LCEC_MODULE_NAME, master_name, slave_name) != 0) {
     return NULL;
   }
+  if (emcy) {
+    if (lcec_pin_newf_list(hal_data, slave_emcy_pins, LCEC_MODULE_NAME, master_name, slave_name) != 0) {
+      return NULL;
+    }
+  }
 
   return hal_data;
 }
 
+// returns the time since *start and restarts the measurement
+static long long lcec_timing_lap(long long *start) {
+  long long now = rtapi_get_time();
+  long long lap = now - *start;
+
+  *start = now;
+  return lap;
+}
+
+/// @brief Attach to the startup timing block created by `lcec_conf`.
+///
+/// The block is optional; without it (for example with an older
+/// `lcec_conf`) timings are only logged.
+void lcec_timing_init(int slave_count) {
+  lcec_master_t *master;
+  lcec_slave_t *slave;
+  LCEC_TIMING_MASTER_T *tm;
+  LCEC_TIMING_SLAVE_T *ts;
+  int master_count = 0;
+  void *shmem_ptr;
+
+  for (master = first_master; master != NULL; master = master->next) {
+    master_count++;
+  }
+
+  // map the timing block
+  if ((timing_shmem_id = rtapi_shmem_new(LCEC_TIMING_SHMEM_KEY, lcec_comp_id, LCEC_TIMING_BYTES(master_count, slave_count))) < 0) {
+    timing_shmem_id = -1;
+    return;
+  }
+  if (lcec_rtapi_shmem_getptr(timing_shmem_id, &shmem_ptr) < 0) {
+    goto fail;
+  }
+  timing = shmem_ptr;
+  if (timing->magic != LCEC_TIMING_SHMEM_MAGIC || timing->master_count != master_count || timing->slave_count != slave_count) {
+    goto fail;
+  }
+
+  // assign records in config order
+  tm = LCEC_TIMING_MASTERS(timing);
+  ts = LCEC_TIMING_SLAVES(timing);
+  for (master = first_master; master != NULL; master = master->next, tm++) {
+    master->timing = tm;
+    tm->index = master->index;
+    strncpy(tm->name, master->name, LCEC_CONF_STR_MAXLEN);
+    tm->first_slave = ts - LCEC_TIMING_SLAVES(timing);
+    tm->slave_count = 0;
+    for (slave = master->first_slave; slave != NULL; slave = slave->next, ts++) {
+      ts->index = slave->index;
+      strncpy(ts->name, slave->name, LCEC_CONF_STR_MAXLEN);
+      tm->slave_count++;
+    }
+  }
+  return;
+
+fail:
+  rtapi_shmem_delete(timing_shmem_id, lcec_comp_id);
+  timing_shmem_id = -1;
+  timing = NULL;
+}
+
+/// @brief Log the startup timing summary and publish it to `lcec_conf`.
+///
+/// Each line is a list of `phase=<microseconds>us` pairs, one line for
+/// the whole startup, one per master, and one per slave.
+void lcec_timing_report(long long handoff_ns, long long total_ns) {
+  static const char *master_phases[] = LCEC_TIMING_MASTER_PHASE_NAMES;
+  static const char *slave_phases[] = LCEC_TIMING_SLAVE_PHASE_NAMES;
+  lcec_master_t *master;
+  lcec_slave_t *slave;
+  LCEC_TIMING_SLAVE_T *ts;
+  char line[256];
+  int len, i;
+
+  if (timing != NULL) {
+    rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "startup timing: parse=%lldus handoff=%lldus total=%lldus\n", timing->parse_ns / 1000,
+        handoff_ns / 1000, total_ns / 1000);
+    timing->handoff_ns = handoff_ns;
+    timing->total_ns = total_ns;
+  } else {
+    rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "startup timing: handoff=%lldus total=%lldus\n", handoff_ns / 1000, total_ns / 1000);
+  }
+
+  for (master = first_master; master != NULL; master = master->next) {
+    // all_op is reported once it happens
+    len = rtapi_snprintf(line, sizeof(line), "master=%s", master->name);
+    for (i = 0; i < LCEC_TIMING_MASTER_ALL_OP && len < sizeof(line); i++) {
+      len += rtapi_snprintf(line + len, sizeof(line) - len, " %s=%lldus", master_phases[i], master->timing_ns[i] / 1000);
+    }
+    rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "startup timing: %s\n", line);
+    if (master->timing != NULL) {
+      memcpy(master->timing->phase_ns, master->timing_ns, sizeof(master->timing_ns));
+    }
+
+    ts = (master->timing != NULL) ? &LCEC_TIMING_SLAVES(timing)[master->timing->first_slave] : NULL;
+    for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+      len = rtapi_snprintf(line, sizeof(line), "master=%s slave=%s position=%d", master->name, slave->name, slave->index);
+      for (i = 0; i < LCEC_TIMING_SLAVE_PHASES && len < sizeof(line); i++) {
+        len += rtapi_snprintf(line + len, sizeof(line) - len, " %s=%lldus", slave_phases[i], slave->timing_ns[i] / 1000);
+      }
+      rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "startup timing: %s\n", line);
+      if (ts != NULL) {
+        memcpy(ts->phase_ns, slave->timing_ns, sizeof(slave->timing_ns));
+        ts++;
+      }
+    }
+  }
+
+  if (timing != NULL) {
+    lcec_wmb();
+    timing->init_done = 1;
+  }
+}
+
+/// @brief Record that a master reached OP for the first time.
+void lcec_timing_all_op(lcec_master_t *master) {
+  master->timing_ns[LCEC_TIMING_MASTER_ALL_OP] = rtapi_get_time() - master->activate_time;
+  rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "startup timing: master=%s all_op=%lldus\n", master->name,
+      master->timing_ns[LCEC_TIMING_MASTER_ALL_OP] / 1000);
+  if (master->timing != NULL) {
+    master->timing->phase_ns[LCEC_TIMING_MASTER_ALL_OP] = master->timing_ns[LCEC_TIMING_MASTER_ALL_OP];
+  }
+}
+
+/// @brief Shared state for the mailbox prefetch workers of one master.
+typedef struct {
+  lcec_slave_t **slaves;
+  int count;
+  volatile int next;
+} lcec_prefetch_ctx_t;
+
+static void *lcec_prefetch_worker(void *arg) {
+  lcec_prefetch_ctx_t *ctx = (lcec_prefetch_ctx_t *)arg;
+  int i;
+
+  // each worker handles one slave at a time, so no slave ever has more than one request outstanding
+  while ((i = __sync_fetch_and_add(&ctx->next, 1)) < ctx->count) {
+    lcec_prefetch_exec(ctx->slaves[i]);
+  }
+
+  return NULL;
+}
+
+/// @brief Issue all mailbox reads queued by the slaves' `proc_preinit`.
+///
+/// Mailbox round-trips to different slaves overlap, so startup time
+/// is bounded by the slowest slave instead of the sum of all slaves.
+/// Up to `LCEC_PREFETCH_MAX_THREADS` slaves are in flight at once.
+/// Where threads aren't available, the reads are done inline.
+int lcec_prefetch_master(lcec_master_t *master) {
+  lcec_prefetch_ctx_t ctx;
+  lcec_thread_t threads[LCEC_PREFETCH_MAX_THREADS];
+  lcec_slave_t *slave;
+  int thread_count, i;
+
+  // collect slaves with queued reads
+  ctx.count = 0;
+  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+    if (slave->mbx_reads != NULL) {
+      ctx.count++;
+    }
+  }
+  if (ctx.count == 0) {
+    return 0;
+  }
+
+  if ((ctx.slaves = lcec_zalloc(sizeof(lcec_slave_t *) * ctx.count)) == NULL) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "Unable to allocate prefetch slave list for master %s\n", master->name);
+    return -1;
+  }
+  for (i = 0, slave = master->first_slave; slave != NULL; slave = slave->next) {
+    if (slave->mbx_reads != NULL) {
+      ctx.slaves[i++] = slave;
+    }
+  }
+  ctx.next = 0;
+
+  // start workers, and pitch in ourselves
+  for (thread_count = 0; thread_count < ctx.count - 1 && thread_count < LCEC_PREFETCH_MAX_THREADS; thread_count++) {
+    if (lcec_thread_create(&threads[thread_count], lcec_prefetch_worker, &ctx) != 0) {
+      break;
+    }
+  }
+  lcec_prefetch_worker(&ctx);
+  for (i = 0; i < thread_count; i++) {
+    lcec_thread_join(threads[i]);
+  }
+
+  rtapi_print_msg(RTAPI_MSG_DBG, LCEC_MSG_PFX "prefetched mailbox data for %d slaves on master %s using %d threads\n", ctx.count,
+      master->name, thread_count + 1);
+  lcec_free(ctx.slaves);
+  return 0;
+}
+
+/// @brief Create the shared memory EMCY ring for a master.
+///
+/// The ring is only created if at least one slave on the master has
+/// EMCY capture enabled via `emcyQueueSize`.
+int lcec_init_emcy_ring(lcec_master_t *master) {
+  lcec_slave_t *slave;
+  void *shmem_ptr;
+
+  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+    if (slave->emcy_queue_size > 0) {
+      break;
+    }
+  }
+  if (slave == NULL) {
+    return 0;
+  }
+
+  master->emcy_shmem_id = rtapi_shmem_new(LCEC_EMCY_SHMEM_KEY(master->index), lcec_comp_id, LCEC_EMCY_RING_BYTES(LCEC_EMCY_RING_SIZE));
+  if (master->emcy_shmem_id < 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "couldn't allocate EMCY shared memory for master %s\n", master->name);
+    return -1;
+  }
+  if (lcec_rtapi_shmem_getptr(master->emcy_shmem_id, &shmem_ptr) < 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "couldn't map EMCY shared memory for master %s\n", master->name);
+    rtapi_shmem_delete(master->emcy_shmem_id, lcec_comp_id);
+    return -1;
+  }
+
+  master->emcy_ring = shmem_ptr;
+  memset(master->emcy_ring, 0, LCEC_EMCY_RING_BYTES(LCEC_EMCY_RING_SIZE));
+  master->emcy_ring->size = LCEC_EMCY_RING_SIZE;
+  master->emcy_ring->master_index = master->index;
+  lcec_wmb();
+  master->emcy_ring->magic = LCEC_EMCY_SHMEM_MAGIC;
+
+  return 0;
+}
+
+/// @brief Collect pending EMCY messages for a slave.
+///
+/// Pops all messages queued by EtherLab, updates the slave's EMCY
+/// pins and appends each message to the master's ring.  Readers only
+/// see a message after `head` has been advanced past it.
+void lcec_read_emcy(lcec_master_t *master, lcec_slave_t *slave, int check_states) {
+  LCEC_EMCY_RING_T *ring = master->emcy_ring;
+  lcec_slave_state_t *hal_data = slave->hal_state_data;
+  LCEC_EMCY_MSG_T *msg;
+  uint8_t data[EC_COE_EMERGENCY_MSG_SIZE];
+  uint64_t timestamp;
+  int overruns;
+  int ret;
+
+  timestamp = lcec_master_app_time(master);
+  while (1) {
+    rtapi_mutex_get(&master->mutex);
+    ret = ecrt_slave_config_emerg_pop(slave->config, data);
+    rtapi_mutex_give(&master->mutex);
+    if (ret != 0) {
+      break;
+    }
+
+    *(hal_data->emcy_error_code) = EC_READ_U16(&data[0]);
+    *(hal_data->emcy_error_reg) = EC_READ_U8(&data[2]);
+    (*(hal_data->emcy_count))++;
+
+    msg = &ring->msgs[ring->head & (ring->size - 1)];
+    msg->timestamp = timestamp;
+    msg->slave_index = slave->index;
+    msg->error_code = EC_READ_U16(&data[0]);
+    msg->error_reg = EC_READ_U8(&data[2]);
+    memcpy(msg->data, &data[3], LCEC_EMCY_DATA_LEN);
+    lcec_wmb();
+    ring->head++;
+  }
+
+  if (check_states) {
+    rtapi_mutex_get(&master->mutex);
+    overruns = ecrt_slave_config_emerg_overruns(slave->config);
+    rtapi_mutex_give(&master->mutex);
+    if (overruns >= 0) {
+      *(hal_data->emcy_overruns) = overruns;
+    }
+  }
+}
+
+/// @brief Find the bit length of a PDO entry in a slave's sync config.
+///
+/// @return The length in bits, or 0 if the slave doesn't have a sync
+/// config or the entry isn't in it.
+static int lcec_pdo_entry_bit_len(lcec_slave_t *slave, uint16_t index, uint8_t subindex) {
+  const ec_sync_info_t *sync;
+  const ec_pdo_info_t *pdo;
+  const ec_pdo_entry_info_t *entry;
+  unsigned int i, j;
+
+  if (slave->sync_info == NULL) {
+    return 0;
+  }
+  for (sync = slave->sync_info; sync->index != 0xff; sync++) {
+    for (i = 0, pdo = sync->pdos; pdo != NULL && i < sync->n_pdos; i++, pdo++) {
+      for (j = 0, entry = pdo->entries; entry != NULL && j < pdo->n_entries; j++, entry++) {
+        if (entry->index == index && entry->subindex == subindex) {
+          return entry->bit_length;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+/// @brief Describe the registered PDO entries of a master for userspace tools.
+///
+/// Fills in the final offset of every registered entry, so it must be
+/// called after PDO registration and activation, and before the
+/// slaves' sync info is released.
+///
+/// @param master The master.
+/// @param dst Where to put the descriptions, in slave and registration order.
+/// @param max Room in `dst`.  Further entries are skipped.
+/// @param slave_base Value of `slave` for the master's first slave, counting up from there.
+/// @return The number of entries written to `dst`.
+int lcec_describe_pdo_entries(lcec_master_t *master, LCEC_PDO_ENTRY_DESC_T *dst, int max, uint32_t slave_base) {
+  lcec_slave_t *slave;
+  ec_pdo_entry_reg_t *reg;
+  uint32_t slave_idx;
+  int i, count = 0;
+
+  for (slave = master->first_slave, slave_idx = slave_base; slave != NULL; slave = slave->next, slave_idx++) {
+    for (i = 0, reg = slave->regs->pdo_entry_regs; i < slave->regs->current && count < max; i++, reg++, count++, dst++) {
+      dst->slave = slave_idx;
+      dst->offset = *(reg->offset);
+      dst->index = reg->index;
+      dst->subindex = reg->subindex;
+      dst->bit_pos = (reg->bit_position != NULL) ? *(reg->bit_position) : 0;
+      dst->bit_len = lcec_pdo_entry_bit_len(slave, reg->index, reg->subindex);
+    }
+  }
+
+  return count;
+}
+
+/// @brief Attach to the PDO layout block created by `lcec_conf -l`.
+///
+/// Like the timing block, the layout block is optional and only
+/// exists if a layout report was requested.
+void lcec_layout_init(int slave_count) {
+  lcec_master_t *master;
+  lcec_slave_t *slave;
+  LCEC_LAYOUT_MASTER_T *lm;
+  LCEC_LAYOUT_SLAVE_T *ls;
+  int master_count = 0;
+  int entry_max = slave_count * LCEC_MAX_PDO_REG_COUNT;
+  void *shmem_ptr;
+
+  for (master = first_master; master != NULL; master = master->next) {
+    master_count++;
+  }
+
+  // map the layout block
+  layout_shmem_id = rtapi_shmem_new(LCEC_LAYOUT_SHMEM_KEY, lcec_comp_id, LCEC_LAYOUT_BYTES(master_count, slave_count, entry_max));
+  if (layout_shmem_id < 0) {
+    layout_shmem_id = -1;
+    return;
+  }
+  if (lcec_rtapi_shmem_getptr(layout_shmem_id, &shmem_ptr) < 0) {
+    goto fail;
+  }
+  layout = shmem_ptr;
+  if (layout->magic != LCEC_LAYOUT_SHMEM_MAGIC || layout->master_count != master_count || layout->slave_count != slave_count ||
+      layout->entry_max != entry_max) {
+    goto fail;
+  }
+
+  // assign records in config order
+  lm = LCEC_LAYOUT_MASTERS(layout);
+  ls = LCEC_LAYOUT_SLAVES(layout);
+  for (master = first_master; master != NULL; master = master->next, lm++) {
+    lm->index = master->index;
+    strncpy(lm->name, master->name, LCEC_CONF_STR_MAXLEN);
+    lm->first_slave = ls - LCEC_LAYOUT_SLAVES(layout);
+    lm->slave_count = 0;
+    for (slave = master->first_slave; slave != NULL; slave = slave->next, ls++) {
+      ls->index = slave->index;
+      strncpy(ls->name, slave->name, LCEC_CONF_STR_MAXLEN);
+      lm->slave_count++;
+    }
+  }
+  return;
+
+fail:
+  rtapi_shmem_delete(layout_shmem_id, lcec_comp_id);
+  layout_shmem_id = -1;
+  layout = NULL;
+}
+
+/// @brief Record the domain size and final PDO entry offsets of a master.
+///
+/// Must be called after PDO registration and activation, and before
+/// the slaves' sync info is released.
+void lcec_layout_master(lcec_master_t *master) {
+  LCEC_LAYOUT_MASTER_T *lm;
+  lcec_slave_t *slave;
+  int i, total;
+
+  if (layout == NULL) {
+    return;
+  }
+
+  // find this master's record
+  for (i = 0, lm = LCEC_LAYOUT_MASTERS(layout); i < layout->master_count; i++, lm++) {
+    if (lm->index == master->index) {
+      break;
+    }
+  }
+  if (i == layout->master_count) {
+    return;
+  }
+
+  total = 0;
+  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+    total += lcec_pdo_entry_reg_len(slave->regs);
+  }
+
+  lm->domain_size = master->process_data_len;
+  lm->first_entry = layout->entry_count;
+  lm->entry_count = lcec_describe_pdo_entries(
+      master, &LCEC_LAYOUT_ENTRIES(layout)[layout->entry_count], layout->entry_max - layout->entry_count, lm->first_slave);
+  layout->entry_count += lm->entry_count;
+  layout->entries_dropped += total - lm->entry_count;
+}
+
+/// @brief Tell `lcec_conf` that the layout block is complete.
+void lcec_layout_done(void) {
+  if (layout != NULL) {
+    lcec_wmb();
+    layout->init_done = 1;
+  }
+}
+
+/// @brief Create the shared memory flight recorder for a master.
+///
+/// Only done if the master has `recordDepth` set.  Must be called
+/// after PDO registration and activation, since it records the final
+/// offset of every registered PDO entry and the size of the process
+/// data.
+int lcec_init_record(lcec_master_t *master) {
+  lcec_slave_t *slave;
+  LCEC_RECORD_T *rec;
+  LCEC_RECORD_SLAVE_T *rs;
+  uint32_t slave_count = 0, entry_count = 0;
+  size_t length;
+  void *shmem_ptr;
+
+  if (master->record_depth == 0) {
+    return 0;
+  }
+
+  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+    slave_count++;
+    entry_count += lcec_pdo_entry_reg_len(slave->regs);
+  }
+  length = LCEC_RECORD_BYTES(slave_count, entry_count, master->record_depth, master->process_data_len);
+
+  master->record_shmem_id = rtapi_shmem_new(LCEC_RECORD_SHMEM_KEY(master->index), lcec_comp_id, length);
+  if (master->record_shmem_id < 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "couldn't allocate flight recorder shared memory for master %s\n", master->name);
+    return -1;
+  }
+  if (lcec_rtapi_shmem_getptr(master->record_shmem_id, &shmem_ptr) < 0) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "couldn't map flight recorder shared memory for master %s\n", master->name);
+    rtapi_shmem_delete(master->record_shmem_id, lcec_comp_id);
+    return -1;
+  }
+
+  rec = shmem_ptr;
+  memset(rec, 0, length);
+  rec->length = length;
+  rec->master_index = master->index;
+  rec->depth = master->record_depth;
+  rec->data_len = master->process_data_len;
+  rec->frame_size = LCEC_RECORD_FRAME_BYTES(master->process_data_len);
+  rec->slave_count = slave_count;
+  rec->entry_count = entry_count;
+  rec->state = LCEC_RECORD_RUNNING;
+
+  // describe the process data layout for lcec_dump
+  rs = LCEC_RECORD_SLAVES(rec);
+  for (slave = master->first_slave; slave != NULL; slave = slave->next, rs++) {
+    rs->index = slave->index;
+    rs->vid = slave->vid;
+    rs->pid = slave->pid;
+    strncpy(rs->name, slave->name, LCEC_CONF_STR_MAXLEN);
+    rs->name[LCEC_CONF_STR_MAXLEN - 1] = 0;
+  }
+  lcec_describe_pdo_entries(master, LCEC_RECORD_ENTRIES(rec), entry_count, 0);
+
+  master->record = rec;
+  master->record_frames = (uint8_t *)LCEC_RECORD_FRAME(rec, 0);
+  master->record_pos = 0;
+  lcec_wmb();
+  rec->magic = LCEC_RECORD_SHMEM_MAGIC;
+
+  rtapi_print_msg(RTAPI_MSG_INFO, LCEC_MSG_PFX "flight recorder for master %s: %u frames of %u bytes\n", master->name, rec->depth,
+      rec->data_len);
+  return 0;
+}
+
+/// @brief Record one cycle of process data into the master's flight recorder.
+///
+/// Called from the read function right after the domain has been
+/// processed.  Copies the whole process image with a single
+/// `memcpy()`, unless the recorder is frozen.  Freezes on a rising
+/// edge of `record-trigger`, or when the bus goes from healthy to
+/// faulted (incomplete working counter, link down, or not all slaves
+/// in OP) after it first reached OP.  A rising edge of `record-reset`
+/// restarts capture.  The caller refreshes `master->ms` every cycle
+/// while the recorder is enabled, so all fault triggers fire on the
+/// cycle they happen in.
+void lcec_record_cycle(lcec_master_t *master, ec_domain_state_t *ds) {
+  LCEC_RECORD_T *rec = master->record;
+  lcec_master_data_t *hal_data = master->hal_data;
+  LCEC_RECORD_FRAME_T *frame;
+  int trigger, reset, fault;
+
+  trigger = *(hal_data->record_trigger);
+  reset = *(hal_data->record_reset);
+  fault = master->timing_ns[LCEC_TIMING_MASTER_ALL_OP] >= 0 &&
+          (ds->wc_state != EC_WC_COMPLETE || !master->ms.link_up || master->ms.al_states != 0x08);
+
+  if (reset && !master->record_reset_last) {
+    rec->state = LCEC_RECORD_RUNNING;
+  }
+
+  if (rec->state == LCEC_RECORD_RUNNING) {
+    frame = (LCEC_RECORD_FRAME_T *)(master->record_frames + (size_t)master->record_pos * rec->frame_size);
+    frame->timestamp = lcec_master_app_time(master);
+    frame->seq = rec->head;
+    frame->working_counter = ds->working_counter;
+    frame->slaves_responding = master->ms.slaves_responding;
+    frame->wc_state = ds->wc_state;
+    frame->al_states = master->ms.al_states;
+    frame->link_up = master->ms.link_up;
+    memcpy(frame->data, master->process_data, rec->data_len);
+    lcec_wmb();
+    rec->head++;
+    if (++master->record_pos >= rec->depth) {
+      master->record_pos = 0;
+    }
+
+    // freeze after recording the cycle that triggered it
+    if (trigger && !master->record_trigger_last) {
+      rec->state = LCEC_RECORD_TRIGGER;
+    } else if (fault && !master->record_fault_last) {
+      rec->state = LCEC_RECORD_FAULT;
+    }
+  }
+
+  master->record_trigger_last = trigger;
+  master->record_reset_last = reset;
+  master->record_fault_last = fault;
+  *(hal_data->record_frozen) = (rec->state != LCEC_RECORD_RUNNING);
+}
+
 /// @brief Update HAL pins for the master.
 void lcec_update_master_hal(lcec_master_data_t *hal_data, ec_master_state_t *ms) {
   *(hal_data->slaves_responding) = ms->slaves_responding;
@@ -1122,7 +1799,8 @@ void lcec_write_all(void *arg, long period) {
 /// @brief Read all input pins on a master and its slaves.
 void lcec_read_master(void *arg, long period) {
   lcec_master_t *master = (lcec_master_t *)arg;
-  lcec_slave_t *slave;
+  lcec_slave_rt_t *rt, *rt_end;
+  ec_domain_state_t ds;
   int check_states;
 
   // check period
@@ -1134,6 +1812,13 @@ void lcec_read_master(void *arg, long period) {
     }
   }
 
+#ifdef RTAPI_TASK_PLL_SUPPORT
+  // advance the application time base, see `lcec_master_app_time()`
+  if (master->sync_ref_cycles < 0) {
+    master->dc_ref += period;
+  }
+#endif
+
   // get state check flag
   if (master->state_update_timer > 0) {
     check_states = 0;
@@ -1147,11 +1832,25 @@ void lcec_read_master(void *arg, long period) {
   rtapi_mutex_get(&master->mutex);
   ecrt_master_receive(master->master);
   ecrt_domain_process(master->domain);
-  if (check_states) {
+  if (check_states || master->timing_ns[LCEC_TIMING_MASTER_ALL_OP] < 0 || master->record != NULL) {
+    // the flight recorder needs a fresh link and AL state every cycle to catch faults
     ecrt_master_state(master->master, &master->ms);
   }
+  if (master->record != NULL) {
+    ecrt_domain_state(master->domain, &ds);
+  }
   rtapi_mutex_give(&master->mutex);
 
+  // snapshot the process data before any slave touches it
+  if (master->record != NULL) {
+    lcec_record_cycle(master, &ds);
+  }
+
+  // record when the master first reaches OP; the state is checked every cycle until then
+  if (master->timing_ns[LCEC_TIMING_MASTER_ALL_OP] < 0 && master->ms.al_states == 0x08) {
+    lcec_timing_all_op(master);
+  }
+
   // update state pins
   lcec_update_master_hal(master->hal_data, &master->ms);
 
@@ -1160,21 +1859,31 @@ void lcec_read_master(void *arg, long period) {
   global_ms.al_states |= master->ms.al_states;
   global_ms.link_up = global_ms.link_up && master->ms.link_up;
 
+  // pass safety frames between safety slaves and logic devices
+  if (master->fsoe_route_count > 0) {
+    lcec_master_route_fsoe(master);
+  }
+
   // process slaves
-  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
+  for (rt = master->slave_rt, rt_end = rt + master->slave_rt_count; rt < rt_end; rt++) {
     // get slaves state
     rtapi_mutex_get(&master->mutex);
     if (check_states) {
-      ecrt_slave_config_state(slave->config, &slave->state);
+      ecrt_slave_config_state(rt->config, &rt->slave->state);
     }
     rtapi_mutex_give(&master->mutex);
     if (check_states) {
-      lcec_update_slave_state_hal(slave->hal_state_data, &slave->state);
+      lcec_update_slave_state_hal(rt->hal_state_data, &rt->slave->state);
+    }
+
+    // collect emergency messages
+    if (rt->emcy_queue_size > 0) {
+      lcec_read_emcy(master, rt->slave, check_states);
     }
 
     // process read function
-    if (slave->proc_read != NULL) {
-      slave->proc_read(slave, period);
+    if (rt->proc_read != NULL) {
+      rt->proc_read(rt->slave, period);
     }
   }
 }
@@ -1182,45 +1891,27 @@ void lcec_read_master(void *arg, long period) {
 /// @brief Write all output pins on a master and its slaves.
 void lcec_write_master(void *arg, long period) {
   lcec_master_t *master = (lcec_master_t *)arg;
-  lcec_slave_t *slave;
+  lcec_slave_rt_t *rt, *rt_end;
   uint64_t app_time;
-  long long now;
 #ifdef RTAPI_TASK_PLL_SUPPORT
-  long long ref;
   uint32_t dc_time;
   int dc_time_valid;
   lcec_master_data_t *hal_data;
 #endif
 
   // process slaves
-  for (slave = master->first_slave; slave != NULL; slave = slave->next) {
-    if (slave->proc_write != NULL) {
-      slave->proc_write(slave, period);
+  for (rt = master->slave_rt, rt_end = rt + master->slave_rt_count; rt < rt_end; rt++) {
+    if (rt->proc_write != NULL) {
+      rt->proc_write(rt->slave, period);
     }
   }
 
-#ifdef RTAPI_TASK_PLL_SUPPORT
-  // get reference time
-  ref = rtapi_task_pll_get_reference();
-#endif
-
   // send process data
   rtapi_mutex_get(&master->mutex);
   ecrt_domain_queue(master->domain);
 
   // update application time
-  now = rtapi_get_time();
-#ifdef RTAPI_TASK_PLL_SUPPORT
-  if (master->sync_ref_cycles >= 0) {
-    app_time = master->app_time_base + now;
-  } else {
-    master->dc_ref += period;
-    app_time = master->app_time_base + master->dc_ref + (now - ref);
-  }
-#else
-  app_time = master->app_time_base + now;
-#endif
-
+  app_time = lcec_master_app_time(master);
   ecrt_master_application_time(master->master, app_time);
 
   // sync ref clock to master
@@ -1273,7 +1964,8 @@ void lcec_write_master(void *arg, long period) {
   }
 
   rtapi_task_pll_set_correction(*(hal_data->pll_out));
-  master->app_time_last = (uint32_t)app_time;
   master->dc_time_valid_last = dc_time_valid;
 #endif
+
+  master->app_time_last = (uint32_t)app_time;
 }
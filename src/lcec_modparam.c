@@ -31,6 +31,47 @@ int lcec_modparam_desc_len(const lcec_modparam_desc_t *mp) {
   return l;
 }
 
+/// @brief Find the `lcec_modparam_desc_t` that matches a `<modParam>` name.
+///
+/// Exact matches win.  Otherwise, a name of the form `ch<N>foo`
+/// matches an entry named `foo` with more than N `channels`.
+///
+/// @param mp The modparams to search.
+/// @param name The name from the XML.
+/// @param id Set to the modparam's ID, adjusted for the channel.
+/// @return The matching entry, or NULL if there isn't one.
+const lcec_modparam_desc_t *lcec_modparam_desc_find(const lcec_modparam_desc_t *mp, const char *name, int *id) {
+  const lcec_modparam_desc_t *p;
+  const char *suffix;
+  int channel;
+
+  for (p = mp; p->name != NULL; p++) {
+    if (strcmp(name, p->name) == 0) {
+      *id = p->id;
+      return p;
+    }
+  }
+
+  // try `ch<N>` plus the base name
+  if (name[0] != 'c' || name[1] != 'h' || name[2] < '0' || name[2] > '9') {
+    return NULL;
+  }
+  channel = 0;
+  for (suffix = name + 2; *suffix >= '0' && *suffix <= '9'; suffix++) {
+    channel = channel * 10 + (*suffix - '0');
+    if (channel > 255) return NULL;
+  }
+
+  for (p = mp; p->name != NULL; p++) {
+    if (channel < p->channels && strcmp(suffix, p->name) == 0) {
+      *id = p->id + channel;
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
 lcec_modparam_desc_t *lcec_modparam_desc_concat(lcec_modparam_desc_t const *a, lcec_modparam_desc_t const *b) {
   int a_len, b_len, i;
   lcec_modparam_desc_t *c;
@@ -18,50 +18,172 @@
 
 /// @file
 /// @brief HAL Pin registration code
+///
+/// Nearly every pin and param name starts with
+/// `lcec.<master>.<slave>.`, and drivers register them from
+/// `lcec_pindesc_t` tables whose formats begin with `%s.%s.%s.`.  The
+/// list functions below format that prefix once per list and only
+/// append each entry's suffix, instead of running printf over the full
+/// name for every pin.  Drivers that register many lists for the same
+/// slave can use a `lcec_pinbuilder_t` to format the prefix once for
+/// all of them.
 
 #include "lcec.h"
 
+#define LCEC_PIN_PREFIX_FMT     "%s.%s.%s."
+#define LCEC_PIN_PREFIX_FMT_LEN 9
+
 static int lcec_pin_newfv(hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr, const char *fmt, va_list ap);
 static int lcec_pin_newfv_list(void *base, const lcec_pindesc_t *list, va_list ap);
+static int lcec_param_newfv(hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *fmt, va_list ap);
+static int lcec_param_newfv_list(void *base, const lcec_pindesc_t *list, va_list ap);
 extern int lcec_comp_id;
 
-static int lcec_pin_newfv(hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr, const char *fmt, va_list ap) {
-  char name[HAL_NAME_LEN + 1];
-  int sz;
-  int err;
-
-  sz = rtapi_vsnprintf(name, sizeof(name), fmt, ap);
-  if (sz == -1 || sz > HAL_NAME_LEN) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "length %d too long for name starting '%s'\n", sz, name);
-    return -ENOMEM;
-  }
-
-  err = hal_pin_new(name, type, dir, data_ptr_addr, lcec_comp_id);
-  if (err) {
-    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "exporting pin %s failed\n", name);
-    return err;
-  }
-
+static void lcec_pin_clear(hal_type_t type, void *data) {
   switch (type) {
     case HAL_BIT:
-      **((hal_bit_t **)data_ptr_addr) = 0;
+      *((hal_bit_t *)data) = 0;
       break;
     case HAL_FLOAT:
-      **((hal_float_t **)data_ptr_addr) = 0.0;
+      *((hal_float_t *)data) = 0.0;
       break;
     case HAL_S32:
-      **((hal_s32_t **)data_ptr_addr) = 0;
+      *((hal_s32_t *)data) = 0;
       break;
     case HAL_U32:
-      **((hal_u32_t **)data_ptr_addr) = 0;
+      *((hal_u32_t *)data) = 0;
+      break;
+    case HAL_S64:
+      *((hal_s64_t *)data) = 0;
+      break;
+    case HAL_U64:
+      *((hal_u64_t *)data) = 0;
       break;
     default:
       break;
   }
+}
+
+static int lcec_pin_register(const char *name, hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr) {
+  int err;
+
+  err = hal_pin_new(name, type, dir, data_ptr_addr, lcec_comp_id);
+  if (err) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "exporting pin %s failed\n", name);
+    return err;
+  }
+
+  lcec_pin_clear(type, *data_ptr_addr);
+  return 0;
+}
+
+static int lcec_param_register(const char *name, hal_type_t type, hal_pin_dir_t dir, void *data_addr) {
+  int err;
+
+  err = hal_param_new(name, type, dir, data_addr, lcec_comp_id);
+  if (err) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "exporting param %s failed\n", name);
+    return err;
+  }
+
+  lcec_pin_clear(type, data_addr);
+  return 0;
+}
+
+static int lcec_pinbuilder_set(lcec_pinbuilder_t *pb, const char *module, const char *master, const char *slave, const char *pfx) {
+  int sz;
+
+  sz = rtapi_snprintf(pb->name, sizeof(pb->name), "%s.%s.%s.%s", module, master, slave, (pfx != NULL) ? pfx : "");
+  if (sz < 0 || sz > HAL_NAME_LEN) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "length %d too long for name starting '%s'\n", sz, pb->name);
+    return -ENOMEM;
+  }
 
+  pb->prefix_len = sz;
+  pb->prefix_args = (pfx != NULL) ? 4 : 3;
   return 0;
 }
 
+// Append a literal suffix to the builder's prefix.
+static int lcec_pinbuilder_name(lcec_pinbuilder_t *pb, const char *suffix) {
+  int sz = strlen(suffix);
+
+  if (pb->prefix_len + sz > HAL_NAME_LEN) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "length %d too long for name starting '%s'\n", pb->prefix_len + sz, pb->name);
+    return -ENOMEM;
+  }
+
+  memcpy(pb->name + pb->prefix_len, suffix, sz + 1);
+  return 0;
+}
+
+// Build the name for a format that starts with `%s.%s.%s.`.  The
+// prefix is only formatted for the first such entry of a list; later
+// entries skip its three arguments and format (or just copy) the rest.
+static int lcec_pinbuilder_namefv(lcec_pinbuilder_t *pb, const char *fmt, va_list ap) {
+  const char *module = va_arg(ap, const char *);
+  const char *master = va_arg(ap, const char *);
+  const char *slave = va_arg(ap, const char *);
+  const char *rest = fmt + LCEC_PIN_PREFIX_FMT_LEN;
+  int room, sz, err;
+
+  if (pb->prefix_len < 0) {
+    err = lcec_pinbuilder_set(pb, module, master, slave, NULL);
+    if (err) {
+      return err;
+    }
+  }
+
+  if (strchr(rest, '%') == NULL) {
+    return lcec_pinbuilder_name(pb, rest);
+  }
+
+  room = sizeof(pb->name) - pb->prefix_len;
+  sz = rtapi_vsnprintf(pb->name + pb->prefix_len, room, rest, ap);
+  if (sz < 0 || sz >= room) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "length %d too long for name starting '%s'\n", pb->prefix_len + sz, pb->name);
+    return -ENOMEM;
+  }
+
+  return 0;
+}
+
+// Return the literal suffix of a `lcec_pindesc_t` format whose
+// leading arguments are covered by the builder's prefix, or NULL if it
+// has any other arguments.
+static const char *lcec_pinbuilder_suffix(const lcec_pinbuilder_t *pb, const char *fmt) {
+  if (strncmp(fmt, LCEC_PIN_PREFIX_FMT, LCEC_PIN_PREFIX_FMT_LEN) != 0) {
+    return NULL;
+  }
+  fmt += LCEC_PIN_PREFIX_FMT_LEN;
+
+  if (pb->prefix_args == 4) {
+    if (strncmp(fmt, "%s", 2) != 0) {
+      return NULL;
+    }
+    fmt += 2;
+  }
+
+  if (strchr(fmt, '%') != NULL) {
+    return NULL;
+  }
+
+  return fmt;
+}
+
+static int lcec_pin_newfv(hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr, const char *fmt, va_list ap) {
+  char name[HAL_NAME_LEN + 1];
+  int sz;
+
+  sz = rtapi_vsnprintf(name, sizeof(name), fmt, ap);
+  if (sz == -1 || sz > HAL_NAME_LEN) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "length %d too long for name starting '%s'\n", sz, name);
+    return -ENOMEM;
+  }
+
+  return lcec_pin_register(name, type, dir, data_ptr_addr);
+}
+
 /// @brief Define a LinuxCNC HAL bin based on a printf pattern.
 /// @param[in] type Type of pin (`HAL_BIT`, `HAL_FLOAT`, `HAL_S32`, or `HAL_U32`).
 /// @param[in] dir Direction (`HAL_IN`, `HAL_OUT`, or `HAL_IO`)
@@ -80,13 +202,22 @@ int lcec_pin_newf(hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr, cons
 }
 
 static int lcec_pin_newfv_list(void *base, const lcec_pindesc_t *list, va_list ap) {
+  lcec_pinbuilder_t pb;
   va_list ac;
   int err;
   const lcec_pindesc_t *p;
 
+  pb.prefix_len = -1;
   for (p = list; p->type != HAL_TYPE_UNSPECIFIED; p++) {
     va_copy(ac, ap);
-    err = lcec_pin_newfv(p->type, p->dir, (void **)(base + p->offset), p->fmt, ac);
+    if (strncmp(p->fmt, LCEC_PIN_PREFIX_FMT, LCEC_PIN_PREFIX_FMT_LEN) == 0) {
+      err = lcec_pinbuilder_namefv(&pb, p->fmt, ac);
+      if (!err) {
+        err = lcec_pin_register(pb.name, p->type, p->dir, (void **)(base + p->offset));
+      }
+    } else {
+      err = lcec_pin_newfv(p->type, p->dir, (void **)(base + p->offset), p->fmt, ac);
+    }
     va_end(ac);
     if (err) {
       return err;
@@ -110,3 +241,162 @@ int lcec_pin_newf_list(void *base, const lcec_pindesc_t *list, ...) {
 
   return err;
 }
+
+static int lcec_param_newfv(hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *fmt, va_list ap) {
+  char name[HAL_NAME_LEN + 1];
+  int sz;
+
+  sz = rtapi_vsnprintf(name, sizeof(name), fmt, ap);
+  if (sz == -1 || sz > HAL_NAME_LEN) {
+    rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "length %d too long for name starting '%s'\n", sz, name);
+    return -ENOMEM;
+  }
+
+  return lcec_param_register(name, type, dir, data_addr);
+}
+
+/// @brief Create a new LinuxCNC `param` dynamically.
+int lcec_param_newf(hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *fmt, ...) {
+  va_list ap;
+  int err;
+
+  va_start(ap, fmt);
+  err = lcec_param_newfv(type, dir, data_addr, fmt, ap);
+  va_end(ap);
+
+  return err;
+}
+
+static int lcec_param_newfv_list(void *base, const lcec_pindesc_t *list, va_list ap) {
+  lcec_pinbuilder_t pb;
+  va_list ac;
+  int err;
+  const lcec_pindesc_t *p;
+
+  pb.prefix_len = -1;
+  for (p = list; p->type != HAL_TYPE_UNSPECIFIED; p++) {
+    va_copy(ac, ap);
+    if (strncmp(p->fmt, LCEC_PIN_PREFIX_FMT, LCEC_PIN_PREFIX_FMT_LEN) == 0) {
+      err = lcec_pinbuilder_namefv(&pb, p->fmt, ac);
+      if (!err) {
+        err = lcec_param_register(pb.name, p->type, p->dir, (void *)(base + p->offset));
+      }
+    } else {
+      err = lcec_param_newfv(p->type, p->dir, (void *)(base + p->offset), p->fmt, ac);
+    }
+    va_end(ac);
+    if (err) {
+      return err;
+    }
+  }
+
+  return 0;
+}
+
+/// @brief Create a list of new LinuxCNC params dynamically, using sprintf() to create names.
+int lcec_param_newf_list(void *base, const lcec_pindesc_t *list, ...) {
+  va_list ap;
+  int err;
+
+  va_start(ap, list);
+  err = lcec_param_newfv_list(base, list, ap);
+  va_end(ap);
+
+  return err;
+}
+
+/// @brief Start building pin names for a slave.
+///
+/// Formats `lcec.<master>.<slave>.<pfx>` once; every pin or param
+/// added through `pb` afterwards only appends its suffix.
+///
+/// @param[out] pb The builder to initialize.
+/// @param[in] slave The slave the pins belong to.
+/// @param[in] pfx An additional per-channel prefix, or NULL.
+/// @return 0 if successful, negative for error.
+int lcec_pinbuilder_init(lcec_pinbuilder_t *pb, struct lcec_slave *slave, const char *pfx) {
+  return lcec_pinbuilder_set(pb, LCEC_MODULE_NAME, slave->master->name, slave->name, pfx);
+}
+
+/// @brief Define a LinuxCNC HAL pin named by the builder's prefix plus `suffix`.
+int lcec_pinbuilder_pin(lcec_pinbuilder_t *pb, hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr, const char *suffix) {
+  int err;
+
+  err = lcec_pinbuilder_name(pb, suffix);
+  if (err) {
+    return err;
+  }
+
+  return lcec_pin_register(pb->name, type, dir, data_ptr_addr);
+}
+
+/// @brief Define a LinuxCNC HAL param named by the builder's prefix plus `suffix`.
+int lcec_pinbuilder_param(lcec_pinbuilder_t *pb, hal_type_t type, hal_pin_dir_t dir, void *data_addr, const char *suffix) {
+  int err;
+
+  err = lcec_pinbuilder_name(pb, suffix);
+  if (err) {
+    return err;
+  }
+
+  return lcec_param_register(pb->name, type, dir, data_addr);
+}
+
+/// @brief Define multiple LinuxCNC HAL pins from an existing `lcec_pindesc_t` table.
+///
+/// The table's formats must start with `%s.%s.%s.`, followed by `%s`
+/// if the builder was initialized with a `pfx`, and have no other
+/// arguments; that is, exactly the tables that would otherwise be
+/// passed to `lcec_pin_newf_list()` with the module, master, slave,
+/// and (optionally) prefix names.
+///
+/// @param pb The builder, from `lcec_pinbuilder_init()`.
+/// @param base Data structure behind the pins.
+/// @param list The list of pins to register.
+/// @return 0 if successful, negative for error.
+int lcec_pinbuilder_pin_list(lcec_pinbuilder_t *pb, void *base, const lcec_pindesc_t *list) {
+  const lcec_pindesc_t *p;
+  const char *suffix;
+  int err;
+
+  for (p = list; p->type != HAL_TYPE_UNSPECIFIED; p++) {
+    suffix = lcec_pinbuilder_suffix(pb, p->fmt);
+    if (suffix == NULL) {
+      pb->name[pb->prefix_len] = 0;
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "pin format '%s' does not match prefix '%s'\n", p->fmt, pb->name);
+      return -EINVAL;
+    }
+
+    err = lcec_pinbuilder_pin(pb, p->type, p->dir, (void **)(base + p->offset), suffix);
+    if (err) {
+      return err;
+    }
+  }
+
+  return 0;
+}
+
+/// @brief Define multiple LinuxCNC HAL params from an existing `lcec_pindesc_t` table.
+///
+/// See `lcec_pinbuilder_pin_list()` for the formats accepted.
+int lcec_pinbuilder_param_list(lcec_pinbuilder_t *pb, void *base, const lcec_pindesc_t *list) {
+  const lcec_pindesc_t *p;
+  const char *suffix;
+  int err;
+
+  for (p = list; p->type != HAL_TYPE_UNSPECIFIED; p++) {
+    suffix = lcec_pinbuilder_suffix(pb, p->fmt);
+    if (suffix == NULL) {
+      pb->name[pb->prefix_len] = 0;
+      rtapi_print_msg(RTAPI_MSG_ERR, LCEC_MSG_PFX "param format '%s' does not match prefix '%s'\n", p->fmt, pb->name);
+      return -EINVAL;
+    }
+
+    err = lcec_pinbuilder_param(pb, p->type, p->dir, (void *)(base + p->offset), suffix);
+    if (err) {
+      return err;
+    }
+  }
+
+  return 0;
+}
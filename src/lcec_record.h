@@ -0,0 +1,99 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Shared memory layout for the process data flight recorder.
+///
+/// Each master with `recordDepth` set gets its own recorder block in
+/// user/RT shared memory.  The block starts with a header, followed
+/// by a description of the slaves and registered PDO entries (so
+/// that `lcec_dump` can decode the frames without the XML config),
+/// followed by `depth` frames.  Every read cycle, the realtime side
+/// copies the domain's process data into the next frame, together
+/// with the working counter and master state, until capture is
+/// frozen by the `record-trigger` pin or by a bus fault.
+///
+/// As with the EMCY ring, the realtime side is the only writer of
+/// frames and never waits on readers.
+
+#ifndef _LCEC_RECORD_H_
+#define _LCEC_RECORD_H_
+
+#include "lcec_conf.h"
+
+#define LCEC_RECORD_SHMEM_KEY(master_idx) (0xACB57400 + (master_idx))
+#define LCEC_RECORD_SHMEM_MAGIC           0x52454344
+
+/// @brief Why capture was frozen.
+typedef enum {
+  LCEC_RECORD_RUNNING = 0,  ///< Still capturing.
+  LCEC_RECORD_TRIGGER,      ///< The `record-trigger` pin went high.
+  LCEC_RECORD_FAULT,        ///< Working counter incomplete, link down, or a slave left OP.
+} LCEC_RECORD_STATE_T;
+
+/// @brief A slave, as described in the recorder block.
+typedef struct {
+  int index;                        ///< Bus position.
+  uint32_t vid;                     ///< Vendor ID.
+  uint32_t pid;                     ///< Product ID.
+  char name[LCEC_CONF_STR_MAXLEN];  ///< Slave name.
+} LCEC_RECORD_SLAVE_T;
+
+/// @brief Frame header, followed by `data_len` bytes of process data.
+typedef struct {
+  uint64_t timestamp;          ///< EtherCAT application time (ns since 2000-01-01) of the read cycle.
+  uint32_t seq;                ///< Sequence number, the value of `head` when the frame was written.
+  uint32_t working_counter;    ///< Domain working counter.
+  uint32_t slaves_responding;  ///< Number of slaves responding, as last read from the master.
+  uint8_t wc_state;            ///< `ec_wc_state_t` of the domain.
+  uint8_t al_states;           ///< Master's AL states, as last read from the master.
+  uint8_t link_up;             ///< Master link state.
+  uint8_t reserved;
+  uint8_t data[];
+} LCEC_RECORD_FRAME_T;
+
+/// @brief Recorder block header.
+typedef struct {
+  uint32_t magic;
+  size_t length;             ///< Size of the whole block, including this header.
+  int master_index;          ///< Index of the master that owns this recorder.
+  uint32_t depth;            ///< Number of frames.
+  uint32_t data_len;         ///< Bytes of process data per frame.
+  uint32_t frame_size;       ///< Distance between two frames.
+  uint32_t slave_count;      ///< Number of entries in the slave table.
+  uint32_t entry_count;      ///< Number of entries in the PDO entry table.
+  volatile uint32_t head;    ///< Sequence number of the next frame to be written.
+  volatile uint32_t state;   ///< `LCEC_RECORD_STATE_T`; frames are only written while `LCEC_RECORD_RUNNING`.
+} LCEC_RECORD_T;
+
+#define LCEC_RECORD_ALIGN(x)                (((x) + 7) & ~(size_t)7)
+#define LCEC_RECORD_FRAME_BYTES(data_len)   LCEC_RECORD_ALIGN(sizeof(LCEC_RECORD_FRAME_T) + (data_len))
+#define LCEC_RECORD_SLAVES_OFFSET           LCEC_RECORD_ALIGN(sizeof(LCEC_RECORD_T))
+#define LCEC_RECORD_ENTRIES_OFFSET(slaves)  (LCEC_RECORD_SLAVES_OFFSET + LCEC_RECORD_ALIGN((slaves) * sizeof(LCEC_RECORD_SLAVE_T)))
+#define LCEC_RECORD_FRAMES_OFFSET(slaves, entries) \
+  (LCEC_RECORD_ENTRIES_OFFSET(slaves) + LCEC_RECORD_ALIGN((entries) * sizeof(LCEC_PDO_ENTRY_DESC_T)))
+#define LCEC_RECORD_BYTES(slaves, entries, depth, data_len) \
+  (LCEC_RECORD_FRAMES_OFFSET(slaves, entries) + (size_t)(depth) * LCEC_RECORD_FRAME_BYTES(data_len))
+
+#define LCEC_RECORD_SLAVES(rec)  ((LCEC_RECORD_SLAVE_T *)((char *)(rec) + LCEC_RECORD_SLAVES_OFFSET))
+#define LCEC_RECORD_ENTRIES(rec) ((LCEC_PDO_ENTRY_DESC_T *)((char *)(rec) + LCEC_RECORD_ENTRIES_OFFSET((rec)->slave_count)))
+#define LCEC_RECORD_FRAME(rec, n)                                                                     \
+  ((LCEC_RECORD_FRAME_T *)((char *)(rec) + LCEC_RECORD_FRAMES_OFFSET((rec)->slave_count, (rec)->entry_count) + \
+                           (size_t)(n) * (rec)->frame_size))
+
+#endif
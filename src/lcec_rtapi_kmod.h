@@ -21,6 +21,7 @@
 #ifndef _LCEC_RTAPI_KMOD_H_
 #define _LCEC_RTAPI_KMOD_H_
 
+#include <asm/barrier.h>
 #include <linux/jiffies.h>
 #include <linux/math64.h>
 #include <linux/sched.h>
@@ -37,6 +38,14 @@
 
 #define lcec_schedule() schedule()
 
+#define lcec_wmb() smp_wmb()
+#define lcec_rmb() smp_rmb()
+
+// no worker threads in kernel builds; callers run the work inline
+typedef int lcec_thread_t;
+#define lcec_thread_create(thread, fn, arg) (-ENOSYS)
+#define lcec_thread_join(thread)            ((void)(thread))
+
 static inline long long lcec_mod_64(long long val, unsigned long div) {
   s32 rem;
   div_s64_rem(val, div, &rem);
@@ -21,6 +21,7 @@
 #ifndef _LCEC_RTAPI_USER_H_
 #define _LCEC_RTAPI_USER_H_
 
+#include <pthread.h>
 #include <sched.h>
 #include <stdlib.h>
 #include <string.h>
@@ -45,6 +46,13 @@ static inline long lcec_get_ticks(void) {
 
 #define lcec_schedule() sched_yield()
 
+#define lcec_wmb() __sync_synchronize()
+#define lcec_rmb() __sync_synchronize()
+
+typedef pthread_t lcec_thread_t;
+#define lcec_thread_create(thread, fn, arg) pthread_create(thread, NULL, fn, arg)
+#define lcec_thread_join(thread)            pthread_join(thread, NULL)
+
 static inline long long lcec_mod_64(long long val, unsigned long div) { return val % div; }
 
 #endif
@@ -0,0 +1,188 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Code for `lcec_samples` tool, which writes the sample stream of an oversampling slave as CSV.
+///
+/// Usage: `lcec_samples [-f] [-m master-index] slave-index`
+///
+/// Prints one line per sample, oldest first, with the sample's
+/// timestamp followed by one raw value per channel.  With `-f`, keeps
+/// running and prints new samples as they arrive until interrupted.
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "lcec_rtapi.h"
+#include "lcec_samples.h"
+#include "rtapi.h"
+
+#define POLL_INTERVAL_US 10000
+
+static const char *modname = "lcec_samples";
+static volatile int done = 0;
+
+static void exitHandler(int sig) { done = 1; }
+
+static void usage(void) { fprintf(stderr, "usage: %s [-f] [-m master-index] slave-index\n", modname); }
+
+static void print_block(const LCEC_SAMPLES_RING_T *ring, const LCEC_SAMPLES_BLOCK_T *block) {
+  uint32_t k, ch;
+
+  for (k = 0; k < ring->samples; k++) {
+    printf("%llu", (unsigned long long)(block->timestamp + (uint64_t)k * block->interval));
+    for (ch = 0; ch < ring->channels; ch++) {
+      printf(",%d", block->samples[k * ring->channels + ch]);
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char **argv) {
+  int ret = 1;
+  int follow = 0;
+  int master_index = 0;
+  int slave_index;
+  int comp_id;
+  int shmem_id;
+  void *shmem_ptr;
+  LCEC_SAMPLES_RING_T *ring;
+  LCEC_SAMPLES_BLOCK_T *block = NULL;
+  uint32_t pos, head, ch;
+  size_t length;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "fm:h")) != -1) {
+    switch (opt) {
+      case 'f':
+        follow = 1;
+        break;
+      case 'm':
+        master_index = atoi(optarg);
+        break;
+      default:
+        usage();
+        return 1;
+    }
+  }
+  if (optind >= argc) {
+    usage();
+    return 1;
+  }
+  slave_index = atoi(argv[optind]);
+
+  // initialize component
+  comp_id = hal_init(modname);
+  if (comp_id < 1) {
+    fprintf(stderr, "%s: ERROR: hal_init failed\n", modname);
+    goto fail0;
+  }
+
+  // map the header to get the size of the ring
+  shmem_id = rtapi_shmem_new(LCEC_SAMPLES_SHMEM_KEY(master_index, slave_index), comp_id, sizeof(LCEC_SAMPLES_RING_T));
+  if (shmem_id < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't allocate user/RT shared memory\n", modname);
+    goto fail1;
+  }
+  if (lcec_rtapi_shmem_getptr(shmem_id, &shmem_ptr) < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't map user/RT shared memory\n", modname);
+    goto fail2;
+  }
+  ring = shmem_ptr;
+  if (ring->magic != LCEC_SAMPLES_SHMEM_MAGIC) {
+    fprintf(stderr, "%s: ERROR: no sample ring active on master %d slave %d\n", modname, master_index, slave_index);
+    goto fail2;
+  }
+  lcec_rmb();
+  length = ring->length;
+  rtapi_shmem_delete(shmem_id, comp_id);
+
+  // reopen with the proper size
+  shmem_id = rtapi_shmem_new(LCEC_SAMPLES_SHMEM_KEY(master_index, slave_index), comp_id, length);
+  if (shmem_id < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't allocate user/RT shared memory\n", modname);
+    goto fail1;
+  }
+  if (lcec_rtapi_shmem_getptr(shmem_id, &shmem_ptr) < 0) {
+    fprintf(stderr, "%s: ERROR: couldn't map user/RT shared memory\n", modname);
+    goto fail2;
+  }
+  ring = shmem_ptr;
+
+  block = malloc(ring->block_size);
+  if (block == NULL) {
+    fprintf(stderr, "%s: ERROR: out of memory\n", modname);
+    goto fail2;
+  }
+
+  signal(SIGINT, exitHandler);
+  signal(SIGTERM, exitHandler);
+
+  printf("timestamp");
+  for (ch = 0; ch < ring->channels; ch++) {
+    printf(",ch%u", ch);
+  }
+  printf("\n");
+
+  // start with the oldest block still in the ring.  The slot at
+  // head - size is the one the writer will overwrite next, so it is
+  // never read.
+  head = ring->head;
+  pos = (head >= ring->size) ? head - ring->size + 1 : 0;
+  ret = 0;
+  while (!done) {
+    head = ring->head;
+    lcec_rmb();
+    while (pos != head) {
+      // skip blocks that were overwritten before we got to them
+      if (head - pos >= ring->size) {
+        fprintf(stderr, "%s: WARNING: lost %u cycles\n", modname, head - pos - ring->size + 1);
+        pos = head - ring->size + 1;
+      }
+      memcpy(block, LCEC_SAMPLES_BLOCK(ring, pos), ring->block_size);
+      lcec_rmb();
+
+      // the writer may have lapped us while copying
+      if (ring->head - pos >= ring->size) {
+        head = ring->head;
+        continue;
+      }
+
+      print_block(ring, block);
+      pos++;
+    }
+    fflush(stdout);
+
+    if (!follow) {
+      break;
+    }
+    usleep(POLL_INTERVAL_US);
+  }
+
+  free(block);
+fail2:
+  rtapi_shmem_delete(shmem_id, comp_id);
+fail1:
+  hal_exit(comp_id);
+fail0:
+  return ret;
+}
@@ -0,0 +1,70 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Shared memory layout for the oversampling sample stream.
+///
+/// Each oversampling slave with `sampleRing` set gets its own ring in
+/// user/RT shared memory.  Every cycle, the realtime side appends one
+/// block holding all samples of that cycle, for all channels.  As
+/// with the EMCY ring, the realtime side is the only writer; readers
+/// (like `lcec_samples`) keep their own read position and never
+/// modify the ring, so the RT thread never waits on userspace.  When
+/// a reader falls behind by more than `size` blocks, the oldest
+/// blocks are lost.
+
+#ifndef _LCEC_SAMPLES_H_
+#define _LCEC_SAMPLES_H_
+
+#include "lcec_conf.h"
+
+#define LCEC_SAMPLES_SHMEM_KEY(master_idx, slave_idx) (0xACB60000 + ((master_idx) << 12) + ((slave_idx)&0xfff))
+#define LCEC_SAMPLES_SHMEM_MAGIC                      0x534D504C
+
+/// @brief One cycle of samples.
+typedef struct {
+  uint64_t timestamp;  ///< EtherCAT application time (ns since 2000-01-01) of sample 0.
+  uint32_t interval;   ///< Time between two samples in ns.
+  uint32_t reserved;
+  int32_t samples[];   ///< Raw sample values, `samples` rows of `channels` values each.
+} LCEC_SAMPLES_BLOCK_T;
+
+/// @brief Ring header, followed by `size` blocks.
+typedef struct {
+  uint32_t magic;
+  size_t length;           ///< Size of the whole ring, including this header.
+  int master_index;        ///< Index of the master that owns the slave.
+  int slave_index;         ///< Bus position of the slave.
+  uint32_t size;           ///< Number of blocks, a power of two.
+  uint32_t channels;       ///< Channels per sample row.
+  uint32_t samples;        ///< Sample rows per block.
+  uint32_t block_size;     ///< Distance between two blocks.
+  int is_output;           ///< Samples were written to the slave, not read from it.
+  volatile uint32_t head;  ///< Sequence number of the next block to be written.
+} LCEC_SAMPLES_RING_T;
+
+#define LCEC_SAMPLES_ALIGN(x)                    (((x) + 7) & ~(size_t)7)
+#define LCEC_SAMPLES_BLOCK_BYTES(channels, samples) \
+  LCEC_SAMPLES_ALIGN(sizeof(LCEC_SAMPLES_BLOCK_T) + (size_t)(channels) * (samples) * sizeof(int32_t))
+#define LCEC_SAMPLES_BLOCKS_OFFSET LCEC_SAMPLES_ALIGN(sizeof(LCEC_SAMPLES_RING_T))
+#define LCEC_SAMPLES_BYTES(size, channels, samples) \
+  (LCEC_SAMPLES_BLOCKS_OFFSET + (size_t)(size)*LCEC_SAMPLES_BLOCK_BYTES(channels, samples))
+#define LCEC_SAMPLES_BLOCK(ring, seq) \
+  ((LCEC_SAMPLES_BLOCK_T *)((char *)(ring) + LCEC_SAMPLES_BLOCKS_OFFSET + (size_t)((seq) & ((ring)->size - 1)) * (ring)->block_size))
+
+#endif
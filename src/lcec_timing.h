@@ -0,0 +1,96 @@
+//
+//    Copyright (C) 2024 Scott Laird <scott@sigkill.org>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+/// @file
+/// @brief Shared memory layout for the startup timing report.
+///
+/// `lcec_conf` creates the timing block next to the config block,
+/// sized for the masters and slaves it parsed, and records how long
+/// the XML parse took.  The realtime module fills in the time spent
+/// in each startup phase, per master and per slave, while it
+/// initializes, and the time until each master reaches OP from its
+/// read function.  `lcec_conf -t <file>` then writes the whole report
+/// as JSON.
+
+#ifndef _LCEC_TIMING_H_
+#define _LCEC_TIMING_H_
+
+#include "lcec_conf.h"
+
+#define LCEC_TIMING_SHMEM_KEY   0xACB572C8
+#define LCEC_TIMING_SHMEM_MAGIC 0x54494D45
+
+/// @brief Per-master startup phases.
+typedef enum {
+  LCEC_TIMING_MASTER_REQUEST,   ///< `ecrt_request_master()` and domain creation.
+  LCEC_TIMING_MASTER_PREFETCH,  ///< Parallel mailbox reads queued by `proc_preinit`.
+  LCEC_TIMING_MASTER_SLAVES,    ///< All slave phases below, together.
+  LCEC_TIMING_MASTER_PDO_REG,   ///< PDO entry registration.
+  LCEC_TIMING_MASTER_ACTIVATE,  ///< `ecrt_master_activate()`.
+  LCEC_TIMING_MASTER_PINS,      ///< Master pin and function export.
+  LCEC_TIMING_MASTER_ALL_OP,    ///< From activation until all slaves are in OP.
+  LCEC_TIMING_MASTER_PHASES
+} LCEC_TIMING_MASTER_PHASE_T;
+
+#define LCEC_TIMING_MASTER_PHASE_NAMES {"request", "prefetch", "slaves", "pdo_registration", "activate", "pin_export", "all_op"}
+
+/// @brief Per-slave startup phases.
+typedef enum {
+  LCEC_TIMING_SLAVE_CONFIG,   ///< `ecrt_master_slave_config()`.
+  LCEC_TIMING_SLAVE_SDO_IDN,  ///< `<sdoConfig>` and `<idnConfig>` from the XML.
+  LCEC_TIMING_SLAVE_INIT,     ///< The driver's `proc_init`, including its own pins.
+  LCEC_TIMING_SLAVE_PDOS,     ///< DC, watchdog, and `ecrt_slave_config_pdos()`.
+  LCEC_TIMING_SLAVE_PINS,     ///< Slave state pin export.
+  LCEC_TIMING_SLAVE_PHASES
+} LCEC_TIMING_SLAVE_PHASE_T;
+
+#define LCEC_TIMING_SLAVE_PHASE_NAMES {"slave_config", "sdo_idn_config", "proc_init", "pdo_config", "pin_export"}
+
+/// @brief Timing for one slave.
+typedef struct {
+  int index;                                     ///< Bus position.
+  char name[LCEC_CONF_STR_MAXLEN];               ///< Slave name.
+  long long phase_ns[LCEC_TIMING_SLAVE_PHASES];  ///< Time spent per phase.
+} LCEC_TIMING_SLAVE_T;
+
+/// @brief Timing for one master.
+typedef struct {
+  int index;                                      ///< Master index.
+  char name[LCEC_CONF_STR_MAXLEN];                ///< Master name.
+  int first_slave;                                ///< Index of this master's first slave in the slave table.
+  int slave_count;                                ///< Number of slaves on this master.
+  long long phase_ns[LCEC_TIMING_MASTER_PHASES];  ///< Time spent per phase, -1 until known.
+} LCEC_TIMING_MASTER_T;
+
+/// @brief Timing block header, followed by `master_count` masters and `slave_count` slaves.
+typedef struct {
+  uint32_t magic;
+  int master_count;        ///< Number of masters.
+  int slave_count;         ///< Number of slaves, over all masters.
+  long long parse_ns;      ///< XML parse in `lcec_conf`.
+  long long handoff_ns;    ///< Reading the config out of shared memory in the realtime module.
+  long long total_ns;      ///< All of `rtapi_app_main()`.
+  volatile int init_done;  ///< Set once `rtapi_app_main()` has filled in everything but `all_op`.
+} LCEC_TIMING_T;
+
+#define LCEC_TIMING_BYTES(master_count, slave_count) \
+  (sizeof(LCEC_TIMING_T) + (master_count) * sizeof(LCEC_TIMING_MASTER_T) + (slave_count) * sizeof(LCEC_TIMING_SLAVE_T))
+#define LCEC_TIMING_MASTERS(timing) ((LCEC_TIMING_MASTER_T *)((char *)(timing) + sizeof(LCEC_TIMING_T)))
+#define LCEC_TIMING_SLAVES(timing)  ((LCEC_TIMING_SLAVE_T *)(LCEC_TIMING_MASTERS(timing) + (timing)->master_count))
+
+#endif
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/lcec.h"
+#include "../../src/devices/lcec_class_ain.h"
+#include "tests.h"
+
+TESTGLOBALSETUP;
+
+static const lcec_modparam_desc_t device_mps[] = {
+    {"ch0Sensor", 0, MODPARAM_TYPE_STRING},
+    {NULL},
+};
+
+TESTFUNC(test_ain_modparams) {
+  TESTSETUP;
+  const lcec_modparam_desc_t *mps;
+
+  mps = lcec_ain_modparams(NULL);
+  TESTNOTNULL((void *)mps);
+  TESTINT(lcec_modparam_desc_len(mps), 3 * LCEC_AIN_MAX_CHANNELS);
+
+  mps = lcec_ain_modparams(device_mps);
+  TESTNOTNULL((void *)mps);
+  TESTINT(lcec_modparam_desc_len(mps), 1 + 3 * LCEC_AIN_MAX_CHANNELS);
+  TESTINT(strcmp(mps[0].name, "ch0Sensor"), 0);
+  TESTINT(strcmp(mps[3].name, "ch2Lowpass"), 0);
+  TESTINT(mps[3].id, LCEC_AIN_MODPARAM_LOWPASS + 2);
+
+  // The same device list is only merged once.
+  TESTINT(lcec_ain_modparams(device_mps) == mps, 1);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_ain_filter) {
+  TESTSETUP;
+  lcec_class_ain_channel_t chan;
+  int32_t buf[4];
+
+  // No filters, values pass straight through.
+  memset(&chan, 0, sizeof(chan));
+  TESTINT((int)lcec_ain_filter(&chan, 100), 100);
+  TESTINT((int)lcec_ain_filter(&chan, -200), -200);
+
+  // Moving average over 4 samples, seeded with the first sample.
+  memset(&chan, 0, sizeof(chan));
+  chan.average_buf = buf;
+  chan.average_len = 4;
+  chan.average_recip = 0.25;
+  TESTINT((int)lcec_ain_filter(&chan, 400), 400);
+  TESTINT((int)lcec_ain_filter(&chan, 800), 500);
+  TESTINT((int)lcec_ain_filter(&chan, 800), 600);
+  TESTINT((int)lcec_ain_filter(&chan, 800), 700);
+  TESTINT((int)lcec_ain_filter(&chan, 800), 800);
+  TESTINT((int)lcec_ain_filter(&chan, 0), 600);
+
+  // First-order IIR, seeded with the first sample.
+  memset(&chan, 0, sizeof(chan));
+  chan.lowpass_gain = 0.5;
+  TESTINT((int)lcec_ain_filter(&chan, 1000), 1000);
+  TESTINT((int)lcec_ain_filter(&chan, 0), 500);
+  TESTINT((int)lcec_ain_filter(&chan, 0), 250);
+
+  TESTRESULTS;
+}
+
+TESTMAIN
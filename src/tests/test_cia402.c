@@ -1,7 +1,10 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "../../src/lcec.h"
 #include "../../src/devices/lcec_class_cia402.h"
+#include "../../src/devices/lcec_class_enc.h"
 #include "tests.h"
 
 TESTGLOBALSETUP;
@@ -28,12 +31,318 @@ TESTFUNC(test_modparm_len) {
   channelized_mps = lcec_cia402_channelized_modparams(per_channel_mps);
   TESTNOTNULL(channelized_mps);
 
-  TESTINT(lcec_modparam_desc_len(channelized_mps), 27);
+  TESTINT(lcec_modparam_desc_len(channelized_mps), 3);
+  TESTINT(channelized_mps[1].channels, LCEC_CIA402_MAX_CHANNELS);
 
   lcec_modparam_desc_t *all_mps = lcec_modparam_desc_concat(channelized_mps, device_mps);
   TESTNOTNULL(all_mps);
 
-  TESTINT(lcec_modparam_desc_len(all_mps), 28);
+  TESTINT(lcec_modparam_desc_len(all_mps), 4);
+
+  // Channel prefixes are resolved at lookup, not expanded.
+  int id = 0;
+  TESTINT(lcec_modparam_desc_find(all_mps, "bbb", &id) == &all_mps[1], 1);
+  TESTINT(id, 0x1010);
+  TESTINT(lcec_modparam_desc_find(all_mps, "ch0bbb", &id) == &all_mps[1], 1);
+  TESTINT(id, 0x1010);
+  TESTINT(lcec_modparam_desc_find(all_mps, "ch7ccc", &id) == &all_mps[2], 1);
+  TESTINT(id, 0x1027);
+  TESTINT(lcec_modparam_desc_find(all_mps, "ch8ccc", &id) == NULL, 1);
+  TESTINT(lcec_modparam_desc_find(all_mps, "ch1ddd", &id) == NULL, 1);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_ops) {
+  TESTSETUP;
+  uint8_t pd[16];
+  hal_u32_t statusword = 0, controlword = 0x1234f;
+  hal_s32_t opmode_display = 0, actual_position = 0, opmode = -3, target_position = -100000;
+  lcec_class_cia402_op_t read_ops[] = {
+      {0, LCEC_CIA402_OP_U16, &statusword},
+      {2, LCEC_CIA402_OP_S8, &opmode_display},
+      {4, LCEC_CIA402_OP_S32, &actual_position},
+  };
+  lcec_class_cia402_op_t write_ops[] = {
+      {8, LCEC_CIA402_OP_U16, &controlword},
+      {10, LCEC_CIA402_OP_S8, &opmode},
+      {12, LCEC_CIA402_OP_S32, &target_position},
+  };
+
+  memset(pd, 0, sizeof(pd));
+  EC_WRITE_U16(&pd[0], 0x1237);
+  EC_WRITE_S8(&pd[2], -1);
+  EC_WRITE_S32(&pd[4], -123456);
+  lcec_cia402_run_read_ops(pd, read_ops, 3);
+  TESTINT(statusword, 0x1237);
+  TESTINT(opmode_display, -1);
+  TESTINT(actual_position, -123456);
+
+  // Writes truncate to the object's width and leave neighbors alone.
+  lcec_cia402_run_write_ops(pd, write_ops, 3);
+  TESTINT(EC_READ_U16(&pd[8]), 0x234f);
+  TESTINT(EC_READ_S8(&pd[10]), -3);
+  TESTINT(EC_READ_U8(&pd[11]), 0);
+  TESTINT(EC_READ_S32(&pd[12]), -100000);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_shared_layout) {
+  TESTSETUP;
+  uint8_t pd[32];
+  hal_u32_t status[2] = {0, 0}, control[2] = {0x0f, 0x06};
+  hal_s32_t position[2] = {0, 0}, target[2] = {1000, -1000};
+  lcec_class_cia402_op_t read0[] = {{0, LCEC_CIA402_OP_U16, &status[0]}, {2, LCEC_CIA402_OP_S32, &position[0]}};
+  lcec_class_cia402_op_t read1[] = {{16, LCEC_CIA402_OP_U16, &status[1]}, {18, LCEC_CIA402_OP_S32, &position[1]}};
+  lcec_class_cia402_op_t write0[] = {{6, LCEC_CIA402_OP_U16, &control[0]}, {8, LCEC_CIA402_OP_S32, &target[0]}};
+  lcec_class_cia402_op_t write1[] = {{22, LCEC_CIA402_OP_U16, &control[1]}, {24, LCEC_CIA402_OP_S32, &target[1]}};
+  lcec_class_cia402_channel_t ch0, ch1;
+  lcec_class_cia402_channel_t *chans[] = {&ch0, &ch1};
+  lcec_class_cia402_channels_t channels = {2, chans, 0};
+
+  memset(&ch0, 0, sizeof(ch0));
+  memset(&ch1, 0, sizeof(ch1));
+  ch0.read_ops = read0;
+  ch0.read_op_count = 2;
+  ch0.write_ops = write0;
+  ch0.write_op_count = 2;
+  ch1.read_ops = read1;
+  ch1.read_op_count = 2;
+  ch1.write_ops = write1;
+  ch1.write_op_count = 2;
+
+  TESTINT(lcec_cia402_check_layout(&channels), 1);
+  TESTINT(ch1.read_base, 16);
+  TESTINT(ch1.write_base, 16);
+
+  memset(pd, 0, sizeof(pd));
+  EC_WRITE_U16(&pd[0], 0x0237);
+  EC_WRITE_S32(&pd[2], 12345);
+  EC_WRITE_U16(&pd[16], 0x0250);
+  EC_WRITE_S32(&pd[18], -54321);
+  lcec_cia402_run_read_ops_shared(pd, &channels);
+  TESTINT(status[0], 0x0237);
+  TESTINT(position[0], 12345);
+  TESTINT(status[1], 0x0250);
+  TESTINT(position[1], -54321);
+
+  lcec_cia402_run_write_ops_shared(pd, &channels);
+  TESTINT(EC_READ_U16(&pd[6]), 0x0f);
+  TESTINT(EC_READ_S32(&pd[8]), 1000);
+  TESTINT(EC_READ_U16(&pd[22]), 0x06);
+  TESTINT(EC_READ_S32(&pd[24]), -1000);
+
+  // A channel whose objects aren't evenly spaced can't share.
+  read1[1].os = 20;
+  TESTINT(lcec_cia402_check_layout(&channels), -1);
+  read1[1].os = 18;
+
+  // Neither can one with different objects.
+  ch1.write_op_count = 1;
+  TESTINT(lcec_cia402_check_layout(&channels), -1);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_state_machine) {
+  TESTSETUP;
+
+  TESTINT(lcec_cia402_decode_state(0x0000), LCEC_CIA402_STATE_NOT_READY);
+  TESTINT(lcec_cia402_decode_state(0x0250), LCEC_CIA402_STATE_SWITCH_ON_DISABLED);
+  TESTINT(lcec_cia402_decode_state(0x0231), LCEC_CIA402_STATE_READY);
+  TESTINT(lcec_cia402_decode_state(0x0233), LCEC_CIA402_STATE_SWITCHED_ON);
+  TESTINT(lcec_cia402_decode_state(0x1637), LCEC_CIA402_STATE_OPERATION_ENABLED);
+  TESTINT(lcec_cia402_decode_state(0x0217), LCEC_CIA402_STATE_QUICK_STOP_ACTIVE);
+  TESTINT(lcec_cia402_decode_state(0x021f), LCEC_CIA402_STATE_FAULT_REACTION);
+  TESTINT(lcec_cia402_decode_state(0x0218), LCEC_CIA402_STATE_FAULT);
+
+  // Enabling walks up the state machine one step per cycle.
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_SWITCH_ON_DISABLED, 1, 0), LCEC_CIA402_CW_SHUTDOWN);
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_READY, 1, 0), LCEC_CIA402_CW_SWITCH_ON);
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_SWITCHED_ON, 1, 0), LCEC_CIA402_CW_ENABLE_OPERATION);
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_OPERATION_ENABLED, 1, 0), LCEC_CIA402_CW_ENABLE_OPERATION);
+
+  // Disabling drops back to "ready to switch on".
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_OPERATION_ENABLED, 0, 0), LCEC_CIA402_CW_SHUTDOWN);
+
+  // Quick stop, and leaving it.
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_OPERATION_ENABLED, 1, 1), LCEC_CIA402_CW_QUICK_STOP);
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_QUICK_STOP_ACTIVE, 1, 0), LCEC_CIA402_CW_DISABLE_VOLTAGE);
+
+  // Faults stay put until reset.
+  TESTINT(lcec_cia402_next_controlword(LCEC_CIA402_STATE_FAULT, 1, 0), LCEC_CIA402_CW_DISABLE_VOLTAGE);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_probe_function) {
+  TESTSETUP;
+
+  TESTINT(lcec_cia402_probe_function(0, 0, 0), 0);
+  TESTINT(lcec_cia402_probe_function(0, 0, 1), 0);
+  TESTINT(lcec_cia402_probe_function(1, 0, 0), 0x11);
+  TESTINT(lcec_cia402_probe_function(0, 1, 0), 0x21);
+  TESTINT(lcec_cia402_probe_function(1, 1, 0), 0x31);
+  TESTINT(lcec_cia402_probe_function(1, 0, 1), 0x15);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_feed_forward) {
+  TESTSETUP;
+
+  // 10 counts in 1 ms is 10000 counts/s.
+  TESTINT(lcec_cia402_velocity_feed_forward(110, 100, 1000000, 1.0), 10000);
+  TESTINT(lcec_cia402_velocity_feed_forward(90, 100, 1000000, 1.0), -10000);
+  TESTINT(lcec_cia402_velocity_feed_forward(110, 100, 1000000, 0.5), 5000);
+  TESTINT(lcec_cia402_velocity_feed_forward(110, 100, 0, 1.0), 0);
+
+  // Wrapping positions still give the short way around.
+  TESTINT(lcec_cia402_velocity_feed_forward(INT32_MIN + 4, INT32_MAX - 5, 1000000, 1.0), 10000);
+
+  // Clamp instead of overflowing.
+  TESTINT(lcec_cia402_velocity_feed_forward(1000000, 0, 1000, 1.0) == INT32_MAX, 1);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_skip_unchanged_sdo) {
+  TESTSETUP;
+  struct lcec_slave slave;
+  lcec_slave_mbxread_t *read;
+  lcec_class_cia402_options_t opt;
+  lcec_cia402_modparam_ctx_t ctx;
+  lcec_slave_modparam_t mp[] = {
+      {CIA402_MP_HOME_OFFSET + 1, "ch1homeOffset", {.s32 = -2}},
+      {-1},
+  };
+
+  memset(&slave, 0, sizeof(slave));
+  memset(&opt, 0, sizeof(opt));
+  memset(&ctx, 0, sizeof(ctx));
+
+  // 0x687c:00 (channel 1's home offset), as prefetched from the drive.
+  read = calloc(1, sizeof(lcec_slave_mbxread_t) + 4);
+  read->index = 0x687c;
+  read->size = 4;
+  read->valid = 1;
+  EC_WRITE_S32(read->data, -2);
+  slave.mbx_reads = read;
+
+  TESTINT(lcec_prefetch_matches(&slave, 0x687c, 0, read->data, 4), 1);
+  TESTINT(lcec_prefetch_matches(&slave, 0x687c, 1, read->data, 4), 0);
+  TESTINT(lcec_prefetch_matches(&slave, 0x687c, 0, read->data, 2), 0);
+
+  // Already set, so nothing is written.
+  TESTINT(lcec_cia402_handle_modparam(&slave, &mp[0], &opt, &ctx), 0);
+  TESTINT(ctx.sdos_skipped, 1);
+  TESTINT(ctx.sdos_written, 0);
+
+  free(read);
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_secondary_position_modparams) {
+  TESTSETUP;
+  lcec_class_cia402_options_t opt;
+  lcec_slave_modparam_t mp[] = {
+      {CIA402_MP_ENABLE_SECONDARY_POSITION, "enableSecondaryPosition", {.bit = 1}},
+      {CIA402_MP_SECONDARY_IDX, "secondaryPositionIndex", {.u32 = 0x2511}},
+      {CIA402_MP_SECONDARY_SIDX, "secondaryPositionSubindex", {.u32 = 2}},
+      {-1},
+  };
+
+  memset(&opt, 0, sizeof(opt));
+  for (lcec_slave_modparam_t *p = mp; p->id >= 0; p++) {
+    TESTINT(lcec_cia402_handle_modparam(NULL, p, &opt, NULL), 0);
+  }
+  TESTINT(opt.enable_secondary_position, 1);
+  TESTINT(opt.secondary_position_idx, 0x2511);
+  TESTINT(opt.secondary_position_sidx, 2);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_cia402_secondary_position_read) {
+  TESTSETUP;
+  static lcec_master_t master;
+  struct lcec_slave slave;
+  uint8_t pd[8];
+  lcec_class_cia402_options_t opt;
+  lcec_class_cia402_channel_t ch;
+  lcec_class_enc_data_t enc;
+  hal_float_t scale = 0.5, pos_enc, pos_abs, pos, vel, latch_pos, latch_time;
+  hal_s32_t raw = 0;
+  hal_u32_t ext_lo = 0, ext_hi = 0, ref_lo = 0, ref_hi = 0;
+  hal_bit_t index_ena = 0, pos_reset = 0, latch_valid, on_home_neg, on_home_pos;
+
+  // A channel with only the secondary position, set up the way
+  // lcec_cia402_register_channel() and class_enc_init() would.
+  memset(&slave, 0, sizeof(slave));
+  memset(&opt, 0, sizeof(opt));
+  memset(&ch, 0, sizeof(ch));
+  memset(&enc, 0, sizeof(enc));
+  master.process_data = pd;
+  master.period_last = 1000000;
+  slave.master = &master;
+  opt.enable_secondary_position = 1;
+  ch.options = &opt;
+  ch.ops_resolved = 1;
+  ch.enc2 = &enc;
+  ch.enc2_scale = &scale;
+  ch.secondary_position_os = 4;
+  enc.raw = &raw;
+  enc.ext_lo = &ext_lo;
+  enc.ext_hi = &ext_hi;
+  enc.ref_lo = &ref_lo;
+  enc.ref_hi = &ref_hi;
+  enc.index_ena = &index_ena;
+  enc.pos_reset = &pos_reset;
+  enc.pos_enc = &pos_enc;
+  enc.pos_abs = &pos_abs;
+  enc.pos = &pos;
+  enc.vel.vel = &vel;
+  enc.latch_valid = &latch_valid;
+  enc.latch_pos = &latch_pos;
+  enc.latch_time = &latch_time;
+  enc.on_home_neg = &on_home_neg;
+  enc.on_home_pos = &on_home_pos;
+  enc.master = &master;
+  enc.do_init = 1;
+  enc.raw_bits = 32;
+  enc.raw_shift = 0;
+  enc.raw_mask = 0xffffffff;
+
+  // The first cycle sets the reference.
+  memset(pd, 0, sizeof(pd));
+  EC_WRITE_U32(&pd[4], 0xfffffff0);
+  lcec_cia402_read(&slave, &ch);
+  TESTINT(raw, (int32_t)0xfffffff0);
+  TESTINT((int)pos, 0);
+
+  // 0x60E4 wraps around, srv-enc2-pos doesn't.
+  EC_WRITE_U32(&pd[4], 0x10);
+  lcec_cia402_read(&slave, &ch);
+  TESTINT((int)pos, 16);
+  EC_WRITE_U32(&pd[4], 0xffffffe0);
+  lcec_cia402_read(&slave, &ch);
+  TESTINT((int)pos, -8);
+
+  // srv-enc2-scale applies right away.
+  scale = 2.0;
+  lcec_cia402_read(&slave, &ch);
+  TESTINT((int)pos, -32);
+
+  // Without a reference mark, index-ena just resets the position.
+  index_ena = 1;
+  EC_WRITE_U32(&pd[4], 0xffffffe8);
+  lcec_cia402_read(&slave, &ch);
+  TESTINT(index_ena, 0);
+  TESTINT((int)pos, 0);
+  EC_WRITE_U32(&pd[4], 0xfffffff0);
+  lcec_cia402_read(&slave, &ch);
+  TESTINT((int)pos, 16);
 
   TESTRESULTS;
 }
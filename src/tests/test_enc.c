@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/lcec.h"
+#include "../../src/devices/lcec_class_enc.h"
+#include "tests.h"
+
+TESTGLOBALSETUP;
+
+static lcec_master_t master;
+static lcec_class_enc_data_t enc;
+static hal_s32_t raw;
+static hal_u32_t ext_lo, ext_hi, ref_lo, ref_hi;
+static hal_bit_t index_ena, pos_reset, on_home_neg, on_home_pos;
+static hal_bit_t latch_valid;
+static hal_float_t pos_enc, pos_abs, pos, vel, latch_pos, latch_time;
+
+// Set up an encoder the way class_enc_init() would, without HAL.
+static void setup_enc(uint32_t mode, uint32_t window) {
+  memset(&enc, 0, sizeof(enc));
+  raw = 0;
+  ext_lo = ext_hi = ref_lo = ref_hi = 0;
+  index_ena = pos_reset = 0;
+  enc.raw = &raw;
+  enc.ext_lo = &ext_lo;
+  enc.ext_hi = &ext_hi;
+  enc.ref_lo = &ref_lo;
+  enc.ref_hi = &ref_hi;
+  enc.index_ena = &index_ena;
+  enc.pos_reset = &pos_reset;
+  enc.pos_enc = &pos_enc;
+  enc.pos_abs = &pos_abs;
+  enc.pos = &pos;
+  enc.vel.vel = &vel;
+  enc.latch_valid = &latch_valid;
+  enc.latch_pos = &latch_pos;
+  enc.latch_time = &latch_time;
+  enc.on_home_neg = &on_home_neg;
+  enc.on_home_pos = &on_home_pos;
+  enc.master = &master;
+  enc.do_init = 1;
+  enc.raw_bits = 32;
+  enc.raw_shift = 0;
+  enc.raw_mask = 0xffffffff;
+  enc.vel.mode = mode;
+  enc.vel.window = window;
+
+  master.period_last = 1000000;  // 1 ms
+  class_enc_update(&enc, 0, 1.0, 0, 0, 0);
+}
+
+TESTFUNC(test_enc_vel_diff) {
+  TESTSETUP;
+
+  setup_enc(LCEC_ENC_VEL_DIFF, 0);
+  TESTINT((int)vel, 0);
+
+  // 3 counts per ms
+  class_enc_update(&enc, 0, 1.0, 3, 0, 0);
+  TESTINT((int)vel, 3000);
+  class_enc_update(&enc, 0, 1.0, 3, 0, 0);
+  TESTINT((int)vel, 0);
+
+  // counting down across the 32 bit wrap
+  class_enc_update(&enc, 0, 1.0, 0xfffffffe, 0, 0);
+  TESTINT((int)vel, -5000);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_enc_vel_window) {
+  TESTSETUP;
+  int i;
+
+  // 1 count every other cycle averages out to 500 counts/s
+  setup_enc(LCEC_ENC_VEL_WINDOW, 4);
+  for (i = 1; i <= 8; i++) {
+    class_enc_update(&enc, 0, 1.0, i / 2, 0, 0);
+  }
+  TESTINT((int)vel, 500);
+
+  // out-of-range windows are clamped
+  setup_enc(LCEC_ENC_VEL_WINDOW, 0);
+  class_enc_update(&enc, 0, 1.0, 2, 0, 0);
+  TESTINT((int)vel, 2000);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_enc_vel_period) {
+  TESTSETUP;
+  int i;
+
+  // 1 count every 4 ms is 250 counts/s
+  setup_enc(LCEC_ENC_VEL_PERIOD, 0);
+  for (i = 1; i <= 12; i++) {
+    class_enc_update(&enc, 0, 1.0, i / 4, 0, 0);
+  }
+  TESTINT((int)vel, 250);
+
+  // without new counts the estimate decays as 1 count per elapsed time
+  for (i = 0; i < 8; i++) {
+    class_enc_update(&enc, 0, 1.0, 3, 0, 0);
+  }
+  TESTINT((int)vel, 125);
+
+  // and drops to 0 after the timeout
+  for (i = 0; i < 1000; i++) {
+    class_enc_update(&enc, 0, 1.0, 3, 0, 0);
+  }
+  TESTINT((int)vel, 0);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_enc_vel_off) {
+  TESTSETUP;
+
+  setup_enc(LCEC_ENC_VEL_OFF, 0);
+  class_enc_update(&enc, 0, 1.0, 100, 0, 0);
+  TESTINT((int)vel, 0);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_enc_vel_standalone) {
+  TESTSETUP;
+  lcec_class_enc_vel_t est;
+  hal_float_t est_vel;
+
+  // drivers with their own counters feed the estimator directly
+  memset(&est, 0, sizeof(est));
+  est.vel = &est_vel;
+  est.mode = LCEC_ENC_VEL_DIFF;
+  est.do_init = 1;
+  class_enc_vel_update(&est, 1000000, 100, 0.5);
+  TESTINT((int)est_vel, 0);
+  class_enc_vel_update(&est, 1000000, 104, 0.5);
+  TESTINT((int)est_vel, 2000);
+
+  // a reset restarts from the new position instead of seeing a jump
+  class_enc_vel_reset(&est);
+  class_enc_vel_update(&est, 1000000, -5000, 0.5);
+  TESTINT((int)est_vel, 0);
+  class_enc_vel_update(&est, 1000000, -5002, 0.5);
+  TESTINT((int)est_vel, -1000);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_enc_latch_count) {
+  TESTSETUP;
+
+  setup_enc(LCEC_ENC_VEL_OFF, 0);
+  class_enc_update(&enc, 0, 1.0, 100, 0, 0);
+  TESTINT(latch_valid, 0);
+
+  // latched count 60, current count 110
+  class_enc_update(&enc, 0, 1.0, 110, 60, 1);
+  TESTINT(latch_valid, 1);
+  TESTINT((int)latch_pos, 60);
+  TESTINT((int)pos, 50);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_enc_latch_timed) {
+  TESTSETUP;
+
+  setup_enc(LCEC_ENC_VEL_OFF, 0);
+  class_enc_update_timed(&enc, 0, 1.0, 1000, 0xfff00000, 0, 0);
+
+  // 100 counts in 1 ms, latched 250 us into the cycle
+  class_enc_update_timed(&enc, 0, 1.0, 1100, 0xfff00000 + 1000000, 0xfff00000 + 250000, 1);
+  TESTINT(latch_valid, 1);
+  TESTINT((int)(latch_pos + 0.5), 1025);
+  TESTINT((int)(latch_time * 1e6 - 0.5), -750);
+  TESTINT((int)(pos + 0.5), 75);
+
+  // sub-count accuracy: 3 counts in 1 ms, latched halfway, across a DC time wrap
+  class_enc_update_timed(&enc, 0, 1.0, 1103, 0xfff00000 + 2000000, 0xfff00000 + 1500000, 1);
+  TESTINT((int)(latch_pos * 10 + 0.5), 11015);
+  TESTINT((int)(pos * 10 + 0.5), 15);
+
+  // latch times outside the cycle are clamped to it
+  class_enc_update_timed(&enc, 0, 1.0, 1203, 0xfff00000 + 3000000, 0xfff00000 + 5000000, 1);
+  TESTINT((int)(latch_pos + 0.5), 1203);
+  TESTINT((int)(latch_time * 1e6), 0);
+
+  TESTRESULTS;
+}
+
+TESTMAIN
@@ -17,6 +17,13 @@ static const lcec_modparam_desc_t mp_1[] = {
     {NULL},
 };
 
+static const lcec_modparam_desc_t mp_ch[] = {
+    {"ch0Lowpass", 0x100, MODPARAM_TYPE_FLOAT},
+    {"Lowpass", 0x200, MODPARAM_TYPE_FLOAT, 4},
+    {"Average", 0x300, MODPARAM_TYPE_U32},
+    {NULL},
+};
+
 static const lcec_modparam_desc_t mp_0[] = {
     {NULL},
 };
@@ -31,4 +38,26 @@ TESTFUNC(test_modparm_len) {
   TESTRESULTS;
 }
 
+TESTFUNC(test_modparam_find) {
+  TESTSETUP;
+  int id = -1;
+
+  TESTINT(lcec_modparam_desc_find(mp_3, "positionLimitMax", &id) == &mp_3[1], 1);
+  TESTINT(id, 6);
+  TESTINT(lcec_modparam_desc_find(mp_3, "positionLimit", &id) == NULL, 1);
+  TESTINT(lcec_modparam_desc_find(mp_0, "positionLimitMax", &id) == NULL, 1);
+
+  // Exact names win over channel prefixes.
+  TESTINT(lcec_modparam_desc_find(mp_ch, "ch0Lowpass", &id) == &mp_ch[0], 1);
+  TESTINT(id, 0x100);
+  TESTINT(lcec_modparam_desc_find(mp_ch, "ch3Lowpass", &id) == &mp_ch[1], 1);
+  TESTINT(id, 0x203);
+  TESTINT(lcec_modparam_desc_find(mp_ch, "ch4Lowpass", &id) == NULL, 1);
+  TESTINT(lcec_modparam_desc_find(mp_ch, "ch1Average", &id) == NULL, 1);
+  TESTINT(lcec_modparam_desc_find(mp_ch, "chLowpass", &id) == NULL, 1);
+  TESTINT(lcec_modparam_desc_find(mp_ch, "ch99999999999Lowpass", &id) == NULL, 1);
+
+  TESTRESULTS;
+}
+
 TESTMAIN
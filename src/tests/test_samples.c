@@ -0,0 +1,365 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/lcec.h"
+#include "../../src/lcec_samples.h"
+#include "../../src/devices/lcec_class_oversample.h"
+#include "tests.h"
+
+TESTGLOBALSETUP;
+
+#define PERIOD 1000000  // 1 ms
+
+// Values in thousandths, so float pins can be compared with TESTINT.
+#define MILLI(x) ((int)floor((x)*1000.0 + 0.5))
+
+static lcec_master_t master;
+static struct lcec_slave slave;
+static uint8_t pd[16];
+static lcec_class_oversample_options_t opt;
+static lcec_class_oversample_channel_t chans[2];
+static lcec_class_oversample_t dev;
+static hal_float_t min_pin[2], max_pin[2], mean_pin[2], last_pin[2], scale_pin[2], bias_pin[2], offset_pin[2], value_pin[2], edge_pin[2];
+static hal_bit_t bit_pin[2], bit_min_pin[2], bit_max_pin[2], enable_pin[2], interpolate_pin[2];
+static hal_s32_t raw_pin[2];
+
+// Set up a device the way lcec_oversample_register() would, without
+// HAL or EtherLab.  Channel `ch`'s samples start at byte `2 * ch *
+// samples`, or at bit `first_bp` of byte `ch` for digital devices.
+static void setup_dev(int is_output, int sample_bits, int channels, int samples, unsigned int first_bp) {
+  lcec_class_oversample_channel_t *chan;
+  unsigned int last;
+  int ch;
+
+  memset(&master, 0, sizeof(master));
+  memset(&slave, 0, sizeof(slave));
+  memset(pd, 0, sizeof(pd));
+  memset(&opt, 0, sizeof(opt));
+  memset(chans, 0, sizeof(chans));
+  memset(&dev, 0, sizeof(dev));
+
+  master.process_data = pd;
+  master.app_time_base = 1000000000000LL;
+  slave.master = &master;
+
+  opt.name_prefix = is_output ? "aout" : "ain";
+  opt.is_output = is_output;
+  opt.sample_bits = sample_bits;
+  opt.max_value = (sample_bits == 1) ? 0 : 1000;
+  opt.max_samples = 8;
+  opt.channel_count = channels;
+
+  dev.options = &opt;
+  dev.samples = samples;
+  dev.channel_count = channels;
+  dev.channels = chans;
+  dev.recip_max = (opt.max_value != 0) ? 1.0 / (double)opt.max_value : 1.0;
+  dev.recip_samples = 1.0 / (double)samples;
+
+  for (ch = 0, chan = chans; ch < channels; ch++, chan++) {
+    if (sample_bits == 1) {
+      chan->first_os = ch;
+      chan->first_bp = first_bp;
+    } else {
+      chan->first_os = 2 * ch * samples;
+      chan->first_bp = 0;
+    }
+    last = chan->first_os * 8 + chan->first_bp + (samples - 1) * sample_bits;
+    chan->last_os = last / 8;
+    chan->last_bp = last % 8;
+
+    chan->min = &min_pin[ch];
+    chan->max = &max_pin[ch];
+    chan->mean = &mean_pin[ch];
+    chan->last = &last_pin[ch];
+    chan->scale = &scale_pin[ch];
+    chan->bias = &bias_pin[ch];
+    chan->offset = &offset_pin[ch];
+    chan->value = &value_pin[ch];
+    chan->edge = &edge_pin[ch];
+    chan->bit = &bit_pin[ch];
+    chan->bit_min = &bit_min_pin[ch];
+    chan->bit_max = &bit_max_pin[ch];
+    chan->enable = &enable_pin[ch];
+    chan->interpolate = &interpolate_pin[ch];
+    chan->raw = &raw_pin[ch];
+    scale_pin[ch] = 1.0;
+    bias_pin[ch] = offset_pin[ch] = value_pin[ch] = edge_pin[ch] = 0.0;
+    bit_pin[ch] = enable_pin[ch] = interpolate_pin[ch] = 0;
+  }
+}
+
+// Give the device a sample ring of `size` cycles.
+static LCEC_SAMPLES_RING_T *setup_ring(uint32_t size) {
+  LCEC_SAMPLES_RING_T *ring;
+
+  ring = calloc(1, LCEC_SAMPLES_BYTES(size, dev.channel_count, dev.samples));
+  ring->size = size;
+  ring->channels = dev.channel_count;
+  ring->samples = dev.samples;
+  ring->block_size = LCEC_SAMPLES_BLOCK_BYTES(dev.channel_count, dev.samples);
+  dev.ring = ring;
+  return ring;
+}
+
+TESTFUNC(test_samples_layout) {
+  TESTSETUP;
+
+  // Blocks and the block area are 8-byte aligned.
+  TESTINT((int)(LCEC_SAMPLES_BLOCKS_OFFSET % 8), 0);
+  TESTINT((int)(LCEC_SAMPLES_BLOCK_BYTES(2, 10) % 8), 0);
+  TESTINT((int)(LCEC_SAMPLES_BLOCK_BYTES(3, 1) % 8), 0);
+  TESTINT(LCEC_SAMPLES_BLOCK_BYTES(2, 10) >= sizeof(LCEC_SAMPLES_BLOCK_T) + 2 * 10 * sizeof(int32_t), 1);
+  TESTINT(LCEC_SAMPLES_BYTES(4, 2, 10) == LCEC_SAMPLES_BLOCKS_OFFSET + 4 * LCEC_SAMPLES_BLOCK_BYTES(2, 10), 1);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_samples_block) {
+  TESTSETUP;
+  LCEC_SAMPLES_RING_T *ring;
+  char *base;
+
+  ring = calloc(1, LCEC_SAMPLES_BYTES(4, 2, 3));
+  TESTNOTNULL(ring);
+  ring->size = 4;
+  ring->channels = 2;
+  ring->samples = 3;
+  ring->block_size = LCEC_SAMPLES_BLOCK_BYTES(2, 3);
+  base = (char *)ring + LCEC_SAMPLES_BLOCKS_OFFSET;
+
+  // Sequence numbers wrap around the ring.
+  TESTINT((char *)LCEC_SAMPLES_BLOCK(ring, 0) == base, 1);
+  TESTINT((char *)LCEC_SAMPLES_BLOCK(ring, 3) == base + 3 * ring->block_size, 1);
+  TESTINT((char *)LCEC_SAMPLES_BLOCK(ring, 4) == base, 1);
+  TESTINT((char *)LCEC_SAMPLES_BLOCK(ring, 0xffffffff) == base + 3 * ring->block_size, 1);
+
+  // The last block ends inside the ring.
+  TESTINT((char *)&LCEC_SAMPLES_BLOCK(ring, 3)->samples[2 * 3] <= (char *)ring + LCEC_SAMPLES_BYTES(4, 2, 3), 1);
+
+  free(ring);
+  TESTRESULTS;
+}
+
+TESTFUNC(test_oversample_read_analog) {
+  TESTSETUP;
+  static const int16_t samples[2][4] = {{100, -200, 300, 50}, {-1, -2, -3, -4}};
+  LCEC_SAMPLES_RING_T *ring;
+  LCEC_SAMPLES_BLOCK_T *block;
+  uint64_t before, after;
+  int ch, k;
+
+  setup_dev(0, 16, 2, 4, 0);
+  ring = setup_ring(2);
+  for (ch = 0; ch < 2; ch++) {
+    for (k = 0; k < 4; k++) {
+      EC_WRITE_S16(&pd[chans[ch].first_os + 2 * k], samples[ch][k]);
+    }
+  }
+  scale_pin[0] = 2.0;
+  bias_pin[0] = 1.0;
+
+  before = lcec_master_app_time(&master);
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  after = lcec_master_app_time(&master);
+
+  // Summaries are bias + scale * raw / max_value.
+  TESTINT(dev.layout_state, 1);
+  TESTINT(MILLI(min_pin[0]), 600);
+  TESTINT(MILLI(max_pin[0]), 1600);
+  TESTINT(MILLI(mean_pin[0]), 1125);
+  TESTINT(MILLI(last_pin[0]), 1100);
+  TESTINT(raw_pin[0], 50);
+  TESTINT(MILLI(min_pin[1] * 1000.0), -4000);
+  TESTINT(MILLI(max_pin[1] * 1000.0), -1000);
+  TESTINT(MILLI(mean_pin[1] * 1000.0), -2500);
+  TESTINT(raw_pin[1], -4);
+
+  // The block holds sample rows of all channels, stamped with the
+  // start of the previous cycle, when sample 0 was taken.
+  block = LCEC_SAMPLES_BLOCK(ring, 0);
+  TESTINT(ring->head, 1);
+  TESTINT(block->samples[0], 100);
+  TESTINT(block->samples[1], -1);
+  TESTINT(block->samples[2 * 2 + 0], 300);
+  TESTINT(block->samples[3 * 2 + 1], -4);
+  TESTINT(block->interval, PERIOD / 4);
+  TESTINT(block->timestamp >= before - PERIOD && block->timestamp <= after - PERIOD, 1);
+
+  // The third cycle overwrites the first block.
+  EC_WRITE_S16(&pd[0], 7);
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  EC_WRITE_S16(&pd[0], 8);
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  TESTINT(ring->head, 3);
+  TESTINT(LCEC_SAMPLES_BLOCK(ring, 1)->samples[0], 7);
+  TESTINT(block->samples[0], 8);
+
+  free(ring);
+  TESTRESULTS;
+}
+
+TESTFUNC(test_oversample_read_digital) {
+  TESTSETUP;
+  static const int bits[5] = {0, 1, 1, 0, 1};
+  int k;
+
+  // 5 samples from bit 6 on cross into the next byte.
+  setup_dev(0, 1, 1, 5, 6);
+  for (k = 0; k < 5; k++) {
+    EC_WRITE_BIT(&pd[(6 + k) / 8], (6 + k) % 8, bits[k]);
+  }
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  TESTINT(dev.layout_state, 1);
+  TESTINT(bit_pin[0], 1);
+  TESTINT(bit_min_pin[0], 0);
+  TESTINT(bit_max_pin[0], 1);
+  TESTINT(MILLI(mean_pin[0]), 600);
+
+  // All high.
+  for (k = 0; k < 5; k++) {
+    EC_WRITE_BIT(&pd[(6 + k) / 8], (6 + k) % 8, 1);
+  }
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  TESTINT(bit_min_pin[0], 1);
+  TESTINT(MILLI(mean_pin[0]), 1000);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_oversample_layout) {
+  TESTSETUP;
+  LCEC_SAMPLES_RING_T *ring;
+
+  // EtherLab put the last sample somewhere else, so the channel is disabled.
+  setup_dev(0, 16, 2, 4, 0);
+  ring = setup_ring(2);
+  chans[1].last_os += 2;
+  EC_WRITE_S16(&pd[0], 5);
+  mean_pin[0] = 42.0;
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  TESTINT(dev.layout_state, -1);
+  TESTINT(MILLI(mean_pin[0]), 42000);
+  TESTINT(ring->head, 0);
+
+  // It stays disabled.
+  chans[1].last_os -= 2;
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  TESTINT(ring->head, 0);
+  free(ring);
+
+  // A single sample needs no checking.
+  setup_dev(0, 16, 1, 1, 0);
+  chans[0].last_os = 99;
+  lcec_oversample_read(&slave, &dev, PERIOD);
+  TESTINT(dev.layout_state, 1);
+
+  // Outputs are checked the same way.
+  setup_dev(1, 1, 1, 4, 0);
+  chans[0].last_bp = 0;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  TESTINT(dev.layout_state, -1);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_oversample_write_analog) {
+  TESTSETUP;
+  LCEC_SAMPLES_RING_T *ring;
+  LCEC_SAMPLES_BLOCK_T *block;
+  uint64_t before, after;
+  int k;
+
+  setup_dev(1, 16, 1, 4, 0);
+  ring = setup_ring(4);
+
+  // Disabled outputs write 0.
+  value_pin[0] = 0.5;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  TESTINT(raw_pin[0], 0);
+  TESTINT(EC_READ_S16(&pd[6]), 0);
+
+  // Without interpolation, all samples step to the new value.
+  enable_pin[0] = 1;
+  before = lcec_master_app_time(&master);
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  after = lcec_master_app_time(&master);
+  TESTINT(raw_pin[0], 500);
+  for (k = 0; k < 4; k++) {
+    TESTINT(EC_READ_S16(&pd[2 * k]), 500);
+  }
+  block = LCEC_SAMPLES_BLOCK(ring, 1);
+  TESTINT(block->samples[0], 500);
+  TESTINT(block->timestamp >= before && block->timestamp <= after, 1);
+
+  // With interpolation, samples ramp from the previous value.
+  interpolate_pin[0] = 1;
+  value_pin[0] = 1.0;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  TESTINT(EC_READ_S16(&pd[0]), 625);
+  TESTINT(EC_READ_S16(&pd[2]), 750);
+  TESTINT(EC_READ_S16(&pd[4]), 875);
+  TESTINT(EC_READ_S16(&pd[6]), 1000);
+  TESTINT(LCEC_SAMPLES_BLOCK(ring, 2)->samples[1], 750);
+
+  // Scale, offset, and clamping to full scale.
+  interpolate_pin[0] = 0;
+  scale_pin[0] = 10.0;
+  value_pin[0] = -2.0;
+  offset_pin[0] = 0.1;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  TESTINT(raw_pin[0], -100);
+  value_pin[0] = -100.0;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  TESTINT(raw_pin[0], -1000);
+  TESTINT(ring->head, 5);
+
+  free(ring);
+  TESTRESULTS;
+}
+
+TESTFUNC(test_oversample_write_digital) {
+  TESTSETUP;
+  int k;
+
+  setup_dev(1, 1, 1, 4, 2);
+
+  // A change switches at `edge`, here half way through the cycle.
+  bit_pin[0] = 1;
+  edge_pin[0] = 0.5;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  TESTINT(EC_READ_BIT(&pd[0], 2), 0);
+  TESTINT(EC_READ_BIT(&pd[0], 3), 0);
+  TESTINT(EC_READ_BIT(&pd[0], 4), 1);
+  TESTINT(EC_READ_BIT(&pd[0], 5), 1);
+
+  // No change, no edge.
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  for (k = 0; k < 4; k++) {
+    TESTINT(EC_READ_BIT(&pd[0], 2 + k), 1);
+  }
+
+  // `edge` is clamped to the cycle.
+  bit_pin[0] = 0;
+  edge_pin[0] = -1.0;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  for (k = 0; k < 4; k++) {
+    TESTINT(EC_READ_BIT(&pd[0], 2 + k), 0);
+  }
+  bit_pin[0] = 1;
+  edge_pin[0] = 2.0;
+  lcec_oversample_write(&slave, &dev, PERIOD);
+  for (k = 0; k < 4; k++) {
+    TESTINT(EC_READ_BIT(&pd[0], 2 + k), 0);
+  }
+
+  // Bits outside the channel are left alone.
+  TESTINT(EC_READ_BIT(&pd[0], 1), 0);
+  TESTINT(EC_READ_BIT(&pd[0], 6), 0);
+
+  TESTRESULTS;
+}
+
+TESTMAIN
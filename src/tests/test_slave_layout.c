@@ -0,0 +1,151 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../src/lcec.h"
+#include "tests.h"
+
+TESTGLOBALSETUP;
+
+#define CACHE_LINE 64
+
+#define FIELD_END(type, field) (offsetof(type, field) + sizeof(((type *)0)->field))
+
+TESTFUNC(test_slave_hot_fields) {
+  TESTSETUP;
+
+  // Everything `lcec_read_master()` and the drivers' read/write
+  // functions need from `lcec_slave_t` must be in its first cache line.
+  TESTINT(FIELD_END(lcec_slave_t, next) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, master) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, hal_data) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, proc_read) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, proc_write) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, config) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, hal_state_data) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, state) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_t, emcy_queue_size) <= CACHE_LINE, 1);
+
+  TESTRESULTS;
+}
+
+TESTFUNC(test_slave_rt_hot_fields) {
+  TESTSETUP;
+
+  // The cyclic loop reads all of these for every slave, so a
+  // `lcec_slave_rt_t` must fit in a single cache line.
+  TESTINT(offsetof(lcec_slave_rt_t, slave), 0);
+  TESTINT(FIELD_END(lcec_slave_rt_t, proc_read) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_rt_t, proc_write) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_rt_t, config) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_rt_t, hal_state_data) <= CACHE_LINE, 1);
+  TESTINT(FIELD_END(lcec_slave_rt_t, emcy_queue_size) <= CACHE_LINE, 1);
+  TESTINT(sizeof(lcec_slave_rt_t) <= CACHE_LINE, 1);
+
+  TESTRESULTS;
+}
+
+// Distinct cache lines seen by `touch()`.
+static uintptr_t lines[1024];
+static int line_count;
+
+// Record the cache lines that `len` bytes at `p` live in.
+static void touch(const void *p, size_t len) {
+  uintptr_t line, last = ((uintptr_t)p + len - 1) / CACHE_LINE;
+  int i;
+
+  for (line = (uintptr_t)p / CACHE_LINE; line <= last; line++) {
+    for (i = 0; i < line_count && lines[i] != line; i++)
+      ;
+    if (i == line_count && line_count < 1024) lines[line_count++] = line;
+  }
+}
+
+#define TOUCH(p, field) touch(&(p)->field, sizeof((p)->field))
+
+TESTFUNC(test_slave_cycle_footprint) {
+  TESTSETUP;
+  const int n = 32;
+  lcec_slave_t *slaves[32], *slave;
+  lcec_slave_rt_t *slave_rt, *rt;
+  int i, list_lines, rt_lines;
+
+  // Allocate slaves one at a time, as the config parser does, and the
+  // per-cycle array the way `lcec_master_build_slave_rt()` fills it.
+  for (i = 0; i < n; i++) {
+    slaves[i] = calloc(1, sizeof(lcec_slave_t));
+    if (i > 0) slaves[i - 1]->next = slaves[i];
+  }
+  slave_rt = calloc(n, sizeof(lcec_slave_rt_t));
+  for (i = 0, rt = slave_rt; i < n; i++, rt++) {
+    rt->slave = slaves[i];
+  }
+
+  // Fields the cyclic loops in `lcec_read_master()` and
+  // `lcec_write_master()` read on a cycle without state checks,
+  // walking the `lcec_slave_t` list...
+  line_count = 0;
+  for (slave = slaves[0]; slave != NULL; slave = slave->next) {
+    TOUCH(slave, config);
+    TOUCH(slave, hal_state_data);
+    TOUCH(slave, emcy_queue_size);
+    TOUCH(slave, proc_read);
+    TOUCH(slave, proc_write);
+    TOUCH(slave, next);
+  }
+  list_lines = line_count;
+
+  // ...and walking the `lcec_slave_rt_t` array instead.
+  line_count = 0;
+  for (rt = slave_rt; rt < slave_rt + n; rt++) {
+    TOUCH(rt, config);
+    TOUCH(rt, hal_state_data);
+    TOUCH(rt, emcy_queue_size);
+    TOUCH(rt, proc_read);
+    TOUCH(rt, proc_write);
+    TOUCH(rt, slave);
+  }
+  rt_lines = line_count;
+
+  fprintf(stderr, "%s: %d slaves, cache lines per cycle: %d walking lcec_slave_t, %d walking lcec_slave_rt_t\n", __func__, n, list_lines,
+      rt_lines);
+  TESTINT(list_lines >= n, 1);
+  TESTINT(rt_lines <= (int)((n * sizeof(lcec_slave_rt_t) + CACHE_LINE - 1) / CACHE_LINE) + 1, 1);
+  TESTINT(rt_lines < list_lines, 1);
+
+  for (i = 0; i < n; i++) {
+    free(slaves[i]);
+  }
+  free(slave_rt);
+  TESTRESULTS;
+}
+
+TESTFUNC(test_slave_release_config) {
+  TESTSETUP;
+  lcec_slave_t *slave = calloc(1, sizeof(lcec_slave_t));
+
+  slave->modparams = calloc(1, sizeof(lcec_slave_modparam_t));
+  slave->sdo_config = calloc(1, sizeof(lcec_slave_sdoconf_t));
+  slave->idn_config = calloc(1, sizeof(lcec_slave_idnconf_t));
+  slave->generic_sync_managers = calloc(1, sizeof(ec_sync_info_t));
+  slave->sync_info = slave->generic_sync_managers;
+  slave->dc_conf = calloc(1, sizeof(lcec_slave_dc_t));
+
+  lcec_slave_release_config(slave);
+  TESTINT(slave->modparams == NULL, 1);
+  TESTINT(slave->sdo_config == NULL, 1);
+  TESTINT(slave->idn_config == NULL, 1);
+  TESTINT(slave->generic_sync_managers == NULL, 1);
+  TESTINT(slave->sync_info == NULL, 1);
+  TESTINT(slave->dc_conf == NULL, 1);
+
+  // A second call must be harmless.
+  lcec_slave_release_config(slave);
+  TESTINT(slave->modparams == NULL, 1);
+
+  free(slave);
+  TESTRESULTS;
+}
+
+TESTMAIN